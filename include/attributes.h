@@ -22,8 +22,11 @@ using VecColor = GlmVec3;
 using VecTextureCoord = glm::vec2;
 using GlmMat4 = glm::mat4;
 
-enum ShadingOption { per_vertex, normal_mapping, wireframe, flat };
+enum ShadingOption { per_vertex, normal_mapping, wireframe, flat, point_splats };
 enum ModelChoice { dragon_off, dragon_obj, bunny_off };
+enum RenderPath { forward_shading, deferred_shading };
+enum AntialiasingMode { no_aa, msaa_2x, msaa_4x, msaa_8x, fxaa, taa };
+enum DeformationMode { no_deform, morph_deform, wave_deform, twist_deform };
 
 // Vertex data as loaded into the shader
 // Offsets (in memory) must exactly correspond to the definitions in shaders
@@ -34,4 +37,38 @@ struct Vertex {
     VecTextureCoord uv_coord;
 };
 
+// Matrices uniform block (std140); the camera, shared by all instances
+struct TransformBlock {
+    GlmMat4 view;
+    GlmMat4 projection;
+};
+
+// Entry of the instance shader storage buffer (std430), indexed by the draw's base instance
+struct InstanceBlock {
+    GlmMat4 world;
+    GlmMat4 normal_to_view;
+    GlmMat4 normal_to_world;
+    glm::uvec4 material;  // x: index into the material buffer
+};
+
+// Entry of the material shader storage buffer (std430)
+struct MaterialBlock {
+    glm::uvec4 textures;  // bindless: diffuse and normal handles (lo, hi); otherwise (array, layer) of each
+    GlmVec4 color;        // rgb: albedo of untextured meshes; w: 1 if textured
+};
+
+// Lighting uniform block (std140); the lights themselves are in a shader storage buffer
+struct LightingBlock {
+    GlmVec4 eye_pos;
+    glm::uvec4 cluster_grid;  // froxel counts in x, y, z; w: light capacity per cluster
+    GlmVec4 cluster_depth;    // near, far, z slices / log(far / near)
+    GlmVec4 viewport;         // width, height
+};
+
+// Point light as stored in the light shader storage buffer (std430)
+struct PointLight {
+    GlmVec4 position;  // xyz: world space position, w: radius of influence
+    GlmVec4 color;
+};
+
 #endif
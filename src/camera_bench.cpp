@@ -0,0 +1,108 @@
+#include "pipeline/rasterizer.h"
+#include "pipeline/camera_path.h"
+
+/* Camera path benchmark on the software rasterizer: replays the same path as 'campath' in dragon-opengl (the
+ * built-in one, or a recorded or scripted file) for every model and shading option, and appends one line per case
+ * to the benchmark report. No window or GPU is needed, so CI machines compare builds on identical workloads */
+const std::string warmup_str = "warmup=";
+const unsigned int soft_warmup_frames_default = 3;  // no shaders to compile, only caches to fill
+
+int main(int argc, char* argv[]) {
+    std::string report_filename = benchmark_report_default;
+    std::string path_filename;
+    unsigned int warmup = soft_warmup_frames_default;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        auto extras = std::string(argv[i]);
+
+        if(extras.starts_with(camera_path_str)) {
+            path_filename = extras.substr(camera_path_str.size());
+        } else if(extras.starts_with(benchmark_report_str)) {
+            report_filename = extras.substr(benchmark_report_str.size());
+        } else if(extras.starts_with(threads_str)) {
+            threads = ParseCount(extras.substr(threads_str.size()), extras);
+        } else if(extras.starts_with(warmup_str)) {
+            warmup = ParseCount(extras.substr(warmup_str.size()), extras);
+        } else {
+            std::cout << "Invalid option, try 'campath=path' 'threads=N' 'warmup=N' 'report=path'" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    auto path = path_filename.empty() ? BuiltinCameraPath() : LoadCameraPath(path_filename);
+    auto frames = CameraPathFrames(path);
+
+    std::cout << "Camera path '" << path.name << "': " << path.keys.size() << " keys, " << frames << " frames, "
+              << threads << " threads" << std::endl;
+
+    auto jobs = JobSystem::ForCores(threads);
+
+    unsigned int cases = 0;
+
+    for (auto model: builtin_models) {
+        auto scene_description = BuiltinScene(model);
+
+        for (auto opt: shading_options) {
+            // Same rule as dragon-opengl: normal mapping needs textures
+            if(opt == ShadingOption::normal_mapping && !SceneHasTextures(scene_description)) {
+                continue;
+            }
+
+            auto scene = CreateSoftScene(scene_description, opt, 1, jobs);
+
+            SceneGlobals scene_globals;
+            Framebuffer framebuffer;
+
+            // Untimed frames at the first key
+            ApplyCameraKey(CameraPathKey(path, 0), scene_globals);
+
+            for (unsigned int i = 0; i < warmup; ++i) {
+                RenderSoftFrame(scene, scene_globals, framebuffer, jobs);
+            }
+
+            std::vector<double> times;
+            double triangles = 0.0;
+            double seconds = 0.0;
+
+            for (unsigned int frame = 0; frame < frames; ++frame) {
+                ApplyCameraKey(CameraPathKey(path, frame), scene_globals);
+
+                auto stats = RenderSoftFrame(scene, scene_globals, framebuffer, jobs);
+
+                times.push_back(stats.milliseconds);
+                triangles += (double) stats.triangles;
+                seconds += stats.milliseconds / 1000.0;
+            }
+
+            BenchmarkRecord record;
+
+            record.renderer = "software";
+            record.device = std::to_string(threads) + " threads";
+            record.model = ModelName(model);
+            record.shading = ShadingName(opt);
+            record.render_path = "forward";
+            record.camera_path = path.name;
+            record.frames = frames;
+            record.width = path.keys.front().width;
+            record.height = path.keys.front().height;
+            record.triangles = frames ? triangles / frames : 0.0;
+            record.frame_ms = SummarizeFrameTimes(times);
+            record.triangles_per_second = seconds > 0.0 ? triangles / seconds : 0.0;
+
+            std::cout << BenchmarkRecordStats(record) << std::endl;
+
+            if(!AppendBenchmarkRecord(report_filename, record)) {
+                std::cout << "Could not write " << report_filename << std::endl;
+
+                exit(EXIT_FAILURE);
+            }
+            ++cases;
+        }
+    }
+
+    std::cout << cases << " cases appended to " << report_filename << std::endl;
+
+    exit(EXIT_SUCCESS);
+}
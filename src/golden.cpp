@@ -0,0 +1,204 @@
+#include "pipeline/image_diff.h"
+
+#include <fstream>
+#include <iomanip>
+
+/* Golden image regression run: renders every model and shading option at fixed angles with the software
+ * rasterizer (no window or GPU needed) and compares each image against the stored golden one with SSIM.
+ * One CSV line per case records the render time next to the scores, so speed and quality are tracked in
+ * the same report. Exits with a failure if any case fails or has no golden image, and with golden_skip_code
+ * when there is nothing to compare: a model file or the whole golden directory is missing */
+const std::string dir_str = "dir=";
+const std::string update_str = "update";
+const std::string ssim_str = "ssim=";
+const std::string report_str = "report=";
+const std::string golden_report_default = "golden_report.csv";
+
+const double golden_ssim_default = 0.99;
+const unsigned int golden_width = 480;
+const unsigned int golden_height = 360;
+const unsigned int golden_frames_default = 3;
+const int golden_skip_code = 77;  // SKIP_RETURN_CODE of the ctest test
+
+// Camera angles (rotate_x, rotate_y in degrees), as set by the arrow keys
+const float golden_angles[][2] = {{0.0f, 0.0f}, {0.0f, 90.0f}, {-30.0f, 215.0f}};
+
+double ParseThreshold(const std::string &value, const std::string &option) {
+    // Parses the SSIM threshold of 'ssim=X', between 0 and 1
+    try {
+        auto threshold = std::stod(value);
+
+        if(threshold >= 0.0 && threshold <= 1.0) {
+            return threshold;
+        }
+    } catch (const std::logic_error &) {
+        // handled below
+    }
+    std::cout << "Invalid value in '" << option << "', expected a number between 0 and 1" << std::endl;
+
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+    std::string directory = golden_dir;
+    std::string report_filename = golden_report_default;
+    auto update = false;
+    auto min_ssim = golden_ssim_default;
+    unsigned int width = golden_width;
+    unsigned int height = golden_height;
+    unsigned int frames = golden_frames_default;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        auto extras = std::string(argv[i]);
+
+        if(extras == update_str) {
+            update = true;
+        } else if(extras.starts_with(dir_str)) {
+            directory = extras.substr(dir_str.size());
+        } else if(extras.starts_with(report_str)) {
+            report_filename = extras.substr(report_str.size());
+        } else if(extras.starts_with(ssim_str)) {
+            min_ssim = ParseThreshold(extras.substr(ssim_str.size()), extras);
+        } else if(extras.starts_with(frames_str)) {
+            frames = ParseCount(extras.substr(frames_str.size()), extras);
+        } else if(extras.starts_with(threads_str)) {
+            threads = ParseCount(extras.substr(threads_str.size()), extras);
+        } else if(extras.starts_with(size_str) && extras.find('x') != std::string::npos) {
+            auto dims = extras.substr(size_str.size());
+
+            width = ParseCount(dims.substr(0, dims.find('x')), extras);
+            height = ParseCount(dims.substr(dims.find('x') + 1), extras);
+        } else {
+            std::cout << "Invalid option, try 'update' 'dir=path' 'ssim=X' 'size=WxH' 'frames=N' 'threads=N' "
+                         "'report=path'" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(!directory.empty() && directory.back() != '/') {
+        directory += '/';
+    }
+    if(update) {
+        std::filesystem::create_directories(directory);
+    } else {
+        // A checkout without the models or the goldens has nothing to compare; one golden missing still fails
+        std::string error;
+
+        for (auto model: builtin_models) {
+            if(!CheckSceneFiles(BuiltinScene(model), error)) {
+                std::cout << "Skipped: " << error << std::endl;
+
+                exit(golden_skip_code);
+            }
+        }
+        if(!std::filesystem::is_directory(directory)) {
+            std::cout << "Skipped: no golden images in " << directory << ", run 'dragon-golden update' first"
+                      << std::endl;
+
+            exit(golden_skip_code);
+        }
+    }
+
+    std::ofstream report(report_filename);
+
+    if(!report) {
+        std::cout << "Could not write " << report_filename << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    report << "case,model,shading,rotate_x,rotate_y,width,height,triangles,pixels,render_ms,ssim,worst_window,"
+              "changed,status" << std::endl;
+
+    auto jobs = JobSystem::ForCores(threads);
+
+    unsigned int cases = 0;
+    unsigned int failures = 0;
+
+    for (auto model: builtin_models) {
+        auto scene_description = BuiltinScene(model);
+
+        for (auto opt: shading_options) {
+            // Same rule as dragon-opengl: normal mapping needs textures
+            if(opt == ShadingOption::normal_mapping && !SceneHasTextures(scene_description)) {
+                continue;
+            }
+
+            // Goes through the regular loader, so changes there show up in the images
+            auto scene = CreateSoftScene(scene_description, opt, 1, jobs);
+
+            for (std::size_t angle = 0; angle < std::size(golden_angles); ++angle) {
+                auto name = ModelName(model) + "_" + ShadingName(opt) + "_" + std::to_string(angle);
+
+                SceneGlobals scene_globals;
+
+                scene_globals.width = width;
+                scene_globals.height = height;
+                scene_globals.rotate_x = golden_angles[angle][0];
+                scene_globals.rotate_y = golden_angles[angle][1];
+
+                // One untimed frame, then the median of the timed ones
+                Framebuffer framebuffer;
+                auto stats = RenderSoftFrame(scene, scene_globals, framebuffer, jobs);
+                std::vector<double> times;
+
+                for (unsigned int i = 0; i < frames; ++i) {
+                    stats = RenderSoftFrame(scene, scene_globals, framebuffer, jobs);
+                    times.push_back(stats.milliseconds);
+                }
+                std::sort(times.begin(), times.end());
+
+                auto render_ms = times[times.size() / 2];
+                auto golden_path = directory + name + ".png";
+
+                ImageDiff diff;
+                std::string status;
+
+                if(update) {
+                    status = WriteFramebuffer(framebuffer, golden_path) ? "updated" : "write_error";
+                } else {
+                    Framebuffer golden;
+
+                    if(!ReadFramebuffer(golden_path, golden)) {
+                        status = "missing";
+                    } else if(golden.width != width || golden.height != height) {
+                        status = "size_mismatch";
+                    } else {
+                        Framebuffer heatmap;
+
+                        diff = CompareImages(golden, framebuffer, &heatmap);
+                        status = diff.ssim >= min_ssim ? "pass" : "fail";
+
+                        // Failures leave the new image and where it differs in the working directory
+                        if(status == "fail") {
+                            WriteFramebuffer(framebuffer, name + ".actual.png");
+                            WriteFramebuffer(heatmap, name + ".diff.png");
+                        }
+                    }
+                }
+
+                auto failed = status != "pass" && status != "updated";
+
+                ++cases;
+                failures += failed ? 1 : 0;
+
+                std::cout << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(2)
+                          << std::setw(10) << render_ms << " ms  ssim " << std::setprecision(4) << diff.ssim
+                          << " (worst window " << diff.worst_window << ", " << std::setprecision(2)
+                          << 100.0 * diff.changed << "% pixels changed)  " << status << std::endl;
+
+                report << name << "," << ModelName(model) << "," << ShadingName(opt) << ","
+                       << scene_globals.rotate_x << "," << scene_globals.rotate_y << "," << width << "," << height
+                       << "," << stats.triangles << "," << stats.pixels << "," << render_ms << ","
+                       << std::setprecision(6) << diff.ssim << "," << diff.worst_window << "," << diff.changed
+                       << "," << status << std::endl;
+            }
+        }
+    }
+
+    std::cout << cases << " cases, " << failures << " failed (SSIM threshold " << std::setprecision(4) << min_ssim
+              << ", " << threads << " threads); report in " << report_filename << std::endl;
+
+    exit(failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
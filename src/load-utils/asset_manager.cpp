@@ -0,0 +1,255 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "asset_manager.h"
+
+std::uint64_t HashBytes(std::uint64_t hash, const void *data, std::size_t size) {
+    // http://www.isthe.com/chongo/tech/comp/fnv/index.html#FNV-1a, continued from hash
+    auto bytes = static_cast<const unsigned char *>(data);
+
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= fnv_prime;
+    }
+    return hash;
+}
+
+std::uint64_t HashBytes(const ByteList &bytes) {
+    return HashBytes(fnv_offset_basis, bytes.data(), bytes.size());
+}
+
+std::filesystem::path CacheFilePath(const std::string &dir, std::uint64_t key, const std::string &extension) {
+    std::ostringstream name;
+
+    name << std::hex << std::setw(16) << std::setfill('0') << key << extension;
+
+    return std::filesystem::path(dir) / name.str();
+}
+
+bool ReadCacheFile(const std::filesystem::path &path, const void *header, std::size_t header_size,
+                   const std::vector<std::span<char>> &blocks) {
+    // Fills the blocks; false if there is no file, its header differs (a stale bake) or it is too short
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file) {
+        return false;
+    }
+    std::vector<char> stored(header_size);
+
+    file.read(stored.data(), (std::streamsize) header_size);
+
+    if (!file || std::memcmp(stored.data(), header, header_size) != 0) {
+        return false;
+    }
+    for (const auto &block: blocks) {
+        file.read(block.data(), (std::streamsize) block.size());
+    }
+    return (bool) file;
+}
+
+bool WriteCacheFile(const std::filesystem::path &path, const void *header, std::size_t header_size,
+                    const std::vector<std::span<const char>> &blocks) {
+    // Creates the directory if needed; false if the file could not be written
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+    file.write(static_cast<const char *>(header), (std::streamsize) header_size);
+
+    for (const auto &block: blocks) {
+        file.write(block.data(), (std::streamsize) block.size());
+    }
+    file.close();
+
+    return !file.fail();
+}
+
+VertexList LoadMeshFile(const std::string &mesh_fname, const ByteList &bytes, ShadingOption opt,
+                        JobSystem &jobs) {
+    /* Picks the loader from the extension; .obj carries uv coordinates, .off does not. Every format parses the
+     * bytes already read; compressed meshes decode one job per chunk. Point splats get points, not triangles */
+    auto extension = std::filesystem::path(mesh_fname).extension();
+
+    if (extension == compressed_mesh_extension) {
+        auto mesh = LoadCompressedMesh(bytes, mesh_fname, opt, &jobs);
+
+        return opt == ShadingOption::point_splats ? WeldPoints(mesh) : mesh;
+    }
+    if (extension == ".obj") {
+        return LoadDragonObj(mesh_fname, bytes, opt);
+    }
+    return LoadDragonOff(mesh_fname, bytes, opt);
+}
+
+ImageData DecodeImage(const ByteList &bytes, const std::string &filename) {
+    // Decodes into an owned pixel list so the loader can be freed on the worker thread
+    ImageData image;
+    ImageLoader image_loader;
+
+    auto data = image_loader.LoadImageMemory(bytes.data(), (int) bytes.size(), image.width, image.height,
+                                             image.components);
+
+    if (!data) {
+        std::cout << "Failed to load texture via stb_image: " << filename << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    image.pixels.assign(data, data + (std::size_t) image.width * image.height * image.components);
+    image.memory = MemoryTag(MemoryCategory::cpu_images, image.pixels.size());
+
+    return image;
+}
+
+SceneAssets LoadSceneAssets(const SceneDescription &scene, ShadingOption opt, JobSystem &jobs,
+                            const std::vector<std::string> &prefetch_paths) {
+    /* Loads every file referenced by the scene once. All files, and the ones to prefetch, are read in a single
+     * batch (async_io.h); every file gets a job as soon as it lands, which hashes it and parses or decodes it
+     * unless a file with identical contents (eg. the same texture copied under two names) already was */
+    auto start = std::chrono::steady_clock::now();
+
+    // Distinct paths, in order of first use, and what each is read for
+    const unsigned int use_mesh = 1;
+    const unsigned int use_image = 2;
+    const unsigned int use_prefetch = 4;
+
+    std::vector<std::string> paths;
+    std::vector<unsigned int> uses;
+    std::map<std::string, std::size_t> path_ordinal;
+
+    auto add_path = [&](const std::string &path, unsigned int use) {
+        if (path.empty()) {
+            return;
+        }
+        if (!path_ordinal.contains(path)) {
+            // missing files are reported here, before any read starts
+            ExistsOk(path);
+
+            path_ordinal[path] = paths.size();
+            paths.push_back(path);
+            uses.push_back(0);
+        }
+        uses[path_ordinal[path]] |= use;
+    };
+    for (const auto &mesh: scene.meshes) {
+        // paged meshes are streamed chunk by chunk at draw time (streaming.h), never read here
+        if (IsOctreeMesh(mesh.path)) {
+            ExistsOk(mesh.path);
+        } else {
+            add_path(mesh.path, use_mesh);
+        }
+        add_path(mesh.diffuse_path, use_image);
+        add_path(mesh.normal_path, use_image);
+    }
+    for (const auto &path: prefetch_paths) {
+        add_path(path, use_prefetch);
+    }
+
+    // Images are flipped on load (critical for textures); this is global stb_image state
+    ImageLoader::SetFlipOnLoad(true);
+
+    // Read, then hash and parse or decode as files land
+    SceneAssets assets;
+
+    std::vector<ByteList> contents(paths.size());
+    std::vector<std::future<LoadedFile>> loads(paths.size());
+    std::mutex claimed_mutex;
+    std::set<std::pair<unsigned int, std::uint64_t>> claimed;  // use and content hash, taken by the first file
+
+    auto backend = ReadFilesAsync(paths, [&](std::size_t file, ByteList &&bytes) {
+        if (uses[file] & use_prefetch) {
+            assets.prefetched[paths[file]] = bytes;
+        }
+        if (uses[file] == use_prefetch) {
+            return;
+        }
+        contents[file] = std::move(bytes);
+
+        loads[file] = jobs.Submit([&, file]() {
+            LoadedFile loaded;
+
+            loaded.hash = HashBytes(contents[file]);
+
+            auto claim = [&](unsigned int use) {
+                std::lock_guard<std::mutex> lock(claimed_mutex);
+
+                return (uses[file] & use) && claimed.insert({use, loaded.hash}).second;
+            };
+            if (claim(use_mesh)) {
+                loaded.mesh = LoadMeshFile(paths[file], contents[file], opt, jobs);
+            }
+            if (claim(use_image)) {
+                loaded.image = DecodeImage(contents[file], paths[file]);
+            }
+            return loaded;
+        });
+    });
+
+    std::vector<LoadedFile> loaded(paths.size());
+    std::map<std::uint64_t, std::size_t> mesh_source;   // content hash -> file that was parsed
+    std::map<std::uint64_t, std::size_t> image_source;
+
+    for (std::size_t file = 0; file < paths.size(); ++file) {
+        if (!loads[file].valid()) {
+            continue;
+        }
+        loaded[file] = jobs.Wait(loads[file]);
+
+        if (loaded[file].mesh) {
+            mesh_source[loaded[file].hash] = file;
+        }
+        if (loaded[file].image) {
+            image_source[loaded[file].hash] = file;
+        }
+    }
+
+    // Unique meshes and images, in order of first use in the scene
+    std::map<std::size_t, unsigned int> mesh_ordinal;
+    std::map<std::size_t, int> image_ordinal;
+
+    auto find_image = [&](const std::string &path) -> int {
+        if (path.empty()) {
+            return -1;
+        }
+        auto source = image_source[loaded[path_ordinal[path]].hash];
+        auto [it, inserted] = image_ordinal.try_emplace(source, (int) assets.images.size());
+
+        if (inserted) {
+            assets.images.push_back(std::move(*loaded[source].image));
+        }
+        return it->second;
+    };
+
+    for (const auto &mesh: scene.meshes) {
+        auto unique = (unsigned int) assets.meshes.size();
+
+        if (IsOctreeMesh(mesh.path)) {
+            // an empty vertex range stands in for it
+            assets.meshes.emplace_back();
+        } else {
+            auto source = mesh_source[loaded[path_ordinal[mesh.path]].hash];
+            auto [it, inserted] = mesh_ordinal.try_emplace(source, unique);
+
+            // freed by ConcatenateMeshes
+            if (inserted) {
+                assets.meshes.push_back(std::move(*loaded[source].mesh));
+
+                TrackMemory(MemoryCategory::cpu_vertex_list, assets.meshes.back().capacity() * sizeof(Vertex));
+            }
+            unique = it->second;
+        }
+        assets.mesh_of.push_back(unique);
+        assets.diffuse_of.push_back(find_image(mesh.diffuse_path));
+        assets.normal_of.push_back(find_image(mesh.normal_path));
+    }
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "Loaded " << scene.meshes.size() << " meshes (" << assets.meshes.size() << " unique) and "
+              << assets.images.size() << " unique textures from " << paths.size() << " files in "
+              << elapsed.count() << " ms on " << jobs.ThreadCount() << " threads, " << IoBackendName(backend)
+              << " reads" << std::endl;
+
+    return assets;
+}
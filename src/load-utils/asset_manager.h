@@ -0,0 +1,79 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_ASSET_MANAGER_H
+#define DRAGON_GL_ASSET_MANAGER_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "attributes.h"
+#include "async_io.h"
+#include "image.h"
+#include "load_utils.h"
+#include "mesh_codec.h"
+#include "mesh_octree.h"
+#include "scene_file.h"
+#include "../pipeline/job_system.h"
+
+// Decoded texture, ready for upload
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    ByteList pixels;
+    MemoryTag memory;  // of the pixels
+};
+
+// A file of the scene once read: its content hash, and its mesh or image if it was the first with those contents
+struct LoadedFile {
+    std::uint64_t hash = 0;
+    std::optional<VertexList> mesh;
+    std::optional<ImageData> image;
+};
+
+// CPU side of a scene: unique meshes and images, plus which of them every scene mesh uses
+struct SceneAssets {
+    std::vector<VertexList> meshes;
+    std::vector<ImageData> images;
+    std::vector<unsigned int> mesh_of;  // scene mesh ordinal -> unique mesh
+    std::vector<int> diffuse_of;        // scene mesh ordinal -> unique image, -1 if untextured
+    std::vector<int> normal_of;
+    std::map<std::string, ByteList> prefetched;  // extra files read with the assets, by path
+};
+
+// 64-bit FNV-1a; content hashes identify duplicate files regardless of their path
+const std::uint64_t fnv_offset_basis = 14695981039346656037ull;
+const std::uint64_t fnv_prime = 1099511628211ull;
+
+std::uint64_t HashBytes(std::uint64_t hash, const void *data, std::size_t size);
+std::uint64_t HashBytes(const ByteList &bytes);
+
+// Baked data cached on disk (impostor atlases, ambient occlusion): one file per key, a header that must match the
+// expected one byte for byte (magic, version, key and settings; so headers have no padding), then blocks of known
+// size
+std::filesystem::path CacheFilePath(const std::string &dir, std::uint64_t key, const std::string &extension);
+bool ReadCacheFile(const std::filesystem::path &path, const void *header, std::size_t header_size,
+                   const std::vector<std::span<char>> &blocks);
+bool WriteCacheFile(const std::filesystem::path &path, const void *header, std::size_t header_size,
+                    const std::vector<std::span<const char>> &blocks);
+VertexList LoadMeshFile(const std::string &mesh_fname, const ByteList &bytes, ShadingOption opt,
+                        JobSystem &jobs);
+ImageData DecodeImage(const ByteList &bytes, const std::string &filename);
+SceneAssets LoadSceneAssets(const SceneDescription &scene, ShadingOption opt, JobSystem &jobs,
+                            const std::vector<std::string> &prefetch_paths = {});
+
+#endif // DRAGON_GL_ASSET_MANAGER_H
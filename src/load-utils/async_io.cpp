@@ -0,0 +1,350 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "async_io.h"
+
+namespace {
+    void ReadFailed(const std::string &path, int error) {
+        // Assets are needed to render anything, a failed read ends the run like a missing file
+        std::cout << "Could not read " << path;
+
+        if (error != 0) {
+            std::cout << ": " << std::strerror(error);
+        }
+        std::cout << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    IoBackend ReadWithThreads(const std::vector<std::string> &paths, const ReadCallback &on_read) {
+        // Blocking reads on a few threads; the caller receives the files as they complete
+        std::mutex done_mutex;
+        std::condition_variable done_signal;
+        std::deque<std::pair<std::size_t, ByteList>> done;
+        std::atomic<std::size_t> next_file = 0;
+
+        auto reader = [&]() {
+            for (auto file = next_file++; file < paths.size(); file = next_file++) {
+                std::ifstream filestream(paths[file], std::ios::binary);
+                std::error_code error;
+                auto size = std::filesystem::file_size(paths[file], error);
+
+                if (!filestream || error) {
+                    ReadFailed(paths[file], error.value());
+                }
+
+                ByteList bytes(size);
+
+                if (!filestream.read(reinterpret_cast<char *>(bytes.data()), (std::streamsize) size)) {
+                    ReadFailed(paths[file], 0);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(done_mutex);
+
+                    done.emplace_back(file, std::move(bytes));
+                }
+                done_signal.notify_one();
+            }
+        };
+
+        std::vector<std::thread> readers;
+
+        for (std::size_t i = 0; i < std::min<std::size_t>(async_io_threads, paths.size()); ++i) {
+            readers.emplace_back(reader);
+        }
+
+        for (std::size_t delivered = 0; delivered < paths.size(); ++delivered) {
+            std::unique_lock<std::mutex> lock(done_mutex);
+
+            done_signal.wait(lock, [&done]() { return !done.empty(); });
+
+            auto [file, bytes] = std::move(done.front());
+
+            done.pop_front();
+            lock.unlock();
+
+            on_read(file, std::move(bytes));
+        }
+
+        for (auto &thread: readers) {
+            thread.join();
+        }
+        return IoBackend::threads;
+    }
+
+#ifdef DRAGON_GL_IO_URING
+    // Submission and completion queues shared with the kernel
+    // https://kernel.dk/io_uring.pdf
+    struct IoRing {
+        int fd = -1;
+        unsigned int entries = 0;
+
+        void *sq_map = MAP_FAILED;
+        std::size_t sq_map_size = 0;
+        void *cq_map = MAP_FAILED;
+        std::size_t cq_map_size = 0;
+        void *sqe_map = MAP_FAILED;
+        std::size_t sqe_map_size = 0;
+
+        unsigned int *sq_head = nullptr;
+        unsigned int *sq_tail = nullptr;
+        unsigned int *sq_mask = nullptr;
+        unsigned int *sq_array = nullptr;
+        io_uring_sqe *sqes = nullptr;
+
+        unsigned int *cq_head = nullptr;
+        unsigned int *cq_tail = nullptr;
+        unsigned int *cq_mask = nullptr;
+        io_uring_cqe *cqes = nullptr;
+    };
+
+    // An opened file of the batch
+    struct RingFile {
+        int fd = -1;
+        ByteList bytes;
+        std::size_t remaining = 0;
+    };
+
+    // One read of a file; the iovec points into the file's bytes
+    struct RingRead {
+        std::size_t file = 0;
+        std::size_t offset = 0;
+        iovec target{};
+    };
+
+    void CloseRing(IoRing &ring) {
+        // Unmaps whatever SetupRing got to
+        if (ring.sqe_map != MAP_FAILED) {
+            munmap(ring.sqe_map, ring.sqe_map_size);
+        }
+        if (ring.cq_map != MAP_FAILED && ring.cq_map != ring.sq_map) {
+            munmap(ring.cq_map, ring.cq_map_size);
+        }
+        if (ring.sq_map != MAP_FAILED) {
+            munmap(ring.sq_map, ring.sq_map_size);
+        }
+        if (ring.fd >= 0) {
+            close(ring.fd);
+        }
+    }
+
+    bool SetupRing(IoRing &ring, unsigned int entries) {
+        // Creates the ring and maps its queues; false if the kernel has no io_uring or does not allow it
+        io_uring_params params{};
+
+        ring.fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+
+        if (ring.fd < 0) {
+            return false;
+        }
+        ring.entries = params.sq_entries;
+        ring.sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        ring.cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        // since 5.4 both rings share one mapping
+        auto single_map = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+        if (single_map) {
+            ring.sq_map_size = ring.cq_map_size = std::max(ring.sq_map_size, ring.cq_map_size);
+        }
+
+        ring.sq_map = mmap(nullptr, ring.sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd,
+                           IORING_OFF_SQ_RING);
+
+        if (ring.sq_map == MAP_FAILED) {
+            return false;
+        }
+        ring.cq_map = single_map ? ring.sq_map : mmap(nullptr, ring.cq_map_size, PROT_READ | PROT_WRITE,
+                                                      MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING);
+
+        if (ring.cq_map == MAP_FAILED) {
+            return false;
+        }
+        ring.sqe_map_size = params.sq_entries * sizeof(io_uring_sqe);
+        ring.sqe_map = mmap(nullptr, ring.sqe_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd,
+                            IORING_OFF_SQES);
+
+        if (ring.sqe_map == MAP_FAILED) {
+            return false;
+        }
+
+        auto sq = static_cast<char *>(ring.sq_map);
+        auto cq = static_cast<char *>(ring.cq_map);
+
+        ring.sq_head = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+        ring.sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+        ring.sq_mask = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+        ring.sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+        ring.sqes = static_cast<io_uring_sqe *>(ring.sqe_map);
+
+        ring.cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+        ring.cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+        ring.cq_mask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+        ring.cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        return true;
+    }
+
+    void OpenRingFile(const std::string &path, RingFile &file) {
+        // Opens and sizes a file, and asks the kernel to start fetching all of it right away
+        struct stat status{};
+
+        file.fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (file.fd < 0 || fstat(file.fd, &status) != 0) {
+            ReadFailed(path, errno);
+        }
+        posix_fadvise(file.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(file.fd, 0, 0, POSIX_FADV_WILLNEED);
+
+        file.bytes.resize((std::size_t) status.st_size);
+        file.remaining = file.bytes.size();
+    }
+
+    bool ReadWithRing(const std::vector<std::string> &paths, const ReadCallback &on_read) {
+        /* Every file is opened, then cut into chunk sized reads: the first chunk of every file is queued first so
+         * small files (shaders, textures) land early, then the rest file after file. The ring is kept full; short
+         * reads queue their remainder */
+        IoRing ring;
+
+        if (!SetupRing(ring, async_queue_depth)) {
+            CloseRing(ring);
+
+            return false;
+        }
+
+        std::vector<RingFile> files(paths.size());
+        std::deque<RingRead> reads;     // stable addresses: the kernel reads the iovecs
+        std::deque<std::size_t> waiting;
+        std::vector<std::size_t> landed;
+        std::size_t completed = 0;
+        unsigned int in_flight = 0;
+
+        auto queue_read = [&](std::size_t file, std::size_t offset) {
+            auto length = std::min(async_read_chunk, files[file].bytes.size() - offset);
+
+            reads.push_back({file, offset, {files[file].bytes.data() + offset, length}});
+            waiting.push_back(reads.size() - 1);
+        };
+
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            OpenRingFile(paths[i], files[i]);
+
+            if (files[i].bytes.empty()) {
+                landed.push_back(i);
+            } else {
+                queue_read(i, 0);
+            }
+        }
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            for (auto offset = async_read_chunk; offset < files[i].bytes.size(); offset += async_read_chunk) {
+                queue_read(i, offset);
+            }
+        }
+
+        while (true) {
+            // hand over what landed; decoders start while the rest is still being read
+            for (auto file: landed) {
+                close(files[file].fd);
+                on_read(file, std::move(files[file].bytes));
+                ++completed;
+            }
+            landed.clear();
+
+            if (completed == paths.size()) {
+                break;
+            }
+
+            // fill the submission queue, visible to the kernel once the tail moves
+            auto sq_tail = *ring.sq_tail;
+
+            while (!waiting.empty() && in_flight < ring.entries) {
+                auto read_index = waiting.front();
+                const auto &read = reads[read_index];
+                auto slot = sq_tail & *ring.sq_mask;
+                auto &sqe = ring.sqes[slot];
+
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READV;
+                sqe.fd = files[read.file].fd;
+                sqe.off = read.offset;
+                sqe.addr = reinterpret_cast<std::uint64_t>(&read.target);
+                sqe.len = 1;
+                sqe.user_data = read_index;
+
+                ring.sq_array[slot] = slot;
+                waiting.pop_front();
+                ++sq_tail;
+                ++in_flight;
+            }
+            std::atomic_ref<unsigned int>(*ring.sq_tail).store(sq_tail, std::memory_order_release);
+
+            // submit what the kernel has not consumed yet and wait for at least one completion
+            auto to_submit = sq_tail - std::atomic_ref<unsigned int>(*ring.sq_head).load(std::memory_order_acquire);
+
+            if (syscall(__NR_io_uring_enter, ring.fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                errno != EINTR) {
+                std::cout << "io_uring_enter failed: " << std::strerror(errno) << std::endl;
+
+                exit(EXIT_FAILURE);
+            }
+
+            auto cq_head = *ring.cq_head;
+            auto cq_tail = std::atomic_ref<unsigned int>(*ring.cq_tail).load(std::memory_order_acquire);
+
+            for (; cq_head != cq_tail; ++cq_head) {
+                const auto &cqe = ring.cqes[cq_head & *ring.cq_mask];
+                auto read_index = (std::size_t) cqe.user_data;
+                auto result = cqe.res;
+                auto &read = reads[read_index];
+                auto &file = files[read.file];
+
+                --in_flight;
+
+                if (result == -EAGAIN || result == -EINTR) {
+                    waiting.push_back(read_index);
+                    continue;
+                }
+                if (result <= 0) {
+                    // 0 is an end of file before the size seen at open
+                    ReadFailed(paths[read.file], result < 0 ? -result : EIO);
+                }
+
+                auto length = (std::size_t) result;
+
+                if (length < read.target.iov_len) {
+                    read.offset += length;
+                    read.target.iov_base = static_cast<unsigned char *>(read.target.iov_base) + length;
+                    read.target.iov_len -= length;
+                    waiting.push_back(read_index);
+                }
+                file.remaining -= length;
+
+                if (file.remaining == 0) {
+                    landed.push_back(read.file);
+                }
+            }
+            std::atomic_ref<unsigned int>(*ring.cq_head).store(cq_head, std::memory_order_release);
+        }
+
+        CloseRing(ring);
+
+        return true;
+    }
+#endif
+}
+
+std::string IoBackendName(IoBackend backend) {
+    return backend == IoBackend::io_uring ? "io_uring" : "threads";
+}
+
+IoBackend ReadFilesAsync(const std::vector<std::string> &paths, const ReadCallback &on_read) {
+    // io_uring when the kernel has it, I/O threads otherwise
+#ifdef DRAGON_GL_IO_URING
+    if (ReadWithRing(paths, on_read)) {
+        return IoBackend::io_uring;
+    }
+#endif
+    return ReadWithThreads(paths, on_read);
+}
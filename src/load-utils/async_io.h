@@ -0,0 +1,59 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_ASYNC_IO_H
+#define DRAGON_GL_ASYNC_IO_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#define DRAGON_GL_IO_URING
+#endif
+
+/* Reads a batch of files at once and hands each one over as soon as it is complete, in completion order, so
+ * decoding overlaps the reads still in flight and a batch takes about as long as its slowest file. On Linux the
+ * reads go through an io_uring: every file is split in 1 MB reads at aligned offsets, up to the queue depth in
+ * flight, and read-ahead of the whole file is requested from the kernel when it is opened. Where io_uring is
+ * missing or refused (old kernels, seccomp in containers), a few I/O threads do blocking reads instead; they are
+ * not the job system's workers, which stay free for decoding */
+using ByteList = std::vector<unsigned char>;
+
+const unsigned int async_queue_depth = 64;      // reads in flight in the ring
+const std::size_t async_read_chunk = 1 << 20;   // bytes per read
+const unsigned int async_io_threads = 8;        // blocking reads in flight without io_uring
+
+enum class IoBackend {
+    io_uring,
+    threads
+};
+
+// Called on the thread that issued the batch, with the file's index in the batch
+using ReadCallback = std::function<void(std::size_t file, ByteList &&bytes)>;
+
+std::string IoBackendName(IoBackend backend);
+IoBackend ReadFilesAsync(const std::vector<std::string> &paths, const ReadCallback &on_read);
+
+#endif // DRAGON_GL_ASYNC_IO_H
@@ -0,0 +1,314 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "huffman.h"
+
+namespace {
+    void WriteU32(std::vector<std::uint8_t> &out, std::uint32_t value) {
+        // Little endian
+        for (int i = 0; i < 4; ++i) {
+            out.push_back((std::uint8_t) (value >> (8 * i)));
+        }
+    }
+
+    std::uint32_t ReadU32(const std::uint8_t *in) {
+        return (std::uint32_t) in[0] | (std::uint32_t) in[1] << 8 | (std::uint32_t) in[2] << 16 |
+               (std::uint32_t) in[3] << 24;
+    }
+
+    std::array<std::uint32_t, 256> CanonicalCodes(const HuffmanLengths &lengths) {
+        // Codes by increasing length, then symbol; returned bit reversed for LSB first packing
+        std::array<std::uint32_t, huffman_max_bits + 2> length_count{};
+        std::array<std::uint32_t, huffman_max_bits + 2> next_code{};
+        std::array<std::uint32_t, 256> codes{};
+
+        for (auto length: lengths) {
+            length_count[length]++;
+        }
+        length_count[0] = 0;
+
+        std::uint32_t code = 0;
+
+        for (unsigned int bits = 1; bits <= huffman_max_bits; ++bits) {
+            code = (code + length_count[bits - 1]) << 1;
+            next_code[bits] = code;
+        }
+        for (unsigned int symbol = 0; symbol < 256; ++symbol) {
+            auto length = lengths[symbol];
+
+            if (length == 0) {
+                continue;
+            }
+            auto canonical = next_code[length]++;
+            std::uint32_t reversed = 0;
+
+            for (unsigned int bit = 0; bit < length; ++bit) {
+                reversed |= ((canonical >> bit) & 1u) << (length - 1 - bit);
+            }
+            codes[symbol] = reversed;
+        }
+        return codes;
+    }
+}
+
+HuffmanLengths BuildCodeLengths(const std::array<std::uint64_t, 256> &frequencies) {
+    /* Plain Huffman tree over the used symbols; while the deepest code is too long, frequencies are
+     * halved (never to zero) and the tree rebuilt. This flattens the tree at a tiny cost in ratio */
+    HuffmanLengths lengths{};
+    auto weights = frequencies;
+
+    while (true) {
+        struct Node {
+            std::uint64_t weight;
+            int parent;
+        };
+        std::vector<Node> nodes;
+        std::priority_queue<std::pair<std::uint64_t, int>, std::vector<std::pair<std::uint64_t, int>>,
+                            std::greater<>> queue;
+
+        for (unsigned int symbol = 0; symbol < 256; ++symbol) {
+            if (weights[symbol] > 0) {
+                queue.emplace(weights[symbol], (int) nodes.size());
+                nodes.push_back({weights[symbol], -1});
+            }
+        }
+        auto leaf_count = nodes.size();
+
+        lengths.fill(0);
+
+        if (leaf_count == 0) {
+            return lengths;
+        }
+        if (leaf_count == 1) {
+            // a lone symbol still needs a 1 bit code
+            for (unsigned int symbol = 0; symbol < 256; ++symbol) {
+                lengths[symbol] = weights[symbol] > 0 ? 1 : 0;
+            }
+            return lengths;
+        }
+
+        while (queue.size() > 1) {
+            auto [weight_a, a] = queue.top();
+            queue.pop();
+            auto [weight_b, b] = queue.top();
+            queue.pop();
+
+            nodes[a].parent = (int) nodes.size();
+            nodes[b].parent = (int) nodes.size();
+            queue.emplace(weight_a + weight_b, (int) nodes.size());
+            nodes.push_back({weight_a + weight_b, -1});
+        }
+
+        // parents are created after their children, so depths resolve from the root down
+        std::vector<unsigned int> depth(nodes.size(), 0);
+        unsigned int max_depth = 0;
+
+        for (auto i = (int) nodes.size() - 2; i >= 0; --i) {
+            depth[i] = depth[nodes[i].parent] + 1;
+            max_depth = std::max(max_depth, depth[i]);
+        }
+
+        if (max_depth <= huffman_max_bits) {
+            std::size_t leaf = 0;
+
+            for (unsigned int symbol = 0; symbol < 256; ++symbol) {
+                if (weights[symbol] > 0) {
+                    lengths[symbol] = (std::uint8_t) depth[leaf++];
+                }
+            }
+            return lengths;
+        }
+
+        for (auto &weight: weights) {
+            weight = weight > 0 ? (weight + 1) / 2 : 0;
+        }
+    }
+}
+
+void HuffmanEncode(const std::uint8_t *data, std::size_t size, std::vector<std::uint8_t> &out) {
+    // Appends one block holding 'size' bytes
+    std::array<std::uint64_t, 256> frequencies{};
+
+    for (std::size_t i = 0; i < size; ++i) {
+        frequencies[data[i]]++;
+    }
+    auto lengths = BuildCodeLengths(frequencies);
+    auto codes = CanonicalCodes(lengths);
+    auto quarter = (size + huffman_streams - 1) / huffman_streams;
+
+    WriteU32(out, (std::uint32_t) size);
+
+    auto sizes_offset = out.size();
+
+    out.resize(out.size() + 4 * huffman_streams);  // bitstream sizes, patched below
+
+    for (unsigned int symbol = 0; symbol < 256; symbol += 2) {
+        out.push_back((std::uint8_t) (lengths[symbol] | lengths[symbol + 1] << 4));
+    }
+
+    for (unsigned int stream = 0; stream < huffman_streams; ++stream) {
+        auto begin = std::min(size, stream * quarter);
+        auto end = std::min(size, begin + quarter);
+        auto stream_start = out.size();
+        std::uint64_t bit_buffer = 0;
+        unsigned int bit_count = 0;
+
+        for (auto i = begin; i < end; ++i) {
+            bit_buffer |= (std::uint64_t) codes[data[i]] << bit_count;
+            bit_count += lengths[data[i]];
+
+            while (bit_count >= 8) {
+                out.push_back((std::uint8_t) bit_buffer);
+                bit_buffer >>= 8;
+                bit_count -= 8;
+            }
+        }
+        if (bit_count > 0) {
+            out.push_back((std::uint8_t) bit_buffer);
+        }
+        out.insert(out.end(), huffman_padding, 0);
+
+        auto stream_size = (std::uint32_t) (out.size() - stream_start);
+
+        std::memcpy(out.data() + sizes_offset + 4 * stream, &stream_size, sizeof(stream_size));
+    }
+}
+
+namespace {
+    // Window of 11 bits -> symbol << 8 | code length
+    using DecodeTable = std::array<std::uint16_t, 1u << huffman_max_bits>;
+
+    struct BitReader {
+        const std::uint8_t *read;
+        const std::uint8_t *end;
+        std::uint64_t bit_buffer = 0;
+        unsigned int bit_count = 0;
+
+        bool Refill() {
+            // Tops the buffer up to at least 56 bits (little endian hosts)
+            if (read + 8 > end) {
+                return false;
+            }
+            std::uint64_t word;
+            std::memcpy(&word, read, sizeof(word));
+
+            bit_buffer |= word << bit_count;
+            read += (63 - bit_count) >> 3;
+            bit_count |= 56;
+
+            return true;
+        }
+
+        std::uint8_t Decode(const DecodeTable &table) {
+            auto entry = table[bit_buffer & ((1u << huffman_max_bits) - 1)];
+            auto length = entry & 0xffu;
+
+            bit_buffer >>= length;
+            bit_count -= length;
+
+            return (std::uint8_t) (entry >> 8);
+        }
+    };
+}
+
+const std::uint8_t *HuffmanDecode(const std::uint8_t *in, const std::uint8_t *in_end, std::uint8_t *out,
+                                  std::size_t out_size) {
+    /* Decodes one block of exactly 'out_size' bytes; returns the end of the block, or nullptr if the
+     * block is malformed */
+    if (in_end - in < (std::ptrdiff_t) huffman_header_size || ReadU32(in) != out_size) {
+        return nullptr;
+    }
+
+    std::array<BitReader, huffman_streams> readers;
+    auto stream = in + huffman_header_size;
+
+    for (unsigned int i = 0; i < huffman_streams; ++i) {
+        auto stream_size = ReadU32(in + 4 + 4 * i);
+
+        if (stream_size < huffman_padding || (std::size_t) (in_end - stream) < stream_size) {
+            return nullptr;
+        }
+        readers[i].read = stream;
+        readers[i].end = stream + stream_size;
+        stream += stream_size;
+    }
+
+    HuffmanLengths lengths{};
+    auto lengths_in = in + 4 + 4 * huffman_streams;
+    unsigned int used_symbols = 0;
+
+    for (unsigned int symbol = 0; symbol < 256; symbol += 2) {
+        lengths[symbol] = lengths_in[symbol / 2] & 0xf;
+        lengths[symbol + 1] = lengths_in[symbol / 2] >> 4;
+
+        if (lengths[symbol] > huffman_max_bits || lengths[symbol + 1] > huffman_max_bits) {
+            return nullptr;
+        }
+        used_symbols += (lengths[symbol] > 0) + (lengths[symbol + 1] > 0);
+    }
+
+    // A single used symbol is common for the high bytes of small deltas; no bits to read at all
+    if (used_symbols == 1) {
+        auto symbol = std::find_if(lengths.begin(), lengths.end(), [](auto length) { return length > 0; });
+
+        std::memset(out, (int) (symbol - lengths.begin()), out_size);
+
+        return stream;
+    }
+
+    // Unused windows decode as symbol 0
+    DecodeTable table;
+    table.fill(huffman_max_bits);
+
+    auto codes = CanonicalCodes(lengths);
+
+    for (unsigned int symbol = 0; symbol < 256; ++symbol) {
+        auto length = lengths[symbol];
+
+        if (length == 0) {
+            continue;
+        }
+        for (auto window = codes[symbol]; window < table.size(); window += 1u << length) {
+            table[window] = (std::uint16_t) (symbol << 8 | length);
+        }
+    }
+
+    // The last quarter is the shortest; all 4 readers run in lockstep over its length, 5 symbols per refill
+    auto quarter = (out_size + huffman_streams - 1) / huffman_streams;
+    auto lockstep = out_size - std::min(out_size, (huffman_streams - 1) * quarter);
+    std::size_t i = 0;
+
+    for (; i + 5 <= lockstep; i += 5) {
+        bool refilled = true;
+
+        for (auto &reader: readers) {
+            refilled &= reader.Refill();
+        }
+        if (!refilled) {
+            return nullptr;
+        }
+        for (std::size_t j = i; j < i + 5; ++j) {
+            out[j] = readers[0].Decode(table);
+            out[quarter + j] = readers[1].Decode(table);
+            out[2 * quarter + j] = readers[2].Decode(table);
+            out[3 * quarter + j] = readers[3].Decode(table);
+        }
+    }
+
+    // Tails, one reader at a time
+    for (unsigned int r = 0; r < huffman_streams; ++r) {
+        auto begin = std::min(out_size, r * quarter);
+        auto end = std::min(out_size, begin + quarter);
+
+        for (auto j = begin + i; j < end;) {
+            if (!readers[r].Refill()) {
+                return nullptr;
+            }
+            for (auto batch_end = std::min(end, j + 5); j < batch_end; ++j) {
+                out[j] = readers[r].Decode(table);
+            }
+        }
+    }
+    return stream;
+}
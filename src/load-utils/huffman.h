@@ -0,0 +1,34 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_HUFFMAN_H
+#define DRAGON_GL_HUFFMAN_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+/* Canonical, length-limited Huffman coding of byte streams. A block is
+ *   uint32 symbol count | uint32 bitstream sizes[4] | 256 code lengths as nibbles | bitstreams
+ * with codes packed LSB first. The input is split into 4 quarters with their own bitstream, so the
+ * decoder can interleave 4 independent lookup chains. Limiting codes to 11 bits keeps the decode table
+ * in L1 and lets every reader pull 5 symbols per 64-bit refill.
+ * https://fgiesen.wordpress.com/2018/02/20/reading-bits-in-far-too-many-ways-part-2/ */
+const unsigned int huffman_max_bits = 11;
+const unsigned int huffman_streams = 4;
+const std::size_t huffman_header_size = 4 + 4 * huffman_streams + 128;
+const std::size_t huffman_padding = 16;  // zero bytes after each bitstream; the readers load 8 bytes at a time
+
+using HuffmanLengths = std::array<std::uint8_t, 256>;
+
+HuffmanLengths BuildCodeLengths(const std::array<std::uint64_t, 256> &frequencies);
+void HuffmanEncode(const std::uint8_t *data, std::size_t size, std::vector<std::uint8_t> &out);
+const std::uint8_t *HuffmanDecode(const std::uint8_t *in, const std::uint8_t *in_end, std::uint8_t *out,
+                                  std::size_t out_size);
+
+#endif // DRAGON_GL_HUFFMAN_H
@@ -22,9 +22,25 @@ ImagePointer ImageLoader::LoadImageFile(const std::string& image_filename, int &
     return stbi_data;
 }
 
-ImagePointer ImageLoader::WriteImageFile(const std::string& image_filename, int &width, int &height,
-                                         int components, int stride, CharBufferPtr data_buffer) {
-    // Writes an image to a file
+ImagePointer ImageLoader::LoadImageMemory(const unsigned char *bytes, int size, int &width, int &height,
+                                          int &components) {
+    // Decodes an encoded image (png, jpg...) already read into memory; safe to call from worker
+    // threads, set the flip beforehand with SetFlipOnLoad
+    auto stbi_data = stbi_load_from_memory(bytes, size, &width, &height, &components, 0);
+
+    image_data = std::make_unique<ImagePointer>(stbi_data);
+
+    return stbi_data;
+}
+
+void ImageLoader::SetFlipOnLoad(bool flip) {
+    // Global stb_image setting, shared by all threads
+    stbi_set_flip_vertically_on_load(flip);
+}
+
+bool ImageLoader::WriteImageFile(const std::string& image_filename, int &width, int &height,
+                                 int components, int stride, CharBufferPtr data_buffer) {
+    // Writes an image to a file; false on failure
     stbi_flip_vertically_on_write(true);
 
     int ret = stbi_write_png(image_filename.c_str(), width, height, components,
@@ -34,8 +50,22 @@ ImagePointer ImageLoader::WriteImageFile(const std::string& image_filename, int
         std::cerr << "ERROR: could not write image to " << image_filename << std::endl;
     }
 
-    // struggled to clean exit via glfw in the main loop; this isn't great but works
-    exit(EXIT_SUCCESS);
+    return ret != 0;
+}
+
+bool ImageLoader::EncodePng(int width, int height, int components, int stride, const unsigned char *pixels,
+                            CharBuffer &png) {
+    // Same output as WriteImageFile, appended to png instead of a file; safe to call from worker threads
+    stbi_flip_vertically_on_write(true);
+
+    auto append = [](void *context, void *data, int size) {
+        auto &buffer = *static_cast<CharBuffer *>(context);
+        auto bytes = static_cast<const char *>(data);
+
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    };
+
+    return stbi_write_png_to_func(append, &png, width, height, components, pixels, stride) != 0;
 }
 
 ImageLoader::~ImageLoader() {
@@ -24,8 +24,12 @@ public:
     ~ImageLoader();
 
     ImagePointer LoadImageFile(const std::string& image_filename, int &width, int &height, int &components);
-    static ImagePointer WriteImageFile(const std::string& image_filename, int &width, int &height,
-                                       int components, int stride, CharBufferPtr data_buffer);
+    ImagePointer LoadImageMemory(const unsigned char *bytes, int size, int &width, int &height, int &components);
+    static void SetFlipOnLoad(bool flip);
+    static bool WriteImageFile(const std::string& image_filename, int &width, int &height,
+                              int components, int stride, CharBufferPtr data_buffer);
+    static bool EncodePng(int width, int height, int components, int stride, const unsigned char *pixels,
+                          CharBuffer &png);
 };
 
 #endif // DRAGON_GL_LOAD_IMAGE_H
@@ -91,6 +91,61 @@ void LoadObjFile(const std::string &mesh_fname, Eigen::MatrixXd &vertices, Eigen
     igl::readOBJ(mesh_fname, vertices, uv_coords, discard_1, facets, discard_2, discard_3);
 }
 
+FILE *OpenBytes(const std::vector<unsigned char> &bytes, const std::string &mesh_fname) {
+    // A file already read as a stream for libigl's FILE* readers, which close it; Windows has no fmemopen and
+    // reads the file again
+#ifdef _WIN32
+    FILE *stream = std::fopen(mesh_fname.c_str(), "rb");
+#else
+    FILE *stream = fmemopen(const_cast<unsigned char *>(bytes.data()), bytes.size(), "r");
+#endif
+
+    if (!stream) {
+        std::cout << "Could not read " << mesh_fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    return stream;
+}
+
+void LoadOffBytes(const std::vector<unsigned char> &bytes, const std::string &mesh_fname, Eigen::MatrixXd &vertices,
+                  Eigen::MatrixXi &facets) {
+    // Parses an off file from memory, same result as LoadOffFile
+    std::vector<std::vector<double>> vertex_rows;
+    std::vector<std::vector<int>> facet_rows;
+    std::vector<std::vector<double>> discard_1;
+    std::vector<std::vector<double>> discard_2;
+
+    if (!igl::readOFF(OpenBytes(bytes, mesh_fname), vertex_rows, facet_rows, discard_1, discard_2)) {
+        std::cout << "Failed to parse " << mesh_fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    ListToMatrix(vertex_rows, vertices, mesh_fname);
+    ListToMatrix(facet_rows, facets, mesh_fname);
+}
+
+void LoadObjBytes(const std::vector<unsigned char> &bytes, const std::string &mesh_fname, Eigen::MatrixXd &vertices,
+                  Eigen::MatrixXi &facets, Eigen::MatrixXd &uv_coords) {
+    // Parses an obj file from memory, same result as LoadObjFile
+    std::vector<std::vector<double>> vertex_rows;
+    std::vector<std::vector<double>> uv_rows;
+    std::vector<std::vector<int>> facet_rows;
+    std::vector<std::vector<double>> discard_1;
+    std::vector<std::vector<int>> discard_2;
+    std::vector<std::vector<int>> discard_3;
+
+    if (!igl::readOBJ(OpenBytes(bytes, mesh_fname), vertex_rows, uv_rows, discard_1, facet_rows, discard_2,
+                      discard_3)) {
+        std::cout << "Failed to parse " << mesh_fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    ListToMatrix(vertex_rows, vertices, mesh_fname);
+    ListToMatrix(facet_rows, facets, mesh_fname);
+    ListToMatrix(uv_rows, uv_coords, mesh_fname);
+}
+
 
 std::pair<FaceInfo, NeighboringFaces> ProcessFacets(const Eigen::MatrixXd &vertices,
                                                     const Eigen::MatrixXi &facets,
@@ -156,6 +211,17 @@ VertexList CreateTriangles(const Eigen::MatrixXd &vertices, const Eigen::MatrixX
 
     centroids.resize(facets.rows(), 3);
 
+    // the result of ProcessFacets and the copies of it above all live until the end
+    std::size_t neighbor_bytes = neighboring_faces.capacity() * sizeof(std::vector<unsigned int>);
+
+    for (const auto &neighbors: neighboring_faces) {
+        neighbor_bytes += neighbors.capacity() * sizeof(unsigned int);
+    }
+    MemoryTag face_memory(MemoryCategory::cpu_face_info,
+                          (faces.first.capacity() + vinfo.capacity()) * sizeof(FacetInfo));
+    MemoryTag neighbor_memory(MemoryCategory::cpu_neighbors, 2 * neighbor_bytes);
+    MemoryTag centroid_memory(MemoryCategory::cpu_mesh_source, MatrixBytes(centroids));
+
     // Create vertices
     for (unsigned int i = 0; i < facets.rows(); ++i) {
         auto pos_a = facets(i, 0);
@@ -241,6 +307,111 @@ VertexList CreateTriangles(const Eigen::MatrixXd &vertices, const Eigen::MatrixX
     return tris;
 }
 
+std::uint64_t MortonCode(std::uint32_t x, std::uint32_t y, std::uint32_t z) {
+    // Interleaves the low 21 bits of each coordinate, x lowest
+    auto spread = [](std::uint64_t v) {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffull;
+        v = (v | v << 16) & 0x1f0000ff0000ffull;
+        v = (v | v << 8) & 0x100f00f00f00f00full;
+        v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+        v = (v | v << 2) & 0x1249249249249249ull;
+        return v;
+    };
+    return spread(x) | spread(y) << 1 | spread(z) << 2;
+}
+
+void SortPoints(VertexList &points) {
+    // Morton order on a 2^21 grid over the bounding box: points next to each other in the list are next to each
+    // other in space, so the invocations of a work group splat to nearby pixels
+    if (points.empty()) {
+        return;
+    }
+    GlmVec3 low = points.front().pos;
+    GlmVec3 high = points.front().pos;
+
+    for (const auto &point: points) {
+        low = glm::min(low, point.pos);
+        high = glm::max(high, point.pos);
+    }
+
+    auto cells = glm::vec3((float) ((1u << 21) - 1)) / glm::max(high - low, glm::vec3(1e-20f));
+    std::vector<std::pair<std::uint64_t, std::size_t>> order(points.size());
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        auto cell = glm::clamp((points[i].pos - low) * cells, 0.0f, (float) ((1u << 21) - 1));
+
+        order[i] = {MortonCode((std::uint32_t) cell.x, (std::uint32_t) cell.y, (std::uint32_t) cell.z), i};
+    }
+    std::sort(order.begin(), order.end());
+
+    VertexList sorted(points.size());
+
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        sorted[i] = points[order[i].second];
+    }
+    points.swap(sorted);
+}
+
+VertexList CreatePoints(const Eigen::MatrixXd &vertices, const Eigen::MatrixXi &facets) {
+    // One vertex per loaded vertex, no triangles. The normal is the sum of the normals of the faces around the
+    // vertex, normalized; a bare point cloud has no faces and gets zero normals
+    std::vector<Eigen::Vector3d> normal_sums(vertices.rows(), Eigen::Vector3d::Zero());
+    MemoryTag normal_memory(MemoryCategory::cpu_face_info, normal_sums.size() * sizeof(Eigen::Vector3d));
+
+    for (unsigned int i = 0; facets.cols() >= 3 && i < facets.rows(); ++i) {
+        Eigen::Vector3d a = vertices.row(facets(i, 0));
+        Eigen::Vector3d b = vertices.row(facets(i, 1));
+        Eigen::Vector3d c = vertices.row(facets(i, 2));
+        Eigen::Vector3d face_normal = ComputeTriangleNormal(a, b, c);
+
+        // degenerate faces have no direction
+        if (!face_normal.allFinite()) {
+            continue;
+        }
+        for (int corner = 0; corner < 3; ++corner) {
+            normal_sums[facets(i, corner)] += face_normal;
+        }
+    }
+
+    VertexList points(vertices.rows());
+
+    for (unsigned int i = 0; i < vertices.rows(); ++i) {
+        auto normal = normal_sums[i].norm() > 0.0 ? Eigen::Vector3d(normal_sums[i].normalized()) :
+                      Eigen::Vector3d(0, 0, 0);
+
+        points[i].pos = VecPosition(vertices(i, 0), vertices(i, 1), vertices(i, 2));
+        points[i].normal = VecNormal(normal.x(), normal.y(), normal.z());
+    }
+    SortPoints(points);
+
+    return points;
+}
+
+VertexList WeldPoints(const VertexList &corners) {
+    // Points of a triangle list (eg. a decoded .dmc): corners with bitwise equal positions are one point
+    using Key = std::array<std::uint32_t, 3>;
+
+    std::vector<std::pair<Key, std::size_t>> sorted(corners.size());
+
+    for (std::size_t i = 0; i < corners.size(); ++i) {
+        std::memcpy(sorted[i].first.data(), &corners[i].pos, sizeof(Key));
+        sorted[i].second = i;
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    VertexList points;
+
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+            points.push_back(corners[sorted[i].second]);
+        }
+    }
+    SortPoints(points);
+
+    return points;
+}
+
 VertexList LoadDragonOff(const std::string &mesh_fname, ShadingOption opt) {
     // Load dragon (or bunny) .off file
     Eigen::MatrixXd m_vertices;
@@ -248,7 +419,10 @@ VertexList LoadDragonOff(const std::string &mesh_fname, ShadingOption opt) {
 
     LoadOffFile(mesh_fname, m_vertices, m_faces);
 
-    auto tris = CreateTriangles(m_vertices, m_faces, std::nullopt, opt);
+    MemoryTag source_memory(MemoryCategory::cpu_mesh_source, MatrixBytes(m_vertices) + MatrixBytes(m_faces));
+
+    auto tris = opt == ShadingOption::point_splats ? CreatePoints(m_vertices, m_faces) :
+                CreateTriangles(m_vertices, m_faces, std::nullopt, opt);
 
     return tris;
 }
@@ -261,7 +435,43 @@ VertexList LoadDragonObj(const std::string &mesh_fname, ShadingOption opt) {
 
     LoadObjFile(mesh_fname, m_vertices, m_faces, m_uvcoords);
 
-    auto tris = CreateTriangles(m_vertices, m_faces, m_uvcoords, opt);
+    MemoryTag source_memory(MemoryCategory::cpu_mesh_source, MatrixBytes(m_vertices) + MatrixBytes(m_faces) +
+                                                             MatrixBytes(m_uvcoords));
+
+    auto tris = opt == ShadingOption::point_splats ? CreatePoints(m_vertices, m_faces) :
+                CreateTriangles(m_vertices, m_faces, m_uvcoords, opt);
 
     return tris;
 }
+
+VertexList LoadDragonOff(const std::string &mesh_fname, const std::vector<unsigned char> &bytes, ShadingOption opt) {
+    // Load an .off file already read into memory
+    Eigen::MatrixXd m_vertices;
+    Eigen::MatrixXi m_faces;
+
+    LoadOffBytes(bytes, mesh_fname, m_vertices, m_faces);
+
+    MemoryTag source_memory(MemoryCategory::cpu_mesh_source, MatrixBytes(m_vertices) + MatrixBytes(m_faces));
+
+    if (opt == ShadingOption::point_splats) {
+        return CreatePoints(m_vertices, m_faces);
+    }
+    return CreateTriangles(m_vertices, m_faces, std::nullopt, opt);
+}
+
+VertexList LoadDragonObj(const std::string &mesh_fname, const std::vector<unsigned char> &bytes, ShadingOption opt) {
+    // Load an .obj file already read into memory
+    Eigen::MatrixXd m_vertices;
+    Eigen::MatrixXi m_faces;
+    Eigen::MatrixXd m_uvcoords;
+
+    LoadObjBytes(bytes, mesh_fname, m_vertices, m_faces, m_uvcoords);
+
+    MemoryTag source_memory(MemoryCategory::cpu_mesh_source, MatrixBytes(m_vertices) + MatrixBytes(m_faces) +
+                                                             MatrixBytes(m_uvcoords));
+
+    if (opt == ShadingOption::point_splats) {
+        return CreatePoints(m_vertices, m_faces);
+    }
+    return CreateTriangles(m_vertices, m_faces, m_uvcoords, opt);
+}
@@ -6,7 +6,13 @@
 #ifndef DRAGON_GL_LOAD_UTILS_H
 #define DRAGON_GL_LOAD_UTILS_H
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -18,10 +24,12 @@
 
 #include <Eigen/Dense>
 
+#include <igl/list_to_matrix.h>
 #include <igl/readOFF.h>
 #include <igl/readOBJ.h>
 
 #include "attributes.h"
+#include "../pipeline/memory_tracker.h"
 
 struct FacetInfo {
     Eigen::Vector3d face_normal;
@@ -32,12 +40,29 @@ using VertexList = std::vector<Vertex>;
 using FaceInfo = std::vector<FacetInfo>;
 using NeighboringFaces = std::vector<std::vector<unsigned int>>;
 
+// Bytes held by an Eigen matrix
+template<typename Matrix>
+std::size_t MatrixBytes(const Matrix &matrix) {
+    return (std::size_t) matrix.size() * sizeof(typename Matrix::Scalar);
+}
+
+// Rows of a mesh read by libigl's list readers as a matrix; rows of different sizes (eg. quads) are rejected
+template<typename Scalar, typename Matrix>
+void ListToMatrix(const std::vector<std::vector<Scalar>> &rows, Matrix &matrix, const std::string &mesh_fname) {
+    if (!igl::list_to_matrix(rows, matrix)) {
+        std::cout << mesh_fname << ": only triangle meshes are supported" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+}
+
 // Filesystem paths
 const std::string data_dir = DATA_DIR;  // injected by cmake
 const std::string mesh_off_filename(data_dir + "dragon.off");
 const std::string mesh_obj_filename(data_dir + "dragon.obj");
 const std::string mesh_off_bunny_filename(data_dir + "bunny.off");
 const std::string output_filename("output.png");
+const std::string golden_dir(data_dir + "golden/");
 
 const std::string texture_diffuse_filename(data_dir + "texture/DefaultMaterial_albedo.jpg");
 const std::string texture_normal_map_filename(data_dir + "texture/DefaultMaterial_normal.png");
@@ -45,6 +70,15 @@ const std::string texture_normal_map_filename(data_dir + "texture/DefaultMateria
 const std::string per_vertex_dir = SHADERS_GOURAUD_DIR; // injected by cmake
 const std::string normal_mapping_dir = SHADERS_NORMAL_MAPPING_DIR;
 const std::string flat_dir = SHADERS_FLAT_DIR;
+const std::string deferred_dir = SHADERS_DEFERRED_DIR;
+const std::string present_dir = SHADERS_PRESENT_DIR;
+const std::string clustered_dir = SHADERS_CLUSTERED_DIR;
+const std::string depth_dir = SHADERS_DEPTH_DIR;
+const std::string overdraw_dir = SHADERS_OVERDRAW_DIR;
+const std::string antialiasing_dir = SHADERS_ANTIALIASING_DIR;
+const std::string impostor_dir = SHADERS_IMPOSTOR_DIR;
+const std::string deform_dir = SHADERS_DEFORM_DIR;
+const std::string points_dir = SHADERS_POINTS_DIR;
 
 void ExistsOk(const std::string &filename);
 std::string GetVertexShaderPath(ShadingOption opt);
@@ -60,13 +94,24 @@ Eigen::Vector3d ComputeTriangleNormal(const Eigen::Vector3d &a, const Eigen::Vec
 void LoadOffFile(const std::string &mesh_fname, Eigen::MatrixXd &vertices, Eigen::MatrixXi &facets);
 void LoadObjFile(const std::string &mesh_fname, Eigen::MatrixXd &vertices, Eigen::MatrixXi &facets,
                  Eigen::MatrixXd &uv_coords);
+FILE *OpenBytes(const std::vector<unsigned char> &bytes, const std::string &mesh_fname);
+void LoadOffBytes(const std::vector<unsigned char> &bytes, const std::string &mesh_fname, Eigen::MatrixXd &vertices,
+                  Eigen::MatrixXi &facets);
+void LoadObjBytes(const std::vector<unsigned char> &bytes, const std::string &mesh_fname, Eigen::MatrixXd &vertices,
+                  Eigen::MatrixXi &facets, Eigen::MatrixXd &uv_coords);
 
 std::pair<FaceInfo, NeighboringFaces> ProcessFacets(const Eigen::MatrixXd &vertices,
                                                     const Eigen::MatrixXi &facets,
                                                     const std::optional<Eigen::MatrixXd> &uv_coords);
 VertexList CreateTriangles(const Eigen::MatrixXd &vertices, const Eigen::MatrixXi &facets,
                            const std::optional<Eigen::MatrixXd> &uv_coords, ShadingOption opt);
+std::uint64_t MortonCode(std::uint32_t x, std::uint32_t y, std::uint32_t z);
+void SortPoints(VertexList &points);
+VertexList CreatePoints(const Eigen::MatrixXd &vertices, const Eigen::MatrixXi &facets);
+VertexList WeldPoints(const VertexList &corners);
 VertexList LoadDragonOff(const std::string &mesh_fname, ShadingOption opt);
 VertexList LoadDragonObj(const std::string &mesh_fname, ShadingOption opt);
+VertexList LoadDragonOff(const std::string &mesh_fname, const std::vector<unsigned char> &bytes, ShadingOption opt);
+VertexList LoadDragonObj(const std::string &mesh_fname, const std::vector<unsigned char> &bytes, ShadingOption opt);
 
 #endif // DRAGON_GL_LOAD_UTILS_H
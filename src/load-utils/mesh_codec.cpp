@@ -0,0 +1,592 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "mesh_codec.h"
+
+namespace {
+    using ByteStream = std::vector<std::uint8_t>;
+
+    // Ring buffer; Get(0) is the most recent item
+    template<typename T, unsigned int N>
+    struct Fifo {
+        std::array<T, N> items;
+        unsigned int head = 0;
+
+        explicit Fifo(T empty) {
+            items.fill(empty);
+        }
+
+        void Push(T item) {
+            items[head++ % N] = item;
+        }
+
+        T Get(unsigned int i) const {
+            return items[(head - 1 - i) % N];
+        }
+    };
+
+    std::uint64_t Edge(std::uint32_t a, std::uint32_t b) {
+        return (std::uint64_t) a << 32 | b;
+    }
+
+    std::uint32_t ZigZag(std::int32_t value) {
+        return ((std::uint32_t) value << 1) ^ (std::uint32_t) (value >> 31);
+    }
+
+    std::int32_t UnZigZag(std::uint32_t value) {
+        return (std::int32_t) (value >> 1) ^ -(std::int32_t) (value & 1);
+    }
+
+    void WriteVarint(ByteStream &out, std::uint32_t value) {
+        // 7 bits per byte, high bit set while more bytes follow
+        while (value >= 0x80) {
+            out.push_back((std::uint8_t) (value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((std::uint8_t) value);
+    }
+
+    bool ReadVarint(const std::uint8_t *&in, const std::uint8_t *end, std::uint32_t &value) {
+        value = 0;
+
+        for (unsigned int shift = 0; shift < 35; shift += 7) {
+            if (in == end) {
+                return false;
+            }
+            auto byte = *in++;
+
+            value |= (std::uint32_t) (byte & 0x7f) << shift;
+
+            if (byte < 0x80) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void AppendEncoded(ByteStream &out, const ByteStream &stream) {
+        HuffmanEncode(stream.data(), stream.size(), out);
+    }
+
+    const std::uint8_t *DecodeStream(const std::uint8_t *in, const std::uint8_t *end, ByteStream &stream) {
+        // Streams whose size is not known up front carry it in the Huffman block header
+        if (end - in < 4) {
+            return nullptr;
+        }
+        std::uint32_t size;
+        std::memcpy(&size, in, sizeof(size));
+
+        stream.resize(size);
+
+        return HuffmanDecode(in, end, stream.data(), size);
+    }
+
+    ByteStream EncodeIndexChunk(const std::uint32_t *indices, std::uint32_t face_count, std::uint32_t first_vertex) {
+        /* One code byte per triangle that shares an edge with a recent triangle: the edge's FIFO slot and
+         * how to find the third vertex. Other triangles spend a second byte on their three vertex codes.
+         * Vertices are numbered by first use, so a new vertex is always 'next' and costs no index */
+        Fifo<std::uint64_t, edge_fifo_size> edges(~0ull);
+        Fifo<std::uint32_t, vertex_fifo_size> vertices(~0u);
+        std::uint32_t next = first_vertex;
+        std::uint32_t last = first_vertex;
+        ByteStream codes;
+        ByteStream extra;  // explicit indices, zigzag deltas from the previous explicit or new vertex
+
+        auto vertex_code = [&](std::uint32_t vertex) -> std::uint8_t {
+            if (vertex == next) {
+                next++;
+                last = vertex;
+                vertices.Push(vertex);
+
+                return vertex_code_new;
+            }
+            for (unsigned int i = 0; i < vertex_fifo_search; ++i) {
+                if (vertices.Get(i) == vertex) {
+                    return (std::uint8_t) (i + 1);
+                }
+            }
+            WriteVarint(extra, ZigZag((std::int32_t) (vertex - last)));
+            last = vertex;
+            vertices.Push(vertex);
+
+            return vertex_code_explicit;
+        };
+
+        codes.reserve(face_count + face_count / 4);
+
+        for (std::uint32_t face = 0; face < face_count; ++face) {
+            const std::uint32_t *tri = indices + 3 * face;
+
+            // The rotation whose leading edge sits in the most recent FIFO slot
+            int rotation = -1;
+            unsigned int slot = edge_fifo_search;
+
+            for (int r = 0; r < 3; ++r) {
+                auto edge = Edge(tri[r], tri[(r + 1) % 3]);
+
+                for (unsigned int i = 0; i < slot; ++i) {
+                    if (edges.Get(i) == edge) {
+                        rotation = r;
+                        slot = i;
+                        break;
+                    }
+                }
+            }
+
+            if (rotation >= 0) {
+                auto x = tri[rotation];
+                auto y = tri[(rotation + 1) % 3];
+                auto z = tri[(rotation + 2) % 3];
+
+                codes.push_back((std::uint8_t) (slot << 4 | vertex_code(z)));
+
+                // stored reversed, the way the neighbouring triangle walks them
+                edges.Push(Edge(z, y));
+                edges.Push(Edge(x, z));
+            } else {
+                auto code_a = vertex_code(tri[0]);
+                auto code_b = vertex_code(tri[1]);
+                auto code_c = vertex_code(tri[2]);
+
+                codes.push_back((std::uint8_t) (edge_fifo_search << 4 | code_a));
+                codes.push_back((std::uint8_t) (code_b << 4 | code_c));
+
+                edges.Push(Edge(tri[1], tri[0]));
+                edges.Push(Edge(tri[2], tri[1]));
+                edges.Push(Edge(tri[0], tri[2]));
+            }
+        }
+
+        ByteStream payload;
+
+        AppendEncoded(payload, codes);
+        AppendEncoded(payload, extra);
+
+        return payload;
+    }
+
+    bool DecodeIndexChunk(const std::uint8_t *in, const std::uint8_t *end, const CompressedMeshEntry &entry,
+                          std::uint32_t vertex_count, std::uint32_t *indices) {
+        // Mirrors EncodeIndexChunk; false on malformed input
+        ByteStream codes;
+        ByteStream extra;
+
+        in = DecodeStream(in, end, codes);
+        in = in ? DecodeStream(in, end, extra) : nullptr;
+
+        if (!in) {
+            return false;
+        }
+
+        Fifo<std::uint64_t, edge_fifo_size> edges(~0ull);
+        Fifo<std::uint32_t, vertex_fifo_size> vertices(~0u);
+        std::uint32_t next = entry.first;
+        std::uint32_t last = entry.first;
+        const std::uint8_t *code = codes.data();
+        const std::uint8_t *code_end = code + codes.size();
+        const std::uint8_t *explicit_index = extra.data();
+        const std::uint8_t *explicit_end = explicit_index + extra.size();
+        bool valid = true;
+
+        auto decode_vertex = [&](unsigned int vertex_code) -> std::uint32_t {
+            if (vertex_code == vertex_code_new) {
+                last = next++;
+                vertices.Push(last);
+
+                return last;
+            }
+            if (vertex_code != vertex_code_explicit) {
+                return vertices.Get(vertex_code - 1);
+            }
+            std::uint32_t delta;
+
+            valid &= ReadVarint(explicit_index, explicit_end, delta);
+            last += (std::uint32_t) UnZigZag(delta);
+            vertices.Push(last);
+
+            return last;
+        };
+
+        std::uint32_t max_index = 0;
+
+        for (std::uint32_t face = 0; face < entry.count; ++face) {
+            if (code == code_end) {
+                return false;
+            }
+            auto slot = (unsigned int) (*code >> 4);
+            std::uint32_t x;
+            std::uint32_t y;
+            std::uint32_t z;
+
+            if (slot < edge_fifo_search) {
+                auto edge = edges.Get(slot);
+
+                x = (std::uint32_t) (edge >> 32);
+                y = (std::uint32_t) edge;
+                z = decode_vertex(*code++ & 0xf);
+
+                edges.Push(Edge(z, y));
+                edges.Push(Edge(x, z));
+            } else {
+                if (code_end - code < 2) {
+                    return false;
+                }
+                x = decode_vertex(code[0] & 0xf);
+                y = decode_vertex(code[1] >> 4);
+                z = decode_vertex(code[1] & 0xf);
+                code += 2;
+
+                edges.Push(Edge(y, x));
+                edges.Push(Edge(z, y));
+                edges.Push(Edge(x, z));
+            }
+            indices[3 * face] = x;
+            indices[3 * face + 1] = y;
+            indices[3 * face + 2] = z;
+
+            // empty FIFO slots hold ~0 and fail here as well
+            max_index = std::max({max_index, x, y, z});
+        }
+        return valid && max_index < vertex_count;
+    }
+
+    std::vector<std::uint16_t> Quantize(const std::vector<float> &values, unsigned int stride, unsigned int bits,
+                                        float *minimum, float *step) {
+        // Per component bounding box, mapped onto [0, 2^bits - 1]
+        auto vertex_count = values.size() / stride;
+        auto max_level = (float) ((1u << bits) - 1);
+        std::vector<std::uint16_t> quantized(values.size());
+
+        for (unsigned int c = 0; c < stride; ++c) {
+            float low = vertex_count > 0 ? values[c] : 0.0f;
+            float high = low;
+
+            for (std::size_t i = 0; i < vertex_count; ++i) {
+                low = std::min(low, values[i * stride + c]);
+                high = std::max(high, values[i * stride + c]);
+            }
+            minimum[c] = low;
+            step[c] = (high - low) / max_level;
+
+            for (std::size_t i = 0; i < vertex_count; ++i) {
+                auto level = step[c] > 0 ? std::round((values[i * stride + c] - low) / step[c]) : 0.0f;
+
+                quantized[i * stride + c] = (std::uint16_t) std::clamp(level, 0.0f, max_level);
+            }
+        }
+        return quantized;
+    }
+
+    void EncodeComponents(const std::vector<std::uint16_t> &quantized, unsigned int stride, std::uint32_t first,
+                          std::uint32_t count, ByteStream &payload) {
+        // Delta filter every component, zigzag the deltas, then code low and high bytes as separate planes
+        ByteStream low(count);
+        ByteStream high(count);
+
+        for (unsigned int c = 0; c < stride; ++c) {
+            std::uint16_t previous = 0;
+
+            for (std::uint32_t i = 0; i < count; ++i) {
+                auto value = quantized[(std::size_t) (first + i) * stride + c];
+                auto delta = (std::uint16_t) (value - previous);
+                auto zigzag = (std::uint16_t) ((delta << 1) ^ (std::uint16_t) -(delta >> 15));
+
+                previous = value;
+                low[i] = (std::uint8_t) zigzag;
+                high[i] = (std::uint8_t) (zigzag >> 8);
+            }
+            AppendEncoded(payload, low);
+            AppendEncoded(payload, high);
+        }
+    }
+
+    const std::uint8_t *DecodeComponents(const std::uint8_t *in, const std::uint8_t *end, unsigned int stride,
+                                         std::uint32_t count, const float *minimum, const float *step,
+                                         float *out) {
+        // Inverse of EncodeComponents, dequantizing straight into the interleaved output
+        ByteStream low(count);
+        ByteStream high(count);
+
+        for (unsigned int c = 0; c < stride && in; ++c) {
+            in = HuffmanDecode(in, end, low.data(), count);
+            in = in ? HuffmanDecode(in, end, high.data(), count) : nullptr;
+
+            if (!in) {
+                return nullptr;
+            }
+            std::uint16_t value = 0;
+
+            for (std::uint32_t i = 0; i < count; ++i) {
+                auto zigzag = (std::uint16_t) (low[i] | high[i] << 8);
+
+                value += (std::uint16_t) ((zigzag >> 1) ^ (std::uint16_t) -(zigzag & 1));
+                out[(std::size_t) i * stride + c] = minimum[c] + (float) value * step[c];
+            }
+        }
+        return in;
+    }
+}
+
+IndexedMesh ReadIndexedMesh(const std::string &mesh_fname) {
+    // Reads an .obj or .off through the regular loaders; uv coordinates are taken per vertex, like LoadDragonObj
+    Eigen::MatrixXd vertices;
+    Eigen::MatrixXi facets;
+    Eigen::MatrixXd uv_coords;
+
+    if (std::filesystem::path(mesh_fname).extension() == ".obj") {
+        LoadObjFile(mesh_fname, vertices, facets, uv_coords);
+    } else {
+        LoadOffFile(mesh_fname, vertices, facets);
+    }
+
+    if (facets.rows() > 0 && facets.cols() != 3) {
+        std::cout << "Only triangle meshes can be compressed: " << mesh_fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    IndexedMesh mesh;
+    auto has_uv = uv_coords.rows() >= vertices.rows() && uv_coords.cols() >= 2 && vertices.rows() > 0;
+
+    for (Eigen::Index i = 0; i < vertices.rows(); ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mesh.positions.push_back((float) vertices(i, c));
+        }
+        if (has_uv) {
+            mesh.uv_coords.push_back((float) uv_coords(i, 0));
+            mesh.uv_coords.push_back((float) uv_coords(i, 1));
+        }
+    }
+    for (Eigen::Index i = 0; i < facets.rows(); ++i) {
+        for (int c = 0; c < 3; ++c) {
+            mesh.indices.push_back((std::uint32_t) facets(i, c));
+        }
+    }
+    return mesh;
+}
+
+std::vector<std::uint8_t> EncodeMesh(const IndexedMesh &mesh, unsigned int position_bits, JobSystem &jobs) {
+    // Renumbers vertices by first use (dropping unused ones), then codes chunks and blocks as jobs
+    auto source_vertices = (std::uint32_t) (mesh.positions.size() / 3);
+    auto face_count = (std::uint32_t) (mesh.indices.size() / 3);
+    auto has_uv = !mesh.uv_coords.empty();
+
+    std::vector<std::uint32_t> remap(source_vertices, ~0u);
+    std::vector<std::uint32_t> indices(mesh.indices.size());
+    std::vector<std::uint32_t> chunk_first;
+    IndexedMesh ordered;
+    std::uint32_t next = 0;
+
+    for (std::size_t i = 0; i < mesh.indices.size(); ++i) {
+        if (i % (3 * mesh_chunk_faces) == 0) {
+            chunk_first.push_back(next);
+        }
+        auto vertex = mesh.indices[i];
+
+        if (vertex >= source_vertices) {
+            std::cout << "Face index " << vertex << " is out of range" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+        if (remap[vertex] == ~0u) {
+            remap[vertex] = next++;
+
+            ordered.positions.insert(ordered.positions.end(), mesh.positions.begin() + 3 * vertex,
+                                     mesh.positions.begin() + 3 * vertex + 3);
+            if (has_uv) {
+                ordered.uv_coords.insert(ordered.uv_coords.end(), mesh.uv_coords.begin() + 2 * vertex,
+                                         mesh.uv_coords.begin() + 2 * vertex + 2);
+            }
+        }
+        indices[i] = remap[vertex];
+    }
+
+    CompressedMeshHeader header{};
+
+    header.magic = compressed_mesh_magic;
+    header.version = compressed_mesh_version;
+    header.vertex_count = next;
+    header.face_count = face_count;
+    header.has_uv = has_uv ? 1 : 0;
+    header.position_bits = std::clamp(position_bits, 10u, 16u);
+    header.chunk_count = (std::uint32_t) chunk_first.size();
+    header.block_count = (next + mesh_block_vertices - 1) / mesh_block_vertices;
+
+    auto positions = Quantize(ordered.positions, 3, header.position_bits, header.position_min,
+                              header.position_step);
+    auto uv_coords = Quantize(ordered.uv_coords, 2, uv_bits, header.uv_min, header.uv_step);
+
+    std::vector<CompressedMeshEntry> entries;
+    std::vector<std::future<ByteStream>> payloads;
+
+    for (std::uint32_t chunk = 0; chunk < header.chunk_count; ++chunk) {
+        auto first_face = chunk * mesh_chunk_faces;
+        auto count = std::min(mesh_chunk_faces, face_count - first_face);
+
+        entries.push_back({0, 0, chunk_first[chunk], count});
+        payloads.push_back(jobs.Submit([&indices, &chunk_first, first_face, count, chunk]() {
+            return EncodeIndexChunk(indices.data() + 3 * (std::size_t) first_face, count, chunk_first[chunk]);
+        }));
+    }
+    for (std::uint32_t block = 0; block < header.block_count; ++block) {
+        auto first = block * mesh_block_vertices;
+        auto count = std::min(mesh_block_vertices, next - first);
+
+        entries.push_back({0, 0, first, count});
+        payloads.push_back(jobs.Submit([&positions, &uv_coords, has_uv, first, count]() {
+            ByteStream payload;
+
+            EncodeComponents(positions, 3, first, count, payload);
+
+            if (has_uv) {
+                EncodeComponents(uv_coords, 2, first, count, payload);
+            }
+            return payload;
+        }));
+    }
+
+    // Assemble: the directory goes first so the decoder can dispatch every chunk before touching payloads
+    std::vector<std::uint8_t> file(sizeof(header) + entries.size() * sizeof(CompressedMeshEntry));
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        auto payload = jobs.Wait(payloads[i]);
+
+        entries[i].offset = file.size();
+        entries[i].size = payload.size();
+        file.insert(file.end(), payload.begin(), payload.end());
+    }
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), entries.data(), entries.size() * sizeof(CompressedMeshEntry));
+
+    return file;
+}
+
+IndexedMesh DecodeMesh(const std::uint8_t *data, std::size_t size, JobSystem *jobs, MeshDecodeStats *stats) {
+    /* Validates the directory, then decodes all index chunks and vertex blocks independently; on the job
+     * system if one is given. Returns an empty mesh for malformed input */
+    auto start = std::chrono::steady_clock::now();
+
+    CompressedMeshHeader header{};
+
+    if (size < sizeof(header)) {
+        return {};
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    auto entry_count = (std::size_t) header.chunk_count + header.block_count;
+
+    if (header.magic != compressed_mesh_magic || header.version != compressed_mesh_version ||
+        (size - sizeof(header)) / sizeof(CompressedMeshEntry) < entry_count) {
+        return {};
+    }
+    std::vector<CompressedMeshEntry> entries(entry_count);
+    std::memcpy(entries.data(), data + sizeof(header), entry_count * sizeof(CompressedMeshEntry));
+
+    // Chunks and blocks must tile the faces and vertices exactly, in order
+    std::vector<std::size_t> output_offset(entry_count);
+    std::size_t faces = 0;
+    std::size_t vertices = 0;
+
+    for (std::size_t i = 0; i < entry_count; ++i) {
+        const auto &entry = entries[i];
+        auto is_chunk = i < header.chunk_count;
+
+        if (entry.offset > size || entry.size > size - entry.offset ||
+            (!is_chunk && entry.first != vertices) || (is_chunk && entry.first > header.vertex_count)) {
+            return {};
+        }
+        output_offset[i] = is_chunk ? faces : vertices;
+        (is_chunk ? faces : vertices) += entry.count;
+    }
+    if (faces != header.face_count || vertices != header.vertex_count) {
+        return {};
+    }
+
+    IndexedMesh mesh;
+
+    mesh.positions.resize(3 * (std::size_t) header.vertex_count);
+    mesh.uv_coords.resize(header.has_uv ? 2 * (std::size_t) header.vertex_count : 0);
+    mesh.indices.resize(3 * (std::size_t) header.face_count);
+
+    std::atomic<bool> valid = true;
+
+    auto decode = [&](std::size_t begin, std::size_t end) {
+        for (auto i = begin; i < end; ++i) {
+            const auto &entry = entries[i];
+            auto in = data + entry.offset;
+            auto in_end = in + entry.size;
+
+            if (i < header.chunk_count) {
+                auto indices = mesh.indices.data() + 3 * output_offset[i];
+
+                if (!DecodeIndexChunk(in, in_end, entry, header.vertex_count, indices)) {
+                    valid = false;
+                }
+                continue;
+            }
+            in = DecodeComponents(in, in_end, 3, entry.count, header.position_min, header.position_step,
+                                  mesh.positions.data() + 3 * output_offset[i]);
+
+            if (in && header.has_uv) {
+                in = DecodeComponents(in, in_end, 2, entry.count, header.uv_min, header.uv_step,
+                                      mesh.uv_coords.data() + 2 * output_offset[i]);
+            }
+            if (!in) {
+                valid = false;
+            }
+        }
+    };
+
+    if (jobs) {
+        jobs->ParallelFor(entry_count, 1, decode);
+    } else {
+        decode(0, entry_count);
+    }
+
+    if (!valid) {
+        return {};
+    }
+
+    if (stats) {
+        stats->milliseconds = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - start).count();
+        stats->output_bytes = sizeof(float) * (mesh.positions.size() + mesh.uv_coords.size()) +
+                              sizeof(std::uint32_t) * mesh.indices.size();
+    }
+    return mesh;
+}
+
+VertexList LoadCompressedMesh(const std::vector<std::uint8_t> &bytes, const std::string &mesh_fname,
+                              ShadingOption opt, JobSystem *jobs) {
+    // Decodes a .dmc file already in memory and builds the vertex list like the .obj / .off loaders
+    auto mesh = DecodeMesh(bytes.data(), bytes.size(), jobs);
+
+    if (mesh.indices.empty()) {
+        std::cout << "Corrupt or empty compressed mesh: " << mesh_fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    auto vertex_count = (Eigen::Index) (mesh.positions.size() / 3);
+    auto face_count = (Eigen::Index) (mesh.indices.size() / 3);
+
+    Eigen::MatrixXd vertices(vertex_count, 3);
+    Eigen::MatrixXi facets(face_count, 3);
+    std::optional<Eigen::MatrixXd> uv_coords;
+
+    for (Eigen::Index i = 0; i < vertex_count; ++i) {
+        vertices.row(i) << mesh.positions[3 * i], mesh.positions[3 * i + 1], mesh.positions[3 * i + 2];
+    }
+    for (Eigen::Index i = 0; i < face_count; ++i) {
+        facets.row(i) << (int) mesh.indices[3 * i], (int) mesh.indices[3 * i + 1], (int) mesh.indices[3 * i + 2];
+    }
+    if (!mesh.uv_coords.empty()) {
+        uv_coords = Eigen::MatrixXd(vertex_count, 2);
+
+        for (Eigen::Index i = 0; i < vertex_count; ++i) {
+            uv_coords->row(i) << mesh.uv_coords[2 * i], mesh.uv_coords[2 * i + 1];
+        }
+    }
+    return CreateTriangles(vertices, facets, uv_coords, opt);
+}
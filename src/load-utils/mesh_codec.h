@@ -0,0 +1,94 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_MESH_CODEC_H
+#define DRAGON_GL_MESH_CODEC_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "huffman.h"
+#include "load_utils.h"
+#include "../pipeline/job_system.h"
+
+/* Compressed mesh container (.dmc). Indexed triangles are split into independent chunks so both the
+ * encoder and the decoder run one job per chunk:
+ *  - index chunks: edge/vertex FIFO coding of the triangle list, vertices renumbered in order of first
+ *    use. Adjacent triangles mostly cost one code byte.
+ *    https://zeux.io/2017/08/27/index-buffer-compression/
+ *  - vertex blocks: positions and uv coordinates quantized over their bounding box, delta filtered
+ *    per component and split into low/high byte planes.
+ *  - every stream is entropy coded with a canonical Huffman block (huffman.h). */
+const std::string compressed_mesh_extension = ".dmc";
+const std::array<char, 4> compressed_mesh_magic = {'D', 'M', 'C', '1'};
+const std::uint32_t compressed_mesh_version = 1;
+
+const std::uint32_t mesh_chunk_faces = 32768;
+const std::uint32_t mesh_block_vertices = 16384;
+const unsigned int position_bits_default = 16;  // 10-16; uv coordinates always use 16
+const unsigned int uv_bits = 16;
+
+// Index coding
+const unsigned int edge_fifo_size = 16;
+const unsigned int edge_fifo_search = 15;    // code nibble 15 marks a triangle without a cached edge
+const unsigned int vertex_fifo_size = 16;
+const unsigned int vertex_fifo_search = 14;  // vertex codes: 0 new, 1-14 cached, 15 explicit
+const std::uint8_t vertex_code_new = 0;
+const std::uint8_t vertex_code_explicit = 15;
+
+// Indexed mesh as stored in the container
+struct IndexedMesh {
+    std::vector<float> positions;         // xyz per vertex
+    std::vector<float> uv_coords;         // uv per vertex, empty if the mesh has none
+    std::vector<std::uint32_t> indices;   // 3 per face
+};
+
+// File layout, little endian: header, index chunk entries, vertex block entries, payloads
+struct CompressedMeshHeader {
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    std::uint32_t vertex_count;
+    std::uint32_t face_count;
+    std::uint32_t has_uv;
+    std::uint32_t position_bits;
+    std::uint32_t chunk_count;
+    std::uint32_t block_count;
+    float position_min[3];
+    float position_step[3];  // dequantized = min + q * step
+    float uv_min[2];
+    float uv_step[2];
+};
+
+struct CompressedMeshEntry {
+    std::uint64_t offset;  // from the start of the file
+    std::uint64_t size;
+    std::uint32_t first;   // index chunks: next new vertex; vertex blocks: first vertex
+    std::uint32_t count;   // faces or vertices
+};
+
+static_assert(sizeof(CompressedMeshHeader) == 72);
+static_assert(sizeof(CompressedMeshEntry) == 24);
+
+// Decoded bytes per second, for the encoder's report
+struct MeshDecodeStats {
+    double milliseconds = 0;
+    std::size_t output_bytes = 0;
+};
+
+IndexedMesh ReadIndexedMesh(const std::string &mesh_fname);
+std::vector<std::uint8_t> EncodeMesh(const IndexedMesh &mesh, unsigned int position_bits, JobSystem &jobs);
+IndexedMesh DecodeMesh(const std::uint8_t *data, std::size_t size, JobSystem *jobs,
+                       MeshDecodeStats *stats = nullptr);
+VertexList LoadCompressedMesh(const std::vector<std::uint8_t> &bytes, const std::string &mesh_fname,
+                              ShadingOption opt, JobSystem *jobs);
+
+#endif // DRAGON_GL_MESH_CODEC_H
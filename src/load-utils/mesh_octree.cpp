@@ -0,0 +1,794 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "mesh_octree.h"
+
+namespace {
+    using Position = std::array<float, 3>;
+    using TextureCoord = std::array<float, 2>;
+    using Triangle = std::array<Vertex, 3>;
+
+    // Triangle of the source mesh: vertex indices, and uv indices (octree_no_uv where it has none)
+    struct SourceFace {
+        std::uint32_t vertex[3];
+        std::uint32_t uv[3];
+    };
+
+    struct Bounds {
+        GlmVec3 lo{std::numeric_limits<float>::max()};
+        GlmVec3 hi{std::numeric_limits<float>::lowest()};
+
+        void Add(const GlmVec3 &point) {
+            lo = glm::min(lo, point);
+            hi = glm::max(hi, point);
+        }
+
+        void Add(const Triangle &triangle) {
+            for (const auto &corner: triangle) {
+                Add(corner.pos);
+            }
+        }
+
+        void CopyTo(float *bounds_min, float *bounds_max) const {
+            for (int c = 0; c < 3; ++c) {
+                bounds_min[c] = lo[c];
+                bounds_max[c] = hi[c];
+            }
+        }
+    };
+
+    // Working files of the builder, next to the output
+    struct TemporaryFiles {
+        std::filesystem::path dir;
+        std::string positions;
+        std::string uvs;
+        std::string faces;
+        std::string triangles;  // the output triangles, completed pass by pass
+        std::string rewritten;
+    };
+
+    struct SourceMesh {
+        std::uint64_t vertex_count = 0;
+        std::uint64_t uv_count = 0;
+        std::uint64_t face_count = 0;
+        bool has_uv = false;
+        Bounds bounds;
+    };
+
+    void OctreeError(const std::string &message) {
+        // Malformed input and failed I/O are fatal, like missing meshes
+        std::cout << message << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    // Sequential, buffered writer of fixed size records
+    template<typename Record>
+    class RecordWriter {
+    private:
+        std::string fname;
+        std::ofstream file;
+        std::vector<Record> buffer;
+
+    public:
+        std::uint64_t count = 0;
+
+        explicit RecordWriter(const std::string &fname) : fname(fname), file(fname, std::ios::binary) {
+            if (!file) {
+                OctreeError("Failed to create " + fname);
+            }
+            buffer.reserve(octree_stream_records);
+        }
+
+        void Push(const Record &record) {
+            buffer.push_back(record);
+            count++;
+
+            if (buffer.size() == octree_stream_records) {
+                Flush();
+            }
+        }
+
+        void Flush() {
+            file.write(reinterpret_cast<const char *>(buffer.data()),
+                       (std::streamsize) (buffer.size() * sizeof(Record)));
+            buffer.clear();
+
+            if (!file) {
+                OctreeError("Failed to write " + fname);
+            }
+        }
+
+        void Close() {
+            Flush();
+            file.close();
+        }
+    };
+
+    // Sequential reader of fixed size records, a block at a time
+    template<typename Record>
+    class RecordReader {
+    private:
+        std::ifstream file;
+
+    public:
+        std::vector<Record> block;
+
+        explicit RecordReader(const std::string &fname, std::uint64_t first = 0) : file(fname, std::ios::binary) {
+            if (!file) {
+                OctreeError("Failed to open " + fname);
+            }
+            file.seekg((std::streamoff) (first * sizeof(Record)));
+        }
+
+        std::size_t ReadBlock(std::size_t limit = octree_stream_records) {
+            // Up to limit records; none at the end of the file
+            block.resize(limit);
+            file.read(reinterpret_cast<char *>(block.data()), (std::streamsize) (limit * sizeof(Record)));
+            block.resize((std::size_t) file.gcount() / sizeof(Record));
+
+            return block.size();
+        }
+    };
+
+    std::uint32_t ObjIndex(const std::string &token, std::uint64_t count, const std::string &fname) {
+        // 1-based, or negative to count back from the last element so far
+        long long index = 0;
+
+        try {
+            index = std::stoll(token);
+        } catch (const std::logic_error &) {
+            OctreeError("Invalid face index '" + token + "' in " + fname);
+        }
+        index = index < 0 ? (long long) count + index : index - 1;
+
+        if (index < 0 || (std::uint64_t) index >= count) {
+            OctreeError("Face index '" + token + "' out of range in " + fname);
+        }
+        return (std::uint32_t) index;
+    }
+
+    void AddPolygon(const std::vector<std::pair<std::uint32_t, std::uint32_t>> &corners,
+                    RecordWriter<SourceFace> &faces, RecordWriter<Triangle> &triangles) {
+        // Fan triangulation; every face gets a blank triangle to be completed by the later passes
+        for (std::size_t k = 1; k + 1 < corners.size(); ++k) {
+            SourceFace face{};
+            std::size_t order[3] = {0, k, k + 1};
+
+            for (int c = 0; c < 3; ++c) {
+                face.vertex[c] = corners[order[c]].first;
+                face.uv[c] = corners[order[c]].second;
+            }
+            faces.Push(face);
+            triangles.Push(Triangle{});
+        }
+    }
+
+    void AddPosition(SourceMesh &mesh, RecordWriter<Position> &positions, const Position &position) {
+        // Indices are 32-bit
+        if (positions.count == octree_no_uv) {
+            OctreeError("Meshes are limited to 2^32 - 1 vertices");
+        }
+        positions.Push(position);
+        mesh.bounds.Add(GlmVec3(position[0], position[1], position[2]));
+    }
+
+    SourceMesh ParseObj(const std::string &fname, const TemporaryFiles &temp) {
+        // Streams vertices, uv coordinates and faces into the temporary files; normals are recomputed later
+        std::ifstream file(fname);
+        std::string line;
+
+        SourceMesh mesh;
+        RecordWriter<Position> positions(temp.positions);
+        RecordWriter<TextureCoord> uvs(temp.uvs);
+        RecordWriter<SourceFace> faces(temp.faces);
+        RecordWriter<Triangle> triangles(temp.triangles);
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> corners;
+        std::uint64_t faces_without_uv = 0;
+
+        while (std::getline(file, line)) {
+            std::istringstream tokens(line);
+            std::string statement;
+
+            tokens >> statement;
+
+            if (statement == "v") {
+                Position position{};
+
+                if (!(tokens >> position[0] >> position[1] >> position[2])) {
+                    OctreeError("Invalid vertex '" + line + "' in " + fname);
+                }
+                AddPosition(mesh, positions, position);
+            } else if (statement == "vt") {
+                TextureCoord uv{};
+
+                if (!(tokens >> uv[0] >> uv[1])) {
+                    OctreeError("Invalid uv coordinate '" + line + "' in " + fname);
+                }
+                uvs.Push(uv);
+            } else if (statement == "f") {
+                // corners are v, v/vt, v/vt/vn or v//vn
+                std::string corner;
+                auto without_uv = false;
+
+                corners.clear();
+
+                while (tokens >> corner) {
+                    auto slash = corner.find('/');
+                    auto vertex = ObjIndex(corner.substr(0, slash), positions.count, fname);
+                    auto uv = octree_no_uv;
+
+                    if (slash != std::string::npos) {
+                        auto uv_token = corner.substr(slash + 1, corner.find('/', slash + 1) - slash - 1);
+
+                        if (!uv_token.empty()) {
+                            uv = ObjIndex(uv_token, uvs.count, fname);
+                        }
+                    }
+                    without_uv = without_uv || uv == octree_no_uv;
+                    corners.emplace_back(vertex, uv);
+                }
+                if (corners.size() < 3) {
+                    OctreeError("Face with fewer than 3 corners '" + line + "' in " + fname);
+                }
+                faces_without_uv += without_uv ? 1 : 0;
+
+                AddPolygon(corners, faces, triangles);
+            }
+        }
+
+        positions.Close();
+        uvs.Close();
+        faces.Close();
+        triangles.Close();
+
+        mesh.vertex_count = positions.count;
+        mesh.uv_count = uvs.count;
+        mesh.face_count = faces.count;
+        mesh.has_uv = uvs.count > 0 && faces_without_uv == 0;
+
+        return mesh;
+    }
+
+    SourceMesh ParseOff(const std::string &fname, const TemporaryFiles &temp) {
+        // Streams an .off (no uv coordinates) into the temporary files
+        std::ifstream file(fname);
+        std::string line;
+
+        // Next line with content; comments start with #
+        auto next_line = [&](std::istringstream &tokens) {
+            while (std::getline(file, line)) {
+                auto content = line.substr(0, line.find('#'));
+
+                if (content.find_first_not_of(" \t\r") != std::string::npos) {
+                    tokens = std::istringstream(content);
+                    return;
+                }
+            }
+            OctreeError("Unexpected end of " + fname);
+        };
+
+        std::istringstream tokens;
+        std::string keyword;
+
+        next_line(tokens);
+        tokens >> keyword;
+
+        if (keyword != "OFF") {
+            OctreeError("Missing OFF header in " + fname);
+        }
+
+        // the counts may follow the keyword on the same line
+        std::uint64_t vertex_count = 0;
+        std::uint64_t face_count = 0;
+
+        if (!(tokens >> vertex_count)) {
+            next_line(tokens);
+            tokens >> vertex_count;
+        }
+        if (!(tokens >> face_count)) {
+            OctreeError("Invalid OFF counts in " + fname);
+        }
+
+        SourceMesh mesh;
+        RecordWriter<Position> positions(temp.positions);
+        RecordWriter<SourceFace> faces(temp.faces);
+        RecordWriter<Triangle> triangles(temp.triangles);
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> corners;
+
+        for (std::uint64_t i = 0; i < vertex_count; ++i) {
+            Position position{};
+
+            next_line(tokens);
+
+            if (!(tokens >> position[0] >> position[1] >> position[2])) {
+                OctreeError("Invalid vertex '" + line + "' in " + fname);
+            }
+            AddPosition(mesh, positions, position);
+        }
+        for (std::uint64_t i = 0; i < face_count; ++i) {
+            std::uint64_t corner_count = 0;
+
+            next_line(tokens);
+            tokens >> corner_count;
+            corners.clear();
+
+            for (std::uint64_t c = 0; c < corner_count; ++c) {
+                std::uint64_t vertex = vertex_count;
+
+                if (!(tokens >> vertex) || vertex >= vertex_count) {
+                    OctreeError("Invalid face '" + line + "' in " + fname);
+                }
+                corners.emplace_back((std::uint32_t) vertex, octree_no_uv);
+            }
+            if (corners.size() < 3) {
+                OctreeError("Face with fewer than 3 corners '" + line + "' in " + fname);
+            }
+            AddPolygon(corners, faces, triangles);
+        }
+
+        positions.Close();
+        faces.Close();
+        triangles.Close();
+
+        // an empty uv file keeps the window passes uniform
+        RecordWriter<TextureCoord>(temp.uvs).Close();
+
+        mesh.vertex_count = positions.count;
+        mesh.face_count = faces.count;
+
+        return mesh;
+    }
+
+    void ScanTriangles(const TemporaryFiles &temp, bool rewrite,
+                       const std::function<void(const SourceFace &, Triangle &)> &body) {
+        // Every face with its output triangle, in lockstep; with rewrite, the triangles as changed by body
+        // replace the previous ones
+        {
+            RecordReader<SourceFace> faces(temp.faces);
+            RecordReader<Triangle> triangles(temp.triangles);
+            std::optional<RecordWriter<Triangle>> output;
+
+            if (rewrite) {
+                output.emplace(temp.rewritten);
+            }
+
+            while (faces.ReadBlock() > 0) {
+                if (triangles.ReadBlock(faces.block.size()) != faces.block.size()) {
+                    OctreeError("Temporary file " + temp.triangles + " is truncated");
+                }
+                for (std::size_t i = 0; i < faces.block.size(); ++i) {
+                    body(faces.block[i], triangles.block[i]);
+                }
+                if (output) {
+                    for (const auto &triangle: triangles.block) {
+                        output->Push(triangle);
+                    }
+                }
+            }
+            if (output) {
+                output->Close();
+            }
+        }
+        if (rewrite) {
+            std::filesystem::rename(temp.rewritten, temp.triangles);
+        }
+    }
+
+    template<typename Record>
+    std::vector<Record> ReadWindow(const std::string &fname, std::uint64_t first, std::uint64_t total,
+                                   std::uint64_t window) {
+        // Records [first, first + window) of a file holding total records
+        if (first >= total) {
+            return {};
+        }
+        RecordReader<Record> reader(fname, first);
+
+        reader.ReadBlock(std::min(window, total - first));
+
+        return std::move(reader.block);
+    }
+
+    void FillCorners(const TemporaryFiles &temp, const SourceMesh &mesh, std::uint64_t first,
+                     std::uint64_t window) {
+        // Positions and uv coordinates of the vertices in the window, copied to every corner using them
+        auto positions = ReadWindow<Position>(temp.positions, first, mesh.vertex_count, window);
+        auto uvs = mesh.has_uv ? ReadWindow<TextureCoord>(temp.uvs, first, mesh.uv_count, window) :
+                   std::vector<TextureCoord>();
+
+        ScanTriangles(temp, true, [&](const SourceFace &face, Triangle &triangle) {
+            for (int c = 0; c < 3; ++c) {
+                if (face.vertex[c] >= first && face.vertex[c] - first < positions.size()) {
+                    const auto &position = positions[face.vertex[c] - first];
+
+                    triangle[c].pos = VecPosition(position[0], position[1], position[2]);
+                }
+                if (face.uv[c] >= first && face.uv[c] - first < uvs.size()) {
+                    const auto &uv = uvs[face.uv[c] - first];
+
+                    triangle[c].uv_coord = VecTextureCoord(uv[0], uv[1]);
+                }
+            }
+        });
+    }
+
+    std::pair<GlmVec3, GlmVec3> FaceFrame(const Triangle &triangle, bool has_uv) {
+        // Unit face normal and uv tangent, as ProcessFacets; zero for degenerate triangles
+        auto edge1 = triangle[1].pos - triangle[0].pos;
+        auto edge2 = triangle[2].pos - triangle[0].pos;
+        auto normal = glm::cross(edge1, edge2);
+        auto area = glm::length(normal);
+
+        normal = area > 0.0f ? normal / area : GlmVec3(0.0f);
+
+        GlmVec3 tangent(0.0f);
+
+        if (has_uv) {
+            auto delta_uv1 = triangle[1].uv_coord - triangle[0].uv_coord;
+            auto delta_uv2 = triangle[2].uv_coord - triangle[0].uv_coord;
+            auto determinant = delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y;
+
+            if (determinant != 0.0f) {
+                tangent = (delta_uv2.y * edge1 - delta_uv1.y * edge2) / determinant;
+            }
+        }
+        return {normal, tangent};
+    }
+
+    GlmVec3 OrthogonalTangent(const GlmVec3 &normal) {
+        // Any unit vector perpendicular to the normal; untextured meshes never sample along it
+        auto axis = std::abs(normal.x) < 0.9f ? GlmVec3(1.0f, 0.0f, 0.0f) : GlmVec3(0.0f, 1.0f, 0.0f);
+
+        return glm::normalize(glm::cross(normal, axis));
+    }
+
+    void ComputeNormals(const TemporaryFiles &temp, const SourceMesh &mesh, std::uint64_t first,
+                        std::uint64_t window) {
+        // Sums the face normals and tangents around each vertex of the window, then writes the averages into
+        // the corners; the same smoothing as CreateTriangles, across chunk borders
+        if (first >= mesh.vertex_count) {
+            return;
+        }
+        auto count = std::min(window, mesh.vertex_count - first);
+
+        std::vector<GlmVec3> normals(count, GlmVec3(0.0f));
+        std::vector<GlmVec3> tangents(count, GlmVec3(0.0f));
+
+        auto in_window = [&](std::uint32_t vertex) {
+            return vertex >= first && vertex - first < count;
+        };
+
+        ScanTriangles(temp, false, [&](const SourceFace &face, Triangle &triangle) {
+            auto [normal, tangent] = FaceFrame(triangle, mesh.has_uv);
+
+            for (int c = 0; c < 3; ++c) {
+                if (in_window(face.vertex[c])) {
+                    normals[face.vertex[c] - first] += normal;
+                    tangents[face.vertex[c] - first] += tangent;
+                }
+            }
+        });
+
+        ScanTriangles(temp, true, [&](const SourceFace &face, Triangle &triangle) {
+            for (int c = 0; c < 3; ++c) {
+                if (!in_window(face.vertex[c])) {
+                    continue;
+                }
+                auto normal = normals[face.vertex[c] - first];
+                auto tangent = tangents[face.vertex[c] - first];
+
+                normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : GlmVec3(0.0f, 0.0f, 1.0f);
+                tangent = glm::length(tangent) > 0.0f ? glm::normalize(tangent) : OrthogonalTangent(normal);
+
+                triangle[c].normal = normal;
+                triangle[c].tangent = tangent;
+            }
+        });
+    }
+
+    // Output file and tables while the octree is built
+    struct OctreeWriter {
+        std::string fname;
+        std::ofstream file;
+        std::uint64_t offset = 0;
+        std::uint32_t chunk_triangles = 0;
+        std::vector<OctreeNode> nodes;
+        std::vector<OctreeChunk> chunks;
+        TemporaryFiles temp;
+        unsigned int next_file = 0;
+    };
+
+    void WriteBytes(OctreeWriter &writer, const void *data, std::uint64_t size) {
+        // Appends to the page file
+        writer.file.write(reinterpret_cast<const char *>(data), (std::streamsize) size);
+        writer.offset += size;
+
+        if (!writer.file) {
+            OctreeError("Failed to write " + writer.fname);
+        }
+    }
+
+    void WriteChunk(OctreeWriter &writer, std::uint32_t node, const std::vector<Triangle> &triangles) {
+        // Pads to the next page, then appends the triangles as one chunk
+        std::vector<char> padding((octree_page_size - writer.offset % octree_page_size) % octree_page_size);
+
+        WriteBytes(writer, padding.data(), padding.size());
+
+        Bounds bounds;
+
+        for (const auto &triangle: triangles) {
+            bounds.Add(triangle);
+        }
+
+        OctreeChunk chunk{};
+
+        chunk.offset = writer.offset;
+        chunk.triangle_count = (std::uint32_t) triangles.size();
+        chunk.node = node;
+        bounds.CopyTo(chunk.bounds_min, chunk.bounds_max);
+
+        writer.chunks.push_back(chunk);
+
+        WriteBytes(writer, triangles.data(), triangles.size() * sizeof(Triangle));
+    }
+
+    void BuildNode(OctreeWriter &writer, std::uint32_t node, const std::string &fname, std::uint64_t count,
+                   const GlmVec3 &center, float half_size, unsigned int depth) {
+        // Small nodes become leaves; larger ones are split by triangle centroid into their non-empty octants,
+        // one sequential pass over their triangles each, so a node never needs to fit in memory
+        if (count <= writer.chunk_triangles || depth == octree_depth_max) {
+            writer.nodes[node].first_chunk = (std::uint32_t) writer.chunks.size();
+            {
+                RecordReader<Triangle> reader(fname);
+
+                while (reader.ReadBlock(writer.chunk_triangles) > 0) {
+                    WriteChunk(writer, node, reader.block);
+                }
+            }
+            writer.nodes[node].chunk_count = (std::uint32_t) writer.chunks.size() - writer.nodes[node].first_chunk;
+
+            std::filesystem::remove(fname);
+            return;
+        }
+
+        std::array<std::string, 8> child_files;
+        std::array<std::uint64_t, 8> child_counts{};
+        std::array<Bounds, 8> child_bounds;
+        {
+            std::vector<RecordWriter<Triangle>> children;
+
+            children.reserve(8);
+
+            for (auto &child_file: child_files) {
+                child_file = (writer.temp.dir / ("node" + std::to_string(writer.next_file++) + ".bin")).string();
+                children.emplace_back(child_file);
+            }
+
+            RecordReader<Triangle> reader(fname);
+
+            while (reader.ReadBlock() > 0) {
+                for (const auto &triangle: reader.block) {
+                    auto centroid = (triangle[0].pos + triangle[1].pos + triangle[2].pos) / 3.0f;
+                    auto octant = (centroid.x > center.x ? 1 : 0) | (centroid.y > center.y ? 2 : 0) |
+                                  (centroid.z > center.z ? 4 : 0);
+
+                    children[octant].Push(triangle);
+                    child_bounds[octant].Add(triangle);
+                }
+            }
+            for (int i = 0; i < 8; ++i) {
+                children[i].Close();
+                child_counts[i] = children[i].count;
+            }
+        }
+        std::filesystem::remove(fname);
+
+        // Non-empty children are consecutive; the vector may grow while they are built, so only indices are kept
+        auto first_child = (std::uint32_t) writer.nodes.size();
+
+        for (int i = 0; i < 8; ++i) {
+            if (child_counts[i] == 0) {
+                std::filesystem::remove(child_files[i]);
+                continue;
+            }
+            OctreeNode child{};
+
+            child_bounds[i].CopyTo(child.bounds_min, child.bounds_max);
+            writer.nodes.push_back(child);
+        }
+        writer.nodes[node].first_child = first_child;
+        writer.nodes[node].child_count = (std::uint32_t) writer.nodes.size() - first_child;
+
+        auto child = first_child;
+
+        for (int i = 0; i < 8; ++i) {
+            if (child_counts[i] == 0) {
+                continue;
+            }
+            auto quarter = 0.5f * half_size;
+            auto child_center = center + GlmVec3(i & 1 ? quarter : -quarter, i & 2 ? quarter : -quarter,
+                                                 i & 4 ? quarter : -quarter);
+
+            BuildNode(writer, child++, child_files[i], child_counts[i], child_center, quarter, depth + 1);
+        }
+    }
+}
+
+OctreeBuildStats BuildOctreeMesh(const std::string &input_fname, const std::string &output_fname,
+                                 const OctreeBuildOptions &options) {
+    /* Parses the source mesh into temporary files, completes the output triangles in passes over windows of
+     * vertices (positions and uv coordinates, then normals and tangents), and splits them into the octree while
+     * writing the page file */
+    ExistsOk(input_fname);
+
+    auto start = std::chrono::steady_clock::now();
+
+    TemporaryFiles temp;
+
+    temp.dir = std::filesystem::path(output_fname + ".tmp");
+    temp.positions = (temp.dir / "positions.bin").string();
+    temp.uvs = (temp.dir / "uvs.bin").string();
+    temp.faces = (temp.dir / "faces.bin").string();
+    temp.triangles = (temp.dir / "triangles.bin").string();
+    temp.rewritten = (temp.dir / "triangles.next.bin").string();
+
+    std::filesystem::create_directories(temp.dir);
+
+    auto mesh = std::filesystem::path(input_fname).extension() == ".obj" ? ParseObj(input_fname, temp) :
+                ParseOff(input_fname, temp);
+
+    if (mesh.face_count == 0) {
+        OctreeError("No faces in " + input_fname);
+    }
+
+    // The normal pass needs two vectors per vertex of the window; the corner pass needs less
+    std::uint64_t window = std::max<std::uint64_t>(1, (options.memory_mb << 20) / (2 * sizeof(GlmVec3)));
+    auto indexed = std::max(mesh.vertex_count, mesh.has_uv ? mesh.uv_count : 0);
+
+    OctreeBuildStats stats;
+
+    stats.vertex_count = mesh.vertex_count;
+    stats.uv_count = mesh.uv_count;
+    stats.triangle_count = mesh.face_count;
+    stats.window_passes = (unsigned int) std::max<std::uint64_t>(1, (indexed + window - 1) / window);
+    stats.window_bytes = (std::size_t) std::min(window, indexed) * 2 * sizeof(GlmVec3);
+    stats.temporary_bytes = mesh.vertex_count * sizeof(Position) + mesh.uv_count * sizeof(TextureCoord) +
+                            mesh.face_count * (sizeof(SourceFace) + 2 * sizeof(Triangle));
+
+    for (unsigned int pass = 0; pass < stats.window_passes; ++pass) {
+        FillCorners(temp, mesh, pass * window, window);
+    }
+    for (unsigned int pass = 0; pass < stats.window_passes; ++pass) {
+        ComputeNormals(temp, mesh, pass * window, window);
+    }
+
+    std::filesystem::remove(temp.positions);
+    std::filesystem::remove(temp.uvs);
+    std::filesystem::remove(temp.faces);
+
+    // Page file: the header is written last, once the tables are known
+    OctreeWriter writer;
+
+    writer.fname = output_fname;
+    writer.file.open(output_fname, std::ios::binary);
+    writer.chunk_triangles = options.chunk_triangles;
+    writer.temp = temp;
+
+    if (!writer.file) {
+        OctreeError("Failed to create " + output_fname);
+    }
+    std::vector<char> header_page(octree_page_size);
+
+    WriteBytes(writer, header_page.data(), header_page.size());
+
+    OctreeNode root{};
+
+    mesh.bounds.CopyTo(root.bounds_min, root.bounds_max);
+    writer.nodes.push_back(root);
+
+    // The root octant is the cube around the bounds
+    auto extent = mesh.bounds.hi - mesh.bounds.lo;
+    auto half_size = 0.5f * std::max({extent.x, extent.y, extent.z});
+
+    BuildNode(writer, 0, temp.triangles, mesh.face_count, 0.5f * (mesh.bounds.lo + mesh.bounds.hi), half_size, 0);
+
+    OctreeMeshHeader header{};
+
+    header.magic = octree_mesh_magic;
+    header.version = octree_mesh_version;
+    header.node_count = (std::uint32_t) writer.nodes.size();
+    header.chunk_count = (std::uint32_t) writer.chunks.size();
+    header.chunk_triangles = options.chunk_triangles;
+    header.has_uv = mesh.has_uv ? 1 : 0;
+    header.triangle_count = mesh.face_count;
+    mesh.bounds.CopyTo(header.bounds_min, header.bounds_max);
+
+    header.node_offset = writer.offset;
+    WriteBytes(writer, writer.nodes.data(), writer.nodes.size() * sizeof(OctreeNode));
+
+    header.chunk_offset = writer.offset;
+    WriteBytes(writer, writer.chunks.data(), writer.chunks.size() * sizeof(OctreeChunk));
+
+    writer.file.seekp(0);
+    writer.file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    writer.file.close();
+
+    if (!writer.file) {
+        OctreeError("Failed to write " + output_fname);
+    }
+    std::filesystem::remove_all(temp.dir);
+
+    stats.node_count = header.node_count;
+    stats.chunk_count = header.chunk_count;
+    stats.output_bytes = writer.offset;
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return stats;
+}
+
+OctreeMesh ReadOctreeMesh(const std::string &fname) {
+    // Header and tables only, checked against the file size so chunk reads cannot run past the end
+    ExistsOk(fname);
+
+    OctreeMesh mesh;
+    std::ifstream file(fname, std::ios::binary);
+    auto file_size = std::filesystem::file_size(fname);
+
+    file.read(reinterpret_cast<char *>(&mesh.header), sizeof(OctreeMeshHeader));
+
+    const auto &header = mesh.header;
+
+    if (!file || header.magic != octree_mesh_magic || header.version != octree_mesh_version) {
+        OctreeError("Not a paged mesh (" + octree_mesh_extension + " version " +
+                    std::to_string(octree_mesh_version) + "): " + fname);
+    }
+    if (header.node_count == 0 || header.node_offset + header.node_count * sizeof(OctreeNode) > file_size ||
+        header.chunk_offset + header.chunk_count * sizeof(OctreeChunk) > file_size) {
+        OctreeError("Truncated paged mesh: " + fname);
+    }
+
+    mesh.nodes.resize(header.node_count);
+    mesh.chunks.resize(header.chunk_count);
+
+    file.seekg((std::streamoff) header.node_offset);
+    file.read(reinterpret_cast<char *>(mesh.nodes.data()), (std::streamsize) (mesh.nodes.size() * sizeof(OctreeNode)));
+    file.seekg((std::streamoff) header.chunk_offset);
+    file.read(reinterpret_cast<char *>(mesh.chunks.data()),
+              (std::streamsize) (mesh.chunks.size() * sizeof(OctreeChunk)));
+
+    for (const auto &node: mesh.nodes) {
+        if ((std::uint64_t) node.first_child + node.child_count > header.node_count ||
+            (std::uint64_t) node.first_chunk + node.chunk_count > header.chunk_count) {
+            OctreeError("Corrupt node table in " + fname);
+        }
+    }
+    for (const auto &chunk: mesh.chunks) {
+        if (chunk.triangle_count > header.chunk_triangles ||
+            chunk.offset + chunk.triangle_count * sizeof(Triangle) > file_size) {
+            OctreeError("Corrupt chunk table in " + fname);
+        }
+    }
+    return mesh;
+}
+
+VertexList ReadOctreeChunk(const std::string &fname, const OctreeChunk &chunk) {
+    // One chunk, a single read; safe to call from any thread
+    VertexList vertices((std::size_t) chunk.triangle_count * 3);
+    std::ifstream file(fname, std::ios::binary);
+
+    file.seekg((std::streamoff) chunk.offset);
+    file.read(reinterpret_cast<char *>(vertices.data()), (std::streamsize) (vertices.size() * sizeof(Vertex)));
+
+    if (!file) {
+        OctreeError("Failed to read a chunk of " + fname);
+    }
+    return vertices;
+}
+
+bool IsOctreeMesh(const std::string &fname) {
+    // Paged meshes are streamed instead of loaded
+    return std::filesystem::path(fname).extension() == octree_mesh_extension;
+}
@@ -0,0 +1,110 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_MESH_OCTREE_H
+#define DRAGON_GL_MESH_OCTREE_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "load_utils.h"
+
+/* Paged mesh (.dmo) for scans too large to load whole. The offline builder (dragon-octree-build) splits the triangles
+ * into a spatial octree whose leaves hold self-contained chunks: triangle soups with positions, smooth normals,
+ * tangents and uv coordinates, ready to upload. Normals and tangents are averaged over the whole mesh, so chunk
+ * borders show no seams. Every chunk starts on a page boundary and is a single read; at run time a bounded set of
+ * them lives on the GPU (see streaming.h).
+ * The builder works out of core: every pass streams temporary files sequentially, and the only random access goes
+ * to one window of vertices held in memory, so its peak memory is bounded by 'memory=MB' and not by the mesh */
+const std::string octree_mesh_extension = ".dmo";
+const std::array<char, 4> octree_mesh_magic = {'D', 'M', 'O', '1'};
+const std::uint32_t octree_mesh_version = 1;
+const std::uint64_t octree_page_size = 4096;
+
+const std::uint32_t octree_chunk_triangles_default = 16384;
+const unsigned int octree_depth_max = 16;           // nodes this deep are leaves however many triangles they hold
+const std::size_t octree_memory_default_mb = 512;   // vertex window of the builder
+const std::size_t octree_stream_records = 16384;    // records per read or write of a temporary file
+const std::uint32_t octree_no_uv = 0xffffffff;
+
+// File layout, little endian: header, chunk payloads (page aligned), node table, chunk table
+struct OctreeMeshHeader {
+    std::array<char, 4> magic;
+    std::uint32_t version;
+    std::uint32_t node_count;
+    std::uint32_t chunk_count;
+    std::uint32_t chunk_triangles;  // the most triangles in one chunk
+    std::uint32_t has_uv;
+    std::uint64_t triangle_count;
+    std::uint64_t node_offset;      // from the start of the file
+    std::uint64_t chunk_offset;
+    float bounds_min[3];
+    float bounds_max[3];
+};
+
+struct OctreeNode {
+    float bounds_min[3];  // of its triangles, not of its octant
+    float bounds_max[3];
+    std::uint32_t first_child;  // children are consecutive; no children for leaves
+    std::uint32_t child_count;
+    std::uint32_t first_chunk;  // leaves only; a leaf at the depth limit may need several chunks
+    std::uint32_t chunk_count;
+};
+
+struct OctreeChunk {
+    std::uint64_t offset;          // Vertex triangle soup of 3 * triangle_count vertices
+    std::uint32_t triangle_count;
+    std::uint32_t node;
+    float bounds_min[3];
+    float bounds_max[3];
+};
+
+static_assert(sizeof(OctreeMeshHeader) == 72);
+static_assert(sizeof(OctreeNode) == 40);
+static_assert(sizeof(OctreeChunk) == 40);
+
+// Header and tables of a page file; the chunks stay on disk
+struct OctreeMesh {
+    OctreeMeshHeader header{};
+    std::vector<OctreeNode> nodes;  // node 0 is the root
+    std::vector<OctreeChunk> chunks;
+};
+
+struct OctreeBuildOptions {
+    std::uint32_t chunk_triangles = octree_chunk_triangles_default;
+    std::size_t memory_mb = octree_memory_default_mb;
+};
+
+struct OctreeBuildStats {
+    std::uint64_t vertex_count = 0;
+    std::uint64_t uv_count = 0;
+    std::uint64_t triangle_count = 0;
+    std::uint32_t node_count = 0;
+    std::uint32_t chunk_count = 0;
+    unsigned int window_passes = 0;      // per vertex pass; one if the window holds every vertex
+    std::size_t window_bytes = 0;        // largest in-memory vertex window
+    std::uint64_t temporary_bytes = 0;   // temporary files at their largest
+    std::uint64_t output_bytes = 0;
+    double milliseconds = 0.0;
+};
+
+OctreeBuildStats BuildOctreeMesh(const std::string &input_fname, const std::string &output_fname,
+                                 const OctreeBuildOptions &options);
+OctreeMesh ReadOctreeMesh(const std::string &fname);
+VertexList ReadOctreeChunk(const std::string &fname, const OctreeChunk &chunk);
+bool IsOctreeMesh(const std::string &fname);
+
+#endif // DRAGON_GL_MESH_OCTREE_H
@@ -0,0 +1,241 @@
+//
+// Created by francisk on 10/18/26.
+//
+/* Scene files are plain text, one statement per line; '#' starts a comment. Paths are relative
+ * to the scene file. Example:
+ *
+ *     mesh dragon ../dragon.obj
+ *     texture dragon diffuse ../texture/DefaultMaterial_albedo.jpg
+ *     texture dragon normal ../texture/DefaultMaterial_normal.png
+ *     instance dragon scale 0.01 translate 0 -35 100 rotate 0 90 0
+ *     light 0 0 1.85 0.3 0.45 0.3 [radius]
+ *
+ * Instance transforms compose like the built-in models: scale, then translate (in scaled units),
+ * then rotate (degrees, about y then x then z).
+ */
+
+#include "scene_file.h"
+#include "load_utils.h"
+#include "mesh_codec.h"
+#include "mesh_octree.h"
+
+static std::string SceneError(const std::string &line, const std::string &message) {
+    return "Invalid scene statement '" + line + "': " + message;
+}
+
+static bool SceneFileOk(const std::string &filename, std::string &error) {
+    // ExistsOk without the exit
+    if (!std::filesystem::is_regular_file(filename)) {
+        error = filename + " does not exist or cannot be found";
+        return false;
+    }
+    return true;
+}
+
+std::optional<GlmMat4> ParseInstanceTransform(std::istringstream &tokens, const std::string &line,
+                                              std::string &error) {
+    // Reads 'scale s | scale x y z', 'translate x y z' and 'rotate x y z' in any order
+    GlmVec3 scale(1.0f, 1.0f, 1.0f);
+    GlmVec3 translate(0.0f, 0.0f, 0.0f);
+    GlmVec3 rotate(0.0f, 0.0f, 0.0f);
+    std::string keyword;
+
+    while (tokens >> keyword) {
+        if (keyword == "scale") {
+            tokens >> scale.x;
+
+            // a single factor scales uniformly
+            if (!(tokens >> scale.y >> scale.z)) {
+                scale.y = scale.z = scale.x;
+                tokens.clear();
+            }
+        } else if (keyword == "translate") {
+            tokens >> translate.x >> translate.y >> translate.z;
+        } else if (keyword == "rotate") {
+            tokens >> rotate.x >> rotate.y >> rotate.z;
+        } else {
+            error = SceneError(line, "unknown transform '" + keyword + "'");
+            return std::nullopt;
+        }
+        if (tokens.fail()) {
+            error = SceneError(line, "expected numbers after '" + keyword + "'");
+            return std::nullopt;
+        }
+    }
+
+    GlmMat4 transform = glm::scale(GlmMat4(1.0f), scale);
+
+    transform = glm::translate(transform, translate);
+    transform = glm::rotate(transform, glm::radians(rotate.y), GlmVec3(0.0f, 1.0f, 0.0f));
+    transform = glm::rotate(transform, glm::radians(rotate.x), GlmVec3(1.0f, 0.0f, 0.0f));
+    transform = glm::rotate(transform, glm::radians(rotate.z), GlmVec3(0.0f, 0.0f, 1.0f));
+
+    return transform;
+}
+
+std::optional<SceneDescription> ParseSceneFile(const std::string &scene_fname, std::string &error) {
+    // Parses a scene file into meshes, instances and lights; nothing if it is missing or malformed
+    if (!SceneFileOk(scene_fname, error)) {
+        return std::nullopt;
+    }
+
+    SceneDescription scene;
+
+    auto base_dir = std::filesystem::path(scene_fname).parent_path();
+    auto resolve = [&base_dir](const std::string &path) { return (base_dir / path).lexically_normal().string(); };
+    auto find_mesh = [&scene](const std::string &name) -> int {
+        for (std::size_t i = 0; i < scene.meshes.size(); ++i) {
+            if (scene.meshes[i].name == name) {
+                return (int) i;
+            }
+        }
+        return -1;
+    };
+
+    std::ifstream filestream(scene_fname);
+    std::string line;
+
+    while (std::getline(filestream, line)) {
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream tokens(line);
+        std::string statement;
+
+        if (!(tokens >> statement)) {
+            continue;  // blank or comment
+        }
+
+        if (statement == "mesh") {
+            MeshDesc mesh;
+            std::string path;
+
+            if (!(tokens >> mesh.name >> path)) {
+                error = SceneError(line, "expected 'mesh <name> <path>'");
+                return std::nullopt;
+            }
+            if (find_mesh(mesh.name) >= 0) {
+                error = SceneError(line, "mesh '" + mesh.name + "' is declared twice");
+                return std::nullopt;
+            }
+            mesh.path = resolve(path);
+
+            if (IsOctreeMesh(mesh.path)) {
+                error = SceneError(line, "paged meshes (" + octree_mesh_extension +
+                                         ") are rendered with 'stream=path'");
+                return std::nullopt;
+            }
+            scene.meshes.push_back(mesh);
+        } else if (statement == "texture") {
+            std::string name, kind, path;
+
+            if (!(tokens >> name >> kind >> path)) {
+                error = SceneError(line, "expected 'texture <mesh> diffuse|normal <path>'");
+                return std::nullopt;
+            }
+            auto mesh = find_mesh(name);
+
+            if (mesh < 0) {
+                error = SceneError(line, "unknown mesh '" + name + "'");
+                return std::nullopt;
+            }
+            if (kind == "diffuse") {
+                scene.meshes[mesh].diffuse_path = resolve(path);
+            } else if (kind == "normal") {
+                scene.meshes[mesh].normal_path = resolve(path);
+            } else {
+                error = SceneError(line, "texture kind must be 'diffuse' or 'normal'");
+                return std::nullopt;
+            }
+        } else if (statement == "instance") {
+            std::string name;
+
+            if (!(tokens >> name)) {
+                error = SceneError(line, "expected 'instance <mesh> [transforms]'");
+                return std::nullopt;
+            }
+            auto mesh = find_mesh(name);
+
+            if (mesh < 0) {
+                error = SceneError(line, "unknown mesh '" + name + "'");
+                return std::nullopt;
+            }
+            auto transform = ParseInstanceTransform(tokens, line, error);
+
+            if (!transform.has_value()) {
+                return std::nullopt;
+            }
+            InstanceDesc instance{};
+
+            instance.mesh = (unsigned int) mesh;
+            instance.transform = *transform;
+
+            scene.instances.push_back(instance);
+        } else if (statement == "light") {
+            GlmVec3 position;
+            GlmVec3 color;
+            float radius = scene_light_radius;
+
+            if (!(tokens >> position.x >> position.y >> position.z >> color.x >> color.y >> color.z)) {
+                error = SceneError(line, "expected 'light x y z r g b [radius]'");
+                return std::nullopt;
+            }
+            tokens >> radius;
+
+            PointLight light{};
+
+            light.position = GlmVec4(position, radius);
+            light.color = GlmVec4(color, 1.0f);
+
+            scene.lights.push_back(light);
+        } else {
+            error = SceneError(line, "unknown statement '" + statement + "'");
+            return std::nullopt;
+        }
+    }
+
+    if (scene.instances.empty()) {
+        error = scene_fname + " has no instances";
+        return std::nullopt;
+    }
+
+    return scene;
+}
+
+SceneDescription LoadSceneFile(const std::string &scene_fname) {
+    // ParseSceneFile, fatal on a missing or malformed file like a missing mesh
+    std::string error;
+    auto scene = ParseSceneFile(scene_fname, error);
+
+    if (!scene.has_value()) {
+        std::cout << error << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    return *scene;
+}
+
+bool CheckSceneFiles(const SceneDescription &scene, std::string &error) {
+    /* Every mesh and texture the scene names is a file, and every mesh is in a format LoadSceneAssets reads, so
+     * loading it will not stop the process on a missing file */
+    for (const auto &mesh: scene.meshes) {
+        auto extension = std::filesystem::path(mesh.path).extension();
+
+        if (extension != ".obj" && extension != ".off" && extension != compressed_mesh_extension) {
+            error = mesh.path + ": expected an .obj, .off or " + compressed_mesh_extension + " mesh";
+            return false;
+        }
+        for (const auto &path: {mesh.path, mesh.diffuse_path, mesh.normal_path}) {
+            if (!path.empty() && !SceneFileOk(path, error)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SceneHasTextures(const SceneDescription &scene) {
+    // True if every mesh has both textures, ie. normal mapping can be used
+    return std::all_of(scene.meshes.begin(), scene.meshes.end(), [](const MeshDesc &mesh) {
+        return !mesh.diffuse_path.empty() && !mesh.normal_path.empty();
+    });
+}
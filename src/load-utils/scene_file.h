@@ -0,0 +1,51 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_SCENE_FILE_H
+#define DRAGON_GL_SCENE_FILE_H
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "attributes.h"
+
+// One mesh file and its (optional) material textures
+struct MeshDesc {
+    std::string name;
+    std::string path;
+    std::string diffuse_path;  // empty if untextured
+    std::string normal_path;
+};
+
+// A placed copy of a mesh; transform is model space -> world space, before user rotation
+struct InstanceDesc {
+    unsigned int mesh;  // ordinal into SceneDescription::meshes
+    GlmMat4 transform;
+};
+
+struct SceneDescription {
+    std::vector<MeshDesc> meshes;
+    std::vector<InstanceDesc> instances;
+    std::vector<PointLight> lights;
+};
+
+// Radius of lights declared without one
+const float scene_light_radius = 8.0f;
+
+std::optional<GlmMat4> ParseInstanceTransform(std::istringstream &tokens, const std::string &line,
+                                              std::string &error);
+std::optional<SceneDescription> ParseSceneFile(const std::string &scene_fname, std::string &error);
+SceneDescription LoadSceneFile(const std::string &scene_fname);
+bool CheckSceneFiles(const SceneDescription &scene, std::string &error);
+bool SceneHasTextures(const SceneDescription &scene);
+
+#endif // DRAGON_GL_SCENE_FILE_H
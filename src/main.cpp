@@ -1,23 +1,41 @@
 #include "pipeline/scene.h"
+#include "pipeline/deferred.h"
+#include "pipeline/clusters.h"
+#include "pipeline/frame_stats.h"
+#include "pipeline/prepass.h"
+#include "pipeline/pacing.h"
+#include "pipeline/threading.h"
+#include "pipeline/bvh.h"
+#include "pipeline/render_target.h"
+#include "pipeline/shadows.h"
+#include "pipeline/antialiasing.h"
+#include "pipeline/dynamic_resolution.h"
+#include "pipeline/streaming.h"
+#include "pipeline/vertex_pulling.h"
+#include "pipeline/impostors.h"
+#include "pipeline/deformation.h"
+#include "pipeline/ambient_occlusion.h"
+#include "pipeline/camera_path.h"
+#include "pipeline/point_splats.h"
+#include "pipeline/render_options.h"
+
+#include <thread>
 
 int main(int argc, char* argv[]) {
     // Handle arguments
-    auto input_options = ParseArgs(argc, argv);
+    auto options = ParseRenderOptions(argc, argv);
 
-    // Scene inputs
-    auto model_choice = input_options.model;  // can set to ModelChoice::dragon_off etc
-    auto save_to_image = input_options.save_image;
+    // Budgets are checked from the first allocation on
+    SetMemoryBudget(MemorySide::cpu, options.input.cpu_budget_mb);
+    SetMemoryBudget(MemorySide::gpu, options.input.gpu_budget_mb);
 
-    ShadingOption render_mode;
+    // Scene inputs: a paged mesh to stream, a scene file, or one of the built-in models
+    auto scene_description = options.streamed ? StreamedScene(options.input.stream_file) :
+                             options.input.scene_file.empty() ? BuiltinScene(options.input.model) :
+                             LoadSceneFile(options.input.scene_file);
 
-    if(!input_options.opt.has_value()) {
-        // No additional shading option specified
-        render_mode = model_choice == ModelChoice::dragon_off || model_choice == ModelChoice::bunny_off ?
-                      ShadingOption::per_vertex : ShadingOption::normal_mapping;
-    } else {
-        // Special shading option (flat, wireframe) specified
-        render_mode = input_options.opt.value();
-    }
+    // Shading and the features that run with it; those that do not are reported and left out
+    ValidateRenderOptions(options, scene_description);
 
     // Globals
     static SceneGlobals scene_globals;
@@ -25,17 +43,182 @@ int main(int argc, char* argv[]) {
     // Initialize GLFW window
     auto window = InitializeWindow(width_init, height_init, "Dragon OpenGL", scene_globals);
 
-    // Read mesh, initialize uniforms and create vertex buffers
-    auto scene_params = CreateScene(model_choice, render_mode, scene_globals);
+    // Read meshes and textures, initialize uniforms and create the shared vertex buffer
+    auto scene_params = CreateScene(scene_description, options.render_mode, options.input.light_count,
+                                    options.input.bindless, scene_globals);
+
+    // A streamed mesh draws from its own fixed-size buffer; its draw commands are rewritten every frame
+    StreamingParams streaming_params{};
+
+    if (options.streamed) {
+        streaming_params = CreateStreaming(options.input.stream_file, options.input.stream_budget_mb);
+
+        glDeleteVertexArrays(1, &scene_params.buffer_tris.vao);
+        scene_params.buffer_tris.vao = streaming_params.vao;
+    }
 
     auto buffer_tris = scene_params.buffer_tris.vao;
 
-    auto vertex_shader_path = GetVertexShaderPath(render_mode);
-    auto fragment_shader_path = GetFragmentShaderPath(render_mode);
+    auto vertex_shader_path = GetVertexShaderPath(options.render_mode);
+    auto fragment_shader_path = GetFragmentShaderPath(options.render_mode);
+
+    auto ao_defines = options.ambient_occlusion ? ao_shader_defines : "";
+
+    // Create and link shaders; textured shaders are specialized for bindless handles or texture arrays
+    auto forward_defines = GetMaterialShaderDefines(scene_params.materials) +
+                           (options.shadows ? shadow_shader_defines : "") + ao_defines;
+
+    // Vertex pulling: shaders read split attribute streams at gl_VertexID; the benchmark (forward path) draws
+    // with both programs in turn
+    ShaderParams shader_program{};
+    ShaderParams pulling_program{};
+
+    if (!options.points) {
+        auto pulling_defines = options.pulling && !options.pull_benchmark ? vertex_pulling_defines : "";
+
+        shader_program = CreateShaderProgram(vertex_shader_path, fragment_shader_path,
+                                             forward_defines + pulling_defines);
+    }
+
+    if (options.pull_benchmark) {
+        pulling_program = CreateShaderProgram(vertex_shader_path, fragment_shader_path,
+                                              forward_defines + vertex_pulling_defines);
+    }
+
+    std::cout << "Materials: " << scene_params.materials.count << " via "
+              << (scene_params.materials.bindless ? "bindless textures" : "texture arrays") << ", "
+              << scene_params.draws.size() << " draws in one multi-draw" << std::endl;
+
+    // Deferred path: G-buffer and lighting pass over the light list
+    DeferredParams deferred_params{};
+
+    if (options.deferred) {
+        deferred_params = CreateDeferredRenderer(options.render_mode, scene_params.materials, scene_globals,
+                                                 (options.pulling ? vertex_pulling_defines : "") + ao_defines,
+                                                 ao_defines);
+    }
+
+    // Forward path: lights are binned into clusters before shading
+    ClusterParams cluster_params{};
+
+    if (!options.deferred && !options.points) {
+        cluster_params = CreateClusters();
+        UpdateClusters(cluster_params, scene_globals);
+    }
+
+    // Forward passes draw into an offscreen target with float depth (reverse-Z), multisampled or not depending
+    // on the antialiasing mode, and resolved into the window; the deferred path has its own G-buffer
+    RenderTarget render_target{};
+    AntialiasingParams aa_params{};
+    AntialiasingBenchmark aa_benchmark_state;
+
+    if (!options.deferred && !options.points) {
+        // the benchmark starts from the first mode and goes through all of them
+        auto aa_mode = options.aa_benchmark ? AntialiasingMode::no_aa : options.input.antialiasing;
+
+        aa_params = CreateAntialiasing(aa_mode, options.aa_benchmark);
+        render_target = CreateRenderTarget(scene_globals.width, scene_globals.height,
+                                           AntialiasingSamples(aa_params.mode));
+
+        std::cout << "Antialiasing: " << AntialiasingStats(aa_params, render_target) << std::endl;
+    }
+
+    // Depth pre-pass (forward path)
+    PrepassParams prepass_params{};
+
+    if (options.depth_prepass || options.overdraw) {
+        prepass_params = CreatePrepass(scene_params.buffer_tris.vertex_list.get(),
+                                       scene_params.vertices_count_tris, options.overdraw);
+    }
+
+    // Shadow map of the key light; only redrawn when the model rotates or the light moves
+    ShadowParams shadow_params{};
+
+    if (options.shadows) {
+        shadow_params = CreateShadows(scene_params.buffer_tris.vertex_list.get(), scene_params.vertices_count_tris,
+                                      scene_params.draws);
+        BindShadows(shadow_params);
+    }
+
+    // Octahedral impostors (forward path) for instances that are small on screen, baked while the vertex list and
+    // the attribute vertex array are still there
+    ImpostorParams impostor_params{};
+
+    if (options.impostors) {
+        impostor_params = CreateImpostors(scene_description, scene_params, options.render_mode,
+                                          options.input.impostor_pixels);
+
+        std::cout << "Impostors: " << impostor_params.meshes.size() << " meshes, " << impostor_params.baked
+                  << " baked and " << impostor_params.cached << " read from " << impostor_cache_dir << " in "
+                  << impostor_params.bake_ms << " ms" << std::endl;
+    }
+
+    // Dynamic resolution (forward path): the render size follows the GPU time of the main pass
+    DynamicResolutionParams dynres_params{};
+
+    if (options.dynres) {
+        dynres_params = CreateDynamicResolution(options.input.dynamic_resolution_ms, options.input.edge_aware_upscale);
+    }
+
+    // Camera path benchmark: replays a scripted or recorded sequence of views, then reports and exits
+    CameraBenchmark camera_bench_state;
+
+    if (options.camera_bench) {
+        camera_bench_state.path = options.input.camera_path_file.empty() ? BuiltinCameraPath() :
+                                  LoadCameraPath(options.input.camera_path_file);
+
+        std::cout << "Camera path '" << camera_bench_state.path.name << "': " << camera_bench_state.path.keys.size()
+                  << " keys, " << CameraPathFrames(camera_bench_state.path) << " frames after "
+                  << camera_warmup_frames << " warm-up frames" << std::endl;
+    }
+
+    // Recording saves the views of an interactive session as a camera path
+    CameraPath recorded_path;
+    unsigned int recorded_frames = 0;
+
+    // Scene time of the animations; a replayed path makes it a function of the frame, so every run draws the same
+    auto scene_time = [&]() {
+        return options.camera_bench ? CameraBenchmarkTime(camera_bench_state) : glfwGetTime();
+    };
+
+    // Stress mode: lights orbit the model and frame times are reported
+    auto stress = options.input.stress;
+    auto report_stats = stress || options.overdraw || options.shadows || options.dynres || options.streamed ||
+                        options.impostors || options.deform || options.points;
+
+    // The benchmarks and the deformation draw continuously, like stress mode
+    auto continuous = stress || options.aa_benchmark || options.pull_benchmark || options.camera_bench ||
+                      options.deform;
+
+    // GPU time of the shadow, deformation and main passes, reported with the frame times
+    auto gpu_timing = options.shadows || options.aa_benchmark || options.dynres || options.pull_benchmark ||
+                      options.camera_bench || options.deform || options.points;
+
+    GpuTimer shadow_timer;
+    GpuTimer deform_timer;
+    GpuTimer main_timer;
+
+    // reported by the camera path benchmark: main, shadow, deformation
+    GpuTimer *camera_bench_timers[] = {&main_timer, options.shadows ? &shadow_timer : nullptr,
+                                       options.deform ? &deform_timer : nullptr};
+
+    if (gpu_timing) {
+        CreateGpuTimer(shadow_timer);
+        CreateGpuTimer(deform_timer);
+        CreateGpuTimer(main_timer);
+    }
+    auto base_lights = scene_params.lights;
+
+    FrameStats frame_stats;
+    StartFrameStats(frame_stats, glfwGetTime());
+
+    // On-demand mode only redraws on changes, resize or expose
+    auto pacing = SetupFramePacing(options.input.on_demand);
 
-    // Create and link shaders, and load textures
-    ShaderParams shader_program = CreateShaderProgram(vertex_shader_path,
-                                                      fragment_shader_path);
+    if (options.aa_benchmark || options.pull_benchmark || options.camera_bench) {
+        // frame times must not be capped by the refresh rate
+        glfwSwapInterval(0);
+    }
 
     // Depth buffer
     glEnable(GL_DEPTH_TEST);
@@ -43,55 +226,450 @@ int main(int argc, char* argv[]) {
     // Install shader
     glUseProgram(shader_program.program);
 
+    // CPU-side BVH per mesh for mouse picking, built from the vertex list before it is freed; points have no faces
+    ScenePicker picker;
+
+    if (!options.streamed && !options.points) {
+        JobSystem jobs;
+
+        auto start = std::chrono::steady_clock::now();
+        picker = BuildScenePicker(scene_params.buffer_tris.vertex_list.get(), scene_params.draws, jobs);
+        auto build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::size_t node_count = 0;
+        std::size_t picker_bytes = 0;
+
+        for (const auto &mesh: picker.meshes) {
+            node_count += mesh.nodes.size();
+            picker_bytes += mesh.nodes.capacity() * sizeof(BvhNode) + mesh.packets.capacity() * sizeof(TrianglePacket);
+        }
+        TrackMemory(MemoryCategory::cpu_picking, picker_bytes);
+
+        std::cout << "Picking BVH: " << picker.meshes.size() << " meshes, " << node_count << " nodes, built in "
+                  << build_ms << " ms on " << jobs.ThreadCount() << " threads" << std::endl;
+    }
+
+    // Reports the face under the cursor after a left click; runs on the thread handling input
+    auto handle_pick = [&]() {
+        if(!scene_globals.pick_) {
+            return;
+        }
+        scene_globals.pick_ = false;
+
+        if(options.streamed || options.points) {
+            std::cout << "Picking is not available with 'stream=' or 'points'" << std::endl;
+            return;
+        }
+
+        auto pick = PickFace(picker, scene_params.instances, scene_globals.pick_x, scene_globals.pick_y,
+                             scene_globals);
+
+        if(pick.hit) {
+            std::cout << "Picked instance " << pick.instance << " face " << pick.face << " barycentrics ("
+                      << pick.u << ", " << pick.v << ") at (" << pick.position.x << ", " << pick.position.y
+                      << ", " << pick.position.z << ") in " << pick.microseconds << " us" << std::endl;
+        } else {
+            std::cout << "Picked nothing in " << pick.microseconds << " us" << std::endl;
+        }
+    };
+
+    // Attribute streams of vertex pulling, split from the vertex list before it is freed; every draw reads them
+    // through the same bindings
+    VertexStreams vertex_streams{};
+    VertexPullingBenchmark pull_benchmark_state;
+
+    if (options.pulling) {
+        vertex_streams = CreateVertexStreams(scene_params.buffer_tris.vertex_list.get(),
+                                             scene_params.vertices_count_tris);
+        BindVertexStreams(vertex_streams);
+
+        std::cout << VertexPullingStats(vertex_streams, options.render_mode, options.input.render_path) << std::endl;
+    }
+
+    // vertex array of the attribute path, which the benchmark starts with
+    auto attribute_vao = buffer_tris;
+
+    if (options.pulling && !options.pull_benchmark) {
+        buffer_tris = vertex_streams.empty_vao;
+        scene_params.buffer_tris.vao = vertex_streams.empty_vao;
+    }
+
+    // Welded vertices and morph targets of the deformation, also taken from the vertex list
+    DeformationParams deform_params{};
+
+    if (options.deform) {
+        deform_params = CreateDeformation(scene_params, options.render_mode, options.input.deformation);
+
+        std::cout << "GPU " << DeformationStats(deform_params) << std::endl;
+    }
+
+    // Ambient occlusion, cast against the picking BVHs; an extra attribute of the vertex arrays that draw the scene
+    AmbientOcclusionParams ao_params{};
+
+    if (options.ambient_occlusion) {
+        ao_params = CreateAmbientOcclusion(scene_params.buffer_tris.vertex_list.get(),
+                                           scene_params.vertices_count_tris, scene_params.draws, picker,
+                                           options.input.ao_rays);
+        BindAmbientOcclusion(ao_params, attribute_vao);
+
+        if (options.pulling) {
+            BindAmbientOcclusion(ao_params, vertex_streams.empty_vao);
+        }
+        std::cout << "Ambient occlusion: " << AmbientOcclusionStats(ao_params) << std::endl;
+    }
+
+    // Point splats: compute passes over the shared vertex buffer, read as points
+    PointSplatParams splat_params{};
+
+    if (options.points) {
+        splat_params = CreatePointSplats(scene_params, scene_globals);
+
+        std::cout << "Point splats: " << PointSplatStats(splat_params) << std::endl;
+    }
+
     // free vertex lists
     scene_params.buffer_tris.vertex_list.reset();
+    ReleaseMemory(MemoryCategory::cpu_vertex_copy, scene_params.vertices_count_tris * sizeof(Vertex));
 
-    // set texture uniforms
-    glUniform1i(glGetUniformLocation(shader_program.program, color_texture_name.c_str()),
-                0);
-    glUniform1i(glGetUniformLocation(shader_program.program, normal_texture_name.c_str()),
-                1);
+    // texture arrays (if not bindless) stay bound on their units
+    if (!options.points) {
+        SetMaterialSamplers(shader_program.program);
+    }
+    BindMaterialTextures(scene_params.materials);
+
+    if (options.shadows) {
+        SetShadowSampler(shader_program.program);
+    }
+
+    if (options.pull_benchmark) {
+        SetMaterialSamplers(pulling_program.program);
+
+        if (options.shadows) {
+            SetShadowSampler(pulling_program.program);
+        }
+        glUseProgram(shader_program.program);
+    }
 
     // initial viewport dimensions
     glViewport(0, 0, scene_globals.width, scene_globals.height);
 
     // Enable wireframe if provided as an input
-    if(input_options.opt == ShadingOption::wireframe) {
+    if(options.wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
 
     // resize callback
     SetResizeCallback(window);
 
-    while (!glfwWindowShouldClose(window.get())) {
+    // Draws and presents one frame; view_changed after new transforms or a resize
+    auto draw_frame = [&](const SceneGlobals &window_globals, bool view_changed) {
+        // the forward path renders at a reduced size with dynamic resolution
+        auto frame_globals = options.dynres ? GetRenderGlobals(dynres_params, window_globals) : window_globals;
+
+        // chunks that arrived are uploaded and the visible resident ones become the draw commands
+        if(options.streamed) {
+            UpdateStreaming(streaming_params, scene_params, frame_globals);
+        }
+
+        // distant instances leave the multi-draw for their impostor
+        if(options.impostors) {
+            UpdateImpostors(impostor_params, scene_params, frame_globals);
+        }
+
+        // every pass of the frame draws the deformed vertex buffer
+        if(options.deform) {
+            BeginGpuTimer(deform_timer);
+            UpdateDeformation(deform_params, scene_time());
+            EndGpuTimer(deform_timer);
+        }
+
+        if(options.shadows) {
+            // the key light stays put, also in stress mode: nothing is drawn unless the model rotated
+            if(ShadowsOutdated(shadow_params, scene_params, frame_globals)) {
+                BeginGpuTimer(shadow_timer);
+                RenderShadows(shadow_params, scene_params, frame_globals);
+                EndGpuTimer(shadow_timer);
+            }
+        }
+
+        if(gpu_timing) {
+            BeginGpuTimer(main_timer);
+        }
+
+        // a new render size needs the lights re-binned, like a new view; it rebuilds the upscale framebuffer, so
+        // it comes before the render target is bound
+        if(options.dynres && BeginDynamicResolution(dynres_params, scene_params, frame_globals, view_changed)) {
+            view_changed = true;
+        }
+
+        if(!options.deferred && !options.points) {
+            BindRenderTarget(render_target, frame_globals, AntialiasingSamples(aa_params.mode));
+            JitterProjection(aa_params, scene_params, frame_globals);
+        }
+
         // new frame - clear color and depth buffers
-        glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+        glClearColor(clear_color.x, clear_color.y, clear_color.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // update uniforms based on glfw events and callbacks
-        if(scene_globals.dirty_) {
-            UpdateTransformUniforms(scene_params.transforms_handle, model_choice, scene_globals);
+        auto lights_changed = stress || view_changed;
 
-            // Uniforms are up-to-date now
-            scene_globals.dirty_ = false;
+        if(stress) {
+            AnimateLights(base_lights, scene_time(), scene_params.lights);
+            UpdateLightBuffer(scene_params.lights_handle, scene_params.lights);
+        }
+
+        // re-bin lights when the view or the lights moved
+        if(lights_changed && !options.deferred && !options.points) {
+            UpdateClusters(cluster_params, frame_globals);
         }
 
         // render
-        glBindVertexArray(buffer_tris);
-        glDrawArrays(GL_TRIANGLES, 0, scene_params.vertices_count_tris);
+        if(options.points) {
+            RenderPointSplats(splat_params, scene_params, frame_globals);
+        } else if(options.deferred) {
+            RenderDeferred(deferred_params, scene_params, frame_globals);
+        } else {
+            if(options.depth_prepass) {
+                BeginDepthPrepass(prepass_params, scene_params);
+            }
+
+            DrawScene(scene_params, buffer_tris);
+
+            if(options.depth_prepass) {
+                EndDepthPrepass();
+            }
+
+            if(options.impostors) {
+                DrawImpostors(impostor_params);
+            }
+
+            if(options.overdraw) {
+                CountOverdraw(prepass_params, scene_params, options.depth_prepass, frame_globals);
+                DrawOverdrawHeatmap(prepass_params);
+            }
+
+            if(options.dynres) {
+                ResolveAntialiasing(aa_params, render_target, scene_params, frame_globals,
+                                    DynamicResolutionOutput(dynres_params, window_globals));
+                UpscaleToWindow(dynres_params, window_globals);
+            } else {
+                ResolveAntialiasing(aa_params, render_target, scene_params, frame_globals);
+            }
+        }
 
-        // swap buffers and poll for user input
+        if(gpu_timing) {
+            EndGpuTimer(main_timer);
+        }
+
+        if(options.dynres) {
+            UpdateDynamicResolution(dynres_params, main_timer);
+        }
+
+        // swap buffers
         glfwSwapBuffers(window.get());
 
-        if(save_to_image) {
+        RecordDrawnFrame(pacing);
+
+        if(report_stats) {
+            auto now = glfwGetTime();
+
+            RecordFrame(frame_stats, now);
+
+            if(FrameStatsDue(frame_stats, now)) {
+                auto extra = std::to_string(scene_params.lights.size()) + " lights";
+
+                if(options.overdraw) {
+                    extra += ", " + ReadOverdrawStats(prepass_params);
+                }
+                if(pacing.on_demand) {
+                    extra += ", " + PacingStats(pacing, now);
+                }
+                if(options.dynres) {
+                    extra += ", " + DynamicResolutionStats(dynres_params, window_globals);
+                }
+                if(options.streamed) {
+                    extra += ", " + StreamingStats(streaming_params);
+                }
+                if(options.impostors) {
+                    extra += ", " + ImpostorStats(impostor_params);
+                }
+                if(options.deform) {
+                    extra += ", " + GpuTimerStats(deform_timer, "deformation");
+                }
+                if(options.points) {
+                    extra += ", " + PointSplatStats(splat_params) + ", " + GpuTimerStats(main_timer, "splat passes");
+                }
+                if(options.shadows) {
+                    extra += ", " + GpuTimerStats(main_timer, "main pass") + ", " +
+                             GpuTimerStats(shadow_timer, "shadow pass") + " (" +
+                             std::to_string(shadow_params.renders) + " shadow maps drawn)";
+                }
+                ReportFrameStats(frame_stats, now, extra);
+            }
+        }
+
+        if(options.aa_benchmark && AdvanceAntialiasingBenchmark(aa_benchmark_state, aa_params, render_target,
+                                                                main_timer, glfwGetTime())) {
+            glfwSetWindowShouldClose(window.get(), GLFW_TRUE);
+        }
+
+        if(options.pull_benchmark) {
+            if(AdvanceVertexPullingBenchmark(pull_benchmark_state, main_timer, glfwGetTime(),
+                                             DrawnVertices(scene_params.draws),
+                                             PulledBytesPerVertex(options.render_mode, options.input.render_path))) {
+                glfwSetWindowShouldClose(window.get(), GLFW_TRUE);
+            }
+
+            // the next run may be in the other mode
+            glUseProgram(pull_benchmark_state.pulling ? pulling_program.program : shader_program.program);
+            buffer_tris = pull_benchmark_state.pulling ? vertex_streams.empty_vao : attribute_vao;
+        }
+
+        // primitives per frame: a point splat counts as one triangle
+        if(options.camera_bench && AdvanceCameraBenchmark(camera_bench_state, camera_bench_timers, glfwGetTime(),
+                                                  DrawnVertices(scene_params.draws) / (options.points ? 1 : 3))) {
+            auto record = CameraBenchmarkRecord(camera_bench_state, camera_bench_timers);
+            auto report_file = options.input.report_file.empty() ? benchmark_report_default :
+                               options.input.report_file;
+
+            record.renderer = "opengl";
+            record.device = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+            record.model = options.streamed ? std::filesystem::path(options.input.stream_file).stem().string() :
+                           !options.input.scene_file.empty() ?
+                           std::filesystem::path(options.input.scene_file).stem().string() :
+                           ModelName(options.input.model);
+            record.shading = ShadingName(options.render_mode);
+            record.render_path = options.deferred ? deferred_str : "forward";
+
+            std::cout << "Camera path " << BenchmarkRecordStats(record) << std::endl;
+
+            if(!AppendBenchmarkRecord(report_file, record)) {
+                std::cout << "Could not write " << report_file << std::endl;
+            }
+            glfwSetWindowShouldClose(window.get(), GLFW_TRUE);
+        }
+
+        if(options.save_image) {
             // Save to a png
             SaveToFile(window);
         }
+    };
+
+    if(options.threaded) {
+        // Input and transforms on this (main) thread, GL on a render thread; they only share the
+        // lock-free snapshot channel
+        SnapshotChannel channel;
+        SceneGlobals frame_globals = scene_globals;
+
+        glfwMakeContextCurrent(nullptr);
+
+        std::thread render_thread([&]() {
+            glfwMakeContextCurrent(window.get());
+
+            while(channel.running) {
+                auto version = channel.version.load(std::memory_order_acquire);
+                auto view_changed = AcquireSnapshot(channel, frame_globals, scene_params);
+
+                if(!view_changed && pacing.on_demand && !continuous &&
+                   !(options.streamed && StreamingBusy(streaming_params))) {
+                    // nothing new to draw; sleep until the input thread publishes again
+                    WaitForSnapshot(channel, version);
+                    continue;
+                }
+
+                draw_frame(frame_globals, view_changed);
+            }
+            glfwMakeContextCurrent(nullptr);
+        });
+
+        RunInputLoop(window, scene_params.instances, scene_globals, channel, handle_pick);
+
+        render_thread.join();
+        glfwMakeContextCurrent(window.get());
+    } else {
+        while (!glfwWindowShouldClose(window.get())) {
+            handle_pick();
+
+            // sleep until there is something to draw (on-demand mode)
+            // chunks still arriving count as animation
+            auto animating = continuous || (options.streamed && StreamingBusy(streaming_params));
+
+            if(!WaitForFrame(pacing, scene_globals, animating)) {
+                continue;
+            }
+            scene_globals.redraw_ = false;
+
+            // the camera path sets the view of every frame, and the window follows its size
+            if(options.camera_bench && ApplyCameraBenchmark(camera_bench_state, scene_globals)) {
+                glfwSetWindowSize(window.get(), (int) scene_globals.width, (int) scene_globals.height);
+            }
+
+            // update uniforms based on glfw events and callbacks
+            auto view_changed = scene_globals.dirty_;
 
-        glfwPollEvents();
+            if(view_changed) {
+                glViewport(0, 0, scene_globals.width, scene_globals.height);
+
+                UpdateTransformUniforms(scene_params, scene_globals);
+                UpdateLightingUniforms(scene_params.lighting_handle, scene_globals);
+
+                // Uniforms are up-to-date now
+                scene_globals.dirty_ = false;
+            }
+
+            draw_frame(scene_globals, view_changed);
+
+            if(options.recording) {
+                RecordCameraKey(recorded_path, recorded_frames++, scene_globals);
+            }
+
+            // poll for user input
+            glfwPollEvents();
+        }
     }
+    if(pacing.on_demand) {
+        std::cout << PacingStats(pacing, glfwGetTime()) << std::endl;
+    }
+
+    if(options.recording) {
+        if(SaveCameraPath(recorded_path, options.input.record_file)) {
+            std::cout << "Camera path: " << recorded_path.keys.size() << " keys over " << recorded_frames
+                      << " frames saved to " << options.input.record_file << std::endl;
+        } else {
+            std::cout << "Could not write " << options.input.record_file << std::endl;
+        }
+    }
+
+    // what the run held at its peak, and still holds
+    if(options.input.memory_report || options.input.cpu_budget_mb > 0 || options.input.gpu_budget_mb > 0) {
+        std::cout << MemoryReport() << std::endl;
+    }
+
     // on exit clean up / free operations
-    glDeleteBuffers(1, &buffer_tris);
+    glDeleteVertexArrays(1, &attribute_vao);
+    DeleteRenderTarget(render_target);
+
+    if (options.pulling) {
+        DeleteVertexStreams(vertex_streams);
+    }
+    if (options.impostors) {
+        DeleteImpostors(impostor_params);
+    }
+    if (options.deform) {
+        DeleteDeformation(deform_params);
+    }
+    if (options.ambient_occlusion) {
+        DeleteAmbientOcclusion(ao_params);
+    }
+    if (options.points) {
+        DeletePointSplats(splat_params);
+    }
+
+    if (gpu_timing) {
+        DeleteGpuTimer(shadow_timer);
+        DeleteGpuTimer(deform_timer);
+        DeleteGpuTimer(main_timer);
+    }
 
     glfwTerminate();
 
@@ -0,0 +1,144 @@
+#include "load-utils/mesh_codec.h"
+
+#include <fstream>
+#include <limits>
+
+// Compresses an .obj or .off into the .dmc container, then decodes it back to verify it and time the decoder
+const std::string bits_str = "bits=";
+const int decode_repeats = 5;
+
+MeshDecodeStats TimeDecode(const std::vector<std::uint8_t> &file, JobSystem *jobs) {
+    // Best of a few runs, so the first touch of the output pages does not count
+    MeshDecodeStats best;
+
+    for (int i = 0; i < decode_repeats; ++i) {
+        MeshDecodeStats stats;
+
+        DecodeMesh(file.data(), file.size(), jobs, &stats);
+
+        if (i == 0 || stats.milliseconds < best.milliseconds) {
+            best = stats;
+        }
+    }
+    return best;
+}
+
+double MaxPositionError(const IndexedMesh &original, const IndexedMesh &decoded) {
+    // Triangles come back in order but possibly rotated; compare each with its best matching rotation
+    double max_error = 0;
+
+    for (std::size_t face = 0; face < original.indices.size() / 3; ++face) {
+        double face_error = std::numeric_limits<double>::max();
+
+        for (int rotation = 0; rotation < 3; ++rotation) {
+            double error = 0;
+
+            for (int corner = 0; corner < 3; ++corner) {
+                auto a = original.indices[3 * face + corner];
+                auto b = decoded.indices[3 * face + (corner + rotation) % 3];
+
+                for (int c = 0; c < 3; ++c) {
+                    error = std::max(error, (double) std::abs(original.positions[3 * a + c] -
+                                                              decoded.positions[3 * b + c]));
+                }
+            }
+            face_error = std::min(face_error, error);
+        }
+        max_error = std::max(max_error, face_error);
+    }
+    return max_error;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 3) {
+        std::cout << "Usage: dragon-mesh-encode <input .obj|.off> <output .dmc> [bits=N]" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    std::string input_fname = argv[1];
+    std::string output_fname = argv[2];
+    unsigned int position_bits = position_bits_default;
+
+    if(argc > 3) {
+        std::string extras = argv[3];
+
+        try {
+            position_bits = extras.starts_with(bits_str) ? std::stoi(extras.substr(bits_str.size())) : 0;
+        } catch (const std::logic_error &) {
+            position_bits = 0;
+        }
+        if(position_bits < 10 || position_bits > 16) {
+            std::cout << "Invalid option, try 'bits=N' with N between 10 and 16" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    auto mesh = ReadIndexedMesh(input_fname);
+
+    JobSystem jobs;
+
+    auto start = std::chrono::steady_clock::now();
+    auto file = EncodeMesh(mesh, position_bits, jobs);
+    auto encode_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream filestream(output_fname, std::ios::binary);
+    filestream.write(reinterpret_cast<const char *>(file.data()), (std::streamsize) file.size());
+
+    if(!filestream) {
+        std::cout << "Failed to write " << output_fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    // Round trip: same faces, positions within one quantization step of the bounding box diagonal
+    auto decoded = DecodeMesh(file.data(), file.size(), &jobs);
+    auto face_count = mesh.indices.size() / 3;
+
+    if(decoded.indices.size() != mesh.indices.size() || decoded.uv_coords.empty() != mesh.uv_coords.empty()) {
+        std::cout << "Round trip failed: decoded " << decoded.indices.size() / 3 << " of " << face_count
+                  << " faces" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    Eigen::Vector3d low = Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+    Eigen::Vector3d high = -low;
+
+    for (std::size_t i = 0; i < mesh.positions.size(); ++i) {
+        low[(int) (i % 3)] = std::min(low[(int) (i % 3)], (double) mesh.positions[i]);
+        high[(int) (i % 3)] = std::max(high[(int) (i % 3)], (double) mesh.positions[i]);
+    }
+
+    auto tolerance = face_count > 0 ? (high - low).norm() / ((1u << position_bits) - 1) : 0.0;
+    auto max_error = face_count > 0 ? MaxPositionError(mesh, decoded) : 0.0;
+
+    if(max_error > tolerance) {
+        std::cout << "Round trip failed: position error " << max_error << " above " << tolerance << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    auto raw_bytes = sizeof(float) * (mesh.positions.size() + mesh.uv_coords.size()) +
+                     sizeof(std::uint32_t) * mesh.indices.size();
+
+    std::cout << input_fname << ": " << mesh.positions.size() / 3 << " vertices, " << face_count << " faces"
+              << (mesh.uv_coords.empty() ? "" : ", uv") << std::endl;
+    std::cout << "Encoded " << raw_bytes << " -> " << file.size() << " bytes ("
+              << (double) raw_bytes / (double) std::max<std::size_t>(file.size(), 1) << "x, "
+              << 8.0 * (double) file.size() / (double) std::max<std::size_t>(face_count, 1)
+              << " bits/triangle) in " << encode_ms << " ms, max position error " << max_error << std::endl;
+
+    auto single = TimeDecode(file, nullptr);
+    auto parallel = TimeDecode(file, &jobs);
+
+    auto throughput = [](const MeshDecodeStats &stats) {
+        return (double) stats.output_bytes / (stats.milliseconds * 1e6);
+    };
+
+    std::cout << "Decode: " << single.milliseconds << " ms (" << throughput(single) << " GB/s) on 1 thread, "
+              << parallel.milliseconds << " ms (" << throughput(parallel) << " GB/s) on " << jobs.ThreadCount()
+              << " threads" << std::endl;
+
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,82 @@
+#include "load-utils/mesh_octree.h"
+
+// Splits an .obj or .off into the paged octree container (.dmo) streamed by 'stream=path', see mesh_octree.h
+const std::string chunk_str = "chunk=";
+const std::string memory_str = "memory=";
+
+unsigned long ParseBuildOption(const std::string &extras, const std::string &name, unsigned long low,
+                               unsigned long high) {
+    // Value of 'name=N' within [low, high]
+    unsigned long value = 0;
+
+    try {
+        value = std::stoul(extras.substr(name.size()));
+    } catch (const std::logic_error &) {
+        value = 0;
+    }
+    if(value < low || value > high) {
+        std::cout << "Invalid option, try '" << name << "N' with N between " << low << " and " << high << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    return value;
+}
+
+int main(int argc, char* argv[]) {
+    if(argc < 3) {
+        std::cout << "Usage: dragon-octree-build <input .obj|.off> <output .dmo> [chunk=N] [memory=MB]" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    std::string input_fname = argv[1];
+    std::string output_fname = argv[2];
+    OctreeBuildOptions options;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string extras = argv[i];
+
+        if(extras.starts_with(chunk_str)) {
+            options.chunk_triangles = (std::uint32_t) ParseBuildOption(extras, chunk_str, 256, 1u << 20);
+        } else if(extras.starts_with(memory_str)) {
+            options.memory_mb = ParseBuildOption(extras, memory_str, 16, 1u << 20);
+        } else {
+            std::cout << "Invalid option, try 'chunk=N' 'memory=MB'" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    auto stats = BuildOctreeMesh(input_fname, output_fname, options);
+
+    // Read back the tables the renderer will use
+    auto mesh = ReadOctreeMesh(output_fname);
+
+    std::uint64_t chunked = 0;
+    std::uint32_t largest = 0;
+
+    for (const auto &chunk: mesh.chunks) {
+        chunked += chunk.triangle_count;
+        largest = std::max(largest, chunk.triangle_count);
+    }
+    if(chunked != stats.triangle_count) {
+        std::cout << "Build failed: " << chunked << " of " << stats.triangle_count << " triangles in chunks"
+                  << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    auto megabytes = [](std::uint64_t bytes) {
+        return (double) bytes / (1 << 20);
+    };
+
+    std::cout << input_fname << ": " << stats.vertex_count << " vertices, " << stats.triangle_count
+              << " triangles" << (mesh.header.has_uv ? ", uv" : "") << std::endl;
+    std::cout << "Built " << stats.node_count << " nodes, " << stats.chunk_count << " chunks (largest "
+              << largest << " triangles, " << megabytes((std::uint64_t) largest * 3 * sizeof(Vertex))
+              << " MB) in " << stats.milliseconds << " ms; " << megabytes(stats.output_bytes) << " MB written"
+              << std::endl;
+    std::cout << "Memory: " << megabytes(stats.window_bytes) << " MB vertex window in " << stats.window_passes
+              << " passes, up to " << megabytes(stats.temporary_bytes) << " MB of temporary files" << std::endl;
+
+    exit(EXIT_SUCCESS);
+}
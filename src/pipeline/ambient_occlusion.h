@@ -0,0 +1,81 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_AMBIENT_OCCLUSION_H
+#define DRAGON_GL_AMBIENT_OCCLUSION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+#include "bvh.h"
+#include "job_system.h"
+#include "deformation.h"
+
+/* Baked ambient occlusion ('ao=N'). At load time every vertex casts N rays over the hemisphere around its normal
+ * (cosine weighted Hammersley points, rotated per vertex so neighbours do not band) against the picking BVH of its
+ * mesh, in parallel over all cores. The fraction that escapes within a part of the mesh radius is the vertex's
+ * visibility, packed in one normalized byte and bound as vertex attribute 4 next to the interleaved vertices. The
+ * shaders add an ambient term scaled by it, at no cost per frame. Corners sharing a position are welded first so
+ * each loaded vertex is baked once. Bakes are cached on disk per mesh, keyed by its vertices and the settings */
+const GLuint ao_attribute = 4;          // location of aVisibility in the shaders
+const float ao_distance = 0.3f;         // rays count as occluded within this part of the mesh radius
+const float ao_offset = 1e-4f;          // ray origins leave the surface by this part of the mesh radius
+const std::size_t ao_grain = 256;       // vertices per job
+const std::string ao_shader_defines = "#define AMBIENT_OCCLUSION\n#define AO_AMBIENT 0.12\n";
+
+const std::string ao_cache_dir = "ao_cache";
+const std::string ao_cache_extension = ".dao";
+const char ao_cache_magic[4] = {'D', 'A', 'O', '1'};
+const std::uint32_t ao_cache_version = 1;
+
+// Header of a cached bake; followed by one visibility byte per vertex of the mesh range
+struct AoCacheHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint32_t vertex_count;
+    std::uint32_t rays;
+};
+
+struct AmbientOcclusionParams {
+    unsigned int rays = 0;  // per vertex
+    GLuint buffer = 0;      // one byte per vertex of the scene's vertex list
+
+    // Bake stats
+    std::size_t meshes = 0;
+    std::size_t cached = 0;
+    std::size_t vertices = 0;  // welded, of the baked meshes
+    std::uint64_t rays_cast = 0;
+    double bake_ms = 0.0;
+    std::size_t threads = 0;
+};
+
+GlmVec3 HemisphereSample(unsigned int index, unsigned int count, const glm::vec2 &rotation);
+std::vector<std::uint8_t> BakeMeshOcclusion(const Vertex *vertices, GLuint count, const Bvh &bvh,
+                                            unsigned int rays, JobSystem &jobs, std::size_t &welded);
+AmbientOcclusionParams CreateAmbientOcclusion(const Vertex *vertices, unsigned int vertex_count,
+                                              const std::vector<DrawCommand> &draws, const ScenePicker &picker,
+                                              unsigned int rays);
+void BindAmbientOcclusion(const AmbientOcclusionParams &occlusion, GLuint vao);
+std::string AmbientOcclusionStats(const AmbientOcclusionParams &occlusion);
+void DeleteAmbientOcclusion(AmbientOcclusionParams &occlusion);
+
+#endif // DRAGON_GL_AMBIENT_OCCLUSION_H
@@ -0,0 +1,314 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "antialiasing.h"
+
+namespace {
+    float Halton(unsigned int index, unsigned int base) {
+        // Radical inverse of index in the given base, in [0, 1)
+        float result = 0.0f;
+        float fraction = 1.0f / (float) base;
+
+        while (index > 0) {
+            result += fraction * (float) (index % base);
+            index /= base;
+            fraction /= (float) base;
+        }
+        return result;
+    }
+
+    GlmMat4 ModelClipMatrix(const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+        // Model space of the first instance -> clip space, without jitter; the whole scene rotates with it
+        auto projection = GetPerspectiveMatrix(scene_globals.fov,
+                                               (float) scene_globals.width / (float) scene_globals.height,
+                                               near_plane);
+        auto world = scene_params.instances.empty() ? GlmMat4(1.0f) :
+                     GetWorldSpaceMatrix(scene_params.instances[0].transform, scene_globals);
+
+        return projection * GetViewMatrix() * world;
+    }
+
+    void DeleteHistory(AntialiasingParams &aa) {
+        glDeleteFramebuffers(2, aa.history_fbo);
+        ReleaseGlObjects(GL_TEXTURE, 2, aa.history);
+        glDeleteTextures(2, aa.history);
+
+        for (int i = 0; i < 2; ++i) {
+            aa.history[i] = 0;
+            aa.history_fbo[i] = 0;
+        }
+        aa.width = 0;
+        aa.height = 0;
+        aa.history_valid = false;
+    }
+
+    void CreateHistory(AntialiasingParams &aa, unsigned int width, unsigned int height) {
+        // Two RGBA16F color targets; reprojection reads the history between texels, so it is filtered
+        DeleteHistory(aa);
+
+        aa.width = width;
+        aa.height = height;
+
+        for (int i = 0; i < 2; ++i) {
+            aa.history[i] = CreateRenderTexture(GL_RGBA16F, width, height);
+
+            glBindTexture(GL_TEXTURE_2D, aa.history[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            glGenFramebuffers(1, &aa.history_fbo[i]);
+            glBindFramebuffer(GL_FRAMEBUFFER, aa.history_fbo[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, aa.history[i], 0);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                std::cout << "TAA history framebuffer is incomplete" << std::endl;
+
+                exit(EXIT_FAILURE);
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
+
+void DrawFullscreenPass(const ShaderParams &program) {
+    // Fullscreen triangle over the bound framebuffer, filled even in wireframe mode
+    GLint polygon_mode[2];
+    glGetIntegerv(GL_POLYGON_MODE, polygon_mode);
+
+    glDisable(GL_DEPTH_TEST);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    glUseProgram(program.program);
+    glBindVertexArray(EmptyVertexArray());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glPolygonMode(GL_FRONT_AND_BACK, (GLenum) polygon_mode[0]);
+    glEnable(GL_DEPTH_TEST);
+}
+
+GLsizei AntialiasingSamples(AntialiasingMode mode) {
+    // MSAA samples of the render target; the post-process modes work on a single sampled one
+    if (mode == AntialiasingMode::msaa_2x) {
+        return 2;
+    } else if (mode == AntialiasingMode::msaa_4x) {
+        return 4;
+    } else if (mode == AntialiasingMode::msaa_8x) {
+        return 8;
+    }
+    return 0;
+}
+
+AntialiasingParams CreateAntialiasing(AntialiasingMode mode, bool all_modes) {
+    // Resolve programs of the post-process modes; all of them for the benchmark
+    AntialiasingParams aa;
+
+    aa.mode = mode;
+
+    if (all_modes || mode == AntialiasingMode::fxaa) {
+        aa.fxaa_program = CreateShaderProgram(present_dir + "/vertex.glsl", antialiasing_dir + "/fxaa.glsl");
+
+        glUseProgram(aa.fxaa_program.program);
+        glUniform1i(glGetUniformLocation(aa.fxaa_program.program, "currentColor"), (GLint) aa_color_unit);
+    }
+
+    if (all_modes || mode == AntialiasingMode::taa) {
+        aa.taa_program = CreateShaderProgram(present_dir + "/vertex.glsl", antialiasing_dir + "/taa.glsl");
+
+        glUseProgram(aa.taa_program.program);
+        glUniform1i(glGetUniformLocation(aa.taa_program.program, "currentColor"), (GLint) aa_color_unit);
+        glUniform1i(glGetUniformLocation(aa.taa_program.program, "currentDepth"), (GLint) aa_depth_unit);
+        glUniform1i(glGetUniformLocation(aa.taa_program.program, "historyColor"), (GLint) aa_history_unit);
+    }
+
+    glUseProgram(0);
+
+    return aa;
+}
+
+void SetAntialiasingMode(AntialiasingParams &aa, AntialiasingMode mode) {
+    // The render target follows on its next bind; history is only kept for TAA
+    aa.mode = mode;
+
+    if (mode != AntialiasingMode::taa) {
+        DeleteHistory(aa);
+    }
+    aa.history_valid = false;
+}
+
+glm::vec2 JitterOffset(unsigned int frame) {
+    // Subpixel offset of a frame, in pixels within [-0.5, 0.5)
+    auto index = frame % taa_jitter_samples + 1;
+
+    return {Halton(index, 2) - 0.5f, Halton(index, 3) - 0.5f};
+}
+
+void JitterProjection(AntialiasingParams &aa, const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // TAA: shifts the projection in the Matrices block by this frame's jitter; other modes get it back unshifted
+    auto projection = GetPerspectiveMatrix(scene_globals.fov,
+                                           (float) scene_globals.width / (float) scene_globals.height,
+                                           near_plane);
+
+    if (aa.mode == AntialiasingMode::taa) {
+        auto jitter = JitterOffset(aa.frame++);
+
+        // Adds to clip x and y in proportion to w (= -z view), ie. a constant shift after the divide
+        projection[2][0] -= 2.0f * jitter.x / (float) scene_globals.width;
+        projection[2][1] -= 2.0f * jitter.y / (float) scene_globals.height;
+    } else if (aa.frame == 0) {
+        // never jittered since the last reset
+        return;
+    } else {
+        aa.frame = 0;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, scene_params.transforms_handle);
+    glBufferSubData(GL_UNIFORM_BUFFER, offsetof(TransformBlock, projection), sizeof(GlmMat4),
+                    glm::value_ptr(projection));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void ResolveAntialiasing(AntialiasingParams &aa, const RenderTarget &target, const SceneParams &scene_params,
+                         const SceneGlobals &scene_globals, GLuint output_fbo) {
+    // Brings the rendered frame into the window's back buffer (or output_fbo, of the same size), antialiased by
+    // the current mode
+    if (aa.mode != AntialiasingMode::fxaa && aa.mode != AntialiasingMode::taa) {
+        ResolveRenderTarget(target, output_fbo);
+        return;
+    }
+
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glActiveTexture(GL_TEXTURE0 + aa_color_unit);
+    glBindTexture(GL_TEXTURE_2D, target.color);
+
+    if (aa.mode == AntialiasingMode::fxaa) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindFramebuffer(GL_FRAMEBUFFER, output_fbo);
+
+        DrawFullscreenPass(aa.fxaa_program);
+    } else {
+        if (aa.width != target.width || aa.height != target.height) {
+            CreateHistory(aa, target.width, target.height);
+        }
+
+        // Where each pixel's surface was last frame, assuming it moved with the model
+        auto clip = ModelClipMatrix(scene_params, scene_globals);
+        auto previous_from_current = aa.previous_clip * glm::inverse(clip);
+        auto write = 1 - aa.history_read;
+
+        glActiveTexture(GL_TEXTURE0 + aa_depth_unit);
+        glBindTexture(GL_TEXTURE_2D, target.depth);
+        glActiveTexture(GL_TEXTURE0 + aa_history_unit);
+        glBindTexture(GL_TEXTURE_2D, aa.history[aa.history_read]);
+        glActiveTexture(GL_TEXTURE0);
+
+        auto program = aa.taa_program.program;
+
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "previousFromCurrent"), 1, GL_FALSE,
+                           glm::value_ptr(previous_from_current));
+        glUniform1f(glGetUniformLocation(program, "historyWeight"), aa.history_valid ? taa_history_weight : 0.0f);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, aa.history_fbo[write]);
+        DrawFullscreenPass(aa.taa_program);
+
+        // The new history is also this frame's image
+        auto width = (GLint) target.width;
+        auto height = (GLint) target.height;
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, aa.history_fbo[write]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output_fbo);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        aa.history_read = write;
+        aa.history_valid = true;
+        aa.previous_clip = clip;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glUseProgram(current_program);
+}
+
+std::size_t AntialiasingBytes(const AntialiasingParams &aa, const RenderTarget &target) {
+    // Render target plus the TAA history (two RGBA16F images)
+    auto history = aa.mode == AntialiasingMode::taa ? (std::size_t) 2 * target.width * target.height * 8 : 0;
+
+    return RenderTargetBytes(target) + history;
+}
+
+std::string AntialiasingStats(const AntialiasingParams &aa, const RenderTarget &target) {
+    // eg. "aa=msaa8 (8 samples), 61.04 MB of framebuffers"
+    std::ostringstream stats;
+
+    stats << "aa=" << antialiasing_names[aa.mode] << " (" << std::max<GLsizei>(target.samples, 1) << " samples), "
+          << std::fixed << std::setprecision(2) << (double) AntialiasingBytes(aa, target) / (1024.0 * 1024.0)
+          << " MB of framebuffers";
+
+    return stats.str();
+}
+
+bool AdvanceAntialiasingBenchmark(AntialiasingBenchmark &benchmark, AntialiasingParams &aa,
+                                  const RenderTarget &target, GpuTimer &timer, double now) {
+    // Called after every frame; moves to the next mode once the current one is measured. Returns true after
+    // the last mode, with the results printed
+    benchmark.frames++;
+
+    if (benchmark.frames == aa_benchmark_warmup_frames) {
+        // Drop what was timed so far, it may include the previous mode
+        CollectGpuTimer(timer);
+
+        timer.samples = 0;
+        timer.sum_ms = 0.0;
+        benchmark.start = now;
+
+        return false;
+    }
+
+    if (benchmark.frames < aa_benchmark_warmup_frames || now - benchmark.start < aa_benchmark_seconds) {
+        return false;
+    }
+
+    CollectGpuTimer(timer);
+
+    AntialiasingResult result;
+
+    result.mode = aa.mode;
+    result.frames = benchmark.frames - aa_benchmark_warmup_frames;
+    result.frame_ms = 1000.0 * (now - benchmark.start) / result.frames;
+    result.gpu_ms = timer.samples ? timer.sum_ms / timer.samples : 0.0;
+    result.bytes = AntialiasingBytes(aa, target);
+
+    benchmark.results.push_back(result);
+
+    std::cout << AntialiasingStats(aa, target) << ": " << std::fixed << std::setprecision(3) << result.frame_ms
+              << " ms per frame, " << result.gpu_ms << " ms GPU over " << result.frames << " frames" << std::endl;
+
+    benchmark.frames = 0;
+    benchmark.mode_index++;
+
+    if (benchmark.mode_index < std::size(antialiasing_names)) {
+        SetAntialiasingMode(aa, (AntialiasingMode) benchmark.mode_index);
+
+        return false;
+    }
+
+    // Summary, relative to the default (msaa8)
+    const auto &reference = benchmark.results[AntialiasingMode::msaa_8x];
+
+    std::cout << std::left << std::setw(8) << "mode" << std::right << std::setw(12) << "frame ms"
+              << std::setw(12) << "GPU ms" << std::setw(12) << "memory MB" << std::setw(14) << "GPU vs msaa8"
+              << std::endl;
+
+    for (const auto &entry: benchmark.results) {
+        std::cout << std::left << std::setw(8) << antialiasing_names[entry.mode] << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << entry.frame_ms << std::setw(12) << entry.gpu_ms
+                  << std::setprecision(2) << std::setw(12) << (double) entry.bytes / (1024.0 * 1024.0)
+                  << std::setw(13) << (reference.gpu_ms > 0.0 ? 100.0 * entry.gpu_ms / reference.gpu_ms : 0.0)
+                  << "%" << std::endl;
+    }
+
+    return true;
+}
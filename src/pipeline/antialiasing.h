@@ -0,0 +1,88 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_ANTIALIASING_H
+#define DRAGON_GL_ANTIALIASING_H
+
+#include <cstddef>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+#include "deferred.h"
+#include "render_target.h"
+#include "frame_stats.h"
+
+/* Antialiasing of the forward path, selected with 'aa=':
+ *  off, msaa2, msaa4, msaa8: samples of the render target, resolved by a blit (msaa8 is the default)
+ *  fxaa: single sampled target, then an edge directed blur pass into the window
+ *  taa: single sampled target rendered with a subpixel jitter of the projection; every frame is blended into a
+ *       history that is reprojected with the model rotation and clamped to the current neighbourhood */
+
+// Texture units of the resolve passes (the deferred path, which does not use them, has 2 to 5)
+const GLuint aa_color_unit = 2;
+const GLuint aa_depth_unit = 3;
+const GLuint aa_history_unit = 4;
+
+// TAA: weight of the history in the blend, and length of the jitter sequence (Halton 2, 3)
+const float taa_history_weight = 0.9f;
+const unsigned int taa_jitter_samples = 8;
+
+// Benchmark ('aabench'): every mode runs for a while after some warm-up frames
+const unsigned int aa_benchmark_warmup_frames = 30;
+const double aa_benchmark_seconds = 3.0;
+
+struct AntialiasingParams {
+    AntialiasingMode mode = AntialiasingMode::msaa_8x;
+    ShaderParams fxaa_program{};
+    ShaderParams taa_program{};
+
+    // TAA history, RGBA16F; one is read while the other is written
+    GLuint history[2] = {};
+    GLuint history_fbo[2] = {};
+    unsigned int history_read = 0;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    bool history_valid = false;
+
+    unsigned int frame = 0;       // position in the jitter sequence
+    GlmMat4 previous_clip{1.0f};  // model space -> clip space of the last frame, without jitter
+};
+
+// One mode of the benchmark
+struct AntialiasingResult {
+    AntialiasingMode mode;
+    unsigned int frames = 0;
+    double frame_ms = 0.0;
+    double gpu_ms = 0.0;
+    std::size_t bytes = 0;
+};
+
+struct AntialiasingBenchmark {
+    std::size_t mode_index = 0;
+    unsigned int frames = 0;  // in the current mode, including warm-up
+    double start = 0.0;       // end of the warm-up
+    std::vector<AntialiasingResult> results;
+};
+
+void DrawFullscreenPass(const ShaderParams &program);
+GLsizei AntialiasingSamples(AntialiasingMode mode);
+AntialiasingParams CreateAntialiasing(AntialiasingMode mode, bool all_modes);
+void SetAntialiasingMode(AntialiasingParams &aa, AntialiasingMode mode);
+glm::vec2 JitterOffset(unsigned int frame);
+void JitterProjection(AntialiasingParams &aa, const SceneParams &scene_params, const SceneGlobals &scene_globals);
+void ResolveAntialiasing(AntialiasingParams &aa, const RenderTarget &target, const SceneParams &scene_params,
+                         const SceneGlobals &scene_globals, GLuint output_fbo = 0);
+std::size_t AntialiasingBytes(const AntialiasingParams &aa, const RenderTarget &target);
+std::string AntialiasingStats(const AntialiasingParams &aa, const RenderTarget &target);
+bool AdvanceAntialiasingBenchmark(AntialiasingBenchmark &benchmark, AntialiasingParams &aa,
+                                  const RenderTarget &target, GpuTimer &timer, double now);
+
+#endif // DRAGON_GL_ANTIALIASING_H
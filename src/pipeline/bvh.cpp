@@ -0,0 +1,595 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "bvh.h"
+#include "simd.h"
+
+namespace {
+    struct Bounds {
+        Float4 min = Float4::Set(std::numeric_limits<float>::max());
+        Float4 max = Float4::Set(-std::numeric_limits<float>::max());
+
+        void Grow(const Bounds &other) {
+            min = Min(min, other.min);
+            max = Max(max, other.max);
+        }
+
+        void Grow(Float4 point) {
+            min = Min(min, point);
+            max = Max(max, point);
+        }
+
+        std::array<float, 4> Extent() const {
+            std::array<float, 4> extent{};
+
+            (max - min).Store(extent.data());
+            return extent;
+        }
+
+        float HalfArea() const {
+            // 0 for empty bounds, whose extents are negative
+            auto extent = Extent();
+            auto x = std::max(0.0f, extent[0]);
+            auto y = std::max(0.0f, extent[1]);
+            auto z = std::max(0.0f, extent[2]);
+
+            return x * y + y * z + z * x;
+        }
+    };
+
+    // Triangle bounds with the same layout as a node; the build partitions these in place
+    struct alignas(16) BuildPrimitive {
+        float bounds_min[3];
+        std::uint32_t face;
+        float bounds_max[3];
+        float padding;
+
+        Bounds GetBounds() const {
+            return {Float4::LoadXYZ(bounds_min), Float4::LoadXYZ(bounds_max)};
+        }
+
+        Float4 Centroid() const {
+            return (Float4::LoadXYZ(bounds_min) + Float4::LoadXYZ(bounds_max)) * Float4::Set(0.5f);
+        }
+    };
+
+    struct BinSet {
+        std::array<std::array<Bounds, bvh_bins>, 3> bounds{};
+        std::array<std::array<std::uint32_t, bvh_bins>, 3> count{};
+        Bounds left_centroids;  // filled by the partition step, not by binning
+    };
+
+    struct BuildState {
+        std::vector<BuildPrimitive> primitives;
+        JobSystem *jobs;
+    };
+
+    void StoreBounds(const Bounds &bounds, BvhNode &node) {
+        std::array<float, 4> lanes{};
+
+        bounds.min.Store(lanes.data());
+        std::copy(lanes.begin(), lanes.begin() + 3, node.bounds_min);
+        bounds.max.Store(lanes.data());
+        std::copy(lanes.begin(), lanes.begin() + 3, node.bounds_max);
+    }
+
+    void MakeLeaf(BvhNode &node, std::size_t begin, std::size_t end) {
+        // 'first' is the range in BuildState::primitives until packets are laid out
+        node.first = (std::uint32_t) begin;
+        node.count = (std::uint32_t) (end - begin);
+    }
+
+    std::array<std::uint32_t, 4> BinIndices(Float4 centroid, Float4 origin, Float4 scale) {
+        // Bin of a centroid along x, y and z; lane 3 is unused
+        std::array<float, 4> position{};
+
+        ((centroid - origin) * scale).Store(position.data());
+
+        return {std::min(bvh_bins - 1, (unsigned int) position[0]),
+                std::min(bvh_bins - 1, (unsigned int) position[1]),
+                std::min(bvh_bins - 1, (unsigned int) position[2]), 0};
+    }
+
+    void BinRange(const BuildState &state, std::size_t begin, std::size_t end, Float4 origin, Float4 scale,
+                  BinSet &bins) {
+        for (auto i = begin; i < end; ++i) {
+            const auto &primitive = state.primitives[i];
+            auto bounds = primitive.GetBounds();
+            auto bin = BinIndices(primitive.Centroid(), origin, scale);
+
+            for (int axis = 0; axis < 3; ++axis) {
+                bins.bounds[axis][bin[axis]].Grow(bounds);
+                bins.count[axis][bin[axis]]++;
+            }
+        }
+    }
+
+    void BuildNode(BuildState &state, std::vector<BvhNode> &nodes, std::size_t node_index, std::size_t begin,
+                   std::size_t end, const Bounds &bounds, const Bounds &centroid_bounds, unsigned int depth) {
+        /* Builds the subtree over primitives[begin, end) with its root at nodes[node_index]; the bounds of
+         * the range come from the parent's split. Large subtrees build both children as jobs, each into its
+         * own node list, which is spliced in afterwards */
+        auto count = end - begin;
+
+        StoreBounds(bounds, nodes[node_index]);
+
+        if (count <= bvh_leaf_min) {
+            MakeLeaf(nodes[node_index], begin, end);
+            return;
+        }
+
+        // Binned SAH over all three axes; bins are evenly spaced over the centroid bounds
+        auto centroid_extent = centroid_bounds.Extent();
+        std::array<float, 4> scale_lanes{};
+
+        for (int axis = 0; axis < 3; ++axis) {
+            scale_lanes[axis] = centroid_extent[axis] > 0 ? (float) bvh_bins / centroid_extent[axis] : 0.0f;
+        }
+        auto scale = Float4::Load(scale_lanes.data());
+
+        int best_axis = -1;
+        unsigned int best_bin = 0;
+        float best_cost = std::numeric_limits<float>::max();
+        Bounds best_left;
+        Bounds best_right;
+
+        if (depth < bvh_sah_depth) {
+            BinSet bins;
+
+            if (count < bvh_parallel_threshold) {
+                BinRange(state, begin, end, centroid_bounds.min, scale, bins);
+            } else {
+                // Every job bins a slice; slices are merged in order
+                auto slices = (count + bvh_parallel_threshold - 1) / bvh_parallel_threshold;
+                std::vector<BinSet> slice_bins(slices);
+
+                state.jobs->ParallelFor(slices, 1, [&](std::size_t slice_begin, std::size_t slice_end) {
+                    for (auto slice = slice_begin; slice < slice_end; ++slice) {
+                        BinRange(state, begin + slice * bvh_parallel_threshold,
+                                 std::min(end, begin + (slice + 1) * bvh_parallel_threshold), centroid_bounds.min,
+                                 scale, slice_bins[slice]);
+                    }
+                });
+                for (const auto &slice: slice_bins) {
+                    for (int axis = 0; axis < 3; ++axis) {
+                        for (unsigned int bin = 0; bin < bvh_bins; ++bin) {
+                            bins.bounds[axis][bin].Grow(slice.bounds[axis][bin]);
+                            bins.count[axis][bin] += slice.count[axis][bin];
+                        }
+                    }
+                }
+            }
+
+            for (int axis = 0; axis < 3; ++axis) {
+                if (scale_lanes[axis] == 0) {
+                    continue;
+                }
+                // Sweep from the right to get the bounds and cost of every right side, then from the left
+                std::array<Bounds, bvh_bins> right_bounds{};
+                std::array<float, bvh_bins> right_cost{};
+                Bounds right;
+                std::uint32_t right_count = 0;
+
+                for (auto bin = bvh_bins - 1; bin > 0; --bin) {
+                    right.Grow(bins.bounds[axis][bin]);
+                    right_count += bins.count[axis][bin];
+                    right_bounds[bin] = right;
+                    right_cost[bin] = right.HalfArea() * (float) right_count;
+                }
+
+                Bounds left;
+                std::uint32_t left_count = 0;
+
+                for (unsigned int bin = 0; bin < bvh_bins - 1; ++bin) {
+                    left.Grow(bins.bounds[axis][bin]);
+                    left_count += bins.count[axis][bin];
+
+                    auto cost = left.HalfArea() * (float) left_count + right_cost[bin + 1];
+
+                    if (left_count > 0 && left_count < count && cost < best_cost) {
+                        best_axis = axis;
+                        best_bin = bin;
+                        best_cost = cost;
+                        best_left = left;
+                        best_right = right_bounds[bin + 1];
+                    }
+                }
+            }
+        }
+
+        // Costs in packet tests: a leaf tests all of its packets, a split pays one traversal step plus
+        // the children weighted by the chance of a ray hitting them
+        auto packets = (float) ((count + bvh_packet_width - 1) / bvh_packet_width);
+        auto split_cost = bvh_traversal_cost + best_cost / bvh_packet_width / std::max(bounds.HalfArea(), 1e-30f);
+
+        if (count <= bvh_leaf_max && (best_axis < 0 || packets <= split_cost)) {
+            MakeLeaf(nodes[node_index], begin, end);
+            return;
+        }
+
+        auto first = state.primitives.begin() + (std::ptrdiff_t) begin;
+        auto last = state.primitives.begin() + (std::ptrdiff_t) end;
+        std::size_t mid;
+
+        if (best_axis >= 0) {
+            auto split = std::partition(first, last, [&](const BuildPrimitive &primitive) {
+                return BinIndices(primitive.Centroid(), centroid_bounds.min, scale)[best_axis] <= best_bin;
+            });
+            mid = split - state.primitives.begin();
+        } else {
+            // No usable SAH split (identical centroids, or too deep): median along the widest axis
+            auto axis = (int) (std::max_element(centroid_extent.begin(), centroid_extent.begin() + 3) -
+                               centroid_extent.begin());
+
+            mid = begin + count / 2;
+
+            std::nth_element(first, state.primitives.begin() + (std::ptrdiff_t) mid, last,
+                             [axis](const BuildPrimitive &a, const BuildPrimitive &b) {
+                                 return a.bounds_min[axis] + a.bounds_max[axis] <
+                                        b.bounds_min[axis] + b.bounds_max[axis];
+                             });
+        }
+
+        // Child bounds: known from the bins for SAH splits; centroid bounds always need a pass
+        std::array<Bounds, 2> child_bounds{best_left, best_right};
+        std::array<Bounds, 2> child_centroids{};
+        std::array<std::size_t, 3> range{begin, mid, end};
+
+        for (std::size_t child = 0; child < 2; ++child) {
+            Bounds full;
+
+            for (auto i = range[child]; i < range[child + 1]; ++i) {
+                child_centroids[child].Grow(state.primitives[i].Centroid());
+
+                if (best_axis < 0) {
+                    full.Grow(state.primitives[i].GetBounds());
+                }
+            }
+            if (best_axis < 0) {
+                child_bounds[child] = full;
+            }
+        }
+
+        auto left = nodes.size();
+
+        nodes[node_index].first = (std::uint32_t) left;
+        nodes[node_index].count = 0;
+        nodes.resize(left + 2);
+
+        if (count < bvh_parallel_threshold) {
+            for (std::size_t child = 0; child < 2; ++child) {
+                BuildNode(state, nodes, left + child, range[child], range[child + 1], child_bounds[child],
+                          child_centroids[child], depth + 1);
+            }
+            return;
+        }
+
+        std::array<std::vector<BvhNode>, 2> subtrees;
+
+        state.jobs->ParallelFor(2, 1, [&](std::size_t child, std::size_t) {
+            subtrees[child].resize(1);
+            BuildNode(state, subtrees[child], 0, range[child], range[child + 1], child_bounds[child],
+                      child_centroids[child], depth + 1);
+        });
+
+        // Subtree node k > 0 lands at offset + k, its root in the child slot; leaves keep their ranges
+        for (std::size_t child = 0; child < 2; ++child) {
+            auto offset = (std::uint32_t) (nodes.size() - 1);
+            auto relocate = [offset](BvhNode node) {
+                if (node.count == 0) {
+                    node.first += offset;
+                }
+                return node;
+            };
+
+            nodes[left + child] = relocate(subtrees[child][0]);
+
+            for (std::size_t k = 1; k < subtrees[child].size(); ++k) {
+                nodes.push_back(relocate(subtrees[child][k]));
+            }
+        }
+    }
+
+    float IntersectBox(const BvhNode &node, Float4 origin, Float4 inverse_direction, float t_max) {
+        // Slab test on the xyz lanes; distance to the box, or infinity on a miss
+        auto t_low = (Float4::LoadXYZ(node.bounds_min) - origin) * inverse_direction;
+        auto t_high = (Float4::LoadXYZ(node.bounds_max) - origin) * inverse_direction;
+
+        auto t_near = std::max(MaxXYZ(Min(t_low, t_high)), 0.0f);
+        auto t_far = std::min(MinXYZ(Max(t_low, t_high)), t_max);
+
+        return t_near <= t_far ? t_near : std::numeric_limits<float>::infinity();
+    }
+
+    void IntersectPacket(const TrianglePacket &packet, const Ray &ray, RayHit &best) {
+        // Möller-Trumbore on 4 triangles at once; both faces count as hits
+        // https://www.graphics.cornell.edu/pubs/1997/MT97.pdf
+        auto dx = Float4::Set(ray.direction.x);
+        auto dy = Float4::Set(ray.direction.y);
+        auto dz = Float4::Set(ray.direction.z);
+
+        auto e1x = Float4::Load(packet.e1[0]);
+        auto e1y = Float4::Load(packet.e1[1]);
+        auto e1z = Float4::Load(packet.e1[2]);
+        auto e2x = Float4::Load(packet.e2[0]);
+        auto e2y = Float4::Load(packet.e2[1]);
+        auto e2z = Float4::Load(packet.e2[2]);
+
+        auto px = dy * e2z - dz * e2y;
+        auto py = dz * e2x - dx * e2z;
+        auto pz = dx * e2y - dy * e2x;
+        auto det = e1x * px + e1y * py + e1z * pz;
+        auto inverse_det = Float4::Set(1.0f) / det;
+
+        auto tx = Float4::Set(ray.origin.x) - Float4::Load(packet.v0[0]);
+        auto ty = Float4::Set(ray.origin.y) - Float4::Load(packet.v0[1]);
+        auto tz = Float4::Set(ray.origin.z) - Float4::Load(packet.v0[2]);
+        auto u = (tx * px + ty * py + tz * pz) * inverse_det;
+
+        auto qx = ty * e1z - tz * e1y;
+        auto qy = tz * e1x - tx * e1z;
+        auto qz = tx * e1y - ty * e1x;
+        auto v = (dx * qx + dy * qy + dz * qz) * inverse_det;
+        auto t = (e2x * qx + e2y * qy + e2z * qz) * inverse_det;
+
+        auto zero = Float4::Set(0.0f);
+        auto mask = NotEqual(det, zero) & GreaterEqual(u, zero) & GreaterEqual(v, zero) &
+                    GreaterEqual(Float4::Set(1.0f), u + v) & Greater(t, zero) & Greater(Float4::Set(best.t), t);
+
+        if (!mask) {
+            return;
+        }
+        std::array<float, 4> lanes_t{};
+        std::array<float, 4> lanes_u{};
+        std::array<float, 4> lanes_v{};
+
+        t.Store(lanes_t.data());
+        u.Store(lanes_u.data());
+        v.Store(lanes_v.data());
+
+        for (unsigned int lane = 0; lane < bvh_packet_width; ++lane) {
+            if ((mask >> lane & 1) && lanes_t[lane] < best.t) {
+                best.hit = true;
+                best.face = packet.face[lane];
+                best.u = lanes_u[lane];
+                best.v = lanes_v[lane];
+                best.t = lanes_t[lane];
+            }
+        }
+    }
+}
+
+Bvh BuildBvh(const Vertex *vertices, std::size_t triangle_count, JobSystem &jobs) {
+    /* Vertices are an unindexed triangle list (CreateTriangles), so triangle i is vertices 3i to 3i + 2.
+     * Once the tree is done every leaf copies its triangles into packets, in tree order */
+    Bvh bvh;
+    bvh.triangle_count = triangle_count;
+
+    if (triangle_count == 0) {
+        return bvh;
+    }
+
+    BuildState state;
+
+    state.primitives.resize(triangle_count);
+    state.jobs = &jobs;
+
+    // Primitive bounds, and the root's bounds merged from one partial result per slice
+    auto slices = (triangle_count + bvh_parallel_threshold - 1) / bvh_parallel_threshold;
+    std::vector<std::array<Bounds, 2>> slice_bounds(slices);
+
+    jobs.ParallelFor(slices, 1, [&](std::size_t slice_begin, std::size_t slice_end) {
+        for (auto slice = slice_begin; slice < slice_end; ++slice) {
+            auto end = std::min(triangle_count, (slice + 1) * bvh_parallel_threshold);
+
+            for (auto i = slice * bvh_parallel_threshold; i < end; ++i) {
+                Bounds bounds;
+
+                for (int corner = 0; corner < 3; ++corner) {
+                    const auto &pos = vertices[3 * i + corner].pos;
+
+                    bounds.Grow(Float4::Set(pos.x, pos.y, pos.z, 0.0f));
+                }
+                auto &primitive = state.primitives[i];
+
+                bounds.min.Store(primitive.bounds_min);  // lane 3 is overwritten by the face
+                bounds.max.Store(primitive.bounds_max);
+                primitive.face = (std::uint32_t) i;
+
+                slice_bounds[slice][0].Grow(bounds);
+                slice_bounds[slice][1].Grow(primitive.Centroid());
+            }
+        }
+    });
+
+    Bounds root_bounds;
+    Bounds root_centroids;
+
+    for (const auto &slice: slice_bounds) {
+        root_bounds.Grow(slice[0]);
+        root_centroids.Grow(slice[1]);
+    }
+
+    std::vector<BvhNode> nodes(1);
+
+    BuildNode(state, nodes, 0, 0, triangle_count, root_bounds, root_centroids, 0);
+
+    // Lay out packets: leaves get consecutive packet ranges, filled in parallel
+    std::vector<std::uint32_t> leaves;
+    std::vector<std::uint32_t> leaf_begin;
+    std::uint32_t packet_count = 0;
+
+    for (std::uint32_t i = 0; i < nodes.size(); ++i) {
+        auto &node = nodes[i];
+
+        if (node.count > 0) {
+            leaves.push_back(i);
+            leaf_begin.push_back(node.first);
+
+            node.first = packet_count;
+            packet_count += (node.count + bvh_packet_width - 1) / bvh_packet_width;
+        }
+    }
+    bvh.packets.resize(packet_count);
+
+    jobs.ParallelFor(leaves.size(), 1024, [&](std::size_t begin, std::size_t end) {
+        for (auto leaf = begin; leaf < end; ++leaf) {
+            const auto &node = nodes[leaves[leaf]];
+
+            for (std::uint32_t i = 0; i < node.count; i += bvh_packet_width) {
+                TrianglePacket packet{};
+
+                for (std::uint32_t lane = 0; lane < bvh_packet_width && i + lane < node.count; ++lane) {
+                    auto face = state.primitives[leaf_begin[leaf] + i + lane].face;
+                    const auto &a = vertices[3 * face].pos;
+                    auto e1 = vertices[3 * face + 1].pos - a;
+                    auto e2 = vertices[3 * face + 2].pos - a;
+
+                    for (int axis = 0; axis < 3; ++axis) {
+                        packet.v0[axis][lane] = a[axis];
+                        packet.e1[axis][lane] = e1[axis];
+                        packet.e2[axis][lane] = e2[axis];
+                    }
+                    packet.face[lane] = face;
+                }
+                bvh.packets[node.first + i / bvh_packet_width] = packet;
+            }
+        }
+    });
+
+    bvh.nodes = std::move(nodes);
+
+    return bvh;
+}
+
+RayHit IntersectBvh(const Bvh &bvh, const Ray &ray, float t_max) {
+    // Closest hit in (0, t_max); children are visited near to far, the far one waits on a small stack
+    RayHit best;
+    best.t = t_max;
+
+    if (bvh.nodes.empty()) {
+        best.t = std::numeric_limits<float>::infinity();
+        return best;
+    }
+
+    auto origin = Float4::Set(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+    auto inverse_direction = Float4::Set(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z,
+                                         0.0f);
+
+    std::array<std::uint32_t, bvh_stack_size> stack;
+    unsigned int stack_size = 0;
+    std::uint32_t node_index = 0;
+
+    if (IntersectBox(bvh.nodes[0], origin, inverse_direction, best.t) == std::numeric_limits<float>::infinity()) {
+        best.t = std::numeric_limits<float>::infinity();
+        return best;
+    }
+
+    while (true) {
+        const auto &node = bvh.nodes[node_index];
+
+        if (node.count > 0) {
+            auto packets = (node.count + bvh_packet_width - 1) / bvh_packet_width;
+
+            for (std::uint32_t i = 0; i < packets; ++i) {
+                IntersectPacket(bvh.packets[node.first + i], ray, best);
+            }
+        } else {
+            auto near_child = node.first;
+            auto far_child = node.first + 1;
+            auto near_t = IntersectBox(bvh.nodes[near_child], origin, inverse_direction, best.t);
+            auto far_t = IntersectBox(bvh.nodes[far_child], origin, inverse_direction, best.t);
+
+            if (far_t < near_t) {
+                std::swap(near_child, far_child);
+                std::swap(near_t, far_t);
+            }
+            if (near_t != std::numeric_limits<float>::infinity()) {
+                if (far_t != std::numeric_limits<float>::infinity()) {
+                    stack[stack_size++] = far_child;
+                }
+                node_index = near_child;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+
+    if (!best.hit) {
+        best.t = std::numeric_limits<float>::infinity();
+    }
+    return best;
+}
+
+ScenePicker BuildScenePicker(const Vertex *vertices, const std::vector<DrawCommand> &draws, JobSystem &jobs) {
+    // Instances drawing the same vertex range share one BVH
+    ScenePicker picker;
+    std::map<GLuint, unsigned int> mesh_at;
+
+    for (const auto &draw: draws) {
+        auto [it, inserted] = mesh_at.try_emplace(draw.first, (unsigned int) picker.meshes.size());
+
+        if (inserted) {
+            picker.meshes.push_back(BuildBvh(vertices + draw.first, draw.count / 3, jobs));
+        }
+        picker.mesh_of.push_back(it->second);
+    }
+    return picker;
+}
+
+Ray CursorRay(double x, double y, const SceneGlobals &scene_globals) {
+    // World space ray from the eye through the center of framebuffer pixel (x, y), y down as in GLFW
+    auto camera = ComputeTransforms({}, scene_globals).camera;
+    auto inverse_view = glm::inverse(camera.view);
+    auto inverse_view_projection = glm::inverse(camera.projection * camera.view);
+
+    auto ndc_x = (float) (2.0 * x / scene_globals.width - 1.0);
+    auto ndc_y = (float) (1.0 - 2.0 * y / scene_globals.height);
+    auto on_near_plane = inverse_view_projection * GlmVec4(ndc_x, ndc_y, 1.0f, 1.0f);  // reverse-Z
+
+    Ray ray;
+
+    ray.origin = GlmVec3(inverse_view * GlmVec4(0.0f, 0.0f, 0.0f, 1.0f));
+    ray.direction = glm::normalize(GlmVec3(on_near_plane) / on_near_plane.w - ray.origin);
+
+    return ray;
+}
+
+PickResult PickFace(const ScenePicker &picker, const std::vector<SceneInstance> &instances, double x, double y,
+                    const SceneGlobals &scene_globals) {
+    // Closest face under the cursor over all instances; rays go to model space, where t is unchanged
+    auto start = std::chrono::steady_clock::now();
+    auto ray = CursorRay(x, y, scene_globals);
+
+    PickResult result;
+    float best_t = std::numeric_limits<float>::infinity();
+
+    for (std::size_t i = 0; i < instances.size() && i < picker.mesh_of.size(); ++i) {
+        auto to_model = glm::inverse(GetWorldSpaceMatrix(instances[i].transform, scene_globals));
+
+        Ray model_ray;
+        model_ray.origin = GlmVec3(to_model * GlmVec4(ray.origin, 1.0f));
+        model_ray.direction = GlmVec3(to_model * GlmVec4(ray.direction, 0.0f));
+
+        auto hit = IntersectBvh(picker.meshes[picker.mesh_of[i]], model_ray, best_t);
+
+        if (hit.hit) {
+            best_t = hit.t;
+
+            result.hit = true;
+            result.instance = (unsigned int) i;
+            result.face = hit.face;
+            result.u = hit.u;
+            result.v = hit.v;
+        }
+    }
+    result.position = ray.origin + ray.direction * best_t;
+    result.microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    return result;
+}
@@ -0,0 +1,95 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_BVH_H
+#define DRAGON_GL_BVH_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "attributes.h"
+#include "job_system.h"
+#include "scene.h"
+
+/* Bounding volume hierarchy over the triangles of a mesh, for CPU ray queries (picking).
+ * Built top-down with binned SAH, subtrees in parallel; nodes are 32 bytes and siblings adjacent, so
+ * one cache line holds both children of a node. Leaf triangles are stored in packets of 4 (SoA) and
+ * tested 4 at a time with SSE where available.
+ * https://jacco.ompf2.com/2022/04/21/how-to-build-a-bvh-part-3-quick-builds/ */
+const unsigned int bvh_bins = 16;
+const unsigned int bvh_leaf_min = 4;   // ranges this small always become leaves (one packet)
+const unsigned int bvh_leaf_max = 8;   // larger ranges are split even if SAH prefers a leaf
+const float bvh_traversal_cost = 1.0f;  // relative to one packet test
+const std::size_t bvh_parallel_threshold = 32768;  // subtrees at least this large build as separate jobs
+const unsigned int bvh_sah_depth = 64;  // deeper than this, ranges are split at the median
+const unsigned int bvh_stack_size = 128;
+const unsigned int bvh_packet_width = 4;
+
+struct alignas(32) BvhNode {
+    float bounds_min[3];
+    std::uint32_t first;  // inner node: left child (right child follows); leaf: first packet
+    float bounds_max[3];
+    std::uint32_t count;  // leaf: triangle count; 0 for inner nodes
+};
+
+static_assert(sizeof(BvhNode) == 32);
+
+// 4 triangles as vertex 0 and two edges, structure of arrays; unused lanes have zero edges and never hit
+struct alignas(16) TrianglePacket {
+    float v0[3][bvh_packet_width];
+    float e1[3][bvh_packet_width];
+    float e2[3][bvh_packet_width];
+    std::uint32_t face[bvh_packet_width];
+};
+
+struct Bvh {
+    std::vector<BvhNode> nodes;
+    std::vector<TrianglePacket> packets;
+    std::size_t triangle_count = 0;
+};
+
+struct Ray {
+    GlmVec3 origin;
+    GlmVec3 direction;  // need not be unit length; hits are reported in multiples of it
+};
+
+struct RayHit {
+    bool hit = false;
+    unsigned int face = 0;  // triangle of the mesh, ie. facet of the source file
+    float u = 0;            // barycentrics of vertex 1 and 2
+    float v = 0;
+    float t = std::numeric_limits<float>::infinity();
+};
+
+// One BVH per unique mesh of the scene; instances are intersected in their model space
+struct ScenePicker {
+    std::vector<Bvh> meshes;
+    std::vector<unsigned int> mesh_of;  // scene instance -> mesh
+};
+
+struct PickResult {
+    bool hit = false;
+    unsigned int instance = 0;
+    unsigned int face = 0;
+    float u = 0;
+    float v = 0;
+    GlmVec3 position{};  // world space
+    double microseconds = 0;
+};
+
+Bvh BuildBvh(const Vertex *vertices, std::size_t triangle_count, JobSystem &jobs);
+RayHit IntersectBvh(const Bvh &bvh, const Ray &ray, float t_max);
+
+ScenePicker BuildScenePicker(const Vertex *vertices, const std::vector<DrawCommand> &draws, JobSystem &jobs);
+Ray CursorRay(double x, double y, const SceneGlobals &scene_globals);
+PickResult PickFace(const ScenePicker &picker, const std::vector<SceneInstance> &instances, double x, double y,
+                    const SceneGlobals &scene_globals);
+
+#endif // DRAGON_GL_BVH_H
@@ -0,0 +1,339 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "camera_path.h"
+
+namespace {
+    const std::string path_format = "frame rotate_x rotate_y fov width height";
+
+    // Column order of the benchmark report
+    const std::string report_header = "renderer,device,model,shading,render_path,camera_path,frames,width,height,"
+                                      "triangles_per_frame,frame_ms_mean,frame_ms_p50,frame_ms_p90,frame_ms_p99,"
+                                      "frame_ms_min,frame_ms_max,triangles_per_second,gpu_main_ms,"
+                                      "gpu_shadow_ms,gpu_deform_ms";
+
+    [[noreturn]] void PathError(const std::string &fname, unsigned int line, const std::string &message) {
+        std::cout << "Invalid camera path " << fname << " line " << line << ": " << message << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    std::string CsvField(const std::string &value) {
+        // Quoted if it holds a separator, eg. "llvmpipe (LLVM 15.0.7, 256 bits)"
+        if (value.find_first_of(",\"") == std::string::npos) {
+            return value;
+        }
+        std::string quoted = "\"";
+
+        for (auto c: value) {
+            quoted += c == '"' ? "\"\"" : std::string(1, c);
+        }
+        return quoted + "\"";
+    }
+
+    std::string OptionalMs(double milliseconds) {
+        // Empty when not measured
+        if (milliseconds < 0.0) {
+            return "";
+        }
+        std::ostringstream value;
+
+        value << std::fixed << std::setprecision(4) << milliseconds;
+
+        return value.str();
+    }
+
+    bool SameView(const CameraKey &key, const SceneGlobals &scene_globals) {
+        return key.rotate_x == scene_globals.rotate_x && key.rotate_y == scene_globals.rotate_y &&
+               key.fov == scene_globals.fov && key.width == scene_globals.width &&
+               key.height == scene_globals.height;
+    }
+}
+
+CameraPath BuiltinCameraPath() {
+    // A turn around the model with a tilt, a zoom in and out, and a resize: 300 frames, 5 seconds at 60 Hz
+    CameraPath path;
+
+    path.name = camera_path_builtin_name;
+    path.keys = {{0, 0.0f, 0.0f, 45.0f, 960, 540},
+                 {120, 0.0f, 180.0f, 45.0f, 960, 540},
+                 {180, -30.0f, 270.0f, 30.0f, 960, 540},
+                 {240, 20.0f, 360.0f, 60.0f, 1280, 720},
+                 {299, 0.0f, 360.0f, 45.0f, 1280, 720}};
+
+    return path;
+}
+
+CameraPath LoadCameraPath(const std::string &fname) {
+    // Reads a path file; malformed files are fatal, a benchmark must not silently run another path
+    std::ifstream file(fname);
+
+    if (!file) {
+        std::cout << "Could not read camera path " << fname << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    CameraPath path;
+    path.name = std::filesystem::path(fname).stem().string();
+
+    std::string line;
+    unsigned int line_number = 0;
+
+    while (std::getline(file, line)) {
+        ++line_number;
+
+        // comments and blank lines
+        line = line.substr(0, line.find('#'));
+
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        std::istringstream values(line);
+        CameraKey key;
+        std::string rest;
+
+        if (!(values >> key.frame >> key.rotate_x >> key.rotate_y >> key.fov >> key.width >> key.height) ||
+            (values >> rest)) {
+            PathError(fname, line_number, "expected '" + path_format + "'");
+        }
+        if (key.width == 0 || key.height == 0 || key.fov <= 0.0f || key.fov >= 180.0f) {
+            PathError(fname, line_number, "the size must not be empty and fov within (0, 180) degrees");
+        }
+        if (!path.keys.empty() && key.frame <= path.keys.back().frame) {
+            PathError(fname, line_number, "frames must increase");
+        }
+        path.keys.push_back(key);
+    }
+
+    if (path.keys.empty()) {
+        PathError(fname, line_number, "no keys");
+    }
+    return path;
+}
+
+bool SaveCameraPath(const CameraPath &path, const std::string &fname) {
+    // Same format as LoadCameraPath reads
+    std::ofstream file(fname);
+
+    if (!file) {
+        return false;
+    }
+    file << "# " << path_format << std::endl;
+
+    for (const auto &key: path.keys) {
+        file << key.frame << " " << key.rotate_x << " " << key.rotate_y << " " << key.fov << " " << key.width << " "
+             << key.height << std::endl;
+    }
+    return (bool) file;
+}
+
+void RecordCameraKey(CameraPath &path, unsigned int frame, const SceneGlobals &scene_globals) {
+    // Adds the view drawn at frame if it changed; a view held over several frames gets a key at both ends, so
+    // the replay holds it too instead of drifting towards the next one
+    if (!path.keys.empty()) {
+        auto last = path.keys.back();
+
+        if (SameView(last, scene_globals)) {
+            return;
+        }
+        if (frame == last.frame) {
+            path.keys.pop_back();
+        } else if (frame > last.frame + 1) {
+            last.frame = frame - 1;
+            path.keys.push_back(last);
+        }
+    }
+    path.keys.push_back({frame, scene_globals.rotate_x, scene_globals.rotate_y, scene_globals.fov,
+                         scene_globals.width, scene_globals.height});
+}
+
+unsigned int CameraPathFrames(const CameraPath &path) {
+    return path.keys.empty() ? 0 : path.keys.back().frame + 1;
+}
+
+CameraKey CameraPathKey(const CameraPath &path, unsigned int frame) {
+    // The view at frame: angles interpolated between the surrounding keys, size of the previous key
+    auto next = std::upper_bound(path.keys.begin(), path.keys.end(), frame,
+                                 [](unsigned int value, const CameraKey &key) { return value < key.frame; });
+
+    if (next == path.keys.begin()) {
+        return path.keys.empty() ? CameraKey() : path.keys.front();
+    }
+    auto key = *(next - 1);
+
+    if (next != path.keys.end()) {
+        auto t = (float) (frame - key.frame) / (float) (next->frame - key.frame);
+
+        key.rotate_x += t * (next->rotate_x - key.rotate_x);
+        key.rotate_y += t * (next->rotate_y - key.rotate_y);
+        key.fov += t * (next->fov - key.fov);
+    }
+    key.frame = frame;
+
+    return key;
+}
+
+void ApplyCameraKey(const CameraKey &key, SceneGlobals &scene_globals) {
+    scene_globals.rotate_x = key.rotate_x;
+    scene_globals.rotate_y = key.rotate_y;
+    scene_globals.fov = key.fov;
+    scene_globals.width = key.width;
+    scene_globals.height = key.height;
+}
+
+FrameTimeSummary SummarizeFrameTimes(std::vector<double> milliseconds) {
+    // Mean and nearest-rank percentiles
+    FrameTimeSummary summary;
+
+    if (milliseconds.empty()) {
+        return summary;
+    }
+    std::sort(milliseconds.begin(), milliseconds.end());
+
+    auto percentile = [&](double p) {
+        auto rank = (std::size_t) std::ceil(p * (double) milliseconds.size());
+
+        return milliseconds[std::clamp<std::size_t>(rank, 1, milliseconds.size()) - 1];
+    };
+    double sum = 0.0;
+
+    for (auto value: milliseconds) {
+        sum += value;
+    }
+    summary.mean = sum / (double) milliseconds.size();
+    summary.p50 = percentile(0.5);
+    summary.p90 = percentile(0.9);
+    summary.p99 = percentile(0.99);
+    summary.min = milliseconds.front();
+    summary.max = milliseconds.back();
+
+    return summary;
+}
+
+bool AppendBenchmarkRecord(const std::string &fname, const BenchmarkRecord &record) {
+    // One line per run; the header is written with the first, so runs of several builds can share a report
+    auto new_file = !std::filesystem::exists(fname) || std::filesystem::file_size(fname) == 0;
+    std::ofstream report(fname, std::ios::app);
+
+    if (!report) {
+        return false;
+    }
+    if (new_file) {
+        report << report_header << std::endl;
+    }
+
+    report << CsvField(record.renderer) << "," << CsvField(record.device) << "," << CsvField(record.model) << ","
+           << record.shading << "," << record.render_path << "," << CsvField(record.camera_path) << ","
+           << record.frames << "," << record.width << "," << record.height << "," << std::fixed
+           << std::setprecision(1) << record.triangles << "," << std::setprecision(4) << record.frame_ms.mean
+           << "," << record.frame_ms.p50 << "," << record.frame_ms.p90 << "," << record.frame_ms.p99 << ","
+           << record.frame_ms.min << "," << record.frame_ms.max << "," << std::setprecision(0)
+           << record.triangles_per_second << "," << OptionalMs(record.gpu_main_ms) << ","
+           << OptionalMs(record.gpu_shadow_ms) << "," << OptionalMs(record.gpu_deform_ms) << std::endl;
+
+    return (bool) report;
+}
+
+std::string BenchmarkRecordStats(const BenchmarkRecord &record) {
+    // eg. "dragon_obj gouraud forward: 300 frames, 4.12 ms mean, 5.03 p99, 212.4 Mtri/s, main pass 3.80 ms GPU"
+    std::ostringstream stats;
+
+    stats << record.model << " " << record.shading << " " << record.render_path << ": " << record.frames
+          << " frames, " << std::fixed << std::setprecision(2) << record.frame_ms.mean << " ms mean, "
+          << record.frame_ms.p99 << " p99, " << std::setprecision(1) << record.triangles_per_second / 1.0e6
+          << " Mtri/s";
+
+    if (record.gpu_main_ms >= 0.0) {
+        stats << ", main pass " << std::setprecision(2) << record.gpu_main_ms << " ms GPU";
+    }
+    return stats.str();
+}
+
+bool ApplyCameraBenchmark(const CameraBenchmark &benchmark, SceneGlobals &scene_globals) {
+    // Sets the view of the next frame (the first key during the warm-up) and marks it dirty if it moved.
+    // Returns true if the window size changed
+    auto key = CameraPathKey(benchmark.path, benchmark.warmup > 0 ? 0 : benchmark.frame);
+
+    if (SameView(key, scene_globals)) {
+        return false;
+    }
+    auto resized = key.width != scene_globals.width || key.height != scene_globals.height;
+
+    ApplyCameraKey(key, scene_globals);
+    scene_globals.dirty_ = true;
+
+    return resized;
+}
+
+double CameraBenchmarkTime(const CameraBenchmark &benchmark) {
+    // Scene time in seconds, from the frame rather than the clock
+    return (double) benchmark.frame / camera_path_fps;
+}
+
+bool AdvanceCameraBenchmark(CameraBenchmark &benchmark, GpuTimer *timers[3], double now, std::size_t triangles) {
+    // Called after every frame with the triangles it drew; returns true after the last frame of the path
+    if (benchmark.warmup > 0) {
+        if (--benchmark.warmup == 0) {
+            // GPU times count from here; the timers may also be reset by the periodic stats
+            for (int i = 0; i < 3; ++i) {
+                if (timers[i]) {
+                    CollectGpuTimer(*timers[i]);
+
+                    benchmark.gpu_results[i] = timers[i]->results;
+                    benchmark.gpu_total_ms[i] = timers[i]->total_ms;
+                }
+            }
+            benchmark.last_time = now;
+        }
+        return false;
+    }
+
+    benchmark.frame_ms.push_back(1000.0 * (now - benchmark.last_time));
+    benchmark.last_time = now;
+    benchmark.triangles += (double) triangles;
+
+    return ++benchmark.frame >= CameraPathFrames(benchmark.path);
+}
+
+BenchmarkRecord CameraBenchmarkRecord(const CameraBenchmark &benchmark, GpuTimer *timers[3]) {
+    // Frame times and GPU pass times of the measured frames; the caller fills in what was rendered
+    BenchmarkRecord record;
+    double gpu_ms[3] = {-1.0, -1.0, -1.0};
+
+    for (int i = 0; i < 3; ++i) {
+        if (timers[i]) {
+            CollectGpuTimer(*timers[i]);
+
+            auto results = timers[i]->results - benchmark.gpu_results[i];
+
+            if (results > 0) {
+                gpu_ms[i] = (timers[i]->total_ms - benchmark.gpu_total_ms[i]) / (double) results;
+            }
+        }
+    }
+
+    record.camera_path = benchmark.path.name;
+    record.frames = (unsigned int) benchmark.frame_ms.size();
+
+    if (!benchmark.path.keys.empty()) {
+        record.width = benchmark.path.keys.front().width;
+        record.height = benchmark.path.keys.front().height;
+    }
+    record.frame_ms = SummarizeFrameTimes(benchmark.frame_ms);
+
+    double seconds = 0.0;
+
+    for (auto milliseconds: benchmark.frame_ms) {
+        seconds += milliseconds / 1000.0;
+    }
+    record.triangles = record.frames ? benchmark.triangles / record.frames : 0.0;
+    record.triangles_per_second = seconds > 0.0 ? benchmark.triangles / seconds : 0.0;
+    record.gpu_main_ms = gpu_ms[0];
+    record.gpu_shadow_ms = gpu_ms[1];
+    record.gpu_deform_ms = gpu_ms[2];
+
+    return record;
+}
@@ -0,0 +1,107 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_CAMERA_PATH_H
+#define DRAGON_GL_CAMERA_PATH_H
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "scene.h"
+#include "frame_stats.h"
+
+/* Camera paths: the view (rotation, field of view, window size) at given frames, replayed frame by frame so two
+ * builds, drivers or machines render exactly the same sequence. Between two keys the angles are interpolated and
+ * the size is held. 'campath' replays the built-in path and 'campath=FILE' a saved one in dragon-opengl, which
+ * then exits with one line in the benchmark report; 'record=FILE' saves the views of an interactive session.
+ * dragon-bench replays the same paths for every model and shading option on the software rasterizer. A path
+ * file has one key per line, '#' starts a comment:
+ *     frame rotate_x rotate_y fov width height */
+const std::string camera_path_builtin_name = "builtin";
+const unsigned int camera_warmup_frames = 30;  // render the first key, untimed
+const double camera_path_fps = 60.0;           // scene time of a frame, for the animated lights and deformation
+
+const std::string benchmark_report_default = "camera_bench.csv";
+
+struct CameraKey {
+    unsigned int frame = 0;
+    float rotate_x = 0.0f;  // degrees
+    float rotate_y = 0.0f;  // degrees
+    float fov = fov_initial;
+    unsigned int width = width_init;
+    unsigned int height = height_init;
+};
+
+struct CameraPath {
+    std::string name;
+    std::vector<CameraKey> keys;  // by increasing frame
+};
+
+// Frame time distribution of a run, in milliseconds
+struct FrameTimeSummary {
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// One line of the benchmark report; GPU times are negative when not measured
+struct BenchmarkRecord {
+    std::string renderer;  // "opengl" or "software"
+    std::string device;    // GL renderer string, or the CPU thread count
+    std::string model;
+    std::string shading;
+    std::string render_path;
+    std::string camera_path;
+    unsigned int frames = 0;
+    unsigned int width = 0;   // of the first key
+    unsigned int height = 0;
+    double triangles = 0.0;   // per frame
+    FrameTimeSummary frame_ms;
+    double triangles_per_second = 0.0;
+    double gpu_main_ms = -1.0;
+    double gpu_shadow_ms = -1.0;
+    double gpu_deform_ms = -1.0;
+};
+
+// A camera path replayed by dragon-opengl: the warm-up frames, then one frame per frame of the path
+struct CameraBenchmark {
+    CameraPath path;
+    unsigned int warmup = camera_warmup_frames;
+    unsigned int frame = 0;  // of the path
+    double last_time = 0.0;  // end of the previous frame
+    std::vector<double> frame_ms;
+    double triangles = 0.0;  // sum over the measured frames
+
+    // GpuTimer totals at the end of the warm-up: main, shadow, deformation
+    unsigned long long gpu_results[3] = {};
+    double gpu_total_ms[3] = {};
+};
+
+CameraPath BuiltinCameraPath();
+CameraPath LoadCameraPath(const std::string &fname);
+bool SaveCameraPath(const CameraPath &path, const std::string &fname);
+void RecordCameraKey(CameraPath &path, unsigned int frame, const SceneGlobals &scene_globals);
+unsigned int CameraPathFrames(const CameraPath &path);
+CameraKey CameraPathKey(const CameraPath &path, unsigned int frame);
+void ApplyCameraKey(const CameraKey &key, SceneGlobals &scene_globals);
+FrameTimeSummary SummarizeFrameTimes(std::vector<double> milliseconds);
+bool AppendBenchmarkRecord(const std::string &fname, const BenchmarkRecord &record);
+std::string BenchmarkRecordStats(const BenchmarkRecord &record);
+
+bool ApplyCameraBenchmark(const CameraBenchmark &benchmark, SceneGlobals &scene_globals);
+double CameraBenchmarkTime(const CameraBenchmark &benchmark);
+bool AdvanceCameraBenchmark(CameraBenchmark &benchmark, GpuTimer *timers[3], double now, std::size_t triangles);
+BenchmarkRecord CameraBenchmarkRecord(const CameraBenchmark &benchmark, GpuTimer *timers[3]);
+
+#endif // DRAGON_GL_CAMERA_PATH_H
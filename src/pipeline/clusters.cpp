@@ -0,0 +1,60 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "clusters.h"
+
+ClusterParams CreateClusters() {
+    // Allocates the froxel light lists and compiles the culling pre-pass
+    ClusterParams clusters;
+
+    GLsizeiptr cluster_count = cluster_grid_x * cluster_grid_y * cluster_grid_z;
+
+    glGenBuffers(1, &clusters.light_indices);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.light_indices);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, cluster_count * max_lights_per_cluster * sizeof(GLuint),
+                 nullptr, GL_DYNAMIC_COPY);
+    TrackGlObject(GL_BUFFER, clusters.light_indices, MemoryCategory::gpu_storage,
+                  cluster_count * max_lights_per_cluster * sizeof(GLuint));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, cluster_lights_binding, clusters.light_indices);
+
+    // Counts start at zero so nothing is lit before the first pre-pass
+    std::vector<GLuint> zero_counts(cluster_count, 0);
+
+    glGenBuffers(1, &clusters.light_counts);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters.light_counts);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, cluster_count * sizeof(GLuint), zero_counts.data(),
+                 GL_DYNAMIC_COPY);
+    TrackGlObject(GL_BUFFER, clusters.light_counts, MemoryCategory::gpu_storage, cluster_count * sizeof(GLuint));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, cluster_counts_binding, clusters.light_counts);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    clusters.cull_program = CreateComputeProgram(clustered_dir + "/compute.glsl");
+
+    return clusters;
+}
+
+void UpdateClusters(const ClusterParams &clusters, const SceneGlobals &scene_globals) {
+    // Re-bins the lights; needed whenever the projection, the view or a light changes
+    GLuint cluster_count = cluster_grid_x * cluster_grid_y * cluster_grid_z;
+
+    GlmMat4 projection = GetPerspectiveMatrix(scene_globals.fov,
+                                              (float) scene_globals.width / (float) scene_globals.height,
+                                              near_plane);
+    GlmMat4 inverse_projection = glm::inverse(projection);
+
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glUseProgram(clusters.cull_program.program);
+    glUniformMatrix4fv(glGetUniformLocation(clusters.cull_program.program, "inverseProjection"), 1,
+                       GL_FALSE, glm::value_ptr(inverse_projection));
+
+    glDispatchCompute((cluster_count + cluster_cull_group_size - 1) / cluster_cull_group_size, 1, 1);
+
+    // Shading reads the lists as shader storage
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(current_program);
+}
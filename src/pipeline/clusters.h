@@ -0,0 +1,28 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_CLUSTERS_H
+#define DRAGON_GL_CLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+
+// Must match GROUP_SIZE in the clustered compute shader
+const GLuint cluster_cull_group_size = 64;
+
+// Per-cluster light index lists (fixed capacity) and counts, rebuilt by a compute pre-pass
+struct ClusterParams {
+    GLuint light_indices = 0;
+    GLuint light_counts = 0;
+    ShaderParams cull_program{};
+};
+
+ClusterParams CreateClusters();
+void UpdateClusters(const ClusterParams &clusters, const SceneGlobals &scene_globals);
+
+#endif // DRAGON_GL_CLUSTERS_H
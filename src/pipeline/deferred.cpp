@@ -0,0 +1,179 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "deferred.h"
+
+GLuint CreateRenderTexture(GLenum internal_format, unsigned int width, unsigned int height) {
+    // Immutable single-level texture used as a render target
+    // https://www.khronos.org/opengl/wiki/Framebuffer_Object
+    GLuint texture;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, (GLsizei) width, (GLsizei) height);
+    TrackGlObject(GL_TEXTURE, texture, MemoryCategory::gpu_targets,
+                  TextureBytes((GLsizei) width, (GLsizei) height, 1, 1, TexelBytes(internal_format)));
+
+    // Render targets are read 1:1, filtering is never needed
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+GBufferParams CreateGBuffer(unsigned int width, unsigned int height) {
+    // Albedo, view space normal and depth attachments, plus the lit output image
+    GBufferParams gbuffer;
+
+    gbuffer.width = width;
+    gbuffer.height = height;
+
+    gbuffer.albedo = CreateRenderTexture(GL_RGBA8, width, height);
+    gbuffer.normal = CreateRenderTexture(GL_RGBA16F, width, height);
+    gbuffer.depth = CreateRenderTexture(GL_DEPTH_COMPONENT32F, width, height);
+    gbuffer.lit = CreateRenderTexture(GL_RGBA16F, width, height);
+
+    glGenFramebuffers(1, &gbuffer.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.fbo);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, gbuffer.albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, gbuffer.normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, gbuffer.depth, 0);
+
+    GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, draw_buffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "G-buffer framebuffer is incomplete" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return gbuffer;
+}
+
+void DeleteGBuffer(GBufferParams &gbuffer) {
+    // Frees all render targets, eg. before recreating them on resize
+    GLuint textures[] = {gbuffer.albedo, gbuffer.normal, gbuffer.depth, gbuffer.lit};
+
+    glDeleteFramebuffers(1, &gbuffer.fbo);
+    ReleaseGlObjects(GL_TEXTURE, 4, textures);
+    glDeleteTextures(4, textures);
+
+    gbuffer = GBufferParams();
+}
+
+DeferredParams CreateDeferredRenderer(ShadingOption opt, const MaterialParams &materials,
+                                      const SceneGlobals &scene_globals, const std::string &geometry_defines,
+                                      const std::string &lighting_defines) {
+    // G-buffer, geometry/lighting/present programs; geometry_defines are added to those of the materials,
+    // lighting_defines go to the lighting pass
+    DeferredParams deferred;
+
+    deferred.gbuffer = CreateGBuffer(scene_globals.width, scene_globals.height);
+
+    deferred.geometry_program = CreateShaderProgram(deferred_dir + "/vertex.glsl",
+                                                    deferred_dir + "/fragment.glsl",
+                                                    GetMaterialShaderDefines(materials) + geometry_defines);
+    deferred.lighting_program = CreateComputeProgram(deferred_dir + "/compute.glsl", lighting_defines);
+    deferred.present_program = CreateShaderProgram(present_dir + "/vertex.glsl",
+                                                   present_dir + "/fragment.glsl");
+
+    // Geometry pass: textures come from the material table; untextured materials use their color
+    auto geometry = deferred.geometry_program.program;
+    auto use_textures = opt == ShadingOption::normal_mapping;
+
+    SetMaterialSamplers(geometry);
+    glUniform1i(glGetUniformLocation(geometry, "useTextures"), use_textures);
+
+    // Lighting pass: G-buffer on units 2, 3 and 4
+    auto lighting = deferred.lighting_program.program;
+
+    glUseProgram(lighting);
+    glUniform1i(glGetUniformLocation(lighting, gbuffer_albedo_name.c_str()), 2);
+    glUniform1i(glGetUniformLocation(lighting, gbuffer_normal_name.c_str()), 3);
+    glUniform1i(glGetUniformLocation(lighting, gbuffer_depth_name.c_str()), 4);
+    glUniform3fv(glGetUniformLocation(lighting, "clearColor"), 1, glm::value_ptr(clear_color));
+
+    // Present pass: lit image on unit 5
+    auto present = deferred.present_program.program;
+
+    glUseProgram(present);
+    glUniform1i(glGetUniformLocation(present, scene_color_name.c_str()), 5);
+
+    return deferred;
+}
+
+void RenderDeferred(DeferredParams &deferred, const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Geometry pass -> tiled light culling and accumulation -> present
+    auto &gbuffer = deferred.gbuffer;
+
+    // Follow the viewport size
+    if (gbuffer.width != scene_globals.width || gbuffer.height != scene_globals.height) {
+        DeleteGBuffer(gbuffer);
+
+        gbuffer = CreateGBuffer(scene_globals.width, scene_globals.height);
+    }
+
+    // Geometry pass
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer.fbo);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUseProgram(deferred.geometry_program.program);
+    DrawScene(scene_params, scene_params.buffer_tris.vao);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Lighting pass, one work group per screen tile
+    auto lighting = deferred.lighting_program.program;
+
+    GlmMat4 projection = GetPerspectiveMatrix(scene_globals.fov,
+                                              (float) scene_globals.width / (float) scene_globals.height,
+                                              near_plane);
+    GlmMat4 inverse_projection = glm::inverse(projection);
+
+    glUseProgram(lighting);
+    glUniformMatrix4fv(glGetUniformLocation(lighting, "inverseProjection"), 1, GL_FALSE,
+                       glm::value_ptr(inverse_projection));
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, gbuffer.albedo);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, gbuffer.normal);
+    glActiveTexture(GL_TEXTURE4);
+    glBindTexture(GL_TEXTURE_2D, gbuffer.depth);
+
+    glBindImageTexture(lit_image_unit, gbuffer.lit, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute((gbuffer.width + light_tile_size - 1) / light_tile_size,
+                      (gbuffer.height + light_tile_size - 1) / light_tile_size, 1);
+
+    // Image writes must land before the present pass samples the lit image
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    DrawFullscreenTexture(deferred.present_program, gbuffer.lit);
+}
+
+void DrawFullscreenTexture(const ShaderParams &present_program, GLuint texture) {
+    // Draws a texture over the whole viewport of the bound framebuffer (unit 5)
+    glDisable(GL_DEPTH_TEST);
+
+    glUseProgram(present_program.program);
+
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(EmptyVertexArray());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,54 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_DEFERRED_H
+#define DRAGON_GL_DEFERRED_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+
+// Must match TILE_SIZE in the deferred compute shader
+const GLuint light_tile_size = 16;
+
+// Image unit the lighting pass writes to
+const GLuint lit_image_unit = 0;
+
+// G-buffer sampler names (lighting pass)
+const std::string gbuffer_albedo_name = "gAlbedo";
+const std::string gbuffer_normal_name = "gNormal";
+const std::string gbuffer_depth_name = "gDepth";
+const std::string scene_color_name = "sceneColor";
+
+// Render targets of the deferred path; sized to the viewport
+struct GBufferParams {
+    GLuint fbo = 0;
+    GLuint albedo = 0;  // RGBA8
+    GLuint normal = 0;  // RGBA16F, view space
+    GLuint depth = 0;   // DEPTH_COMPONENT32F
+    GLuint lit = 0;     // RGBA16F, written by the lighting pass
+    unsigned int width = 0;
+    unsigned int height = 0;
+};
+
+struct DeferredParams {
+    GBufferParams gbuffer;
+    ShaderParams geometry_program;
+    ShaderParams lighting_program;
+    ShaderParams present_program;
+};
+
+GLuint CreateRenderTexture(GLenum internal_format, unsigned int width, unsigned int height);
+GBufferParams CreateGBuffer(unsigned int width, unsigned int height);
+void DeleteGBuffer(GBufferParams &gbuffer);
+DeferredParams CreateDeferredRenderer(ShadingOption opt, const MaterialParams &materials,
+                                      const SceneGlobals &scene_globals, const std::string &geometry_defines = "",
+                                      const std::string &lighting_defines = "");
+void RenderDeferred(DeferredParams &deferred, const SceneParams &scene_params, const SceneGlobals &scene_globals);
+void DrawFullscreenTexture(const ShaderParams &present_program, GLuint texture);
+
+#endif // DRAGON_GL_DEFERRED_H
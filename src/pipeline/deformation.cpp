@@ -0,0 +1,230 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "deformation.h"
+
+namespace {
+    template<typename T>
+    GLuint CreateStorage(const std::vector<T> &data) {
+        // Storage buffer, only written by its initial contents or by shaders
+        GLuint buffer;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (data.size() * sizeof(T)), data.data(), GL_DYNAMIC_COPY);
+        TrackGlObject(GL_BUFFER, buffer, MemoryCategory::gpu_storage, data.size() * sizeof(T));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        return buffer;
+    }
+
+    GLuint Groups(GLuint invocations) {
+        // Work groups covering one invocation per element
+        return (invocations + deform_group_size - 1) / deform_group_size;
+    }
+}
+
+std::vector<GLuint> WeldCorners(const Vertex *vertices, GLuint first, GLuint count,
+                                std::vector<GlmVec3> &unique_positions) {
+    // Corners of one mesh with bitwise equal positions share a vertex, as they came from the same loaded vertex;
+    // appends the positions of the new vertices and returns the index of every corner's vertex
+    using Key = std::array<std::uint32_t, 3>;
+
+    std::vector<std::pair<Key, GLuint>> sorted(count);
+
+    for (GLuint i = 0; i < count; ++i) {
+        Key key;
+
+        std::memcpy(key.data(), &vertices[first + i].pos, sizeof(key));
+        sorted[i] = {key, i};
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<GLuint> corners(count);
+
+    for (GLuint i = 0; i < count; ++i) {
+        if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+            unique_positions.push_back(vertices[first + sorted[i].second].pos);
+        }
+        corners[sorted[i].second] = (GLuint) unique_positions.size() - 1;
+    }
+
+    return corners;
+}
+
+DeformationParams CreateDeformation(const SceneParams &scene_params, ShadingOption opt, DeformationMode mode) {
+    // Welds the vertex list, derives the morph targets and uploads everything the passes read
+    DeformationParams deformation;
+
+    deformation.mode = mode;
+    deformation.face_normals = opt == ShadingOption::flat || opt == ShadingOption::wireframe;
+    deformation.vertex_count = scene_params.vertices_count_tris;
+    deformation.vbo = scene_params.buffer_tris.vbo;
+
+    const auto vertices = scene_params.buffer_tris.vertex_list.get();
+
+    // Instances of the same mesh share its range of the vertex list
+    std::map<GLuint, GLuint> mesh_ranges;
+
+    for (const auto &draw: scene_params.draws) {
+        mesh_ranges[draw.first] = draw.count;
+    }
+
+    std::vector<GLuint> corners(deformation.vertex_count, 0);
+    std::vector<GlmVec3> unique_positions;
+    std::vector<GlmVec4> rest;
+    std::vector<GlmVec4> meshes;
+    std::vector<GlmVec3> normals;
+    std::vector<float> mean_radius;
+
+    for (const auto &[first, count]: mesh_ranges) {
+        auto base = (GLuint) unique_positions.size();
+        auto mesh_corners = WeldCorners(vertices, first, count, unique_positions);
+
+        std::copy(mesh_corners.begin(), mesh_corners.end(), corners.begin() + first);
+
+        // Bounding sphere around the center of the bounding box
+        GlmVec3 low(std::numeric_limits<float>::max());
+        GlmVec3 high(std::numeric_limits<float>::lowest());
+
+        for (auto i = base; i < unique_positions.size(); ++i) {
+            low = glm::min(low, unique_positions[i]);
+            high = glm::max(high, unique_positions[i]);
+        }
+
+        auto center = 0.5f * (low + high);
+        float radius = 0.0f;
+        double radius_sum = 0.0;
+
+        for (auto i = base; i < unique_positions.size(); ++i) {
+            auto distance = glm::length(unique_positions[i] - center);
+
+            radius = std::max(radius, distance);
+            radius_sum += distance;
+
+            rest.emplace_back(unique_positions[i], (float) meshes.size());
+        }
+        mean_radius.push_back((float) (radius_sum / std::max<std::size_t>(unique_positions.size() - base, 1)));
+        meshes.emplace_back(center, std::max(radius, std::numeric_limits<float>::min()));
+
+        // Rest normals of the vertices, from their faces, whatever the shading
+        normals.resize(unique_positions.size(), GlmVec3(0.0f));
+
+        for (GLuint i = 0; i + 2 < count; i += 3) {
+            auto a = unique_positions[mesh_corners[i]];
+            auto b = unique_positions[mesh_corners[i + 1]];
+            auto c = unique_positions[mesh_corners[i + 2]];
+            auto face_normal = glm::cross(b - a, c - a);
+
+            if (glm::length(face_normal) > 0.0f) {
+                face_normal = glm::normalize(face_normal);
+            }
+            for (GLuint k = 0; k < 3; ++k) {
+                normals[mesh_corners[i + k]] += face_normal;
+            }
+        }
+    }
+
+    deformation.unique_count = (GLuint) unique_positions.size();
+    deformation.mesh_count = meshes.size();
+
+    // Morph targets, as offsets: inflated along the normal, then projected on the mean radius sphere
+    std::vector<GlmVec4> targets(deform_targets * deformation.unique_count, GlmVec4(0.0f));
+
+    for (GLuint i = 0; i < deformation.unique_count; ++i) {
+        auto mesh = (std::size_t) rest[i].w;
+        auto center = GlmVec3(meshes[mesh]);
+        auto normal = glm::length(normals[i]) > 0.0f ? glm::normalize(normals[i]) : GlmVec3(0.0f);
+        auto offset = unique_positions[i] - center;
+        auto sphere = glm::length(offset) > 0.0f ? center + glm::normalize(offset) * mean_radius[mesh] :
+                      unique_positions[i];
+
+        targets[i] = GlmVec4(normal * deform_inflate * meshes[mesh].w, 0.0f);
+        targets[deformation.unique_count + i] = GlmVec4(sphere - unique_positions[i], 0.0f);
+    }
+
+    deformation.rest = CreateStorage(rest);
+    deformation.targets = CreateStorage(targets);
+    deformation.meshes = CreateStorage(meshes);
+    deformation.corners = CreateStorage(corners);
+    deformation.positions = CreateStorage(std::vector<GlmVec4>(deformation.unique_count));
+    deformation.sums = CreateStorage(std::vector<GLint>(6 * (std::size_t) deformation.unique_count));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_rest_binding, deformation.rest);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_targets_binding, deformation.targets);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_meshes_binding, deformation.meshes);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_positions_binding, deformation.positions);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_sums_binding, deformation.sums);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_corners_binding, deformation.corners);
+
+    // The vertex buffer is read and written as floats, 11 per vertex (see Vertex)
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, deform_vertices_binding, deformation.vbo);
+
+    deformation.positions_program = CreateComputeProgram(deform_dir + "/positions.glsl");
+    deformation.faces_program = CreateComputeProgram(deform_dir + "/faces.glsl");
+    deformation.vertices_program = CreateComputeProgram(deform_dir + "/vertices.glsl");
+
+    return deformation;
+}
+
+void UpdateDeformation(const DeformationParams &deformation, double time) {
+    // Deforms the unique vertices, sums the face normals and tangents, then rewrites the vertex buffer
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    auto positions_program = deformation.positions_program.program;
+
+    glUseProgram(positions_program);
+    glUniform1f(glGetUniformLocation(positions_program, "time"), (float) time);
+    glUniform1ui(glGetUniformLocation(positions_program, "mode"), (GLuint) deformation.mode);
+    glUniform1ui(glGetUniformLocation(positions_program, "uniqueCount"), deformation.unique_count);
+    glDispatchCompute(Groups(deformation.unique_count), 1, 1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    auto faces_program = deformation.faces_program.program;
+
+    glUseProgram(faces_program);
+    glUniform1ui(glGetUniformLocation(faces_program, "triangleCount"), deformation.vertex_count / 3);
+    glDispatchCompute(Groups(deformation.vertex_count / 3), 1, 1);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    auto vertices_program = deformation.vertices_program.program;
+
+    glUseProgram(vertices_program);
+    glUniform1ui(glGetUniformLocation(vertices_program, "vertexCount"), deformation.vertex_count);
+    glUniform1i(glGetUniformLocation(vertices_program, "faceNormals"), deformation.face_normals);
+    glDispatchCompute(Groups(deformation.vertex_count), 1, 1);
+
+    // Draws read the vertex buffer as attributes; the next frame's passes overwrite what this one read
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glUseProgram(current_program);
+}
+
+std::string DeformationStats(const DeformationParams &deformation) {
+    // Summary of the welded meshes
+    std::ostringstream stats;
+
+    stats << "deformation '" << deformation_names[deformation.mode] << "': " << deformation.vertex_count
+          << " vertices welded into " << deformation.unique_count << " over " << deformation.mesh_count
+          << " meshes, " << (deformation.face_normals ? "face" : "smooth") << " normals";
+
+    return stats.str();
+}
+
+void DeleteDeformation(DeformationParams &deformation) {
+    // The vertex buffer belongs to the scene
+    GLuint buffers[] = {deformation.rest, deformation.targets, deformation.meshes, deformation.positions,
+                        deformation.sums, deformation.corners};
+
+    ReleaseGlObjects(GL_BUFFER, std::size(buffers), buffers);
+    glDeleteBuffers(std::size(buffers), buffers);
+    glDeleteProgram(deformation.positions_program.program);
+    glDeleteProgram(deformation.faces_program.program);
+    glDeleteProgram(deformation.vertices_program.program);
+
+    deformation = DeformationParams();
+}
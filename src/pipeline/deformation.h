@@ -0,0 +1,76 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_DEFORMATION_H
+#define DRAGON_GL_DEFORMATION_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+
+/* GPU deformation ('deform=morph|wave|twist'). The corners of the vertex list are welded per mesh into unique
+ * vertices, whose rest positions, morph targets and mesh bounds live in storage buffers. Every frame three compute
+ * passes rewrite the shared vertex buffer in place, so every program keeps drawing it unchanged:
+ *  - positions: each unique vertex is blended with the morph targets, or waved or twisted, and its normal and
+ *    tangent sums are cleared
+ *  - faces: each triangle adds its face normal and tangent to the sums of its three vertices, with integer atomics
+ *    on fixed point values
+ *  - vertices: each corner gets its deformed position and its normalized sums (the face normal for flat shading)
+ * The morph targets are made from the mesh itself: inflated along the normals, and projected on its bounding
+ * sphere */
+const GLuint deform_group_size = 64;    // must match GROUP_SIZE in the deform shaders
+const unsigned int deform_targets = 2;  // must match TARGETS in the positions shader
+const float deform_inflate = 0.08f;     // of the mesh radius
+
+// Storage buffer bindings (impostors use 12 and 13)
+const GLuint deform_rest_binding = 14;
+const GLuint deform_targets_binding = 15;
+const GLuint deform_meshes_binding = 16;
+const GLuint deform_positions_binding = 17;
+const GLuint deform_sums_binding = 18;
+const GLuint deform_corners_binding = 19;
+const GLuint deform_vertices_binding = 20;
+
+struct DeformationParams {
+    DeformationMode mode = DeformationMode::no_deform;
+    bool face_normals = false;  // flat and wireframe shading
+
+    GLuint vertex_count = 0;    // corners, 3 per triangle
+    GLuint unique_count = 0;    // after welding
+    std::size_t mesh_count = 0;
+
+    GLuint vbo = 0;        // the scene's vertex buffer, written in place
+    GLuint rest = 0;       // vec4 per unique vertex: xyz rest position, w mesh
+    GLuint targets = 0;    // vec4 per target and unique vertex: offset from the rest position
+    GLuint meshes = 0;     // vec4 per mesh: xyz center, w radius
+    GLuint positions = 0;  // vec4 per unique vertex, deformed
+    GLuint sums = 0;       // 6 ints per unique vertex: normal and tangent, fixed point
+    GLuint corners = 0;    // unique vertex of each corner
+
+    ShaderParams positions_program{};
+    ShaderParams faces_program{};
+    ShaderParams vertices_program{};
+};
+
+std::vector<GLuint> WeldCorners(const Vertex *vertices, GLuint first, GLuint count,
+                                std::vector<GlmVec3> &unique_positions);
+DeformationParams CreateDeformation(const SceneParams &scene_params, ShadingOption opt, DeformationMode mode);
+void UpdateDeformation(const DeformationParams &deformation, double time);
+std::string DeformationStats(const DeformationParams &deformation);
+void DeleteDeformation(DeformationParams &deformation);
+
+#endif // DRAGON_GL_DEFORMATION_H
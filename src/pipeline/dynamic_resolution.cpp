@@ -0,0 +1,164 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "dynamic_resolution.h"
+
+DynamicResolutionParams CreateDynamicResolution(double budget_ms, bool edge_aware) {
+    // Upscale program; the intermediate image is created at the first frame
+    DynamicResolutionParams dynres;
+
+    dynres.budget_ms = budget_ms;
+    dynres.edge_aware = edge_aware;
+
+    dynres.upscale_program = CreateShaderProgram(present_dir + "/vertex.glsl", present_dir + "/upscale.glsl");
+
+    auto program = dynres.upscale_program.program;
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, scene_color_name.c_str()), (GLint) upscale_source_unit);
+    glUniform1i(glGetUniformLocation(program, "edgeAware"), edge_aware ? 1 : 0);
+    glUniform1f(glGetUniformLocation(program, "sharpness"), dynres_sharpness);
+    glUseProgram(0);
+
+    return dynres;
+}
+
+SceneGlobals GetRenderGlobals(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals) {
+    // The window's globals at the render size; the field of view and rotation are the same
+    SceneGlobals render_globals;
+
+    render_globals.width = std::max(1u, (unsigned int) std::lround((float) window_globals.width * dynres.scale));
+    render_globals.height = std::max(1u, (unsigned int) std::lround((float) window_globals.height * dynres.scale));
+    render_globals.rotate_x = window_globals.rotate_x;
+    render_globals.rotate_y = window_globals.rotate_y;
+    render_globals.fov = window_globals.fov;
+
+    return render_globals;
+}
+
+bool BeginDynamicResolution(DynamicResolutionParams &dynres, const SceneParams &scene_params,
+                            const SceneGlobals &render_globals, bool view_changed) {
+    // Viewport and cluster lookup at the render size; returns true if that size changed. A new size leaves the
+    // default framebuffer bound
+    glViewport(0, 0, (GLsizei) render_globals.width, (GLsizei) render_globals.height);
+
+    auto resized = dynres.width != render_globals.width || dynres.height != render_globals.height;
+
+    // A new view uploads the window size to the Lighting block, so it is overwritten in that case too
+    if (resized || view_changed) {
+        UpdateLightingUniforms(scene_params.lighting_handle, render_globals);
+    }
+
+    if (resized) {
+        glDeleteFramebuffers(1, &dynres.fbo);
+        ReleaseGlObjects(GL_TEXTURE, 1, &dynres.color);
+        glDeleteTextures(1, &dynres.color);
+
+        dynres.width = render_globals.width;
+        dynres.height = render_globals.height;
+
+        // Bilinear filtering does the upscale
+        dynres.color = CreateRenderTexture(GL_RGBA8, dynres.width, dynres.height);
+
+        glBindTexture(GL_TEXTURE_2D, dynres.color);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &dynres.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, dynres.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, dynres.color, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Dynamic resolution framebuffer is incomplete" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    return resized;
+}
+
+GLuint DynamicResolutionOutput(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals) {
+    // Where the resolved frame goes: the window itself at full scale, otherwise the image to upscale
+    if (dynres.width == window_globals.width && dynres.height == window_globals.height) {
+        return 0;
+    }
+    return dynres.fbo;
+}
+
+void UpscaleToWindow(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals) {
+    // Stretches the resolved frame over the window; nothing to do at full scale
+    if (DynamicResolutionOutput(dynres, window_globals) == 0) {
+        return;
+    }
+
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, (GLsizei) window_globals.width, (GLsizei) window_globals.height);
+
+    glActiveTexture(GL_TEXTURE0 + upscale_source_unit);
+    glBindTexture(GL_TEXTURE_2D, dynres.color);
+    glActiveTexture(GL_TEXTURE0);
+
+    DrawFullscreenPass(dynres.upscale_program);
+
+    glUseProgram(current_program);
+}
+
+bool UpdateDynamicResolution(DynamicResolutionParams &dynres, GpuTimer &timer) {
+    // Feeds the newest main pass GPU time to the controller; returns true if the scale changed
+    CollectGpuTimer(timer);
+
+    if (timer.results == dynres.seen_results) {
+        return false;
+    }
+    dynres.seen_results = timer.results;
+
+    // Results lag a few frames behind; the first ones after a change were measured at the old size
+    if (++dynres.samples_since_change <= dynres_settle_samples) {
+        dynres.gpu_ms = timer.last_ms;
+        return false;
+    }
+    dynres.gpu_ms += dynres_smoothing * (timer.last_ms - dynres.gpu_ms);
+
+    auto target = dynres.scale;
+
+    if (dynres.gpu_ms > dynres.budget_ms) {
+        target = dynres.scale * (float) std::sqrt(dynres.budget_ms / dynres.gpu_ms);
+    } else if (dynres.gpu_ms < dynres_headroom * dynres.budget_ms) {
+        target = dynres.scale * (float) std::sqrt(dynres_headroom * dynres.budget_ms / dynres.gpu_ms);
+        target = std::min(target, dynres.scale + dynres_scale_up_max);
+    }
+
+    // Rounded down to a step: the budget is met rather than just missed, and between the headroom and the
+    // budget nothing changes
+    auto steps = std::floor(target / dynres_scale_step + 0.001f);
+    auto scale = std::clamp(steps * dynres_scale_step, dynres_scale_min, 1.0f);
+
+    if (std::abs(scale - dynres.scale) < 0.5f * dynres_scale_step) {
+        return false;
+    }
+
+    dynres.scale = scale;
+    dynres.samples_since_change = 0;
+    dynres.changes++;
+
+    return true;
+}
+
+std::string DynamicResolutionStats(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals) {
+    // eg. "render scale 0.75 (750x750 of 1000x1000), main pass 7.9 ms GPU (budget 8 ms), 3 changes"
+    std::ostringstream stats;
+
+    stats << "render scale " << dynres.scale << " (" << dynres.width << "x" << dynres.height << " of "
+          << window_globals.width << "x" << window_globals.height << "), main pass " << dynres.gpu_ms
+          << " ms GPU (budget " << dynres.budget_ms << " ms), " << dynres.changes << " changes";
+
+    return stats.str();
+}
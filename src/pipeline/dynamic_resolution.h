@@ -0,0 +1,63 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_DYNAMIC_RESOLUTION_H
+#define DRAGON_GL_DYNAMIC_RESOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include <glad/glad.h>
+
+#include "attributes.h"
+#include "scene.h"
+#include "deferred.h"
+#include "antialiasing.h"
+#include "frame_stats.h"
+
+/* Dynamic resolution ('dynres=MS'): the forward path renders at a fraction of the window size, chosen so the GPU
+ * time of the main pass stays within a budget, and the result is upscaled to the window. The pixel count goes
+ * with the square of the scale, so a measured overrun by a factor k scales by 1 / sqrt(k) */
+const float dynres_scale_min = 0.5f;
+const float dynres_scale_step = 0.05f;   // scales are multiples of this, so the target is not recreated constantly
+const float dynres_scale_up_max = 0.1f;  // growing is cautious, shrinking is not
+const double dynres_headroom = 0.85;     // grow only below this fraction of the budget
+const double dynres_smoothing = 0.25;    // weight of a new GPU time in the running average
+const unsigned int dynres_settle_samples = 6;  // timer results still measuring the previous size are skipped
+const float dynres_sharpness = 0.15f;   // edge-aware upscale: strength of the sharpening in flat areas
+
+// Texture unit of the upscale source (the deferred path, which does not use it, has 2 to 5)
+const GLuint upscale_source_unit = 2;
+
+struct DynamicResolutionParams {
+    double budget_ms = 0.0;
+    bool edge_aware = false;
+    float scale = 1.0f;
+
+    // Controller state
+    double gpu_ms = 0.0;  // running average
+    unsigned long long seen_results = 0;
+    unsigned int samples_since_change = 0;
+    unsigned int changes = 0;
+
+    // Single sampled image at the render size, upscaled into the window
+    GLuint color = 0;
+    GLuint fbo = 0;
+    unsigned int width = 0;
+    unsigned int height = 0;
+
+    ShaderParams upscale_program{};
+};
+
+DynamicResolutionParams CreateDynamicResolution(double budget_ms, bool edge_aware);
+SceneGlobals GetRenderGlobals(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals);
+bool BeginDynamicResolution(DynamicResolutionParams &dynres, const SceneParams &scene_params,
+                            const SceneGlobals &render_globals, bool view_changed);
+GLuint DynamicResolutionOutput(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals);
+void UpscaleToWindow(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals);
+bool UpdateDynamicResolution(DynamicResolutionParams &dynres, GpuTimer &timer);
+std::string DynamicResolutionStats(const DynamicResolutionParams &dynres, const SceneGlobals &window_globals);
+
+#endif // DRAGON_GL_DYNAMIC_RESOLUTION_H
@@ -0,0 +1,124 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "frame_stats.h"
+
+void StartFrameStats(FrameStats &stats, double now) {
+    // Resets the counters; 'now' is in seconds (eg. glfwGetTime)
+    stats = FrameStats();
+
+    stats.last_frame = now;
+    stats.last_report = now;
+}
+
+void RecordFrame(FrameStats &stats, double now) {
+    // Called once per presented frame
+    double frame_time = now - stats.last_frame;
+
+    stats.last_frame = now;
+    stats.frames++;
+    stats.frame_time_sum += frame_time;
+    stats.frame_time_max = std::max(stats.frame_time_max, frame_time);
+}
+
+bool FrameStatsDue(const FrameStats &stats, double now) {
+    // True once per interval, if at least one frame was recorded
+    return now - stats.last_report >= stats_report_interval && stats.frames > 0;
+}
+
+bool ReportFrameStats(FrameStats &stats, double now, const std::string &extra) {
+    // Prints average and worst frame time once per interval, then starts a new interval
+    if (!FrameStatsDue(stats, now)) {
+        return false;
+    }
+
+    double average_ms = 1000.0 * stats.frame_time_sum / stats.frames;
+
+    std::cout << "frame time: " << average_ms << " ms avg, " << 1000.0 * stats.frame_time_max
+              << " ms max (" << 1000.0 / average_ms << " fps)";
+
+    if (!extra.empty()) {
+        std::cout << ", " << extra;
+    }
+    std::cout << std::endl;
+
+    stats.last_report = now;
+    stats.frames = 0;
+    stats.frame_time_sum = 0.0;
+    stats.frame_time_max = 0.0;
+
+    return true;
+}
+
+void CreateGpuTimer(GpuTimer &timer) {
+    // Query objects of the ring
+    timer = GpuTimer();
+
+    glGenQueries(gpu_timer_queries, timer.queries);
+}
+
+void DeleteGpuTimer(GpuTimer &timer) {
+    glDeleteQueries(gpu_timer_queries, timer.queries);
+
+    timer = GpuTimer();
+}
+
+void BeginGpuTimer(GpuTimer &timer) {
+    // Starts timing the commands that follow; only one timer may run at a time. Finished results are
+    // collected first, a slot whose result still has not arrived is overwritten
+    CollectGpuTimer(timer);
+
+    timer.pending[timer.next] = false;
+
+    glBeginQuery(GL_TIME_ELAPSED, timer.queries[timer.next]);
+}
+
+void EndGpuTimer(GpuTimer &timer) {
+    glEndQuery(GL_TIME_ELAPSED);
+
+    timer.pending[timer.next] = true;
+    timer.next = (timer.next + 1) % gpu_timer_queries;
+}
+
+void CollectGpuTimer(GpuTimer &timer) {
+    // Adds every finished query to the running sum, without waiting for the others
+    for (unsigned int i = 0; i < gpu_timer_queries; ++i) {
+        if (!timer.pending[i]) {
+            continue;
+        }
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(timer.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            GLuint64 nanoseconds = 0;
+            glGetQueryObjectui64v(timer.queries[i], GL_QUERY_RESULT, &nanoseconds);
+
+            timer.pending[i] = false;
+            timer.samples++;
+            timer.sum_ms += (double) nanoseconds / 1.0e6;
+            timer.results++;
+            timer.total_ms += (double) nanoseconds / 1.0e6;
+            timer.last_ms = (double) nanoseconds / 1.0e6;
+        }
+    }
+}
+
+std::string GpuTimerStats(GpuTimer &timer, const std::string &name) {
+    // Average GPU time since the last call, eg. "shadow pass 0.4 ms GPU (2 runs)"; resets the sums
+    CollectGpuTimer(timer);
+
+    std::ostringstream stats;
+
+    if (timer.samples == 0) {
+        stats << name << " idle";
+    } else {
+        stats << name << " " << timer.sum_ms / timer.samples << " ms GPU (" << timer.samples << " runs)";
+    }
+
+    timer.samples = 0;
+    timer.sum_ms = 0.0;
+
+    return stats.str();
+}
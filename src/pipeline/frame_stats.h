@@ -0,0 +1,53 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_FRAME_STATS_H
+#define DRAGON_GL_FRAME_STATS_H
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <glad/glad.h>
+
+// Seconds between two printed stats lines
+const double stats_report_interval = 1.0;
+
+// Frame times accumulated between two reports
+struct FrameStats {
+    double last_frame = 0.0;
+    double last_report = 0.0;
+    unsigned int frames = 0;
+    double frame_time_sum = 0.0;
+    double frame_time_max = 0.0;
+};
+
+// GPU time of a pass, from GL_TIME_ELAPSED queries in a ring: results are picked up a few frames later,
+// once available, so reading them never stalls the pipeline
+const unsigned int gpu_timer_queries = 4;
+
+struct GpuTimer {
+    GLuint queries[gpu_timer_queries] = {};
+    bool pending[gpu_timer_queries] = {};
+    unsigned int next = 0;
+    unsigned int samples = 0;  // results since the last report
+    double sum_ms = 0.0;
+    unsigned long long results = 0;  // all results so far
+    double total_ms = 0.0;           // of all results
+    double last_ms = 0.0;            // the newest result
+};
+
+void StartFrameStats(FrameStats &stats, double now);
+void RecordFrame(FrameStats &stats, double now);
+bool FrameStatsDue(const FrameStats &stats, double now);
+bool ReportFrameStats(FrameStats &stats, double now, const std::string &extra);
+void CreateGpuTimer(GpuTimer &timer);
+void DeleteGpuTimer(GpuTimer &timer);
+void BeginGpuTimer(GpuTimer &timer);
+void EndGpuTimer(GpuTimer &timer);
+void CollectGpuTimer(GpuTimer &timer);
+std::string GpuTimerStats(GpuTimer &timer, const std::string &name);
+
+#endif // DRAGON_GL_FRAME_STATS_H
@@ -0,0 +1,111 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "image_diff.h"
+
+namespace {
+    std::vector<double> Luma(const Framebuffer &image) {
+        // Rec. 709 weights on the stored (sRGB encoded) values, as SSIM is usually computed
+        std::vector<double> luma((std::size_t) image.width * image.height);
+
+        for (std::size_t i = 0; i < luma.size(); ++i) {
+            const auto *rgb = &image.color[3 * i];
+
+            luma[i] = 0.2126 * rgb[0] + 0.7152 * rgb[1] + 0.0722 * rgb[2];
+        }
+        return luma;
+    }
+}
+
+ImageDiff CompareImages(const Framebuffer &expected, const Framebuffer &actual, Framebuffer *heatmap) {
+    // SSIM per window, then the mean and the minimum; images smaller than a window compare as one window
+    const double c1 = (0.01 * 255.0) * (0.01 * 255.0);
+    const double c2 = (0.03 * 255.0) * (0.03 * 255.0);
+
+    auto width = actual.width;
+    auto height = actual.height;
+    auto a = Luma(expected);
+    auto b = Luma(actual);
+
+    auto window_x = std::min(ssim_window, width);
+    auto window_y = std::min(ssim_window, height);
+    std::vector<float> worst_at((std::size_t) width * height, 1.0f);
+
+    ImageDiff diff;
+    double ssim_sum = 0.0;
+    std::size_t windows = 0;
+
+    diff.worst_window = 1.0;
+
+    for (unsigned int y = 0; y + window_y <= height; y += ssim_step) {
+        for (unsigned int x = 0; x + window_x <= width; x += ssim_step) {
+            double sum_a = 0.0, sum_b = 0.0, sum_aa = 0.0, sum_bb = 0.0, sum_ab = 0.0;
+
+            for (unsigned int j = y; j < y + window_y; ++j) {
+                for (unsigned int i = x; i < x + window_x; ++i) {
+                    auto va = a[(std::size_t) j * width + i];
+                    auto vb = b[(std::size_t) j * width + i];
+
+                    sum_a += va;
+                    sum_b += vb;
+                    sum_aa += va * va;
+                    sum_bb += vb * vb;
+                    sum_ab += va * vb;
+                }
+            }
+
+            auto n = (double) (window_x * window_y);
+            auto mean_a = sum_a / n;
+            auto mean_b = sum_b / n;
+            auto var_a = std::max(0.0, sum_aa / n - mean_a * mean_a);
+            auto var_b = std::max(0.0, sum_bb / n - mean_b * mean_b);
+            auto covariance = sum_ab / n - mean_a * mean_b;
+
+            auto ssim = ((2.0 * mean_a * mean_b + c1) * (2.0 * covariance + c2)) /
+                        ((mean_a * mean_a + mean_b * mean_b + c1) * (var_a + var_b + c2));
+
+            ssim_sum += ssim;
+            ++windows;
+            diff.worst_window = std::min(diff.worst_window, ssim);
+
+            for (unsigned int j = y; j < y + window_y; ++j) {
+                for (unsigned int i = x; i < x + window_x; ++i) {
+                    auto &worst = worst_at[(std::size_t) j * width + i];
+
+                    worst = std::min(worst, (float) ssim);
+                }
+            }
+        }
+    }
+    diff.ssim = windows ? ssim_sum / (double) windows : 1.0;
+
+    std::size_t changed = 0;
+
+    for (std::size_t i = 0; i < 3 * a.size(); i += 3) {
+        for (int c = 0; c < 3; ++c) {
+            if (std::abs((int) expected.color[i + c] - (int) actual.color[i + c]) > changed_pixel_threshold) {
+                ++changed;
+                break;
+            }
+        }
+    }
+    diff.changed = a.empty() ? 0.0 : (double) changed / (double) a.size();
+
+    if (heatmap) {
+        // 1 - SSIM of 0.25 or more is full red
+        heatmap->width = width;
+        heatmap->height = height;
+        heatmap->color.resize(3 * b.size());
+
+        for (std::size_t i = 0; i < b.size(); ++i) {
+            auto gray = 0.25 * b[i];
+            auto red = std::clamp(4.0 * (1.0 - worst_at[i]), 0.0, 1.0) * 255.0;
+
+            heatmap->color[3 * i] = (std::uint8_t) std::lround(std::max(gray, red));
+            heatmap->color[3 * i + 1] = (std::uint8_t) std::lround(gray);
+            heatmap->color[3 * i + 2] = (std::uint8_t) std::lround(gray);
+        }
+    }
+    return diff;
+}
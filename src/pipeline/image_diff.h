@@ -0,0 +1,31 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_IMAGE_DIFF_H
+#define DRAGON_GL_IMAGE_DIFF_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "rasterizer.h"
+
+/* Perceptual comparison of two renders with SSIM (Wang et al. 2004) on luma: mean, variance and covariance of
+ * 8x8 windows stepped by 4 pixels. 1 is identical; noise, blur, shifted edges or a changed tone all lower it,
+ * while a handful of pixels flipping along an edge barely does.
+ * https://www.cns.nyu.edu/pub/eero/wang03-reprint.pdf */
+const unsigned int ssim_window = 8;
+const unsigned int ssim_step = 4;
+const int changed_pixel_threshold = 8;  // of 255, on any channel
+
+struct ImageDiff {
+    double ssim = 0.0;          // mean over all windows
+    double worst_window = 0.0;  // lowest window; a local regression shows here before it moves the mean
+    double changed = 0.0;       // fraction of pixels off by more than changed_pixel_threshold
+};
+
+// Images must have the same size; heatmap (optional) gets the actual image darkened, with 1 - SSIM in red
+ImageDiff CompareImages(const Framebuffer &expected, const Framebuffer &actual, Framebuffer *heatmap = nullptr);
+
+#endif // DRAGON_GL_IMAGE_DIFF_H
@@ -0,0 +1,502 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "impostors.h"
+
+namespace {
+    std::uint64_t HashFile(std::uint64_t hash, const std::string &path) {
+        // The name, size and modification time of a texture; an edited image gets a new bake
+        hash = HashBytes(hash, path.data(), path.size());
+
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+
+        if (!error) {
+            hash = HashBytes(hash, &size, sizeof(size));
+        }
+        auto time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+
+        if (!error) {
+            hash = HashBytes(hash, &time, sizeof(time));
+        }
+        return hash;
+    }
+
+    // Bytes per pixel of the three atlases
+    const std::size_t albedo_pixel_bytes = 4;
+    const std::size_t normal_pixel_bytes = 8;  // RGBA16F
+    const std::size_t depth_pixel_bytes = 4;
+
+    std::size_t AtlasPixels() {
+        return (std::size_t) impostor_atlas_size * impostor_atlas_size;
+    }
+
+    ImpostorCacheHeader CacheHeader(const ImpostorMesh &mesh) {
+        // What a cached bake of the mesh must start with
+        ImpostorCacheHeader header{};
+
+        std::copy(std::begin(impostor_cache_magic), std::end(impostor_cache_magic), header.magic);
+        header.version = impostor_cache_version;
+        header.key = mesh.key;
+        header.grid = impostor_grid;
+        header.frame_size = impostor_frame_size;
+
+        for (int i = 0; i < 4; ++i) {
+            header.sphere[i] = mesh.sphere[i];
+        }
+        return header;
+    }
+
+    bool ReadCachedBake(const ImpostorParams &impostors, GLint layer) {
+        // Uploads a cached bake of the layer's mesh; false if there is none or it is stale
+        const auto &mesh = impostors.meshes[layer];
+        auto header = CacheHeader(mesh);
+
+        std::vector<char> albedo(AtlasPixels() * albedo_pixel_bytes);
+        std::vector<char> normal(AtlasPixels() * normal_pixel_bytes);
+        std::vector<char> depth(AtlasPixels() * depth_pixel_bytes);
+
+        if (!ReadCacheFile(CacheFilePath(impostor_cache_dir, mesh.key, impostor_cache_extension), &header,
+                           sizeof(header), {albedo, normal, depth})) {
+            return false;
+        }
+        auto size = (GLsizei) impostor_atlas_size;
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.albedo);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_UNSIGNED_BYTE, albedo.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.normal);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_RGBA, GL_HALF_FLOAT, normal.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.depth);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, size, size, 1, GL_DEPTH_COMPONENT, GL_FLOAT,
+                        depth.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        return true;
+    }
+
+    void WriteCachedBake(const ImpostorParams &impostors, GLint layer) {
+        // Reads the layer back from the bake framebuffer, which still has it attached, and stores it; a failed
+        // write only costs a bake next time
+        const auto &mesh = impostors.meshes[layer];
+        auto size = (GLsizei) impostor_atlas_size;
+
+        std::vector<char> albedo(AtlasPixels() * albedo_pixel_bytes);
+        std::vector<char> normal(AtlasPixels() * normal_pixel_bytes);
+        std::vector<char> depth(AtlasPixels() * depth_pixel_bytes);
+
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, albedo.data());
+        glReadBuffer(GL_COLOR_ATTACHMENT1);
+        glReadPixels(0, 0, size, size, GL_RGBA, GL_HALF_FLOAT, normal.data());
+        glReadPixels(0, 0, size, size, GL_DEPTH_COMPONENT, GL_FLOAT, depth.data());
+
+        auto header = CacheHeader(mesh);
+
+        if (!WriteCacheFile(CacheFilePath(impostor_cache_dir, mesh.key, impostor_cache_extension), &header,
+                            sizeof(header), {albedo, normal, depth})) {
+            std::cout << "Could not write the impostor cache in " << impostor_cache_dir << std::endl;
+        }
+    }
+
+    void BakeLayer(const ImpostorParams &impostors, GLint layer, GLuint camera_handle) {
+        // Every view of the grid into its own square of the layer, on the bound bake framebuffer
+        const auto &mesh = impostors.meshes[layer];
+
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, impostors.albedo, 0, layer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, impostors.normal, 0, layer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, impostors.depth, 0, layer);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "Impostor bake framebuffer is incomplete" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+
+        // Nothing covered: zero albedo and coverage, depth at the back of the sphere
+        glBindBuffer(GL_UNIFORM_BUFFER, camera_handle);
+        glViewport(0, 0, (GLsizei) impostor_atlas_size, (GLsizei) impostor_atlas_size);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        for (unsigned int j = 0; j < impostor_grid; ++j) {
+            for (unsigned int i = 0; i < impostor_grid; ++i) {
+                auto direction = HemiOctahedronDirection(glm::vec2(i, j) / (float) (impostor_grid - 1));
+                auto camera = ImpostorBakeCamera(mesh.sphere, direction);
+
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(TransformBlock), &camera);
+                glViewport((GLint) (i * impostor_frame_size), (GLint) (j * impostor_frame_size),
+                           (GLsizei) impostor_frame_size, (GLsizei) impostor_frame_size);
+
+                // The bake instance of this layer: model space is world and view space of the normals
+                glDrawArraysInstancedBaseInstance(GL_TRIANGLES, (GLint) mesh.first, (GLsizei) mesh.count, 1,
+                                                  (GLuint) layer);
+            }
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    GLuint CreateAtlasArray(GLenum internal_format, GLsizei levels, GLsizei layers) {
+        // Layered render target, filtered when sampled
+        GLuint texture;
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internal_format, (GLsizei) impostor_atlas_size,
+                       (GLsizei) impostor_atlas_size, layers);
+        TrackGlObject(GL_TEXTURE, texture, MemoryCategory::gpu_textures,
+                      TextureBytes((GLsizei) impostor_atlas_size, (GLsizei) impostor_atlas_size, layers, levels,
+                                   TexelBytes(internal_format)));
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        return texture;
+    }
+}
+
+std::uint64_t HashImpostorMesh(const Vertex *vertices, const ImpostorMesh &mesh, const MeshDesc &desc,
+                               bool use_textures) {
+    // Cache key of a bake: vertices, textures and everything that changes the atlases
+    auto hash = HashBytes(fnv_offset_basis, vertices + mesh.first, mesh.count * sizeof(Vertex));
+
+    if (use_textures && !desc.diffuse_path.empty()) {
+        hash = HashFile(hash, desc.diffuse_path);
+        hash = HashFile(hash, desc.normal_path);
+    }
+
+    const std::uint32_t settings[] = {impostor_cache_version, impostor_grid, impostor_frame_size,
+                                      use_textures && !desc.diffuse_path.empty()};
+
+    return HashBytes(hash, settings, sizeof(settings));
+}
+
+GlmVec3 HemiOctahedronDirection(const glm::vec2 &grid_uv) {
+    // [0, 1]^2 -> direction with y >= 0; the corners and edges of the square are on the horizon. Same as
+    // hemi_octahedron_direction in the impostor fragment shader
+    auto o = grid_uv * 2.0f - 1.0f;
+    GlmVec3 direction(0.5f * (o.x + o.y), 0.0f, 0.5f * (o.x - o.y));
+
+    direction.y = 1.0f - std::abs(direction.x) - std::abs(direction.z);
+
+    return glm::normalize(direction);
+}
+
+void ImpostorFrameBasis(const GlmVec3 &direction, GlmVec3 &right, GlmVec3 &up) {
+    // Image axes of the view looking along -direction; the shaders build the same basis
+    auto up_ref = std::abs(direction.y) > 0.999f ? GlmVec3(0.0f, 0.0f, -1.0f) : GlmVec3(0.0f, 1.0f, 0.0f);
+
+    right = glm::normalize(glm::cross(up_ref, direction));
+    up = glm::cross(direction, right);
+}
+
+TransformBlock ImpostorBakeCamera(const GlmVec4 &sphere, const GlmVec3 &direction) {
+    // Orthographic view of the bounding sphere from outside along direction. Reverse-Z like the scene: depth is 1
+    // at the front of the sphere and 0 at its back
+    GlmVec3 right, up;
+
+    ImpostorFrameBasis(direction, right, up);
+
+    auto center = GlmVec3(sphere);
+    auto radius = sphere.w;
+    auto eye = center + radius * direction;
+
+    TransformBlock camera{};
+
+    camera.view = GlmMat4(1.0f);
+
+    for (int i = 0; i < 3; ++i) {
+        camera.view[i][0] = right[i];
+        camera.view[i][1] = up[i];
+        camera.view[i][2] = direction[i];
+    }
+    camera.view[3][0] = -glm::dot(right, eye);
+    camera.view[3][1] = -glm::dot(up, eye);
+    camera.view[3][2] = -glm::dot(direction, eye);
+
+    camera.projection = GlmMat4(1.0f);
+    camera.projection[0][0] = 1.0f / radius;
+    camera.projection[1][1] = 1.0f / radius;
+    camera.projection[2][2] = 0.5f / radius;
+    camera.projection[3][2] = 1.0f;
+
+    return camera;
+}
+
+ImpostorParams CreateImpostors(const SceneDescription &scene, const SceneParams &scene_params, ShadingOption opt,
+                               unsigned int threshold_pixels) {
+    /* One layer per distinct mesh and material, baked with the deferred geometry program or read from the cache.
+     * Needs the vertex list, which main.cpp frees later */
+    ImpostorParams impostors;
+
+    impostors.threshold_pixels = threshold_pixels;
+
+    auto vertices = scene_params.buffer_tris.vertex_list.get();
+    auto use_textures = opt == ShadingOption::normal_mapping;
+
+    for (std::size_t i = 0; i < scene_params.draws.size(); ++i) {
+        const auto &draw = scene_params.draws[i];
+        auto material = scene_params.instances[i].material;
+
+        auto found = std::find_if(impostors.meshes.begin(), impostors.meshes.end(), [&](const ImpostorMesh &mesh) {
+            return mesh.first == draw.first && mesh.count == draw.count && mesh.material == material;
+        });
+
+        impostors.layer_of.push_back((unsigned int) (found - impostors.meshes.begin()));
+        impostors.full_counts.push_back(draw.instance_count);
+
+        if (found != impostors.meshes.end()) {
+            continue;
+        }
+
+        // Bounding sphere as for the shadow map, with a margin
+        ImpostorMesh mesh;
+
+        mesh.first = draw.first;
+        mesh.count = draw.count;
+        mesh.material = material;
+
+        GlmVec3 lo(std::numeric_limits<float>::max());
+        GlmVec3 hi(std::numeric_limits<float>::lowest());
+
+        for (GLuint v = draw.first; v < draw.first + draw.count; ++v) {
+            lo = glm::min(lo, vertices[v].pos);
+            hi = glm::max(hi, vertices[v].pos);
+        }
+
+        auto center = draw.count ? 0.5f * (lo + hi) : GlmVec3(0.0f);
+        auto radius = 0.0f;
+
+        for (GLuint v = draw.first; v < draw.first + draw.count; ++v) {
+            radius = std::max(radius, glm::length(vertices[v].pos - center));
+        }
+        mesh.sphere = GlmVec4(center, std::max(radius, 1e-6f) * impostor_sphere_margin);
+        mesh.key = HashImpostorMesh(vertices, mesh, scene.meshes[scene.instances[i].mesh], use_textures);
+
+        impostors.meshes.push_back(mesh);
+    }
+
+    auto layers = (GLsizei) impostors.meshes.size();
+    auto levels = (GLsizei) std::log2(impostor_atlas_size) + 1;
+
+    impostors.albedo = CreateAtlasArray(GL_RGBA8, levels, layers);
+    impostors.normal = CreateAtlasArray(GL_RGBA16F, levels, layers);
+    impostors.depth = CreateAtlasArray(GL_DEPTH_COMPONENT32F, 1, layers);
+
+    // Bake state: the geometry program of the deferred path, and a camera and instance per layer in place of
+    // the scene's
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<GLint> missing;
+
+    for (GLint layer = 0; layer < layers; ++layer) {
+        if (ReadCachedBake(impostors, layer)) {
+            impostors.cached++;
+        } else {
+            missing.push_back(layer);
+        }
+    }
+
+    if (!missing.empty()) {
+        auto program = CreateShaderProgram(deferred_dir + "/vertex.glsl", deferred_dir + "/fragment.glsl",
+                                           GetMaterialShaderDefines(scene_params.materials));
+
+        SetMaterialSamplers(program.program);
+        glUniform1i(glGetUniformLocation(program.program, "useTextures"), use_textures);
+        BindMaterialTextures(scene_params.materials);
+
+        std::vector<InstanceBlock> bake_instances(layers);
+
+        for (GLsizei layer = 0; layer < layers; ++layer) {
+            bake_instances[layer] = {GlmMat4(1.0f), GlmMat4(1.0f), GlmMat4(1.0f),
+                                     glm::uvec4(impostors.meshes[layer].material, 0, 0, 0)};
+        }
+
+        GLuint instance_handle, camera_handle, fbo;
+
+        glGenBuffers(1, &instance_handle);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, instance_handle);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (bake_instances.size() * sizeof(InstanceBlock)),
+                     bake_instances.data(), GL_STATIC_DRAW);
+        TrackGlObject(GL_BUFFER, instance_handle, MemoryCategory::gpu_storage,
+                      bake_instances.size() * sizeof(InstanceBlock));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glGenBuffers(1, &camera_handle);
+        glBindBuffer(GL_UNIFORM_BUFFER, camera_handle);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(TransformBlock), nullptr, GL_DYNAMIC_DRAW);
+        TrackGlObject(GL_BUFFER, camera_handle, MemoryCategory::gpu_uniforms, sizeof(TransformBlock));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+        GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, draw_buffers);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, instance_buffer_binding, instance_handle);
+        glBindBufferRange(GL_UNIFORM_BUFFER, 0, camera_handle, 0, sizeof(TransformBlock));
+        glBindVertexArray(scene_params.buffer_tris.vao);
+        glEnable(GL_DEPTH_TEST);
+
+        for (auto layer: missing) {
+            BakeLayer(impostors, layer, camera_handle);
+            WriteCachedBake(impostors, layer);
+            impostors.baked++;
+        }
+
+        // Back to the scene's camera and instances
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, instance_buffer_binding, scene_params.instances_handle);
+        glBindBufferRange(GL_UNIFORM_BUFFER, 0, scene_params.transforms_handle, 0, sizeof(TransformBlock));
+        glUseProgram(0);
+
+        GLuint bake_buffers[] = {camera_handle, instance_handle};
+
+        glDeleteFramebuffers(1, &fbo);
+        ReleaseGlObjects(GL_BUFFER, 2, bake_buffers);
+        glDeleteBuffers(2, bake_buffers);
+        glDeleteProgram(program.program);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.albedo);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.normal);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    impostors.bake_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Drawing: the atlases stay bound on their units, the bounds and the draw list in shader storage
+    std::vector<GlmVec4> spheres;
+
+    for (const auto &mesh: impostors.meshes) {
+        spheres.push_back(mesh.sphere);
+    }
+
+    glGenBuffers(1, &impostors.spheres);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, impostors.spheres);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (spheres.size() * sizeof(GlmVec4)), spheres.data(),
+                 GL_STATIC_DRAW);
+    TrackGlObject(GL_BUFFER, impostors.spheres, MemoryCategory::gpu_storage, spheres.size() * sizeof(GlmVec4));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, impostor_spheres_binding, impostors.spheres);
+
+    glGenBuffers(1, &impostors.draws);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, impostors.draws);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::uvec4), nullptr, GL_STREAM_DRAW);
+    TrackGlObject(GL_BUFFER, impostors.draws, MemoryCategory::gpu_storage, sizeof(glm::uvec4));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, impostor_draws_binding, impostors.draws);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + impostor_albedo_unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.albedo);
+    glActiveTexture(GL_TEXTURE0 + impostor_normal_unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.normal);
+    glActiveTexture(GL_TEXTURE0 + impostor_depth_unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, impostors.depth);
+    glActiveTexture(GL_TEXTURE0);
+
+    impostors.program = CreateShaderProgram(impostor_dir + "/vertex.glsl", impostor_dir + "/fragment.glsl");
+
+    auto program = impostors.program.program;
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "impostorAlbedo"), (GLint) impostor_albedo_unit);
+    glUniform1i(glGetUniformLocation(program, "impostorNormal"), (GLint) impostor_normal_unit);
+    glUniform1i(glGetUniformLocation(program, "impostorDepth"), (GLint) impostor_depth_unit);
+    glUseProgram(0);
+
+    return impostors;
+}
+
+void UpdateImpostors(ImpostorParams &impostors, SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Once per frame, before drawing: instances smaller than the threshold on screen leave the multi-draw (their
+    // command gets no instance) and join the impostor list. The commands are only uploaded if that changed
+    auto transforms = ComputeTransforms(scene_params.instances, scene_globals);
+    auto pixels_per_unit = 0.5f * (float) scene_globals.height * transforms.camera.projection[1][1];
+    auto changed = false;
+
+    impostors.drawn.clear();
+    impostors.triangles_replaced = 0;
+
+    for (std::size_t i = 0; i < scene_params.draws.size(); ++i) {
+        auto layer = impostors.layer_of[i];
+        const auto &sphere = impostors.meshes[layer].sphere;
+        const auto &world = transforms.instances[i].world;
+
+        auto center = GlmVec3(world * GlmVec4(GlmVec3(sphere), 1.0f));
+        auto scale = std::max({glm::length(GlmVec3(world[0])), glm::length(GlmVec3(world[1])),
+                               glm::length(GlmVec3(world[2]))});
+        auto radius = sphere.w * scale;
+        auto distance = glm::length(center - eye_pos);
+
+        // diameter in pixels; the camera must be outside the sphere
+        auto far = distance > radius && 2.0f * radius * pixels_per_unit / distance < (float) impostors.threshold_pixels;
+        auto &draw = scene_params.draws[i];
+        auto instance_count = far ? 0u : impostors.full_counts[i];
+
+        if (draw.instance_count != instance_count) {
+            draw.instance_count = instance_count;
+            changed = true;
+        }
+        if (far) {
+            impostors.drawn.emplace_back((unsigned int) i, layer, 0, 0);
+            impostors.triangles_replaced += draw.count / 3;
+        }
+    }
+
+    if (changed) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene_params.indirect_handle);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, (GLsizeiptr) (scene_params.draws.size() * sizeof(DrawCommand)),
+                        scene_params.draws.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    if (!impostors.drawn.empty()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, impostors.draws);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (impostors.drawn.size() * sizeof(glm::uvec4)),
+                     impostors.drawn.data(), GL_STREAM_DRAW);
+        TrackGlObject(GL_BUFFER, impostors.draws, MemoryCategory::gpu_storage,
+                      impostors.drawn.size() * sizeof(glm::uvec4));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+void DrawImpostors(const ImpostorParams &impostors) {
+    // All impostors in one instanced draw of a 4 vertex strip; after the meshes, depth tested against them
+    if (impostors.drawn.empty()) {
+        return;
+    }
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glUseProgram(impostors.program.program);
+    glBindVertexArray(EmptyVertexArray());
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei) impostors.drawn.size());
+
+    glUseProgram(current_program);
+}
+
+std::string ImpostorStats(const ImpostorParams &impostors) {
+    // eg. "12 impostors (1843200 triangles replaced)"
+    std::ostringstream stats;
+
+    stats << impostors.drawn.size() << " impostors (" << impostors.triangles_replaced << " triangles replaced)";
+
+    return stats.str();
+}
+
+void DeleteImpostors(ImpostorParams &impostors) {
+    GLuint textures[] = {impostors.albedo, impostors.normal, impostors.depth};
+    GLuint buffers[] = {impostors.spheres, impostors.draws};
+
+    ReleaseGlObjects(GL_TEXTURE, 3, textures);
+    ReleaseGlObjects(GL_BUFFER, 2, buffers);
+    glDeleteTextures(3, textures);
+    glDeleteBuffers(2, buffers);
+    glDeleteProgram(impostors.program.program);
+
+    impostors = ImpostorParams{};
+}
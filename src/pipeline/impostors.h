@@ -0,0 +1,107 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_IMPOSTORS_H
+#define DRAGON_GL_IMPOSTORS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+#include "deferred.h"
+#include "materials.h"
+#include "../load-utils/scene_file.h"
+
+/* Octahedral impostors ('impostors=PX'): every mesh (with its material) is baked from a hemi-octahedral grid of
+ * view directions above its horizon, by the geometry program of the deferred path, into layers of three texture
+ * arrays: albedo (alpha: coverage), model space normal, and depth. Instances whose bounding sphere covers fewer
+ * than PX pixels on screen leave the multi-draw and become one camera facing quad each. The quad is intersected
+ * per fragment with the planes of the four nearest baked views, each sample is corrected for parallax with the
+ * baked depth, and the samples are blended. Bakes are cached on disk, keyed by the vertices, the textures and the
+ * bake settings */
+const unsigned int impostor_grid = 8;          // views per side of the grid; must match GRID in the shaders
+const unsigned int impostor_frame_size = 128;  // pixels per side of one view
+const unsigned int impostor_atlas_size = impostor_grid * impostor_frame_size;
+const float impostor_sphere_margin = 1.02f;    // the bounding sphere is grown so no edge touches the frame border
+
+// Texture units (materials use 6 to 13, the shadow map 14) and storage buffer bindings (vertex pulling uses 8
+// to 11)
+const GLuint impostor_albedo_unit = 15;
+const GLuint impostor_normal_unit = 16;
+const GLuint impostor_depth_unit = 17;
+const GLuint impostor_draws_binding = 12;
+const GLuint impostor_spheres_binding = 13;
+
+const std::string impostor_cache_dir = "impostor_cache";
+const std::string impostor_cache_extension = ".dimp";
+const char impostor_cache_magic[4] = {'D', 'I', 'M', '1'};
+const std::uint32_t impostor_cache_version = 1;
+
+// Header of a cached bake; followed by the albedo (RGBA8), normal (RGBA16F) and depth (float) atlases
+struct ImpostorCacheHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t key;
+    std::uint32_t grid;
+    std::uint32_t frame_size;
+    float sphere[4];  // model space center and radius
+};
+
+// A mesh and material pair; one layer of the atlases
+struct ImpostorMesh {
+    GLuint first = 0;
+    GLuint count = 0;
+    unsigned int material = 0;
+    GlmVec4 sphere{0.0f};  // model space bounds (xyz: center, w: radius)
+    std::uint64_t key = 0;
+};
+
+struct ImpostorParams {
+    unsigned int threshold_pixels = 0;
+    std::vector<ImpostorMesh> meshes;
+    std::vector<unsigned int> layer_of;  // per instance
+
+    GLuint albedo = 0;  // 2D arrays, one layer per mesh
+    GLuint normal = 0;
+    GLuint depth = 0;
+    GLuint spheres = 0;  // vec4 per layer
+    GLuint draws = 0;    // uvec4 per drawn impostor: instance, layer
+    ShaderParams program{};
+
+    std::vector<glm::uvec4> drawn;          // this frame's impostors
+    std::vector<GLuint> full_counts;        // instance count of every command without impostors
+    std::size_t triangles_replaced = 0;     // this frame
+
+    // Bake stats
+    std::size_t baked = 0;
+    std::size_t cached = 0;
+    double bake_ms = 0.0;
+};
+
+std::uint64_t HashImpostorMesh(const Vertex *vertices, const ImpostorMesh &mesh, const MeshDesc &desc,
+                               bool use_textures);
+GlmVec3 HemiOctahedronDirection(const glm::vec2 &grid_uv);
+void ImpostorFrameBasis(const GlmVec3 &direction, GlmVec3 &right, GlmVec3 &up);
+TransformBlock ImpostorBakeCamera(const GlmVec4 &sphere, const GlmVec3 &direction);
+ImpostorParams CreateImpostors(const SceneDescription &scene, const SceneParams &scene_params, ShadingOption opt,
+                               unsigned int threshold_pixels);
+void UpdateImpostors(ImpostorParams &impostors, SceneParams &scene_params, const SceneGlobals &scene_globals);
+void DrawImpostors(const ImpostorParams &impostors);
+std::string ImpostorStats(const ImpostorParams &impostors);
+void DeleteImpostors(ImpostorParams &impostors);
+
+#endif // DRAGON_GL_IMPOSTORS_H
@@ -0,0 +1,95 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "job_system.h"
+
+JobSystem::JobSystem(unsigned int thread_count) {
+    // Workers start immediately and sleep until jobs arrive
+    for (unsigned int i = 0; i < thread_count; ++i) {
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem() {
+    // Finishes queued jobs, then joins all workers
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+JobSystem JobSystem::ForCores(unsigned int cores) {
+    // The calling thread runs jobs inside ParallelFor and Wait, so N cores need N - 1 workers; one core gets a
+    // pool without workers, which only makes progress through those two
+    return JobSystem(cores > 0 ? cores - 1 : 0);
+}
+
+unsigned int JobSystem::ThreadCount() const {
+    return (unsigned int) workers.size();
+}
+
+void JobSystem::WorkerLoop() {
+    // Runs jobs until the pool is destroyed and the queue is empty
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+            if (queue.empty()) {
+                return;
+            }
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
+
+bool JobSystem::RunPendingJob() {
+    // Runs one queued job on the calling thread, if there is any
+    std::function<void()> job;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+
+        if (queue.empty()) {
+            return false;
+        }
+        job = std::move(queue.front());
+        queue.pop_front();
+    }
+    job();
+
+    return true;
+}
+
+void JobSystem::ParallelFor(std::size_t count, std::size_t grain,
+                            const std::function<void(std::size_t begin, std::size_t end)> &body) {
+    // Splits [0, count) into chunks of at least 'grain' items and blocks until all are done
+    grain = std::max<std::size_t>(grain, 1);
+
+    std::vector<std::future<void>> chunks;
+
+    for (std::size_t begin = 0; begin < count; begin += grain) {
+        auto end = std::min(count, begin + grain);
+
+        chunks.push_back(Submit([&body, begin, end]() { body(begin, end); }));
+    }
+
+    // Help out until the queue is drained; chunks still unfinished after that are running elsewhere
+    while (RunPendingJob()) {
+    }
+
+    // get() rethrows exceptions raised inside a chunk
+    for (auto &chunk: chunks) {
+        chunk.get();
+    }
+}
@@ -0,0 +1,77 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_JOB_SYSTEM_H
+#define DRAGON_GL_JOB_SYSTEM_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads consuming a FIFO of jobs.
+// ParallelFor and Wait may be nested inside a job: while they wait, the calling thread runs queued jobs itself,
+// so workers never all block on work that nobody is left to run, and a pool without workers still finishes.
+class JobSystem {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex queue_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void WorkerLoop();
+    bool RunPendingJob();
+
+public:
+    explicit JobSystem(unsigned int thread_count = std::max(1u, std::thread::hardware_concurrency()));
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    static JobSystem ForCores(unsigned int cores);
+
+    unsigned int ThreadCount() const;
+
+    template<typename Job>
+    auto Submit(Job &&job) -> std::future<decltype(job())> {
+        // Queues a job; the future carries its result (or exception)
+        using Result = decltype(job());
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Job>(job));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+
+            queue.emplace_back([task]() { (*task)(); });
+        }
+        wake.notify_one();
+
+        return result;
+    }
+
+    template<typename Result>
+    Result Wait(std::future<Result> &result) {
+        // The result of a submitted job; queued jobs run on the calling thread until it is ready
+        while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!RunPendingJob()) {
+                // the job is running on a worker
+                result.wait();
+            }
+        }
+        return result.get();
+    }
+
+    void ParallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t begin, std::size_t end)> &body);
+};
+
+#endif // DRAGON_GL_JOB_SYSTEM_H
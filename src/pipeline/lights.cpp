@@ -0,0 +1,76 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "lights.h"
+
+LightList CreateSceneLights(const LightList &scene_lights, unsigned int count) {
+    // The lights of the scene come first (the first one is the key light); randomly placed fill lights
+    // are added up to count
+    LightList lights(scene_lights);
+
+    std::mt19937 generator(light_seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (auto i = (unsigned int) lights.size(); i < count; ++i) {
+        // Uniformly distributed direction, random distance within the shell
+        float z = 2.0f * unit(generator) - 1.0f;
+        float phi = 2.0f * glm::pi<float>() * unit(generator);
+        float r_xy = std::sqrt(1.0f - z * z);
+        float distance = glm::mix(light_shell_inner, light_shell_outer, unit(generator));
+
+        VecDirection direction(r_xy * std::cos(phi), r_xy * std::sin(phi), z);
+
+        PointLight light{};
+
+        light.position = GlmVec4(direction * distance, glm::mix(light_radius_min, light_radius_max,
+                                                                 unit(generator)));
+        light.color = GlmVec4(unit(generator), unit(generator), unit(generator), 1.0f);
+
+        lights.push_back(light);
+    }
+
+    return lights;
+}
+
+GLuint CreateLightBuffer(const LightList &lights) {
+    // Shader storage buffer holding an arbitrary number of point lights
+    // https://www.khronos.org/opengl/wiki/Shader_Storage_Buffer_Object
+    GLuint light_buffer;
+
+    glGenBuffers(1, &light_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, light_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, lights.size() * sizeof(PointLight), lights.data(),
+                 GL_DYNAMIC_DRAW);
+    TrackGlObject(GL_BUFFER, light_buffer, MemoryCategory::gpu_storage, lights.size() * sizeof(PointLight));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, light_buffer_binding, light_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return light_buffer;
+}
+
+void UpdateLightBuffer(GLuint light_buffer, const LightList &lights) {
+    // Re-upload light positions and colors (the light count does not change)
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, light_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, lights.size() * sizeof(PointLight), lights.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void AnimateLights(const LightList &base_lights, double time, LightList &lights) {
+    // Orbits every fill light around the y axis and bobs it up and down; the key light stays put
+    // Speeds are derived from the light ordinal so a given time always gives the same positions
+    for (std::size_t i = 1; i < base_lights.size(); ++i) {
+        float phase = std::fmod((float) i * 0.618034f, 1.0f);  // golden ratio sequence
+        float speed = glm::mix(light_orbit_speed_min, light_orbit_speed_max, phase);
+        float angle = (float) time * speed * (i % 2 ? 1.0f : -1.0f);
+
+        GlmVec4 base = base_lights[i].position;
+
+        float x = base.x * std::cos(angle) - base.z * std::sin(angle);
+        float z = base.x * std::sin(angle) + base.z * std::cos(angle);
+        float y = base.y + light_bob_height * std::sin((float) time * speed * 2.0f + phase * 6.2831853f);
+
+        lights[i].position = GlmVec4(x, y, z, base.w);
+    }
+}
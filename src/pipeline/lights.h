@@ -0,0 +1,52 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_LIGHTS_H
+#define DRAGON_GL_LIGHTS_H
+
+#include <random>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "attributes.h"
+#include "memory_tracker.h"
+
+using LightList = std::vector<PointLight>;
+
+// Shader storage binding point of the light list (0 and 1 are the Matrices and Lighting UBOs)
+const GLuint light_buffer_binding = 2;
+
+// Clustered (forward+) light culling: froxel grid over the view frustum, exponential in depth
+const unsigned int cluster_grid_x = 16;
+const unsigned int cluster_grid_y = 16;
+const unsigned int cluster_grid_z = 24;
+const unsigned int max_lights_per_cluster = 128;
+const GLuint cluster_lights_binding = 3;
+const GLuint cluster_counts_binding = 4;
+
+// Stress mode animation
+const float light_orbit_speed_min = 0.2f;  // radians per second
+const float light_orbit_speed_max = 1.2f;
+const float light_bob_height = 0.15f;
+
+// Lights beyond the scene lights are scattered in a shell around the model
+const float light_shell_inner = 0.6f;
+const float light_shell_outer = 1.6f;
+const float light_radius_min = 0.35f;
+const float light_radius_max = 0.75f;
+const float key_light_radius = 8.0f;
+
+// Fixed seed; the same light count always produces the same scene
+const unsigned int light_seed = 1996;
+
+LightList CreateSceneLights(const LightList &scene_lights, unsigned int count);
+GLuint CreateLightBuffer(const LightList &lights);
+void UpdateLightBuffer(GLuint light_buffer, const LightList &lights);
+void AnimateLights(const LightList &base_lights, double time, LightList &lights);
+
+#endif // DRAGON_GL_LIGHTS_H
@@ -0,0 +1,186 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "materials.h"
+#include "scene.h"
+
+bool HasExtension(const std::string &name) {
+    // https://www.khronos.org/opengl/wiki/OpenGL_Extension#Extension_querying
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (GLint i = 0; i < count; ++i) {
+        auto extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+
+        if (extension && name == extension) {
+            return true;
+        }
+    }
+    return false;
+}
+
+GLenum GetPixelFormat(int components) {
+    // Client pixel format of a decoded image
+    if (components == 1) {
+        return GL_RED;
+    } else if (components == 2) {
+        return GL_RG;
+    } else if (components == 3) {
+        return GL_RGB;
+    }
+    return GL_RGBA;
+}
+
+GLuint CreateTextureArray(const std::vector<ImageData> &images, const std::vector<std::size_t> &layers) {
+    // One RGBA8 array holding same-sized images, one per layer, with a full mip chain
+    // https://www.khronos.org/opengl/wiki/Array_Texture
+    const auto &first = images[layers.front()];
+    auto levels = 1 + (GLsizei) std::floor(std::log2(std::max(first.width, first.height)));
+
+    GLuint texture;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, first.width, first.height, (GLsizei) layers.size());
+    TrackGlObject(GL_TEXTURE, texture, MemoryCategory::gpu_textures,
+                  TextureBytes(first.width, first.height, (GLsizei) layers.size(), levels, 4));
+
+    // rows of 1 or 3 component images are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (std::size_t layer = 0; layer < layers.size(); ++layer) {
+        const auto &image = images[layers[layer]];
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint) layer, image.width, image.height, 1,
+                        GetPixelFormat(image.components), GL_UNSIGNED_BYTE, image.pixels.data());
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return texture;
+}
+
+MaterialParams CreateMaterials(const SceneAssets &assets, bool allow_bindless, const VecColor &base_color,
+                               std::vector<unsigned int> &material_of) {
+    /* Uploads every unique image once and builds the material table; scene meshes with the same pair of
+     * images share a material. Shaders find textures through the table, so no draw rebinds anything */
+    MaterialParams materials;
+
+    materials.bindless = allow_bindless && HasExtension(bindless_extension);
+
+    // Reference stored in the material table for each unique image
+    std::vector<glm::uvec2> image_refs(assets.images.size());
+
+    if (materials.bindless) {
+        // https://www.khronos.org/opengl/wiki/Bindless_Texture
+        auto get_texture_handle = (GetTextureHandleProc) glfwGetProcAddress("glGetTextureHandleARB");
+        auto make_handle_resident = (MakeTextureHandleResidentProc)
+                glfwGetProcAddress("glMakeTextureHandleResidentARB");
+
+        for (std::size_t i = 0; i < assets.images.size(); ++i) {
+            const auto &image = assets.images[i];
+
+            // the texture is immutable once it has a handle; CreateTexture sets all state first
+            auto texture = CreateTexture(image.pixels.data(), image.width, image.height, image.components);
+            auto handle = get_texture_handle(texture);
+
+            make_handle_resident(handle);
+
+            image_refs[i] = glm::uvec2((GLuint) (handle & 0xffffffffu), (GLuint) (handle >> 32));
+            materials.textures.push_back(texture);
+        }
+    } else {
+        // Arrays need equally sized layers: one array per distinct size
+        std::map<std::pair<int, int>, std::vector<std::size_t>> by_size;
+
+        for (std::size_t i = 0; i < assets.images.size(); ++i) {
+            by_size[{assets.images[i].width, assets.images[i].height}].push_back(i);
+        }
+
+        if (by_size.size() > max_material_arrays) {
+            std::cout << "Too many distinct texture sizes (" << by_size.size() << ") without bindless textures, "
+                      << "at most " << max_material_arrays << " are supported" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+
+        for (const auto &[size, layers]: by_size) {
+            auto array = (unsigned int) materials.textures.size();
+
+            materials.textures.push_back(CreateTextureArray(assets.images, layers));
+
+            for (std::size_t layer = 0; layer < layers.size(); ++layer) {
+                image_refs[layers[layer]] = glm::uvec2(array, layer);
+            }
+        }
+    }
+
+    std::vector<MaterialBlock> blocks;
+    std::map<std::pair<int, int>, unsigned int> material_ordinal;
+
+    for (std::size_t i = 0; i < assets.mesh_of.size(); ++i) {
+        auto key = std::make_pair(assets.diffuse_of[i], assets.normal_of[i]);
+        auto [it, inserted] = material_ordinal.try_emplace(key, (unsigned int) blocks.size());
+
+        if (inserted) {
+            MaterialBlock block{};
+            auto textured = key.first >= 0 && key.second >= 0;
+
+            if (textured) {
+                block.textures = glm::uvec4(image_refs[key.first], image_refs[key.second]);
+            }
+            block.color = GlmVec4(base_color, textured ? 1.0f : 0.0f);
+
+            blocks.push_back(block);
+        }
+        material_of.push_back(it->second);
+    }
+    materials.count = blocks.size();
+
+    glGenBuffers(1, &materials.buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, materials.buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, blocks.size() * sizeof(MaterialBlock), blocks.data(), GL_STATIC_DRAW);
+    TrackGlObject(GL_BUFFER, materials.buffer, MemoryCategory::gpu_storage, blocks.size() * sizeof(MaterialBlock));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, material_buffer_binding, materials.buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return materials;
+}
+
+void BindMaterialTextures(const MaterialParams &materials) {
+    // Texture arrays stay bound for the lifetime of the scene; bindless textures need no units
+    if (materials.bindless) {
+        return;
+    }
+    for (std::size_t i = 0; i < materials.textures.size(); ++i) {
+        glActiveTexture(GL_TEXTURE0 + material_array_unit + i);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, materials.textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SetMaterialSamplers(GLuint program) {
+    // Points the materialArrays[] samplers at their units; a no-op for programs without them
+    GLint units[max_material_arrays];
+
+    for (unsigned int i = 0; i < max_material_arrays; ++i) {
+        units[i] = (GLint) (material_array_unit + i);
+    }
+
+    glUseProgram(program);
+    glUniform1iv(glGetUniformLocation(program, material_arrays_name.c_str()), max_material_arrays, units);
+}
+
+std::string GetMaterialShaderDefines(const MaterialParams &materials) {
+    // Selects the texture lookup in shaders that sample materials
+    return materials.bindless ? bindless_shader_defines : "";
+}
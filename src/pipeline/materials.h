@@ -0,0 +1,54 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_MATERIALS_H
+#define DRAGON_GL_MATERIALS_H
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "attributes.h"
+#include "../load-utils/asset_manager.h"
+
+// Shader storage binding points of the per-instance data and the material table
+const GLuint instance_buffer_binding = 5;
+const GLuint material_buffer_binding = 6;
+
+// Texture array fallback: one array per distinct texture size, on consecutive units
+const GLuint material_array_unit = 6;
+const unsigned int max_material_arrays = 8;  // must match MAX_MATERIAL_ARRAYS in the shaders
+const std::string material_arrays_name = "materialArrays";
+
+// Prepended (after #version) to shaders that sample materials, if bindless handles are used
+const std::string bindless_extension = "GL_ARB_bindless_texture";
+const std::string bindless_shader_defines = "#extension GL_ARB_bindless_texture : require\n"
+                                            "#define BINDLESS_TEXTURES\n";
+
+// ARB_bindless_texture entry points, loaded by hand since the loader may not include the extension
+using GetTextureHandleProc = GLuint64 (APIENTRYP)(GLuint texture);
+using MakeTextureHandleResidentProc = void (APIENTRYP)(GLuint64 handle);
+
+struct MaterialParams {
+    bool bindless = false;
+    GLuint buffer = 0;             // MaterialBlock per material
+    std::vector<GLuint> textures;  // bindless: one texture per unique image; otherwise the texture arrays
+    unsigned int count = 0;
+};
+
+bool HasExtension(const std::string &name);
+GLenum GetPixelFormat(int components);
+GLuint CreateTextureArray(const std::vector<ImageData> &images, const std::vector<std::size_t> &layers);
+MaterialParams CreateMaterials(const SceneAssets &assets, bool allow_bindless, const VecColor &base_color,
+                               std::vector<unsigned int> &material_of);
+void BindMaterialTextures(const MaterialParams &materials);
+void SetMaterialSamplers(GLuint program);
+std::string GetMaterialShaderDefines(const MaterialParams &materials);
+
+#endif // DRAGON_GL_MATERIALS_H
@@ -0,0 +1,234 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "memory_tracker.h"
+
+static_assert(std::size(memory_category_names) == (std::size_t) MemoryCategory::count);
+
+namespace {
+    const auto category_count = (std::size_t) MemoryCategory::count;
+    const auto side_count = (std::size_t) MemorySide::count;
+    const std::string side_names[] = {"CPU", "GPU"};
+
+    MemoryCounter category_counters[category_count];
+    MemoryCounter side_counters[side_count];
+    std::atomic<std::int64_t> side_budgets[side_count] = {};  // bytes; 0 is no budget
+    std::atomic<bool> over_budget[side_count] = {};
+
+    // Category and size of every tagged GL object, by type and name
+    std::mutex gl_objects_mutex;
+    std::map<std::pair<GLenum, GLuint>, std::pair<MemoryCategory, std::size_t>> gl_objects;
+
+    double Megabytes(std::int64_t bytes) {
+        return (double) bytes / (1024.0 * 1024.0);
+    }
+
+    void RaisePeak(MemoryCounter &counter, std::int64_t live) {
+        auto peak = counter.peak.load(std::memory_order_relaxed);
+
+        while (live > peak && !counter.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    void CheckBudget(MemorySide side, std::int64_t live) {
+        // Warns when the side goes over its budget, and again only after it went back under
+        auto index = (std::size_t) side;
+        auto budget = side_budgets[index].load(std::memory_order_relaxed);
+
+        if (budget == 0) {
+            return;
+        }
+        if (live <= budget) {
+            over_budget[index].store(false, std::memory_order_relaxed);
+            return;
+        }
+        if (over_budget[index].exchange(true, std::memory_order_relaxed)) {
+            return;
+        }
+
+        // the largest category of the side is the first place to look
+        std::size_t largest = category_count;
+
+        for (std::size_t i = 0; i < category_count; ++i) {
+            if (CategorySide((MemoryCategory) i) == side &&
+                (largest == category_count || category_counters[i].live > category_counters[largest].live)) {
+                largest = i;
+            }
+        }
+
+        std::ostringstream warning;
+
+        warning << std::fixed << std::setprecision(1) << "Memory budget exceeded: " << side_names[index] << " "
+                << Megabytes(live) << " MB live, budget " << Megabytes(budget) << " MB";
+
+        if (largest < category_count) {
+            warning << " (largest: " << memory_category_names[largest] << " "
+                    << Megabytes(category_counters[largest].live) << " MB)";
+        }
+        std::cout << warning.str() << std::endl;
+    }
+
+    void AddMemory(MemoryCategory category, std::int64_t bytes) {
+        auto &counter = category_counters[(std::size_t) category];
+        auto side = CategorySide(category);
+        auto &side_counter = side_counters[(std::size_t) side];
+
+        RaisePeak(counter, counter.live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+
+        auto side_live = side_counter.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+        RaisePeak(side_counter, side_live);
+        CheckBudget(side, side_live);
+    }
+}
+
+MemoryTag::MemoryTag(MemoryCategory category, std::size_t bytes) : category_(category), bytes_(bytes) {
+    TrackMemory(category_, bytes_);
+}
+
+MemoryTag::MemoryTag(MemoryTag &&other) noexcept : category_(other.category_), bytes_(other.bytes_) {
+    other.bytes_ = 0;
+}
+
+MemoryTag &MemoryTag::operator=(MemoryTag &&other) noexcept {
+    if (this != &other) {
+        ReleaseMemory(category_, bytes_);
+
+        category_ = other.category_;
+        bytes_ = other.bytes_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+MemoryTag::~MemoryTag() {
+    ReleaseMemory(category_, bytes_);
+}
+
+MemorySide CategorySide(MemoryCategory category) {
+    return category < MemoryCategory::gpu_vertices ? MemorySide::cpu : MemorySide::gpu;
+}
+
+void TrackMemory(MemoryCategory category, std::size_t bytes) {
+    if (bytes > 0) {
+        AddMemory(category, (std::int64_t) bytes);
+    }
+}
+
+void ReleaseMemory(MemoryCategory category, std::size_t bytes) {
+    if (bytes > 0) {
+        AddMemory(category, -(std::int64_t) bytes);
+    }
+}
+
+std::int64_t LiveMemory(MemorySide side) {
+    return side_counters[(std::size_t) side].live.load(std::memory_order_relaxed);
+}
+
+std::int64_t PeakMemory(MemorySide side) {
+    return side_counters[(std::size_t) side].peak.load(std::memory_order_relaxed);
+}
+
+void SetMemoryBudget(MemorySide side, std::size_t megabytes) {
+    // 0 removes the budget; what is already live is checked right away
+    side_budgets[(std::size_t) side].store((std::int64_t) megabytes * 1024 * 1024, std::memory_order_relaxed);
+    over_budget[(std::size_t) side].store(false, std::memory_order_relaxed);
+
+    CheckBudget(side, LiveMemory(side));
+}
+
+void TrackGlObject(GLenum type, GLuint name, MemoryCategory category, std::size_t bytes) {
+    // Called after (re)allocating the storage of a buffer (GL_BUFFER), texture (GL_TEXTURE) or renderbuffer
+    // (GL_RENDERBUFFER); replaces what the object held before
+    std::pair<MemoryCategory, std::size_t> previous{category, 0};
+    {
+        std::lock_guard<std::mutex> lock(gl_objects_mutex);
+        auto &entry = gl_objects[{type, name}];
+
+        if (entry.second > 0) {
+            previous = entry;
+        }
+        entry = {category, bytes};
+    }
+    ReleaseMemory(previous.first, previous.second);
+    TrackMemory(category, bytes);
+}
+
+void ReleaseGlObjects(GLenum type, GLsizei count, const GLuint *names) {
+    // Called next to glDelete*; names that were never tagged (or 0) are ignored
+    for (GLsizei i = 0; i < count; ++i) {
+        std::pair<MemoryCategory, std::size_t> released{MemoryCategory::gpu_storage, 0};
+        {
+            std::lock_guard<std::mutex> lock(gl_objects_mutex);
+            auto it = gl_objects.find({type, names[i]});
+
+            if (it == gl_objects.end()) {
+                continue;
+            }
+            released = it->second;
+            gl_objects.erase(it);
+        }
+        ReleaseMemory(released.first, released.second);
+    }
+}
+
+std::size_t TexelBytes(GLenum internal_format) {
+    // Size of one texel of the internal formats used here
+    switch (internal_format) {
+        case GL_R8:
+            return 1;
+        case GL_RG16F:
+            return 4;
+        case GL_RGBA16F:
+        case GL_RG32F:
+            return 8;
+        case GL_RGBA32F:
+            return 16;
+        default:
+            return 4;  // GL_RGBA8, GL_R32F, GL_R32UI, GL_DEPTH_COMPONENT32F
+    }
+}
+
+std::size_t TextureBytes(GLsizei width, GLsizei height, GLsizei layers, GLsizei levels, std::size_t texel_bytes) {
+    // Storage of a texture with its mip chain; drivers may pad, so this is a lower bound
+    std::size_t bytes = 0;
+
+    for (GLsizei level = 0; level < levels; ++level) {
+        bytes += (std::size_t) std::max(width >> level, 1) * (std::size_t) std::max(height >> level, 1);
+    }
+    return bytes * (std::size_t) std::max(layers, 1) * texel_bytes;
+}
+
+std::string MemoryReport() {
+    // Live and peak megabytes of every category used so far, then of each side
+    std::ostringstream report;
+
+    report << std::fixed << std::setprecision(1) << std::left << std::setw(20) << "Memory (MB)" << std::right
+           << std::setw(10) << "live" << std::setw(10) << "peak" << std::endl;
+
+    for (std::size_t side = 0; side < side_count; ++side) {
+        for (std::size_t i = 0; i < category_count; ++i) {
+            const auto &counter = category_counters[i];
+
+            if (CategorySide((MemoryCategory) i) != (MemorySide) side || counter.peak == 0) {
+                continue;
+            }
+            report << "  " << std::left << std::setw(18) << memory_category_names[i] << std::right << std::setw(10)
+                   << Megabytes(counter.live) << std::setw(10) << Megabytes(counter.peak) << std::endl;
+        }
+
+        report << std::left << std::setw(20) << side_names[side] + " total" << std::right << std::setw(10)
+               << Megabytes(side_counters[side].live) << std::setw(10) << Megabytes(side_counters[side].peak);
+
+        auto budget = side_budgets[side].load(std::memory_order_relaxed);
+
+        if (budget > 0) {
+            report << "  (budget " << Megabytes(budget) << ")";
+        }
+        if (side + 1 < side_count) {
+            report << std::endl;
+        }
+    }
+    return report.str();
+}
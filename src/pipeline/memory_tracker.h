@@ -0,0 +1,88 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_MEMORY_TRACKER_H
+#define DRAGON_GL_MEMORY_TRACKER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include <glad/glad.h>
+
+/* Memory accounting: the loader tags its CPU copies of a mesh (the matrices read by libigl, the per-face data, the
+ * neighbouring faces, the vertex lists) and decoded images, and every GL buffer, texture and renderbuffer is tagged
+ * with its category and size when its storage is allocated, and untagged when deleted. Live and peak bytes are kept
+ * per category and per side (CPU, GPU); the counters are atomic, so loader jobs tag from any thread. A side going
+ * over its budget prints a warning, once per crossing. 'M' prints the report, 'memory' prints it at exit */
+enum class MemoryCategory {
+    cpu_mesh_source,  // vertices, faces and uv coordinates as read, in doubles
+    cpu_face_info,    // FaceInfo: face normal and tangent per face
+    cpu_neighbors,    // NeighboringFaces: faces around each vertex
+    cpu_vertex_list,  // VertexList of each mesh, and of the whole scene
+    cpu_vertex_copy,  // Vertex[] of BufferParams, kept until the passes that need it are created
+    cpu_images,       // decoded texture pixels
+    cpu_picking,      // picking BVHs
+    gpu_vertices,     // vertex buffers and attribute streams
+    gpu_storage,      // storage and indirect buffers
+    gpu_uniforms,     // uniform buffers
+    gpu_textures,     // material textures and impostor atlases, with their mip chains
+    gpu_targets,      // framebuffer attachments: MSAA target, G-buffer, shadow map, history
+    count
+};
+
+const std::string memory_category_names[] = {"mesh source", "face info", "neighbors", "vertex lists",
+                                             "vertex copy", "images", "picking", "vertices", "storage",
+                                             "uniforms", "textures", "render targets"};
+
+enum class MemorySide {
+    cpu,
+    gpu,
+    count
+};
+
+// Bytes of one counter; peak is the highest live value so far
+struct MemoryCounter {
+    std::atomic<std::int64_t> live{0};
+    std::atomic<std::int64_t> peak{0};
+};
+
+// Counts bytes in a category for as long as it lives, eg. next to a temporary copy
+class MemoryTag {
+public:
+    MemoryTag() = default;
+    MemoryTag(MemoryCategory category, std::size_t bytes);
+    MemoryTag(MemoryTag &&other) noexcept;
+    MemoryTag &operator=(MemoryTag &&other) noexcept;
+    MemoryTag(const MemoryTag &) = delete;
+    MemoryTag &operator=(const MemoryTag &) = delete;
+    ~MemoryTag();
+
+private:
+    MemoryCategory category_ = MemoryCategory::cpu_mesh_source;
+    std::size_t bytes_ = 0;
+};
+
+MemorySide CategorySide(MemoryCategory category);
+void TrackMemory(MemoryCategory category, std::size_t bytes);
+void ReleaseMemory(MemoryCategory category, std::size_t bytes);
+std::int64_t LiveMemory(MemorySide side);
+std::int64_t PeakMemory(MemorySide side);
+void SetMemoryBudget(MemorySide side, std::size_t megabytes);
+
+void TrackGlObject(GLenum type, GLuint name, MemoryCategory category, std::size_t bytes);
+void ReleaseGlObjects(GLenum type, GLsizei count, const GLuint *names);
+std::size_t TexelBytes(GLenum internal_format);
+std::size_t TextureBytes(GLsizei width, GLsizei height, GLsizei layers, GLsizei levels, std::size_t texel_bytes);
+
+std::string MemoryReport();
+
+#endif // DRAGON_GL_MEMORY_TRACKER_H
@@ -0,0 +1,68 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "pacing.h"
+
+PacingParams SetupFramePacing(bool on_demand) {
+    // Chooses the swap interval; needs a current context
+    PacingParams pacing;
+
+    pacing.on_demand = on_demand;
+    pacing.start = glfwGetTime();
+
+    auto video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+
+    if (video_mode && video_mode->refreshRate > 0) {
+        pacing.refresh_rate = video_mode->refreshRate;
+    }
+
+    if (on_demand) {
+        // Adaptive vsync (-1) syncs when on time and tears instead of stalling a whole interval when late
+        // https://www.glfw.org/docs/3.3/group__context.html#ga6d4e0cdf151b5e579bd67f13202994ed
+        pacing.adaptive_vsync = glfwExtensionSupported("WGL_EXT_swap_control_tear") ||
+                                glfwExtensionSupported("GLX_EXT_swap_control_tear");
+
+        glfwSwapInterval(pacing.adaptive_vsync ? -1 : 1);
+    }
+
+    return pacing;
+}
+
+bool WaitForFrame(PacingParams &pacing, const SceneGlobals &scene_globals, bool animating) {
+    // Returns whether a frame should be drawn now; sleeps while idle in on-demand mode
+    if (!pacing.on_demand || animating || scene_globals.dirty_ || scene_globals.redraw_) {
+        return true;
+    }
+
+    // Callbacks run in here and set dirty_ or redraw_
+    glfwWaitEventsTimeout(idle_wait_timeout);
+
+    if (scene_globals.dirty_ || scene_globals.redraw_) {
+        return true;
+    }
+
+    pacing.idle_wakeups++;
+
+    return false;
+}
+
+void RecordDrawnFrame(PacingParams &pacing) {
+    // Called once per presented frame
+    pacing.frames_drawn++;
+}
+
+std::string PacingStats(const PacingParams &pacing, double now) {
+    // Frames skipped compared to a loop that redraws on every refresh
+    double elapsed = now - pacing.start;
+    auto continuous_frames = (unsigned long) (elapsed * pacing.refresh_rate);
+    auto skipped = continuous_frames > pacing.frames_drawn ? continuous_frames - pacing.frames_drawn : 0;
+
+    std::ostringstream stats;
+
+    stats << "on-demand: " << pacing.frames_drawn << " frames drawn, ~" << skipped << " skipped at "
+          << pacing.refresh_rate << " Hz over " << elapsed << " s (" << pacing.idle_wakeups
+          << " idle wakeups" << (pacing.adaptive_vsync ? ", adaptive vsync" : "") << ")";
+
+    return stats.str();
+}
@@ -0,0 +1,36 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_PACING_H
+#define DRAGON_GL_PACING_H
+
+#include <sstream>
+#include <string>
+
+#include <GLFW/glfw3.h>
+
+#include "scene.h"
+
+// Longest idle sleep of the on-demand loop (seconds); bounds the latency of missed wakeups
+const double idle_wait_timeout = 0.5;
+
+// Assumed refresh rate when the monitor does not report one
+const int fallback_refresh_rate = 60;
+
+// On-demand rendering: the loop sleeps in glfwWaitEventsTimeout until something needs drawing
+struct PacingParams {
+    bool on_demand = false;
+    bool adaptive_vsync = false;
+    int refresh_rate = fallback_refresh_rate;
+    double start = 0.0;
+    unsigned long frames_drawn = 0;
+    unsigned long idle_wakeups = 0;
+};
+
+PacingParams SetupFramePacing(bool on_demand);
+bool WaitForFrame(PacingParams &pacing, const SceneGlobals &scene_globals, bool animating);
+void RecordDrawnFrame(PacingParams &pacing);
+std::string PacingStats(const PacingParams &pacing, double now);
+
+#endif // DRAGON_GL_PACING_H
@@ -0,0 +1,175 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "point_splats.h"
+
+namespace {
+    void CreateSplatTargets(PointSplatParams &splats, unsigned int width, unsigned int height) {
+        // Per pixel words of the splat pass and the image they resolve to
+        auto pixel_count = (std::size_t) width * height;
+        auto pixel_bytes = pixel_count * (splats.atomic_int64 ? sizeof(GLuint64) : sizeof(GLuint));
+
+        splats.width = width;
+        splats.height = height;
+
+        glGenBuffers(1, &splats.pixels);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, splats.pixels);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) pixel_bytes, nullptr, GL_DYNAMIC_COPY);
+        TrackGlObject(GL_BUFFER, splats.pixels, MemoryCategory::gpu_targets, pixel_bytes);
+
+        if (!splats.atomic_int64) {
+            glGenBuffers(1, &splats.depths);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, splats.depths);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (pixel_count * sizeof(GLuint)), nullptr,
+                         GL_DYNAMIC_COPY);
+            TrackGlObject(GL_BUFFER, splats.depths, MemoryCategory::gpu_targets, pixel_count * sizeof(GLuint));
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        splats.color = CreateRenderTexture(GL_RGBA8, width, height);
+    }
+
+    void DeleteSplatTargets(PointSplatParams &splats) {
+        // eg. before recreating them on resize
+        GLuint buffers[] = {splats.pixels, splats.depths};
+
+        ReleaseGlObjects(GL_BUFFER, 2, buffers);
+        ReleaseGlObjects(GL_TEXTURE, 1, &splats.color);
+        glDeleteBuffers(2, buffers);
+        glDeleteTextures(1, &splats.color);
+
+        splats.pixels = 0;
+        splats.depths = 0;
+        splats.color = 0;
+    }
+
+    void DispatchSplats(const ShaderParams &program, const SceneParams &scene_params, unsigned int width,
+                        unsigned int height) {
+        // One dispatch per draw command: its points, seen through its instance
+        auto splat = program.program;
+
+        glUseProgram(splat);
+        glUniform2ui(glGetUniformLocation(splat, "viewportSize"), width, height);
+
+        for (const auto &draw: scene_params.draws) {
+            if (draw.count == 0) {
+                continue;
+            }
+            glUniform1ui(glGetUniformLocation(splat, "firstPoint"), draw.first);
+            glUniform1ui(glGetUniformLocation(splat, "pointCount"), draw.count);
+            glUniform1ui(glGetUniformLocation(splat, "instanceIndex"), draw.base_instance);
+            glDispatchCompute(std::min((draw.count + splat_group_size - 1) / splat_group_size, splat_max_groups),
+                              1, 1);
+        }
+    }
+}
+
+PointSplatParams CreatePointSplats(const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Programs for 64-bit atomics if the driver has them, the per pixel buffers, and the scene's points bound
+    PointSplatParams splats;
+
+    splats.atomic_int64 = HasExtension(splat_atomic_extension) && HasExtension(splat_int64_extension);
+    splats.vbo = scene_params.buffer_tris.vbo;
+
+    auto defines = splats.atomic_int64 ? splat_int64_defines : "";
+
+    splats.splat_program = CreateComputeProgram(points_dir + "/splat.glsl", defines);
+    splats.resolve_program = CreateComputeProgram(points_dir + "/resolve.glsl", defines);
+    splats.present_program = CreateShaderProgram(present_dir + "/vertex.glsl", present_dir + "/fragment.glsl");
+
+    if (!splats.atomic_int64) {
+        splats.depth_program = CreateComputeProgram(points_dir + "/splat.glsl", splat_depth_defines);
+    }
+
+    auto resolve = splats.resolve_program.program;
+
+    glUseProgram(resolve);
+    glUniform1i(glGetUniformLocation(resolve, "fillRadius"), splat_fill_radius);
+    glUniform1f(glGetUniformLocation(resolve, "depthTolerance"), splat_depth_tolerance);
+    glUniform3fv(glGetUniformLocation(resolve, "clearColor"), 1, glm::value_ptr(clear_color));
+
+    auto present = splats.present_program.program;
+
+    glUseProgram(present);
+    glUniform1i(glGetUniformLocation(present, scene_color_name.c_str()), 5);
+
+    CreateSplatTargets(splats, scene_globals.width, scene_globals.height);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, splat_points_binding, splats.vbo);
+
+    for (const auto &draw: scene_params.draws) {
+        splats.points += draw.count;
+    }
+    return splats;
+}
+
+void RenderPointSplats(PointSplatParams &splats, const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Clear -> splat (depth first without 64-bit atomics) -> resolve and fill holes -> present
+    if (splats.width != scene_globals.width || splats.height != scene_globals.height) {
+        DeleteSplatTargets(splats);
+        CreateSplatTargets(splats, scene_globals.width, scene_globals.height);
+    }
+
+    // Farthest possible distance; colors start at 0 and only count where a point landed
+    const GLuint empty[] = {0xFFFFFFFFu, 0xFFFFFFFFu};
+    const GLuint no_color = 0;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, splats.pixels);
+
+    if (splats.atomic_int64) {
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_RG32UI, GL_RG_INTEGER, GL_UNSIGNED_INT, empty);
+    } else {
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &no_color);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, splats.depths);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, empty);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, splat_pixels_binding, splats.pixels);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, splat_depths_binding, splats.depths);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (!splats.atomic_int64) {
+        DispatchSplats(splats.depth_program, scene_params, splats.width, splats.height);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    DispatchSplats(splats.splat_program, scene_params, splats.width, splats.height);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // Resolve, one invocation per pixel
+    auto resolve = splats.resolve_program.program;
+
+    glUseProgram(resolve);
+    glUniform2ui(glGetUniformLocation(resolve, "viewportSize"), splats.width, splats.height);
+    glBindImageTexture(splat_image_unit, splats.color, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glDispatchCompute((splats.width + splat_tile_size - 1) / splat_tile_size,
+                      (splats.height + splat_tile_size - 1) / splat_tile_size, 1);
+
+    // Image writes must land before the present pass samples the image
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    DrawFullscreenTexture(splats.present_program, splats.color);
+}
+
+std::string PointSplatStats(const PointSplatParams &splats) {
+    // Points per frame and how the nearest is kept
+    std::ostringstream stats;
+
+    stats << splats.points << " points splatted per frame, "
+          << (splats.atomic_int64 ? "64-bit atomics" : "32-bit atomics in two passes");
+
+    return stats.str();
+}
+
+void DeletePointSplats(PointSplatParams &splats) {
+    // The vertex buffer belongs to the scene
+    DeleteSplatTargets(splats);
+
+    glDeleteProgram(splats.splat_program.program);
+    glDeleteProgram(splats.depth_program.program);
+    glDeleteProgram(splats.resolve_program.program);
+    glDeleteProgram(splats.present_program.program);
+
+    splats = PointSplatParams();
+}
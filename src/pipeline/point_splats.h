@@ -0,0 +1,71 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_POINT_SPLATS_H
+#define DRAGON_GL_POINT_SPLATS_H
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+#include "deferred.h"
+
+/* Point splats ('points'): meshes are loaded as their vertices, without triangles (CreatePoints), and drawn by a
+ * compute rasterizer rather than the fixed function pipeline, which wastes most of its work once primitives are
+ * smaller than a pixel. Two passes per frame:
+ *  - splat: one invocation per point and instance projects the point to its pixel and shades it with a headlight;
+ *    the nearest point wins through a 64-bit atomicMin on the pixel, view distance in the high bits and RGBA8
+ *    color in the low ones (GL_NV_shader_atomic_int64). Without 64-bit atomics, a first pass keeps the nearest
+ *    distance with a 32-bit atomicMin and a second one writes the color of the points at that distance
+ *  - resolve: writes the colors to an image and fills holes: a pixel that is empty, or sees the background through
+ *    a gap of a nearer surface, takes the nearest point around it when nearer points lie on two opposite sides
+ * Points are in Morton order per mesh (SortPoints), so the invocations of a work group land on nearby pixels */
+const GLuint splat_group_size = 256;      // must match GROUP_SIZE in splat.glsl
+const GLuint splat_max_groups = 16384;    // invocations loop over the points beyond this many groups
+const GLuint splat_tile_size = 16;        // must match TILE_SIZE in resolve.glsl
+const int splat_fill_radius = 2;          // pixels searched around each pixel for hole filling
+const float splat_depth_tolerance = 0.01f;  // relative; points nearer by less are on the same surface
+
+// Storage buffer bindings (deformation uses 14 to 20) and the image unit of the resolved colors
+const GLuint splat_points_binding = 21;
+const GLuint splat_pixels_binding = 22;
+const GLuint splat_depths_binding = 23;
+const GLuint splat_image_unit = 0;
+
+// Prepended (after #version) to both passes when 64-bit atomics are available
+const std::string splat_atomic_extension = "GL_NV_shader_atomic_int64";
+const std::string splat_int64_extension = "GL_ARB_gpu_shader_int64";
+const std::string splat_int64_defines = "#extension GL_ARB_gpu_shader_int64 : require\n"
+                                        "#extension GL_NV_shader_atomic_int64 : require\n"
+                                        "#define ATOMIC_INT64\n";
+const std::string splat_depth_defines = "#define DEPTH_PASS\n";
+
+struct PointSplatParams {
+    bool atomic_int64 = false;
+    GLuint vbo = 0;          // the scene's vertex buffer, holding points
+    GLuint pixels = 0;       // per pixel: distance and color in 64 bits, or only the color
+    GLuint depths = 0;       // per pixel, without 64-bit atomics: distance
+    GLuint color = 0;        // RGBA8, resolved
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::size_t points = 0;  // splatted per frame, over all instances
+
+    ShaderParams splat_program{};
+    ShaderParams depth_program{};  // without 64-bit atomics
+    ShaderParams resolve_program{};
+    ShaderParams present_program{};
+};
+
+PointSplatParams CreatePointSplats(const SceneParams &scene_params, const SceneGlobals &scene_globals);
+void RenderPointSplats(PointSplatParams &splats, const SceneParams &scene_params, const SceneGlobals &scene_globals);
+std::string PointSplatStats(const PointSplatParams &splats);
+void DeletePointSplats(PointSplatParams &splats);
+
+#endif // DRAGON_GL_POINT_SPLATS_H
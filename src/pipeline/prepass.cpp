@@ -0,0 +1,171 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "prepass.h"
+
+PositionBufferParams CreatePositionBuffer(const Vertex *vertices, unsigned int count) {
+    // Tightly packed copy of the vertex positions, bound to attribute 0 like in CreateVertexBuffer
+    // Same order as the shared vertex buffer, so the scene draw ranges apply unchanged
+    std::vector<VecPosition> positions(count);
+
+    for (unsigned int i = 0; i < count; ++i) {
+        positions[i] = vertices[i].pos;
+    }
+
+    PositionBufferParams params;
+
+    glGenVertexArrays(1, &params.vao);
+    glBindVertexArray(params.vao);
+
+    glGenBuffers(1, &params.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, params.vbo);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(VecPosition), positions.data(), GL_STATIC_DRAW);
+    TrackGlObject(GL_BUFFER, params.vbo, MemoryCategory::gpu_vertices, count * sizeof(VecPosition));
+
+    // vertex position (model space)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VecPosition), (void *) 0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+
+    return params;
+}
+
+PrepassParams CreatePrepass(const Vertex *vertices, unsigned int count, bool overdraw) {
+    // Position stream and depth-only program; overdraw counting programs if requested
+    PrepassParams prepass;
+
+    prepass.positions = CreatePositionBuffer(vertices, count);
+    prepass.depth_program = CreateShaderProgram(depth_dir + "/vertex.glsl", depth_dir + "/fragment.glsl");
+
+    if (overdraw) {
+        prepass.overdraw_program = CreateShaderProgram(depth_dir + "/vertex.glsl",
+                                                       overdraw_dir + "/fragment.glsl");
+        prepass.heatmap_program = CreateShaderProgram(present_dir + "/vertex.glsl",
+                                                      overdraw_dir + "/heatmap.glsl");
+
+        glUseProgram(prepass.heatmap_program.program);
+        glUniform1f(glGetUniformLocation(prepass.heatmap_program.program, "maxOverdraw"),
+                    overdraw_heatmap_max);
+    }
+
+    return prepass;
+}
+
+void BeginDepthPrepass(const PrepassParams &prepass, const SceneParams &scene_params) {
+    // Lay down the nearest depth without shading, then only let exactly matching fragments through
+    // https://www.khronos.org/opengl/wiki/Early_Fragment_Test
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthFunc(depth_func);
+
+    glUseProgram(prepass.depth_program.program);
+    DrawScene(scene_params, prepass.positions.vao);
+
+    // Shading pass state
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_EQUAL);
+
+    glUseProgram(current_program);
+}
+
+void EndDepthPrepass() {
+    // Default depth state; the depth mask must be on again for the next glClear
+    glDepthMask(GL_TRUE);
+    glDepthFunc(depth_func);
+}
+
+void CountOverdraw(PrepassParams &prepass, const SceneParams &scene_params, bool depth_prepass,
+                   const SceneGlobals &scene_globals) {
+    // Replays the shading pass with a counting fragment shader, in the same order and depth state
+    if (prepass.width != scene_globals.width || prepass.height != scene_globals.height) {
+        ReleaseGlObjects(GL_TEXTURE, 1, &prepass.overdraw_counts);
+        glDeleteTextures(1, &prepass.overdraw_counts);
+
+        prepass.width = scene_globals.width;
+        prepass.height = scene_globals.height;
+
+        glGenTextures(1, &prepass.overdraw_counts);
+        glBindTexture(GL_TEXTURE_2D, prepass.overdraw_counts);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, (GLsizei) prepass.width, (GLsizei) prepass.height);
+        TrackGlObject(GL_TEXTURE, prepass.overdraw_counts, MemoryCategory::gpu_targets,
+                      TextureBytes((GLsizei) prepass.width, (GLsizei) prepass.height, 1, 1, sizeof(GLuint)));
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    GLuint zero = 0;
+    glClearTexImage(prepass.overdraw_counts, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    glBindImageTexture(overdraw_image_unit, prepass.overdraw_counts, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    if (depth_prepass) {
+        // Depth is final already; the shading pass ran with GL_EQUAL and no depth writes
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_EQUAL);
+    } else {
+        // The shading pass started from a cleared depth buffer
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    glUseProgram(prepass.overdraw_program.program);
+    DrawScene(scene_params, prepass.positions.vao);
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    EndDepthPrepass();
+
+    glUseProgram(current_program);
+
+    // Counts are read by the heatmap pass and on readback
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+}
+
+void DrawOverdrawHeatmap(const PrepassParams &prepass) {
+    // Replaces the frame with a color coded fragments-per-pixel view
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glDisable(GL_DEPTH_TEST);
+
+    glUseProgram(prepass.heatmap_program.program);
+    glBindVertexArray(EmptyVertexArray());
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+
+    glUseProgram(current_program);
+}
+
+std::string ReadOverdrawStats(const PrepassParams &prepass) {
+    // Reads the counters back (slow, only for periodic reports)
+    std::vector<GLuint> counts((std::size_t) prepass.width * prepass.height);
+
+    glBindTexture(GL_TEXTURE_2D, prepass.overdraw_counts);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, counts.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    unsigned long long fragments = 0;
+    unsigned long long covered = 0;
+    GLuint max_count = 0;
+
+    for (auto count: counts) {
+        fragments += count;
+        covered += count > 0;
+        max_count = std::max(max_count, count);
+    }
+
+    std::ostringstream stats;
+
+    stats << "overdraw: " << (covered ? (double) fragments / (double) covered : 0.0)
+          << " fragments shaded per covered pixel (max " << max_count << ")";
+
+    return stats.str();
+}
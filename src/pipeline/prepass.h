@@ -0,0 +1,48 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_PREPASS_H
+#define DRAGON_GL_PREPASS_H
+
+#include <sstream>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+
+// Image unit of the overdraw counters (the deferred lit image uses unit 0)
+const GLuint overdraw_image_unit = 1;
+
+// Count shown as the hottest color of the heatmap
+const float overdraw_heatmap_max = 8.0f;
+
+// Position-only vertex stream; the pre-pass fetches 12 bytes per vertex instead of sizeof(Vertex)
+struct PositionBufferParams {
+    GLuint vao = 0;
+    GLuint vbo = 0;
+};
+
+struct PrepassParams {
+    PositionBufferParams positions;
+    ShaderParams depth_program{};
+    ShaderParams overdraw_program{};
+    ShaderParams heatmap_program{};
+    GLuint overdraw_counts = 0;  // R32UI, fragments shaded per pixel
+    unsigned int width = 0;
+    unsigned int height = 0;
+};
+
+PositionBufferParams CreatePositionBuffer(const Vertex *vertices, unsigned int count);
+PrepassParams CreatePrepass(const Vertex *vertices, unsigned int count, bool overdraw);
+void BeginDepthPrepass(const PrepassParams &prepass, const SceneParams &scene_params);
+void EndDepthPrepass();
+void CountOverdraw(PrepassParams &prepass, const SceneParams &scene_params, bool depth_prepass,
+                   const SceneGlobals &scene_globals);
+void DrawOverdrawHeatmap(const PrepassParams &prepass);
+std::string ReadOverdrawStats(const PrepassParams &prepass);
+
+#endif // DRAGON_GL_PREPASS_H
@@ -0,0 +1,798 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "rasterizer.h"
+#include "simd.h"
+
+namespace {
+    const std::uint32_t no_triangle = std::numeric_limits<std::uint32_t>::max();
+    const unsigned int setup_id_bits = 14;  // a chunk sets up at most 2 triangles per submitted one
+
+    static_assert(2 * raster_setup_chunk <= (1u << setup_id_bits));
+
+    // Inputs of one frame, shared by all jobs
+    struct FrameState {
+        const SoftScene *scene = nullptr;
+        SceneTransforms transforms;
+        std::vector<GlmMat4> clip_from_model;  // projection * view * world, per instance
+        std::vector<GlmVec3> light_positions_vs;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int tiles_x = 0;
+        unsigned int tiles_y = 0;
+    };
+
+    // Clip space vertex; source holds its barycentrics in the submitted triangle (clipping adds vertices)
+    struct ClipVertex {
+        GlmVec4 position;
+        GlmVec3 source;
+    };
+
+    // A triangle ready for rasterization, counter-clockwise on screen
+    struct SetupTriangle {
+        float edge_a[3];  // edge i (opposite vertex i): a * x + b * y + c, positive inside
+        float edge_b[3];
+        float edge_c[3];
+        float edge_scale[3];  // 1 / length of edge i, turns edge functions into pixel distances (wireframe)
+        float depth[3];   // window depth plane: depth[0] + depth[1] * x + depth[2] * y
+        float inverse_w[3];
+        GlmVec3 source[3];  // barycentrics of each vertex in the submitted triangle
+        std::uint32_t triangle;  // submitted triangle: first vertex / 3
+        std::uint32_t instance;
+        std::int32_t bounds[4];  // covered pixels, inclusive: min x, min y, max x, max y
+        std::uint8_t top_left;   // bit i: edge i is a top or left edge, and owns pixels exactly on it
+    };
+
+    struct SetupChunk {
+        std::vector<SetupTriangle> triangles;
+        std::vector<std::vector<std::uint32_t>> bins;  // per tile, indices into triangles
+    };
+
+    // Vertex shader outputs of the 3 vertices of a submitted triangle
+    struct TriangleVaryings {
+        std::uint32_t key = no_triangle;
+        float values[3][raster_max_varyings];
+    };
+
+    /* Shading, after the GLSL shaders */
+    float FalloffWindow(float light_dist, float radius) {
+        // Smoothly forces the contribution to zero at the culling radius
+        auto ratio = std::clamp(light_dist / radius, 0.0f, 1.0f);
+        auto window = 1.0f - ratio * ratio * ratio * ratio;
+
+        return window * window;
+    }
+
+    GlmVec3 Lighting(const GlmVec3 &vertex_pos, const GlmVec3 &light_pos, const GlmVec3 &eye,
+                     const GlmVec3 &normal, const GlmVec3 &color_mat, const GlmVec3 &color_light) {
+        // Ambient, diffuse and specular; the shaders compute an attenuation but apply it after the colors
+        // are formed, so it has no effect there and is left out here
+        auto light_vec = light_pos - vertex_pos;
+        auto light_dir = glm::normalize(light_vec);
+        auto view_dir = glm::normalize(eye - vertex_pos);
+
+        auto ambient = 0.005f * color_light;
+        auto diffuse = std::max(glm::dot(normal, light_dir), 0.0f);
+
+        // pow(x, 256) as 8 squarings
+        auto specular = std::max(glm::dot(normal, glm::normalize(view_dir + light_dir)), 0.0f);
+
+        for (int i = 0; i < 8; ++i) {
+            specular *= specular;
+        }
+
+        auto tint = glm::mix(color_light, color_mat, 0.75f);
+
+        return ambient + diffuse * tint + specular * tint;
+    }
+
+    void ShadeVertices(const FrameState &frame, std::uint32_t triangle, std::uint32_t instance,
+                       TriangleVaryings &out) {
+        // The vertex shader, for the 3 vertices of a submitted triangle
+        const auto &scene = *frame.scene;
+        const auto &block = frame.transforms.instances[instance];
+
+        for (int corner = 0; corner < 3; ++corner) {
+            const auto &vertex = scene.vertices[3 * triangle + corner];
+            auto *values = out.values[corner];
+
+            if (scene.shading == ShadingOption::normal_mapping) {
+                // normal_mapping/vertex.glsl: rows of the world -> tangent space matrix (TBN), tangent space
+                // position and eye, uv
+                auto normal_to_world = glm::mat3(block.normal_to_world);
+                auto tangent_ws = glm::normalize(normal_to_world * vertex.tangent);
+                auto normal_ws = glm::normalize(normal_to_world * vertex.normal);
+
+                tangent_ws = glm::normalize(tangent_ws - glm::dot(tangent_ws, normal_ws) * normal_ws);
+
+                auto bitangent_ws = glm::cross(normal_ws, tangent_ws);
+                auto pos_ws = GlmVec3(block.world * GlmVec4(vertex.pos, 1.0f));
+
+                GlmVec3 rows[3] = {tangent_ws, bitangent_ws, normal_ws};
+
+                for (int row = 0; row < 3; ++row) {
+                    values[row] = glm::dot(rows[row], pos_ws);
+                    values[3 + row] = glm::dot(rows[row], eye_pos);
+
+                    for (int c = 0; c < 3; ++c) {
+                        values[6 + 3 * row + c] = rows[row][c];
+                    }
+                }
+                values[15] = vertex.uv_coord.x;
+                values[16] = vertex.uv_coord.y;
+            } else {
+                // gouraud/vertex.glsl (flat only differs in interpolation): lighting per vertex, view space
+                auto pos_vs = GlmVec3(frame.transforms.camera.view * (block.world * GlmVec4(vertex.pos, 1.0f)));
+                auto normal_vs = glm::normalize(glm::mat3(block.normal_to_view) * vertex.normal);
+                auto color_mat = GlmVec3(scene.lights[0].color);
+
+                GlmVec3 color(0.0f);
+
+                for (std::size_t i = 0; i < scene.lights.size(); ++i) {
+                    const auto &light_pos = frame.light_positions_vs[i];
+                    auto window = FalloffWindow(glm::length(light_pos - pos_vs), scene.lights[i].position.w);
+
+                    // lights culled by the clusters on the GPU are exactly those with a zero window
+                    if (window > 0.0f) {
+                        color += window * Lighting(pos_vs, light_pos, GlmVec3(0.0f), normal_vs, color_mat,
+                                                   GlmVec3(scene.lights[i].color));
+                    }
+                }
+                values[0] = color.x;
+                values[1] = color.y;
+                values[2] = color.z;
+            }
+        }
+    }
+
+    GlmVec4 FetchBilinear(const SoftMipLevel &level, float u, float v) {
+        // GL_LINEAR with GL_REPEAT; coordinates are wrapped first so the texel indices stay small
+        auto x = (u - std::floor(u)) * (float) level.width - 0.5f;
+        auto y = (v - std::floor(v)) * (float) level.height - 0.5f;
+        auto x0 = std::floor(x);
+        auto y0 = std::floor(y);
+        auto fx = x - x0;
+        auto fy = y - y0;
+
+        auto wrap = [](long long i, int size) { return (std::size_t) (((i % size) + size) % size); };
+        auto x_lo = wrap((long long) x0, level.width);
+        auto x_hi = wrap((long long) x0 + 1, level.width);
+        auto y_lo = wrap((long long) y0, level.height);
+        auto y_hi = wrap((long long) y0 + 1, level.height);
+
+        auto texel = [&](std::size_t tx, std::size_t ty) {
+            const auto *p = &level.texels[4 * (ty * level.width + tx)];
+
+            return GlmVec4(p[0], p[1], p[2], p[3]);
+        };
+
+        auto bottom = glm::mix(texel(x_lo, y_lo), texel(x_hi, y_lo), fx);
+        auto top = glm::mix(texel(x_lo, y_hi), texel(x_hi, y_hi), fx);
+
+        return glm::mix(bottom, top, fy) / 255.0f;
+    }
+
+    GlmVec4 SampleTexture(const SoftTexture &texture, const VecTextureCoord &uv, const VecTextureCoord &uv_dx,
+                          const VecTextureCoord &uv_dy) {
+        // textureGrad with GL_LINEAR_MIPMAP_LINEAR minification and GL_LINEAR magnification
+        if (!std::isfinite(uv.x) || !std::isfinite(uv.y)) {
+            return GlmVec4(0.0f);
+        }
+
+        const auto &base = texture.levels.front();
+        auto scale = VecTextureCoord((float) base.width, (float) base.height);
+        auto rho = std::max(glm::length(uv_dx * scale), glm::length(uv_dy * scale));
+        auto lod = rho > 0.0f ? std::log2(rho) : 0.0f;
+
+        if (lod <= 0.0f) {
+            return FetchBilinear(base, uv.x, uv.y);
+        }
+
+        lod = std::min(lod, (float) (texture.levels.size() - 1));
+
+        auto lower = (std::size_t) lod;
+        auto upper = std::min(lower + 1, texture.levels.size() - 1);
+
+        return glm::mix(FetchBilinear(texture.levels[lower], uv.x, uv.y),
+                        FetchBilinear(texture.levels[upper], uv.x, uv.y), lod - (float) lower);
+    }
+
+    GlmVec3 SourceBarycentrics(const SetupTriangle &triangle, float x, float y) {
+        // Perspective-correct barycentrics at a pixel (or off-triangle, for derivatives), in the
+        // submitted triangle
+        float weights[3];
+        float sum = 0.0f;
+
+        for (int i = 0; i < 3; ++i) {
+            auto edge = triangle.edge_a[i] * x + (triangle.edge_b[i] * y + triangle.edge_c[i]);
+
+            weights[i] = edge * triangle.inverse_w[i];
+            sum += weights[i];
+        }
+        if (sum == 0.0f) {
+            return triangle.source[0];
+        }
+
+        return (weights[0] * triangle.source[0] + weights[1] * triangle.source[1] +
+                weights[2] * triangle.source[2]) / sum;
+    }
+
+    void Interpolate(const TriangleVaryings &varyings, const GlmVec3 &barycentrics, int first, int count,
+                     float *out) {
+        for (int k = first; k < first + count; ++k) {
+            out[k - first] = barycentrics.x * varyings.values[0][k] + barycentrics.y * varyings.values[1][k] +
+                             barycentrics.z * varyings.values[2][k];
+        }
+    }
+
+    GlmVec3 ShadeFragment(const FrameState &frame, const SetupTriangle &triangle, const TriangleVaryings &varyings,
+                          float x, float y) {
+        // The fragment shader at pixel center (x, y)
+        const auto &scene = *frame.scene;
+
+        if (scene.shading == ShadingOption::flat || scene.shading == ShadingOption::wireframe) {
+            // flat outputs come from the provoking (last) vertex; wireframes use the flat shaders
+            return {varyings.values[2][0], varyings.values[2][1], varyings.values[2][2]};
+        }
+
+        auto barycentrics = SourceBarycentrics(triangle, x, y);
+
+        if (scene.shading != ShadingOption::normal_mapping) {
+            GlmVec3 color;
+
+            Interpolate(varyings, barycentrics, 0, 3, &color.x);
+            return color;
+        }
+
+        // normal_mapping/fragment.glsl; uv derivatives from the neighbouring pixels, as in a 2x2 quad
+        float values[raster_max_varyings];
+        VecTextureCoord uv_dx;
+        VecTextureCoord uv_dy;
+
+        Interpolate(varyings, barycentrics, 0, raster_max_varyings, values);
+        Interpolate(varyings, SourceBarycentrics(triangle, x + 1.0f, y), 15, 2, &uv_dx.x);
+        Interpolate(varyings, SourceBarycentrics(triangle, x, y + 1.0f), 15, 2, &uv_dy.x);
+
+        VecTextureCoord uv(values[15], values[16]);
+
+        uv_dx = uv_dx - uv;
+        uv_dy = uv_dy - uv;
+
+        const auto &material = scene.materials[scene.instances[triangle.instance].material];
+
+        auto color_texture = material.diffuse >= 0 ?
+                             GlmVec3(SampleTexture(scene.textures[material.diffuse], uv, uv_dx, uv_dy)) :
+                             light_color;
+        auto normal_ts = material.normal >= 0 ?
+                         GlmVec3(SampleTexture(scene.textures[material.normal], uv, uv_dx, uv_dy)) :
+                         GlmVec3(0.5f, 0.5f, 1.0f);
+
+        normal_ts = glm::normalize(2.0f * normal_ts - GlmVec3(1.0f));
+
+        GlmVec3 pos_ts(values[0], values[1], values[2]);
+        GlmVec3 eye_ts(values[3], values[4], values[5]);
+        GlmVec3 rows[3] = {{values[6], values[7], values[8]},
+                           {values[9], values[10], values[11]},
+                           {values[12], values[13], values[14]}};
+        GlmVec3 color(0.0f);
+
+        for (const auto &light: scene.lights) {
+            auto light_ws = GlmVec3(light.position);
+            GlmVec3 light_ts(glm::dot(rows[0], light_ws), glm::dot(rows[1], light_ws), glm::dot(rows[2], light_ws));
+            auto window = FalloffWindow(glm::length(light_ts - pos_ts), light.position.w);
+
+            if (window > 0.0f) {
+                color += window * Lighting(pos_ts, light_ts, eye_ts, normal_ts, color_texture, GlmVec3(light.color));
+            }
+        }
+        return color;
+    }
+
+    /* Setup */
+    void EmitTriangle(const FrameState &frame, const ClipVertex (&vertices)[3], std::uint32_t triangle,
+                        std::uint32_t instance, SetupChunk &chunk) {
+        // Projects, snaps and orients a clipped triangle, and bins it into the tiles its bounds touch
+        double x[3];
+        double y[3];
+        float depth[3];
+        float inverse_w[3];
+        GlmVec3 source[3];
+
+        for (int i = 0; i < 3; ++i) {
+            const auto &p = vertices[i].position;
+            auto w = 1.0 / p.w;
+
+            // viewport transform, then snap to the subpixel grid
+            x[i] = std::round((p.x * w * 0.5 + 0.5) * frame.width * raster_subpixel_steps) / raster_subpixel_steps;
+            y[i] = std::round((p.y * w * 0.5 + 0.5) * frame.height * raster_subpixel_steps) / raster_subpixel_steps;
+            depth[i] = (float) (p.z * w);  // GL_ZERO_TO_ONE
+            inverse_w[i] = (float) w;
+            source[i] = vertices[i].source;
+        }
+
+        // No culling (GL_CULL_FACE is off); clockwise triangles are flipped so inside is positive
+        auto area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+        if (!(std::abs(area) > 0.0)) {
+            return;
+        }
+        if (area < 0.0) {
+            std::swap(x[1], x[2]);
+            std::swap(y[1], y[2]);
+            std::swap(depth[1], depth[2]);
+            std::swap(inverse_w[1], inverse_w[2]);
+            std::swap(source[1], source[2]);
+            area = -area;
+        }
+
+        // Pixels whose center is inside the bounds; lines of a wireframe reach half a pixel further out
+        auto clamp_x = [&](double v) { return (std::int32_t) std::clamp(v, -1.0, (double) frame.width); };
+        auto clamp_y = [&](double v) { return (std::int32_t) std::clamp(v, -1.0, (double) frame.height); };
+        auto margin = frame.scene->shading == ShadingOption::wireframe ? 1.0 : 0.5;
+
+        SetupTriangle setup{};
+
+        setup.bounds[0] = std::max(0, clamp_x(std::ceil(std::min({x[0], x[1], x[2]}) - margin)));
+        setup.bounds[1] = std::max(0, clamp_y(std::ceil(std::min({y[0], y[1], y[2]}) - margin)));
+        setup.bounds[2] = std::min((std::int32_t) frame.width - 1,
+                                   clamp_x(std::floor(std::max({x[0], x[1], x[2]}) + margin - 1.0)));
+        setup.bounds[3] = std::min((std::int32_t) frame.height - 1,
+                                   clamp_y(std::floor(std::max({y[0], y[1], y[2]}) + margin - 1.0)));
+
+        if (setup.bounds[0] > setup.bounds[2] || setup.bounds[1] > setup.bounds[3]) {
+            return;
+        }
+
+        /* Edge functions in double from the snapped vertices, then rounded to float. Two triangles sharing
+         * an edge get exactly negated coefficients, so they agree on every pixel; the top-left rule hands
+         * pixels exactly on the edge to one of them */
+        double plane[3] = {0.0, 0.0, 0.0};
+
+        for (int i = 0; i < 3; ++i) {
+            auto a = (i + 1) % 3;
+            auto b = (i + 2) % 3;
+            auto edge_a = y[a] - y[b];
+            auto edge_b = x[b] - x[a];
+            auto edge_c = x[a] * y[b] - y[a] * x[b];
+
+            setup.edge_a[i] = (float) edge_a;
+            setup.edge_b[i] = (float) edge_b;
+            setup.edge_c[i] = (float) edge_c;
+            setup.edge_scale[i] = (float) (1.0 / std::sqrt(edge_a * edge_a + edge_b * edge_b));
+
+            // left edges (inside to the right) and top edges (horizontal, inside below)
+            if (edge_a > 0.0 || (edge_a == 0.0 && edge_b < 0.0)) {
+                setup.top_left |= (std::uint8_t) (1 << i);
+            }
+
+            // the edge functions over the area are the screen space barycentrics
+            plane[0] += edge_c * depth[i];
+            plane[1] += edge_a * depth[i];
+            plane[2] += edge_b * depth[i];
+        }
+        for (int i = 0; i < 3; ++i) {
+            setup.depth[i] = (float) (plane[i] / area);
+            setup.inverse_w[i] = inverse_w[i];
+            setup.source[i] = source[i];
+        }
+        setup.triangle = triangle;
+        setup.instance = instance;
+
+        auto index = (std::uint32_t) chunk.triangles.size();
+
+        chunk.triangles.push_back(setup);
+
+        for (auto ty = setup.bounds[1] / raster_tile_size; ty <= setup.bounds[3] / raster_tile_size; ++ty) {
+            for (auto tx = setup.bounds[0] / raster_tile_size; tx <= setup.bounds[2] / raster_tile_size; ++tx) {
+                chunk.bins[ty * frame.tiles_x + tx].push_back(index);
+            }
+        }
+    }
+
+    void SetupTriangles(const FrameState &frame, const std::vector<std::size_t> &draw_starts, std::size_t begin,
+                        std::size_t end, SetupChunk &chunk) {
+        // Vertex positions, frustum rejection and near plane clipping of submitted triangles [begin, end)
+        const auto &scene = *frame.scene;
+        auto draw = (std::size_t) (std::upper_bound(draw_starts.begin(), draw_starts.end(), begin) -
+                                   draw_starts.begin() - 1);
+
+        for (auto t = begin; t < end; ++t) {
+            while (t >= draw_starts[draw + 1]) {
+                ++draw;
+            }
+            const auto &command = scene.draws[draw];
+            auto triangle = (std::uint32_t) (command.first / 3 + (t - draw_starts[draw]));
+            auto instance = command.base_instance;
+            const auto &clip_from_model = frame.clip_from_model[instance];
+
+            ClipVertex vertices[3];
+
+            for (int i = 0; i < 3; ++i) {
+                vertices[i].position = clip_from_model * GlmVec4(scene.vertices[3 * triangle + i].pos, 1.0f);
+                vertices[i].source = GlmVec3(0.0f);
+                vertices[i].source[i] = 1.0f;
+            }
+
+            // Trivially rejected if all vertices are outside the same frustum plane
+            auto outside = 0x3f;
+            auto near_outside = 0;
+
+            for (const auto &vertex: vertices) {
+                const auto &p = vertex.position;
+                // reverse-Z: z = w at the near plane, z = 0 at the far plane, at infinity
+                auto planes = (p.x < -p.w ? 1 : 0) | (p.x > p.w ? 2 : 0) | (p.y < -p.w ? 4 : 0) |
+                              (p.y > p.w ? 8 : 0) | (p.z > p.w ? 16 : 0) | (p.z < 0.0f ? 32 : 0);
+
+                outside &= planes;
+                near_outside += (planes & 16) ? 1 : 0;
+            }
+            if (outside) {
+                continue;
+            }
+            if (near_outside == 0) {
+                EmitTriangle(frame, vertices, triangle, instance, chunk);
+                continue;
+            }
+
+            // Sutherland-Hodgman against the near plane (z = w): 3 or 4 vertices, drawn as a fan
+            ClipVertex polygon[4];
+            int polygon_size = 0;
+
+            for (int i = 0; i < 3; ++i) {
+                const auto &current = vertices[i];
+                const auto &next = vertices[(i + 1) % 3];
+                auto d_current = current.position.w - current.position.z;
+                auto d_next = next.position.w - next.position.z;
+
+                if (d_current >= 0.0f) {
+                    polygon[polygon_size++] = current;
+                }
+                if ((d_current >= 0.0f) != (d_next >= 0.0f)) {
+                    auto s = d_current / (d_current - d_next);
+
+                    polygon[polygon_size++] = {current.position + s * (next.position - current.position),
+                                               current.source + s * (next.source - current.source)};
+                }
+            }
+            for (int i = 1; i + 1 < polygon_size; ++i) {
+                ClipVertex fan[3] = {polygon[0], polygon[i], polygon[i + 1]};
+
+                EmitTriangle(frame, fan, triangle, instance, chunk);
+            }
+        }
+    }
+
+    /* Tiles */
+    std::size_t RenderTile(const FrameState &frame, const std::vector<SetupChunk> &chunks, unsigned int tile,
+                           Framebuffer &framebuffer) {
+        // Rasterizes the tile's triangles in submission order into a visibility buffer (reverse-Z depth
+        // test, GL_GREATER), then shades every covered pixel once; returns the number of covered pixels
+        const auto size = raster_tile_size;
+
+        alignas(16) float depth[size * size];
+        std::uint32_t visible[size * size];
+
+        std::fill(std::begin(depth), std::end(depth), (float) depth_clear);
+        std::fill(std::begin(visible), std::end(visible), no_triangle);
+
+        auto tile_x = (std::int32_t) ((tile % frame.tiles_x) * size);
+        auto tile_y = (std::int32_t) ((tile / frame.tiles_x) * size);
+        auto tile_width = std::min<std::int32_t>(size, (std::int32_t) frame.width - tile_x);
+        auto tile_height = std::min<std::int32_t>(size, (std::int32_t) frame.height - tile_y);
+
+        auto zero = Float4::Set(0.0f);
+        auto half = Float4::Set(0.5f);
+        auto minus_half = Float4::Set(-0.5f);
+        auto wireframe = frame.scene->shading == ShadingOption::wireframe;
+        auto lane_centers = Float4::Set(0.5f, 1.5f, 2.5f, 3.5f);
+
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            for (auto index: chunks[c].bins[tile]) {
+                const auto &triangle = chunks[c].triangles[index];
+                auto id = (std::uint32_t) (c << setup_id_bits) | index;
+
+                // Tile-relative pixel range
+                auto x_begin = std::max(triangle.bounds[0] - tile_x, 0);
+                auto x_end = std::min(triangle.bounds[2] - tile_x, tile_width - 1);
+                auto y_begin = std::max(triangle.bounds[1] - tile_y, 0);
+                auto y_end = std::min(triangle.bounds[3] - tile_y, tile_height - 1);
+
+                Float4 edge_a[3];
+                Float4 edge_scale[3];
+                int top_left[3];
+
+                for (int i = 0; i < 3; ++i) {
+                    edge_a[i] = Float4::Set(triangle.edge_a[i]);
+                    edge_scale[i] = Float4::Set(triangle.edge_scale[i]);
+                    top_left[i] = ((triangle.top_left >> i) & 1) ? 0xf : 0;
+                }
+                auto depth_x = Float4::Set(triangle.depth[1]);
+
+                for (auto y = y_begin; y <= y_end; ++y) {
+                    auto py = (float) (tile_y + y) + 0.5f;
+                    Float4 edge_row[3];
+
+                    for (int i = 0; i < 3; ++i) {
+                        edge_row[i] = Float4::Set(triangle.edge_b[i] * py + triangle.edge_c[i]);
+                    }
+                    auto depth_row = Float4::Set(triangle.depth[0] + triangle.depth[2] * py);
+
+                    for (auto x = x_begin & ~3; x <= x_end; x += 4) {
+                        // lanes left of x_begin or right of x_end are masked out
+                        auto mask = (0xf << std::max(0, x_begin - x)) & (0xf >> std::max(0, x + 3 - x_end));
+                        auto px = Float4::Set((float) (tile_x + x)) + lane_centers;
+
+                        if (wireframe) {
+                            // glPolygonMode(GL_LINE): 1 pixel wide lines centered on the edges, ie. inside
+                            // the triangle grown by half a pixel but not inside the one shrunk by as much
+                            auto inner = 0xf;
+
+                            for (int i = 0; i < 3 && mask; ++i) {
+                                auto distance = (edge_a[i] * px + edge_row[i]) * edge_scale[i];
+
+                                mask &= GreaterEqual(distance, minus_half);
+                                inner &= Greater(distance, half);
+                            }
+                            mask &= ~inner;
+                        } else {
+                            for (int i = 0; i < 3 && mask; ++i) {
+                                auto edge = edge_a[i] * px + edge_row[i];
+
+                                mask &= Greater(edge, zero) | (Equal(edge, zero) & top_left[i]);
+                            }
+                        }
+                        if (!mask) {
+                            continue;
+                        }
+
+                        auto z = depth_x * px + depth_row;
+                        auto *depth_out = &depth[y * size + x];
+
+                        mask &= Greater(z, Float4::Load(depth_out));
+
+                        if (!mask) {
+                            continue;
+                        }
+
+                        alignas(16) float z_lanes[4];
+                        z.Store(z_lanes);
+
+                        for (int lane = 0; lane < 4; ++lane) {
+                            if (mask & (1 << lane)) {
+                                depth_out[lane] = z_lanes[lane];
+                                visible[y * size + x + lane] = id;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Shade; neighbouring pixels mostly share triangles, whose vertex outputs are cached
+        TriangleVaryings cache[raster_varying_cache];
+        std::size_t covered = 0;
+
+        for (std::int32_t y = 0; y < tile_height; ++y) {
+            auto *row = &framebuffer.color[3 * ((std::size_t) (tile_y + y) * frame.width + tile_x)];
+
+            for (std::int32_t x = 0; x < tile_width; ++x) {
+                auto id = visible[y * size + x];
+                auto color = clear_color;
+
+                if (id != no_triangle) {
+                    const auto &triangle = chunks[id >> setup_id_bits].triangles[id & ((1u << setup_id_bits) - 1)];
+                    auto &varyings = cache[id % raster_varying_cache];
+
+                    if (varyings.key != id) {
+                        ShadeVertices(frame, triangle.triangle, triangle.instance, varyings);
+                        varyings.key = id;
+                    }
+                    color = ShadeFragment(frame, triangle, varyings, (float) (tile_x + x) + 0.5f,
+                                          (float) (tile_y + y) + 0.5f);
+                    ++covered;
+                }
+                for (int c = 0; c < 3; ++c) {
+                    row[3 * x + c] = (std::uint8_t) std::lround(std::clamp(color[c], 0.0f, 1.0f) * 255.0f);
+                }
+            }
+        }
+        return covered;
+    }
+}
+
+SoftTexture CreateSoftTexture(const ImageData &image) {
+    // Expands to RGBA the way GL does for GL_RED / GL_RG / GL_RGB sources, then box filters a full mip
+    // chain like glGenerateMipmap
+    SoftTexture texture;
+    SoftMipLevel base;
+
+    base.width = image.width;
+    base.height = image.height;
+    base.texels.resize(4 * (std::size_t) image.width * image.height);
+
+    for (std::size_t i = 0; i < (std::size_t) image.width * image.height; ++i) {
+        std::uint8_t rgba[4] = {0, 0, 0, 255};
+
+        for (int c = 0; c < std::min(image.components, 4); ++c) {
+            rgba[c] = image.pixels[i * image.components + c];
+        }
+        std::copy(rgba, rgba + 4, &base.texels[4 * i]);
+    }
+    texture.levels.push_back(std::move(base));
+
+    while (texture.levels.back().width > 1 || texture.levels.back().height > 1) {
+        const auto &above = texture.levels.back();
+        SoftMipLevel level;
+
+        level.width = std::max(1, above.width / 2);
+        level.height = std::max(1, above.height / 2);
+        level.texels.resize(4 * (std::size_t) level.width * level.height);
+
+        for (int y = 0; y < level.height; ++y) {
+            for (int x = 0; x < level.width; ++x) {
+                auto x0 = std::min(2 * x, above.width - 1);
+                auto x1 = std::min(2 * x + 1, above.width - 1);
+                auto y0 = std::min(2 * y, above.height - 1);
+                auto y1 = std::min(2 * y + 1, above.height - 1);
+
+                for (int c = 0; c < 4; ++c) {
+                    auto texel = [&](int tx, int ty) { return (int) above.texels[4 * ((std::size_t) ty * above.width + tx) + c]; };
+                    auto sum = texel(x0, y0) + texel(x1, y0) + texel(x0, y1) + texel(x1, y1);
+
+                    level.texels[4 * ((std::size_t) y * level.width + x) + c] = (std::uint8_t) ((sum + 2) / 4);
+                }
+            }
+        }
+        texture.levels.push_back(std::move(level));
+    }
+    return texture;
+}
+
+SoftScene CreateSoftScene(const SceneDescription &scene, ShadingOption opt, unsigned int light_count,
+                          JobSystem &jobs) {
+    /* CreateScene without a GL context: meshes back to back, one draw per instance, the same light list.
+     * Every scene mesh is its own material */
+    auto assets = LoadSceneAssets(scene, opt, jobs);
+
+    SoftScene soft;
+    std::vector<std::pair<GLuint, GLuint>> mesh_ranges;
+
+    soft.shading = opt;
+    soft.vertices = ConcatenateMeshes(assets, mesh_ranges);
+
+    for (std::size_t mesh = 0; mesh < scene.meshes.size(); ++mesh) {
+        soft.materials.push_back({assets.diffuse_of[mesh], assets.normal_of[mesh]});
+    }
+
+    // Only normal mapping samples textures
+    if (opt == ShadingOption::normal_mapping) {
+        soft.textures.resize(assets.images.size());
+
+        jobs.ParallelFor(assets.images.size(), 1, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                soft.textures[i] = CreateSoftTexture(assets.images[i]);
+            }
+        });
+    }
+
+    for (unsigned int i = 0; i < scene.instances.size(); ++i) {
+        auto mesh = scene.instances[i].mesh;
+        auto [first, count] = mesh_ranges[assets.mesh_of[mesh]];
+
+        soft.draws.push_back({count, 1, first, i});
+        soft.instances.push_back({scene.instances[i].transform, mesh});
+    }
+    soft.lights = CreateLightList(scene.lights, light_count);
+
+    return soft;
+}
+
+RasterStats RenderSoftFrame(const SoftScene &scene, const SceneGlobals &scene_globals, Framebuffer &framebuffer,
+                            JobSystem &jobs) {
+    // Setup and binning over chunks of triangles, then rasterization and shading over tiles
+    auto start = std::chrono::steady_clock::now();
+
+    FrameState frame;
+
+    frame.scene = &scene;
+    frame.transforms = ComputeTransforms(scene.instances, scene_globals);
+    frame.width = scene_globals.width;
+    frame.height = scene_globals.height;
+    frame.tiles_x = (frame.width + raster_tile_size - 1) / raster_tile_size;
+    frame.tiles_y = (frame.height + raster_tile_size - 1) / raster_tile_size;
+
+    const auto &camera = frame.transforms.camera;
+
+    for (const auto &block: frame.transforms.instances) {
+        frame.clip_from_model.push_back(camera.projection * camera.view * block.world);
+    }
+    for (const auto &light: scene.lights) {
+        frame.light_positions_vs.emplace_back(camera.view * GlmVec4(GlmVec3(light.position), 1.0f));
+    }
+
+    framebuffer.width = frame.width;
+    framebuffer.height = frame.height;
+    framebuffer.color.resize(3 * (std::size_t) frame.width * frame.height);
+
+    // Submitted triangles, numbered across draws
+    std::vector<std::size_t> draw_starts{0};
+
+    for (const auto &draw: scene.draws) {
+        draw_starts.push_back(draw_starts.back() + draw.count / 3);
+    }
+
+    RasterStats stats;
+
+    stats.triangles = draw_starts.back();
+
+    auto tile_count = frame.tiles_x * frame.tiles_y;
+    std::vector<SetupChunk> chunks((stats.triangles + raster_setup_chunk - 1) / raster_setup_chunk);
+
+    jobs.ParallelFor(chunks.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (auto c = begin; c < end; ++c) {
+            chunks[c].bins.resize(tile_count);
+
+            SetupTriangles(frame, draw_starts, c * raster_setup_chunk,
+                           std::min(stats.triangles, (c + 1) * raster_setup_chunk), chunks[c]);
+        }
+    });
+
+    std::vector<std::size_t> covered(tile_count);
+
+    jobs.ParallelFor(tile_count, 1, [&](std::size_t begin, std::size_t end) {
+        for (auto tile = begin; tile < end; ++tile) {
+            covered[tile] = RenderTile(frame, chunks, (unsigned int) tile, framebuffer);
+        }
+    });
+
+    for (const auto &chunk: chunks) {
+        stats.setup += chunk.triangles.size();
+    }
+    for (auto count: covered) {
+        stats.pixels += count;
+    }
+    stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return stats;
+}
+
+bool WriteFramebuffer(const Framebuffer &framebuffer, const std::string &filename) {
+    // Same writer as SaveToFile; rows are bottom first there as well
+    auto buffer = std::make_unique<CharBuffer>(framebuffer.color.begin(), framebuffer.color.end());
+    auto width = (int) framebuffer.width;
+    auto height = (int) framebuffer.height;
+
+    return ImageLoader::WriteImageFile(filename, width, height, 3, 3 * width, std::move(buffer));
+}
+
+bool EncodeFramebuffer(const Framebuffer &framebuffer, CharBuffer &png) {
+    // PNG bytes of the framebuffer, as WriteFramebuffer would write them
+    auto width = (int) framebuffer.width;
+
+    return ImageLoader::EncodePng(width, (int) framebuffer.height, 3, 3 * width, framebuffer.color.data(), png);
+}
+
+bool ReadFramebuffer(const std::string &filename, Framebuffer &framebuffer) {
+    // Reads an image written by WriteFramebuffer (or SaveToFile) back, bottom row first; false if unreadable
+    ImageLoader image_loader;
+    int width, height, components;
+
+    auto pixels = image_loader.LoadImageFile(filename, width, height, components);
+
+    if (!pixels) {
+        return false;
+    }
+
+    framebuffer.width = (unsigned int) width;
+    framebuffer.height = (unsigned int) height;
+    framebuffer.color.resize(3 * (std::size_t) width * height);
+
+    for (std::size_t i = 0; i < (std::size_t) width * height; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            // gray (and gray + alpha) images repeat their first channel
+            framebuffer.color[3 * i + c] = pixels[i * components + (components < 3 ? 0 : c)];
+        }
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_RASTERIZER_H
+#define DRAGON_GL_RASTERIZER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "attributes.h"
+#include "job_system.h"
+#include "scene.h"
+
+/* CPU rendering backend for machines without a GPU. Takes the same inputs as the GL path (the vertex
+ * list of CreateTriangles, the matrices of ComputeTransforms, the light list) and reproduces the flat,
+ * gouraud and normal mapping shaders, and wireframes.
+ * Triangles are set up in parallel chunks and binned into screen tiles; every tile then rasterizes its
+ * triangles 4 pixels at a time (SSE edge functions and depth test) into a visibility buffer, and shades
+ * each visible pixel once. Vertex shading runs only for triangles that end up visible.
+ * https://fgiesen.wordpress.com/2013/02/10/optimizing-the-basic-rasterizer/ */
+const unsigned int raster_tile_size = 64;
+const double raster_subpixel_steps = 256.0;  // vertices snap to 1/256 pixel (8 subpixel bits)
+const std::size_t raster_setup_chunk = 8192;  // submitted triangles per setup job
+const unsigned int raster_varying_cache = 64;  // triangles whose vertex outputs a tile keeps around
+const unsigned int raster_max_varyings = 17;   // normal mapping: tangent space position and eye, TBN, uv
+
+// Options of the software rendering tools
+const std::string size_str = "size=";
+const std::string frames_str = "frames=";
+const std::string threads_str = "threads=";
+
+// One level of a mipmapped texture, RGBA8 like the GL texture arrays
+struct SoftMipLevel {
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> texels;
+};
+
+struct SoftTexture {
+    std::vector<SoftMipLevel> levels;  // level 0 first, down to 1x1
+};
+
+// Textures of a scene mesh; -1 if untextured
+struct SoftMaterial {
+    int diffuse = -1;
+    int normal = -1;
+};
+
+// Everything the software path needs; SceneInstance::material indexes materials
+struct SoftScene {
+    ShadingOption shading = ShadingOption::per_vertex;
+    VertexList vertices;
+    std::vector<DrawCommand> draws;
+    std::vector<SceneInstance> instances;
+    std::vector<SoftMaterial> materials;
+    std::vector<SoftTexture> textures;
+    LightList lights;
+};
+
+struct Framebuffer {
+    unsigned int width = 0;
+    unsigned int height = 0;
+    std::vector<std::uint8_t> color;  // RGB, bottom row first like glReadPixels
+};
+
+struct RasterStats {
+    std::size_t triangles = 0;  // submitted
+    std::size_t setup = 0;      // left after culling and clipping
+    std::size_t pixels = 0;     // covered, ie. shaded
+    double milliseconds = 0;
+};
+
+SoftTexture CreateSoftTexture(const ImageData &image);
+SoftScene CreateSoftScene(const SceneDescription &scene, ShadingOption opt, unsigned int light_count,
+                          JobSystem &jobs);
+RasterStats RenderSoftFrame(const SoftScene &scene, const SceneGlobals &scene_globals, Framebuffer &framebuffer,
+                            JobSystem &jobs);
+bool WriteFramebuffer(const Framebuffer &framebuffer, const std::string &filename);
+bool EncodeFramebuffer(const Framebuffer &framebuffer, CharBuffer &png);
+bool ReadFramebuffer(const std::string &filename, Framebuffer &framebuffer);
+
+#endif // DRAGON_GL_RASTERIZER_H
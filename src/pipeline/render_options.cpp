@@ -0,0 +1,144 @@
+//
+// Created by francisk on 10/19/26.
+//
+
+#include "render_options.h"
+
+namespace {
+    using Feature = bool RenderOptions::*;
+
+    // A feature, as named on the command line; it is switched on by any of 'implied_by' and off by any of
+    // 'excluded_by', which are resolved before it
+    struct FeatureRule {
+        Feature feature;
+        std::string name;
+        std::vector<Feature> excluded_by;
+        std::vector<Feature> implied_by;
+    };
+
+    const std::vector<FeatureRule> &FeatureRules() {
+        // In resolution order
+        static const std::vector<FeatureRule> rules = {
+            {&RenderOptions::streamed, stream_str, {}, {}},
+            {&RenderOptions::flat, flat_str, {}, {}},
+            {&RenderOptions::wireframe, wireframe_str, {}, {}},
+            {&RenderOptions::save_image, save_to_image_str, {}, {}},
+            // splats draw the vertices of the shared vertex buffer, which a streamed mesh does not use
+            {&RenderOptions::points, points_str, {&RenderOptions::streamed}, {}},
+            {&RenderOptions::deferred, deferred_str, {&RenderOptions::points}, {}},
+            {&RenderOptions::aa_benchmark, antialiasing_benchmark_str,
+             {&RenderOptions::deferred, &RenderOptions::points}, {}},
+            // streamed chunks only exist in the streaming vertex buffer
+            {&RenderOptions::pull_benchmark, pulling_benchmark_str,
+             {&RenderOptions::deferred, &RenderOptions::streamed, &RenderOptions::points,
+              &RenderOptions::aa_benchmark}, {}},
+            {&RenderOptions::pulling, vertex_pulling_str, {&RenderOptions::streamed, &RenderOptions::points},
+             {&RenderOptions::pull_benchmark}},
+            // deformation rewrites the shared vertex buffer; vertex pulling reads copies of it
+            {&RenderOptions::deform, deform_str,
+             {&RenderOptions::streamed, &RenderOptions::pulling, &RenderOptions::points}, {}},
+            // baked per vertex of the shared vertex buffer
+            {&RenderOptions::ambient_occlusion, ambient_occlusion_str,
+             {&RenderOptions::streamed, &RenderOptions::points}, {}},
+            // the passes below keep a copy of the whole mesh, which a streamed mesh never has and which would keep
+            // the rest pose of a deformed one; flat and wireframe shading are not lit per light
+            {&RenderOptions::shadows, shadows_str,
+             {&RenderOptions::deferred, &RenderOptions::streamed, &RenderOptions::deform, &RenderOptions::points,
+              &RenderOptions::flat, &RenderOptions::wireframe}, {}},
+            // lines would not match filled depth
+            {&RenderOptions::depth_prepass, prepass_str,
+             {&RenderOptions::deferred, &RenderOptions::streamed, &RenderOptions::deform, &RenderOptions::points,
+              &RenderOptions::wireframe}, {}},
+            {&RenderOptions::overdraw, overdraw_str,
+             {&RenderOptions::deferred, &RenderOptions::streamed, &RenderOptions::deform, &RenderOptions::points},
+             {}},
+            // wireframes would show the quads
+            {&RenderOptions::impostors, impostors_str,
+             {&RenderOptions::deferred, &RenderOptions::streamed, &RenderOptions::deform, &RenderOptions::points,
+              &RenderOptions::wireframe}, {}},
+            {&RenderOptions::dynres, dynamic_resolution_str, {&RenderOptions::deferred, &RenderOptions::points}, {}},
+            // one benchmark per run
+            {&RenderOptions::camera_bench, camera_benchmark_str,
+             {&RenderOptions::aa_benchmark, &RenderOptions::pull_benchmark}, {}},
+            // the benchmarks and the saved image end the run from the main thread
+            {&RenderOptions::threaded, threaded_str,
+             {&RenderOptions::aa_benchmark, &RenderOptions::pull_benchmark, &RenderOptions::camera_bench,
+              &RenderOptions::save_image}, {}},
+            {&RenderOptions::recording, record_path_str, {&RenderOptions::camera_bench, &RenderOptions::threaded}, {}},
+        };
+        return rules;
+    }
+
+    std::string FeatureName(Feature feature) {
+        for (const auto &rule: FeatureRules()) {
+            if (rule.feature == feature) {
+                return rule.name;
+            }
+        }
+        return "";
+    }
+}
+
+RenderOptions ParseRenderOptions(int argc, char* argv[]) {
+    // The features asked for; ValidateRenderOptions drops those that do not combine once the scene is known
+    RenderOptions options;
+
+    options.input = ParseArgs(argc, argv);
+
+    const auto &input = options.input;
+
+    options.streamed = !input.stream_file.empty();
+    options.save_image = input.save_image;
+    options.points = input.opt == ShadingOption::point_splats;
+    options.deferred = input.render_path == RenderPath::deferred_shading;
+    options.aa_benchmark = input.antialiasing_benchmark;
+    options.pull_benchmark = input.pulling_benchmark;
+    options.pulling = input.vertex_pulling;
+    options.deform = input.deformation != DeformationMode::no_deform;
+    options.ambient_occlusion = input.ao_rays > 0;
+    options.shadows = input.shadows;
+    options.depth_prepass = input.depth_prepass;
+    options.overdraw = input.overdraw;
+    options.impostors = input.impostor_pixels > 0;
+    options.dynres = input.dynamic_resolution_ms > 0;
+    options.camera_bench = input.camera_benchmark;
+    options.threaded = input.threaded;
+    options.recording = !input.record_file.empty();
+
+    return options;
+}
+
+void ValidateRenderOptions(RenderOptions &options, const SceneDescription &scene) {
+    // Without a shading option, normal mapping needs textures on every mesh
+    options.render_mode = options.input.opt.value_or(SceneHasTextures(scene) ? ShadingOption::normal_mapping :
+                                                     ShadingOption::per_vertex);
+    options.flat = options.render_mode == ShadingOption::flat;
+    options.wireframe = options.render_mode == ShadingOption::wireframe;
+
+    // Every feature asked for that cannot run is reported once, with the first feature that keeps it out
+    for (const auto &rule: FeatureRules()) {
+        auto &enabled = options.*rule.feature;
+        auto requested = enabled;
+
+        for (auto implied: rule.implied_by) {
+            enabled = enabled || options.*implied;
+        }
+
+        auto excluded = std::find_if(rule.excluded_by.begin(), rule.excluded_by.end(), [&options](Feature other) {
+            return options.*other;
+        });
+
+        if (enabled && excluded != rule.excluded_by.end()) {
+            enabled = false;
+
+            if (requested) {
+                std::cout << "'" << rule.name << "' is not available with '" << FeatureName(*excluded) << "'"
+                          << std::endl;
+            }
+        }
+    }
+
+    if (!options.points && options.render_mode == ShadingOption::point_splats) {
+        options.render_mode = ShadingOption::per_vertex;
+    }
+}
@@ -0,0 +1,45 @@
+//
+// Created by francisk on 10/19/26.
+//
+
+#ifndef DRAGON_GL_RENDER_OPTIONS_H
+#define DRAGON_GL_RENDER_OPTIONS_H
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "scene.h"
+
+// The features of a dragon-opengl run: those asked for on the command line, minus the ones that cannot run
+// together. ValidateRenderOptions applies the rules of render_options.cpp, one table for every pair that does not combine
+struct RenderOptions {
+    InputOptions input;
+    ShadingOption render_mode = ShadingOption::per_vertex;
+
+    bool streamed = false;
+    bool flat = false;
+    bool wireframe = false;
+    bool save_image = false;        // saves the first frame and exits
+    bool points = false;            // compute splats; the passes that rasterize triangles are left out
+    bool deferred = false;
+    bool aa_benchmark = false;
+    bool pull_benchmark = false;    // forward path only
+    bool pulling = false;           // also on for the benchmark
+    bool deform = false;
+    bool ambient_occlusion = false;
+    bool shadows = false;           // key light, forward path, gouraud or normal mapping
+    bool depth_prepass = false;
+    bool overdraw = false;
+    bool impostors = false;
+    bool dynres = false;
+    bool camera_bench = false;
+    bool threaded = false;
+    bool recording = false;
+};
+
+RenderOptions ParseRenderOptions(int argc, char* argv[]);
+void ValidateRenderOptions(RenderOptions &options, const SceneDescription &scene);
+
+#endif // DRAGON_GL_RENDER_OPTIONS_H
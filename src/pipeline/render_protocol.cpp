@@ -0,0 +1,181 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "render_protocol.h"
+
+namespace {
+    bool SocketAddress(const std::string &path, sockaddr_un &address) {
+        // false if the path does not fit sun_path
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(address.sun_path)) {
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+        return true;
+    }
+}
+
+std::string DefaultSocketPath() {
+    // In the per-user runtime directory when there is one, else in /tmp
+    auto runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+
+    if (runtime_dir && runtime_dir[0] != '\0') {
+        return std::string(runtime_dir) + "/" + render_socket_name;
+    }
+    return "/tmp/" + render_socket_name;
+}
+
+int ListenLocalSocket(const std::string &path) {
+    /* Binds the socket file and listens; a file left by a daemon that died is replaced, a live daemon is not.
+     * Connecting needs write access to the file, which is taken from other users before anyone can connect */
+    sockaddr_un address{};
+
+    if (!SocketAddress(path, address)) {
+        std::cout << "Socket path too long: " << path << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    auto running = ConnectLocalSocket(path);
+
+    if (running >= 0) {
+        CloseLocalSocket(running);
+
+        std::cout << "A render daemon is already listening on " << path << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    unlink(path.c_str());
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(fd, 64) != 0) {
+        std::cout << "Could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    return fd;
+}
+
+int ConnectLocalSocket(const std::string &path) {
+    // -1 if nothing listens there
+    sockaddr_un address{};
+
+    if (!SocketAddress(path, address)) {
+        return -1;
+    }
+
+    auto fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void CloseLocalSocket(int fd) {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool SetNonBlocking(int fd) {
+    // Sends and receives return at once instead of waiting on the peer
+    auto flags = fcntl(fd, F_GETFL);
+
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool SendAll(int fd, const char *data, std::size_t size) {
+    // Blocks until everything is sent; false once the peer is gone (SIGPIPE must be ignored)
+    while (size > 0) {
+        auto sent = send(fd, data, size, 0);
+
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= (std::size_t) sent;
+    }
+    return true;
+}
+
+ssize_t SendSome(int fd, const char *data, std::size_t size) {
+    // On a non-blocking socket: the bytes sent, 0 if its buffer is full, -1 once the peer is gone
+    ssize_t sent;
+
+    do {
+        sent = send(fd, data, size, 0);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    return sent < 0 ? -1 : sent;
+}
+
+bool ReceiveSome(int fd, std::string &buffer) {
+    // Appends what one read returns; false on end of stream or error. A non-blocking socket with nothing to read
+    // appends nothing
+    char chunk[socket_read_chunk];
+    ssize_t received;
+
+    do {
+        received = recv(fd, chunk, sizeof(chunk), 0);
+    } while (received < 0 && errno == EINTR);
+
+    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return true;
+    }
+    if (received <= 0) {
+        return false;
+    }
+    buffer.append(chunk, (std::size_t) received);
+
+    return true;
+}
+
+bool TakeLine(std::string &buffer, std::string &line) {
+    // Moves the first complete line out of the buffer, without its newline (or carriage return)
+    auto end = buffer.find('\n');
+
+    if (end == std::string::npos) {
+        return false;
+    }
+    line = buffer.substr(0, end > 0 && buffer[end - 1] == '\r' ? end - 1 : end);
+    buffer.erase(0, end + 1);
+
+    return true;
+}
+
+bool ReceiveLine(int fd, std::string &buffer, std::string &line) {
+    // Blocks until a complete line was received
+    while (!TakeLine(buffer, line)) {
+        if (buffer.size() > max_request_line || !ReceiveSome(fd, buffer)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ReceiveBytes(int fd, std::string &buffer, std::size_t size) {
+    // Blocks until the buffer holds at least size bytes
+    while (buffer.size() < size) {
+        if (!ReceiveSome(fd, buffer)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_RENDER_PROTOCOL_H
+#define DRAGON_GL_RENDER_PROTOCOL_H
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Wire format of the render daemon (dragon-render-daemon), over a Unix domain socket. A request is one text line
+ * of key=value words (see render_service.h). Every request gets exactly one reply, in request order per
+ * connection:
+ *     ok <bytes>\n<PNG bytes>   the rendered image
+ *     saved <path>\n            written by the daemon to the output=path of the request
+ *     error <message>\n
+ * Clients may send many requests before reading any reply; the daemon batches whatever arrived together.
+ * The line 'shutdown' stops the daemon once the requests before it are answered. The socket file is only open to
+ * the user running the daemon */
+const std::string render_socket_name = "dragon-render.sock";
+const std::string socket_str = "socket=";
+const std::string reply_ok = "ok";
+const std::string reply_saved = "saved";
+const std::string reply_error = "error";
+const std::string shutdown_request = "shutdown";
+
+const std::size_t max_request_line = 64 * 1024;  // longer lines close the connection
+const std::size_t socket_read_chunk = 64 * 1024;
+
+std::string DefaultSocketPath();
+int ListenLocalSocket(const std::string &path);
+int ConnectLocalSocket(const std::string &path);
+void CloseLocalSocket(int fd);
+bool SetNonBlocking(int fd);
+bool SendAll(int fd, const char *data, std::size_t size);
+ssize_t SendSome(int fd, const char *data, std::size_t size);
+bool ReceiveSome(int fd, std::string &buffer);
+bool TakeLine(std::string &buffer, std::string &line);
+bool ReceiveLine(int fd, std::string &buffer, std::string &line);
+bool ReceiveBytes(int fd, std::string &buffer, std::size_t size);
+
+#endif // DRAGON_GL_RENDER_PROTOCOL_H
@@ -0,0 +1,352 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "render_service.h"
+
+namespace {
+    // The scenes of a batch: requests by scene key, in arrival order
+    struct BatchScene {
+        std::string name;
+        ShadingOption shading = ShadingOption::per_vertex;
+        unsigned int light_count = 1;
+        std::vector<std::size_t> requests;
+    };
+
+    using ViewKey = std::tuple<float, float, float, unsigned int, unsigned int>;
+
+    bool ParseNumber(const std::string &value, unsigned int low, unsigned int high, unsigned int &number) {
+        // Decimal integer within [low, high]
+        char *end = nullptr;
+        auto parsed = std::strtoul(value.c_str(), &end, 10);
+
+        if (value.empty() || !std::isdigit((unsigned char) value[0]) || end != value.c_str() + value.size() ||
+            parsed < low || parsed > high) {
+            return false;
+        }
+        number = (unsigned int) parsed;
+
+        return true;
+    }
+
+    bool ParseNumber(const std::string &value, float low, float high, float &number) {
+        // Decimal number within [low, high]
+        char *end = nullptr;
+        auto parsed = std::strtof(value.c_str(), &end);
+
+        if (value.empty() || end != value.c_str() + value.size() || !(parsed >= low && parsed <= high)) {
+            return false;
+        }
+        number = parsed;
+
+        return true;
+    }
+
+    std::string SceneName(const RenderRequest &request) {
+        // The model or scene file, as requested
+        return request.scene_file.empty() ? ModelName(request.model.value_or(ModelChoice::dragon_obj)) :
+               scene_str + request.scene_file;
+    }
+
+    RenderReply ErrorReply(const std::string &message) {
+        return {reply_error + " " + message + "\n", nullptr};
+    }
+
+    bool InsideDirectory(const std::filesystem::path &path) {
+        // Relative and without '..', so it cannot name anything outside the directory it is joined to
+        return !path.has_root_path() && std::none_of(path.begin(), path.end(), [](const std::filesystem::path &part) {
+            return part == "..";
+        });
+    }
+
+    bool WriteNewFile(const std::filesystem::path &path, const CharBuffer &bytes, std::string &error) {
+        // Creates the file and writes it whole; an existing file (or a symbolic link in its place) is left alone
+        auto fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+        if (fd < 0) {
+            error = std::strerror(errno);
+            return false;
+        }
+
+        auto data = bytes.data();
+        auto size = bytes.size();
+
+        while (size > 0) {
+            auto written = write(fd, data, size);
+
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                error = written < 0 ? std::strerror(errno) : "nothing written";
+
+                close(fd);
+                unlink(path.c_str());
+                return false;
+            }
+            data += written;
+            size -= (std::size_t) written;
+        }
+        if (close(fd) != 0) {
+            error = std::strerror(errno);
+            unlink(path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    SoftScene &AcquireScene(RenderServiceParams &service, const std::string &key, const SceneDescription &description,
+                            const BatchScene &batch_scene, JobSystem &jobs, unsigned int &loaded) {
+        // The resident scene of the key, loaded unless it is; the least recently used ones make room first
+        for (auto &resident: service.scenes) {
+            if (resident.key == key) {
+                resident.last_used = service.batches;
+                return resident.scene;
+            }
+        }
+
+        while (!service.scenes.empty() && service.scenes.size() >= service.max_scenes) {
+            auto oldest = std::min_element(service.scenes.begin(), service.scenes.end(),
+                                           [](const ResidentScene &a, const ResidentScene &b) {
+                                               return a.last_used < b.last_used;
+                                           });
+            service.scenes.erase(oldest);
+        }
+
+        service.scenes.push_back({key, CreateSoftScene(description, batch_scene.shading, batch_scene.light_count,
+                                                       jobs), service.batches});
+        ++service.loads;
+        ++loaded;
+
+        return service.scenes.back().scene;
+    }
+}
+
+RenderRequest ParseRenderRequest(const std::string &line) {
+    // key=value words; the first invalid one turns the request into an error
+    RenderRequest request;
+    std::istringstream words(line);
+    std::string word;
+
+    while (request.error.empty() && words >> word) {
+        auto split = word.find('=');
+
+        if (split == std::string::npos) {
+            request.error = "expected key=value, got '" + word + "'";
+            break;
+        }
+
+        auto key = word.substr(0, split + 1);
+        auto value = word.substr(split + 1);
+        auto &camera = request.camera;
+
+        if (key == request_model_str) {
+            request.model.reset();
+
+            for (auto model: builtin_models) {
+                if (value == ModelName(model)) {
+                    request.model = model;
+                }
+            }
+            if (!request.model.has_value()) {
+                request.error = "unknown model in '" + word + "', expected one of 'dragon' 'dragon_off' 'bunny'";
+            }
+        } else if (key == scene_str) {
+            request.scene_file = value;
+        } else if (key == request_shading_str) {
+            request.shading.reset();
+
+            for (auto opt: shading_options) {
+                if (value == ShadingName(opt)) {
+                    request.shading = opt;
+                }
+            }
+            if (!request.shading.has_value()) {
+                request.error = "unknown shading in '" + word + "', expected one of 'gouraud' 'normal_mapping' "
+                                "'flat' 'wireframe'";
+            }
+        } else if (key == lights_str) {
+            if (!ParseNumber(value, 1u, request_max_lights, request.light_count)) {
+                request.error = "expected 1 to " + std::to_string(request_max_lights) + " in '" + word + "'";
+            }
+        } else if (key == size_str) {
+            auto x = value.find('x');
+
+            if (x == std::string::npos || !ParseNumber(value.substr(0, x), 1u, request_max_size, camera.width) ||
+                !ParseNumber(value.substr(x + 1), 1u, request_max_size, camera.height)) {
+                request.error = "expected WxH of 1 to " + std::to_string(request_max_size) + " in '" + word + "'";
+            }
+        } else if (key == request_rotate_x_str || key == request_rotate_y_str) {
+            auto &angle = key == request_rotate_x_str ? camera.rotate_x : camera.rotate_y;
+
+            if (!ParseNumber(value, -360.0f, 360.0f, angle)) {
+                request.error = "expected degrees within [-360, 360] in '" + word + "'";
+            }
+        } else if (key == request_fov_str) {
+            if (!ParseNumber(value, 1.0f, 179.0f, camera.fov)) {
+                request.error = "expected degrees within [1, 179] in '" + word + "'";
+            }
+        } else if (key == request_output_str && !value.empty()) {
+            request.output_file = value;
+
+            if (!InsideDirectory(value)) {
+                request.error = "output paths are relative and cannot contain '..', got '" + word + "'";
+            }
+        } else {
+            request.error = "unknown option '" + word + "', try 'model=' 'scene=' 'shading=' 'lights=' 'rx=' 'ry=' "
+                            "'fov=' 'size=' 'output='";
+        }
+    }
+    return request;
+}
+
+std::vector<RenderReply> RenderBatch(RenderServiceParams &service, const std::vector<RenderRequest> &requests,
+                                     JobSystem &jobs) {
+    // Scene by scene: load it unless resident and render its distinct views; then encode all the images of the
+    // batch in parallel and answer in request order
+    auto start = std::chrono::steady_clock::now();
+
+    ++service.batches;
+    service.requests += requests.size();
+
+    std::vector<RenderReply> replies(requests.size());
+    std::map<std::string, SceneDescription> descriptions;
+    std::map<std::string, std::string> scene_errors;
+    std::map<std::string, BatchScene> scenes;
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        const auto &request = requests[i];
+
+        if (!request.error.empty()) {
+            replies[i] = ErrorReply(request.error);
+            continue;
+        }
+        if (!request.output_file.empty() && service.output_dir.empty()) {
+            replies[i] = ErrorReply("output= needs a daemon started with outdir=dir");
+            continue;
+        }
+
+        auto name = SceneName(request);
+
+        // The loaders exit on missing or malformed files, so a scene is checked before it is loaded
+        if (!descriptions.contains(name) && !scene_errors.contains(name)) {
+            std::string error;
+            auto description = request.scene_file.empty() ?
+                               BuiltinScene(request.model.value_or(ModelChoice::dragon_obj)) :
+                               ParseSceneFile(request.scene_file, error);
+
+            if (description.has_value() && CheckSceneFiles(*description, error)) {
+                descriptions[name] = *description;
+            } else {
+                scene_errors[name] = error;
+            }
+        }
+        if (scene_errors.contains(name)) {
+            replies[i] = ErrorReply(scene_errors[name]);
+            continue;
+        }
+
+        // Same rule as dragon-opengl: normal mapping needs textures on every mesh
+        auto textured = SceneHasTextures(descriptions[name]);
+        auto shading = request.shading.value_or(textured ? ShadingOption::normal_mapping :
+                                                ShadingOption::per_vertex);
+
+        if (shading == ShadingOption::normal_mapping && !textured) {
+            replies[i] = ErrorReply("normal mapping needs textures on every mesh of " + name);
+            continue;
+        }
+
+        auto key = name + " " + ShadingName(shading) + " " + lights_str + std::to_string(request.light_count);
+        auto &batch_scene = scenes[key];
+
+        batch_scene.name = name;
+        batch_scene.shading = shading;
+        batch_scene.light_count = request.light_count;
+        batch_scene.requests.push_back(i);
+    }
+
+    // One framebuffer per distinct view of a scene; identical requests share it
+    std::vector<Framebuffer> framebuffers;
+    std::vector<std::size_t> request_frame(requests.size(), 0);
+    unsigned int loaded = 0;
+
+    for (const auto &[key, batch_scene]: scenes) {
+        auto &scene = AcquireScene(service, key, descriptions[batch_scene.name], batch_scene, jobs, loaded);
+        std::map<ViewKey, std::size_t> views;
+
+        for (auto i: batch_scene.requests) {
+            const auto &camera = requests[i].camera;
+            auto view = std::make_tuple(camera.rotate_x, camera.rotate_y, camera.fov, camera.width, camera.height);
+            auto found = views.find(view);
+
+            if (found != views.end()) {
+                request_frame[i] = found->second;
+                ++service.coalesced;
+                continue;
+            }
+
+            SceneGlobals scene_globals;
+
+            ApplyCameraKey(camera, scene_globals);
+
+            framebuffers.emplace_back();
+            RenderSoftFrame(scene, scene_globals, framebuffers.back(), jobs);
+
+            request_frame[i] = views[view] = framebuffers.size() - 1;
+        }
+    }
+    service.frames += framebuffers.size();
+
+    // PNG compression runs on one thread per image, so the images are encoded side by side
+    std::vector<std::shared_ptr<const CharBuffer>> images(framebuffers.size());
+
+    jobs.ParallelFor(framebuffers.size(), 1, [&](std::size_t begin, std::size_t end) {
+        for (auto frame = begin; frame < end; ++frame) {
+            auto png = std::make_shared<CharBuffer>();
+
+            if (EncodeFramebuffer(framebuffers[frame], *png)) {
+                images[frame] = png;
+            }
+        }
+    });
+
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        if (!replies[i].header.empty()) {
+            continue;
+        }
+
+        const auto &png = images[request_frame[i]];
+        const auto &output_file = requests[i].output_file;
+
+        if (!png) {
+            replies[i] = ErrorReply("could not encode the image");
+        } else if (!output_file.empty()) {
+            std::string error;
+
+            replies[i] = WriteNewFile(service.output_dir / output_file, *png, error) ?
+                         RenderReply{reply_saved + " " + output_file + "\n", nullptr} :
+                         ErrorReply("could not create " + output_file + ": " + error);
+        } else {
+            replies[i] = {reply_ok + " " + std::to_string(png->size()) + "\n", png};
+        }
+    }
+
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Batch " << service.batches << ": " << requests.size() << " requests, " << framebuffers.size()
+              << " images rendered, " << scenes.size() << " scenes (" << loaded << " loaded) in " << ms << " ms"
+              << std::endl;
+
+    return replies;
+}
+
+std::string RenderServiceStats(const RenderServiceParams &service) {
+    // Totals since the daemon started
+    std::ostringstream stats;
+
+    stats << service.requests << " requests in " << service.batches << " batches: " << service.frames
+          << " images rendered, " << service.coalesced << " coalesced, " << service.loads << " scene loads, "
+          << service.scenes.size() << " scenes resident";
+
+    return stats.str();
+}
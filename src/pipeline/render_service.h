@@ -0,0 +1,88 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_RENDER_SERVICE_H
+#define DRAGON_GL_RENDER_SERVICE_H
+
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+
+#include "camera_path.h"
+#include "job_system.h"
+#include "rasterizer.h"
+#include "render_protocol.h"
+#include "scene.h"
+
+/* Render requests of the render daemon, on the software rasterizer so the daemon needs no window or GPU. Scenes
+ * stay resident between requests, keyed by model (or scene file), shading and light count, and the least recently
+ * used one is dropped when more than 'scenes=N' are loaded. A request line is key=value words, all optional:
+ *     model=dragon|dragon_off|bunny  scene=path  shading=gouraud|normal_mapping|flat|wireframe  lights=N
+ *     rx=DEG ry=DEG fov=DEG  size=WxH  output=path
+ * The defaults are those of dragon-opengl: the dragon, normal mapping if every mesh is textured, one light, the
+ * initial view and window size. Without output=path the PNG bytes are sent back (see render_protocol.h). With it
+ * the daemon creates the file under its 'outdir=dir', never replacing one; output paths are relative and cannot
+ * leave that directory, and without 'outdir=dir' they are refused.
+ * A batch renders the requests of each scene one after the other, draws identical views once, then encodes all
+ * its images in parallel. A scene file that is missing or malformed, or names a mesh or texture that is not there,
+ * is answered with an error instead of stopping the daemon */
+const std::string request_model_str = "model=";
+const std::string request_shading_str = "shading=";
+const std::string request_rotate_x_str = "rx=";
+const std::string request_rotate_y_str = "ry=";
+const std::string request_fov_str = "fov=";
+const std::string request_output_str = "output=";
+
+const unsigned int request_max_size = 4096;    // pixels per side; a batch holds all its images at once
+const unsigned int request_max_lights = 1024;
+
+struct RenderRequest {
+    std::optional<ModelChoice> model;
+    std::string scene_file;  // instead of a built-in model
+    std::optional<ShadingOption> shading;
+    unsigned int light_count = 1;
+    CameraKey camera;        // the frame is not used
+    std::string output_file;  // relative to the output directory; empty: the PNG is sent back
+    std::string error;       // the line was invalid; answered as is
+};
+
+struct RenderReply {
+    std::string header;  // reply line, newline included
+    std::shared_ptr<const CharBuffer> png;  // shared by coalesced requests; null unless sent back
+};
+
+struct ResidentScene {
+    std::string key;
+    SoftScene scene;
+    std::size_t last_used = 0;  // batch
+};
+
+struct RenderServiceParams {
+    unsigned int max_scenes = 4;
+    std::filesystem::path output_dir;  // empty: requests cannot write files
+    std::vector<ResidentScene> scenes;
+
+    std::size_t batches = 0;
+    std::size_t requests = 0;
+    std::size_t frames = 0;     // rendered
+    std::size_t coalesced = 0;  // answered with the image of an identical request
+    std::size_t loads = 0;      // scenes loaded, including reloads after eviction
+};
+
+RenderRequest ParseRenderRequest(const std::string &line);
+std::vector<RenderReply> RenderBatch(RenderServiceParams &service, const std::vector<RenderRequest> &requests,
+                                     JobSystem &jobs);
+std::string RenderServiceStats(const RenderServiceParams &service);
+
+#endif // DRAGON_GL_RENDER_SERVICE_H
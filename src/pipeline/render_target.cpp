@@ -0,0 +1,111 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "render_target.h"
+
+RenderTarget CreateRenderTarget(unsigned int width, unsigned int height, GLsizei samples) {
+    // Multisampled color and float depth renderbuffers, with up to 'samples' samples as the driver allows;
+    // single sampled textures for 0
+    RenderTarget target;
+    GLint max_samples = 0;
+
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+
+    target.requested_samples = samples;
+    target.samples = std::min<GLsizei>(samples, max_samples);
+    target.width = width;
+    target.height = height;
+
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+
+    if (target.samples == 0) {
+        // FXAA and TAA filter the color when sampling it
+        target.color = CreateRenderTexture(GL_RGBA8, width, height);
+        target.depth = CreateRenderTexture(GL_DEPTH_COMPONENT32F, width, height);
+
+        glBindTexture(GL_TEXTURE_2D, target.color);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.color, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, target.depth, 0);
+    } else {
+        glGenRenderbuffers(1, &target.color);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.color);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, target.samples, GL_RGBA8, (GLsizei) width,
+                                         (GLsizei) height);
+        TrackGlObject(GL_RENDERBUFFER, target.color, MemoryCategory::gpu_targets,
+                      TextureBytes((GLsizei) width, (GLsizei) height, target.samples, 1, 4));
+
+        glGenRenderbuffers(1, &target.depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, target.samples, GL_DEPTH_COMPONENT32F, (GLsizei) width,
+                                         (GLsizei) height);
+        TrackGlObject(GL_RENDERBUFFER, target.depth, MemoryCategory::gpu_targets,
+                      TextureBytes((GLsizei) width, (GLsizei) height, target.samples, 1, 4));
+
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Scene framebuffer is incomplete" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return target;
+}
+
+void DeleteRenderTarget(RenderTarget &target) {
+    // Frees the framebuffer and its attachments, eg. before recreating them on resize
+    GLuint attachments[] = {target.color, target.depth};
+
+    glDeleteFramebuffers(1, &target.fbo);
+
+    if (target.samples == 0) {
+        ReleaseGlObjects(GL_TEXTURE, 2, attachments);
+        glDeleteTextures(2, attachments);
+    } else {
+        ReleaseGlObjects(GL_RENDERBUFFER, 2, attachments);
+        glDeleteRenderbuffers(2, attachments);
+    }
+
+    target = RenderTarget();
+}
+
+void BindRenderTarget(RenderTarget &target, const SceneGlobals &scene_globals, GLsizei samples) {
+    // Draws go to the target from here on; follows the viewport size and the antialiasing mode
+    if (target.width != scene_globals.width || target.height != scene_globals.height ||
+        target.requested_samples != samples) {
+        DeleteRenderTarget(target);
+
+        target = CreateRenderTarget(scene_globals.width, scene_globals.height, samples);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+}
+
+void ResolveRenderTarget(const RenderTarget &target, GLuint output_fbo) {
+    // Averages the samples into the window's back buffer (or output_fbo, of the same size); depth stays behind
+    auto width = (GLint) target.width;
+    auto height = (GLint) target.height;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, output_fbo);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+std::size_t RenderTargetBytes(const RenderTarget &target) {
+    // 4 bytes of color and 4 of depth per sample
+    return (std::size_t) target.width * target.height * 8 * std::max<GLsizei>(target.samples, 1);
+}
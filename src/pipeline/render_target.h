@@ -0,0 +1,35 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_RENDER_TARGET_H
+#define DRAGON_GL_RENDER_TARGET_H
+
+#include <algorithm>
+
+#include <glad/glad.h>
+
+#include "attributes.h"
+#include "scene.h"
+#include "deferred.h"
+
+/* Offscreen target of the forward path. The default framebuffer only offers fixed point depth, which wastes
+ * reverse-Z: this one has a 32-bit float depth buffer, and as many MSAA samples as the antialiasing mode asks for.
+ * Resolved into the window once per frame */
+struct RenderTarget {
+    GLuint fbo = 0;
+    GLuint color = 0;  // RGBA8; renderbuffer if multisampled, otherwise a texture the resolve passes can sample
+    GLuint depth = 0;  // DEPTH_COMPONENT32F; same
+    GLsizei samples = 0;
+    GLsizei requested_samples = 0;  // before the driver limit
+    unsigned int width = 0;
+    unsigned int height = 0;
+};
+
+RenderTarget CreateRenderTarget(unsigned int width, unsigned int height, GLsizei samples);
+void DeleteRenderTarget(RenderTarget &target);
+void BindRenderTarget(RenderTarget &target, const SceneGlobals &scene_globals, GLsizei samples);
+void ResolveRenderTarget(const RenderTarget &target, GLuint output_fbo = 0);
+std::size_t RenderTargetBytes(const RenderTarget &target);
+
+#endif // DRAGON_GL_RENDER_TARGET_H
@@ -35,15 +35,20 @@ static void FrameBufferSizeCallback([[maybe_unused]] GLFWwindow *window, int wid
     scene_globals_ref->height = height;
     scene_globals_ref->width = width;
 
+    // The render loop sets the viewport; it may run on another thread than this callback
     scene_globals_ref->dirty_ = true;
+}
+
+static void RefreshCallback(GLFWwindow *window) {
+    // Window contents were damaged (eg. uncovered or restored) and must be drawn again
+    auto scene_globals_ref = static_cast<SceneGlobals *>(glfwGetWindowUserPointer(window));
 
-    // Set the viewport
-    glViewport(0, 0, width, height);
+    scene_globals_ref->redraw_ = true;
 }
 
 static void InputCallback(GLFWwindow *window, int key, [[maybe_unused]] int scancode,
                           [[maybe_unused]] int action, [[maybe_unused]] int mods) {
-    // Callback on key press - Escape, Left arrow, Right arrow
+    // Callback on key press - Escape, arrows, M
     // Reference to globals is stored in the GLFW window
     auto scene_globals_ref = static_cast<SceneGlobals *>(glfwGetWindowUserPointer(window));
 
@@ -69,6 +74,35 @@ static void InputCallback(GLFWwindow *window, int key, [[maybe_unused]] int scan
         scene_globals_ref->rotate_x += rotation_tick;
         scene_globals_ref->dirty_ = true;
     }
+
+    // Memory report on demand
+    if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+        std::cout << MemoryReport() << std::endl;
+    }
+}
+
+static void MouseButtonCallback(GLFWwindow *window, int button, int action, [[maybe_unused]] int mods) {
+    // Left click picks the face under the cursor
+    auto scene_globals_ref = static_cast<SceneGlobals *>(glfwGetWindowUserPointer(window));
+
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) {
+        return;
+    }
+
+    // Cursor positions are in screen coordinates, which differ from pixels on high-DPI displays
+    double x, y;
+    int window_width, window_height;
+
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &window_width, &window_height);
+
+    if (window_width <= 0 || window_height <= 0) {
+        return;
+    }
+
+    scene_globals_ref->pick_x = x * scene_globals_ref->width / window_width;
+    scene_globals_ref->pick_y = y * scene_globals_ref->height / window_height;
+    scene_globals_ref->pick_ = true;
 }
 
 void SetResizeCallback(const WindowPtr &window_ptr) {
@@ -90,8 +124,8 @@ GlmVec4 GetLightPosition(ModelChoice model) {
     return {0, 0, light_z, 1.0f};
 }
 
-GlmMat4 GetWorldSpaceMatrix(ModelChoice model, const SceneGlobals &scene_globals) {
-    /* Model Space -> World Space
+GlmMat4 GetModelTransform(ModelChoice model) {
+    /* Placement of a built-in model (scale, then translate) in world space
      * GLM is utilized. Good resources:
      * https://web.engr.oregonstate.edu/~mjb/cs557/Handouts/GLM.1pp.pdf
      * https://open.gl/transformations
@@ -114,6 +148,13 @@ GlmMat4 GetWorldSpaceMatrix(ModelChoice model, const SceneGlobals &scene_globals
         model_transform = glm::translate(model_transform, GlmVec3(.1, 0.15f, .2f));
     }
 
+    return model_transform;
+}
+
+GlmMat4 GetWorldSpaceMatrix(const GlmMat4 &instance_transform, const SceneGlobals &scene_globals) {
+    // Model Space -> World Space: the instance placement followed by the user rotation
+    GlmMat4 model_transform = instance_transform;
+
     // Rotation
     // https://glm.g-truc.net/0.9.9/api/a00668.html#gaee9e865eaa9776370996da2940873fd4
     model_transform = glm::rotate(model_transform, glm::radians(scene_globals.rotate_y),
@@ -130,11 +171,20 @@ GlmMat4 GetViewMatrix() {
     return glm::lookAt(eye_pos, eye_pos + gaze_dir, look_up);
 }
 
-GlmMat4 GetPerspectiveMatrix(double fov, double aspect_ratio, double near_z, double far_z) {
+GlmMat4 GetPerspectiveMatrix(double fov, double aspect_ratio, double near_z) {
     // View Space (or Camera) -> Perspective
-    // https://glm.g-truc.net/0.9.9/api/a00665.html#ga747c8cf99458663dd7ad1bb3a2f07787
+    // x and y as glm::perspective; z_clip = near and w_clip = -z_view, so with glClipControl's [0, 1] depth
+    // range the depth is near / distance: reversed, and finite however far away the geometry is
+    // https://www.reedbeta.com/blog/depth-precision-visualized/
     // This also adapts to viewport resize events
-    GlmMat4 projection = glm::perspective(fov, aspect_ratio, near_z, far_z);
+    auto focal = 1.0 / std::tan(fov / 2.0);
+
+    GlmMat4 projection(0.0f);
+
+    projection[0][0] = (float) (focal / aspect_ratio);
+    projection[1][1] = (float) focal;
+    projection[2][3] = -1.0f;
+    projection[3][2] = (float) near_z;
 
     // clamp values
     if (projection[0][0] < 0) {
@@ -152,51 +202,56 @@ GlmMat4 GetNormalUpdateMatrix(const GlmMat4 &model_view) {
     return GlmMat4(glm::transpose(glm::inverse(model_view)));
 }
 
-unsigned int LoadTexture(const std::string &filename) {
-    /* Load a texture into uniform memory */
+unsigned int CreateTexture(const unsigned char *data, int width, int height, int components) {
+    /* Load decoded pixels into texture memory */
     // https://learnopengl.com
     unsigned int texture_id;
 
-    ExistsOk(filename);
-
     glGenTextures(1, &texture_id);
 
-    int width, height, nrComponents;
+    GLenum format = GetPixelFormat(components);
 
-    ImageLoader image_loader;
+    // rows of 1 or 3 component images are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    auto data = image_loader.LoadImageFile(filename, width, height, nrComponents);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, (GLint) format, width, height, 0, format,
+                 GL_UNSIGNED_BYTE, data);
 
-    if (data) {
-        GLenum format;
+    auto levels = (GLsizei) std::floor(std::log2(std::max(width, height))) + 1;
+    TrackGlObject(GL_TEXTURE, texture_id, MemoryCategory::gpu_textures,
+                  TextureBytes(width, height, 1, levels, (std::size_t) components));
 
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Automatically generates mipmaps for the current texture
+    // https://www.khronos.org/opengl/wiki/Common_Mistakes#Automatic_mipmap_generation
+    glGenerateMipmap(GL_TEXTURE_2D);  // invoked once since the texture does not change
 
-        glBindTexture(GL_TEXTURE_2D, texture_id);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
-                     GL_UNSIGNED_BYTE, data);
+    // Sampling settings - these will affect image quality
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-        // Automatically generates mipmaps for the current texture
-        // https://www.khronos.org/opengl/wiki/Common_Mistakes#Automatic_mipmap_generation
-        glGenerateMipmap(GL_TEXTURE_2D);  // invoked once since the texture does not change
+    return texture_id;
+}
+
+unsigned int LoadTexture(const std::string &filename) {
+    /* Load a texture file into texture memory */
+    ExistsOk(filename);
 
-        // Sampling settings - these will affect image quality
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    int width, height, nrComponents;
 
-    } else {
+    ImageLoader image_loader;
+
+    auto data = image_loader.LoadImageFile(filename, width, height, nrComponents);
+
+    if (!data) {
         std::cout << "Failed to load texture via stb_image" << std::endl;
 
         exit(EXIT_FAILURE);
     }
 
-    return texture_id;
+    return CreateTexture(data, width, height, nrComponents);
 }
 
 WindowPtr InitializeWindow(int width, int height, const std::string &title, SceneGlobals &scene_globals) {
@@ -208,17 +263,17 @@ WindowPtr InitializeWindow(int width, int height, const std::string &title, Scen
         exit(EXIT_FAILURE);
     }
 
-    // uses 3.3 profile, which is recent (this is not the same as the OpenGL version)
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    // requests a 4.6 context; compute shaders (deferred lighting) need at least 4.3
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    // Anti-aliasing 8x MSAA if it is supported
-    // Assumes that "GL_MULTISAMPLE" is enabled (it is by default in modern drivers)
+    // The scene is drawn into its own multisampled target with a float depth buffer (see render_target.h),
+    // then resolved into the window, which needs neither samples nor depth
     // https://www.glfw.org/docs/3.3/window_guide.html#window_hints_fb
-    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glEnable.xhtml
-    glfwWindowHint(GLFW_SAMPLES, antialiasing_subsamples);
+    glfwWindowHint(GLFW_SAMPLES, 0);
+    glfwWindowHint(GLFW_DEPTH_BITS, 0);
 
     // create window
     WindowPtr window = WindowPtr(glfwCreateWindow(width, height, title.c_str(), nullptr, nullptr));
@@ -248,9 +303,17 @@ WindowPtr InitializeWindow(int width, int height, const std::string &title, Scen
     std::cout << "Renderer: " << renderer << std::endl;
     std::cout << "OpenGL supported version and driver: " << version << std::endl;
 
+    // Reverse-Z: [0, 1] clip depth keeps the float depth buffer's precision where it is needed (core in 4.5)
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glClipControl.xhtml
+    glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+    glClearDepth(depth_clear);
+    glDepthFunc(depth_func);
+
     // register user callbacks
     glfwSetKeyCallback(window.get(), InputCallback);
     glfwSetScrollCallback(window.get(), ScrollCallback);
+    glfwSetWindowRefreshCallback(window.get(), RefreshCallback);
+    glfwSetMouseButtonCallback(window.get(), MouseButtonCallback);
 
     // Associate scene globals
     glfwSetWindowUserPointer(window.get(), &scene_globals);
@@ -258,119 +321,157 @@ WindowPtr InitializeWindow(int width, int height, const std::string &title, Scen
     return window;
 }
 
-GLuint InitTransformUniforms(ModelChoice model, const SceneGlobals &scene_globals) {
+GLuint InitTransformUniforms() {
     // https://learnopengl.com/Advanced-OpenGL/Advanced-GLSL
     unsigned int ubo_matrices;
 
     glGenBuffers(1, &ubo_matrices);
     glBindBuffer(GL_UNIFORM_BUFFER, ubo_matrices);
-    glBufferData(GL_UNIFORM_BUFFER, 5 * sizeof(GlmMat4), nullptr, GL_STATIC_DRAW);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(TransformBlock), nullptr, GL_DYNAMIC_DRAW);
+    TrackGlObject(GL_BUFFER, ubo_matrices, MemoryCategory::gpu_uniforms, sizeof(TransformBlock));
 
     // define the range of the buffer that links to a uniform binding point
-    glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo_matrices, 0, 5 * sizeof(GlmMat4));
-
-    // world, view and projection matrices
-    UpdateTransformUniforms(ubo_matrices, model, scene_globals);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo_matrices, 0, sizeof(TransformBlock));
 
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
     return ubo_matrices;
 }
 
-void InitLightingUniforms(ModelChoice model) {
+GLuint InitInstanceBuffer(std::size_t instance_count) {
+    // Shader storage with one InstanceBlock per instance; shaders index it with gl_BaseInstance
+    GLuint instance_buffer;
+
+    glGenBuffers(1, &instance_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instance_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, instance_count * sizeof(InstanceBlock), nullptr, GL_DYNAMIC_DRAW);
+    TrackGlObject(GL_BUFFER, instance_buffer, MemoryCategory::gpu_storage, instance_count * sizeof(InstanceBlock));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, instance_buffer_binding, instance_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    return instance_buffer;
+}
+
+GLuint InitLightingUniforms(const SceneGlobals &scene_globals) {
     // https://learnopengl.com/Advanced-OpenGL/Advanced-GLSL
     unsigned int ubo_lighting;
 
-    auto eye_pos4 = GlmVec4(eye_pos, 1);
-    auto light_pos4 = GetLightPosition(model);
-    auto light_color4 = GlmVec4(light_color, 1);
-
     glGenBuffers(1, &ubo_lighting);
 
     glBindBuffer(GL_UNIFORM_BUFFER, ubo_lighting);
-    glBufferData(GL_UNIFORM_BUFFER, 3 * sizeof(GlmVec4), nullptr, GL_STATIC_DRAW);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingBlock), nullptr, GL_DYNAMIC_DRAW);
+    TrackGlObject(GL_BUFFER, ubo_lighting, MemoryCategory::gpu_uniforms, sizeof(LightingBlock));
 
     // initialize buffer range
-    glBindBufferRange(GL_UNIFORM_BUFFER, 1, ubo_lighting, 0, 3 * sizeof(GlmVec4));
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, ubo_lighting, 0, sizeof(LightingBlock));
 
-    // bind eye pos, light pos, and light color
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GlmVec4),
-                    glm::value_ptr(eye_pos4));
-    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(GlmVec4), sizeof(GlmVec4),
-                    glm::value_ptr(light_pos4));
-    glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(GlmVec4), sizeof(GlmVec4),
-                    glm::value_ptr(light_color4));
+    // eye pos, cluster grid and viewport
+    UpdateLightingUniforms(ubo_lighting, scene_globals);
 
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    return ubo_lighting;
 }
 
-BufferHandle InitializeUniforms(ModelChoice model, SceneGlobals &scene_globals) {
-    // world space, view, perspective
-    auto handle = InitTransformUniforms(model, scene_globals);
+void UpdateLightingUniforms(const BufferHandle &ubo_lighting, const SceneGlobals &scene_globals) {
+    // Cluster lookup parameters; the viewport part changes on resize
+    LightingBlock block{};
 
-    // eye pos, light pos, color
-    InitLightingUniforms(model);
+    block.eye_pos = GlmVec4(eye_pos, 1);
+    block.cluster_grid = glm::uvec4(cluster_grid_x, cluster_grid_y, cluster_grid_z, max_lights_per_cluster);
+    block.cluster_depth = GlmVec4(near_plane, far_plane,
+                                  (float) cluster_grid_z / std::log(far_plane / near_plane), 0);
+    block.viewport = GlmVec4(scene_globals.width, scene_globals.height, 0, 0);
 
-    return handle;
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo_lighting);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightingBlock), &block);
 }
 
-void UpdateTransformUniforms(const BufferHandle &ubo_matrices, ModelChoice model, const SceneGlobals &scene_globals) {
-    // Sets uniform buffers corresponding to transformations (eg. view)
-    // These can be updated via user input
-    GlmMat4 world = GetWorldSpaceMatrix(model, scene_globals);
-    GlmMat4 view = GetViewMatrix();
+std::tuple<BufferHandle, BufferHandle, BufferHandle> InitializeUniforms(const std::vector<SceneInstance> &instances,
+                                                                        SceneGlobals &scene_globals) {
+    // view, perspective; world space and normal matrices per instance
+    auto transforms_handle = InitTransformUniforms();
+    auto instances_handle = InitInstanceBuffer(instances.size());
 
-    GlmMat4 projection = GetPerspectiveMatrix(scene_globals.fov,
-                                              (float) scene_globals.width / (float) scene_globals.height,
-                                              near_plane, far_plane);
+    UploadTransformUniforms(transforms_handle, instances_handle, ComputeTransforms(instances, scene_globals));
 
-    // Normal updates (model -> view, model -> world)
-    GlmMat4 normal_to_view = GetNormalUpdateMatrix(view * world);
-    GlmMat4 normal_to_world = GetNormalUpdateMatrix(world);
+    // eye pos, cluster grid
+    auto lighting_handle = InitLightingUniforms(scene_globals);
 
-    glBindBufferRange(GL_UNIFORM_BUFFER, 0, ubo_matrices, 0, 5 * sizeof(GlmMat4));
+    return {transforms_handle, instances_handle, lighting_handle};
+}
 
-    // World Space
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(GlmMat4),
-                    glm::value_ptr(world));
+LightList CreateLightList(const LightList &scene_lights, unsigned int light_count) {
+    // The scene lights come first, followed by fill lights up to light_count
+    LightList key_lights = scene_lights;
 
-    // View (or Camera)
-    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(GlmMat4), sizeof(GlmMat4),
-                    glm::value_ptr(view));
+    // Scenes without lights get the usual key light in front of the camera
+    if (key_lights.empty()) {
+        PointLight key_light{};
 
-    // Perspective
-    glBufferSubData(GL_UNIFORM_BUFFER, 2 * sizeof(GlmMat4), sizeof(GlmMat4),
-                    glm::value_ptr(projection));
+        key_light.position = GlmVec4(0.0f, 0.0f, 2.0f, key_light_radius);
+        key_light.color = GlmVec4(light_color, 1.0f);
 
-    // Normal to View
-    glBufferSubData(GL_UNIFORM_BUFFER, 3 * sizeof(GlmMat4), sizeof(GlmMat4),
-                    glm::value_ptr(normal_to_view));
+        key_lights.push_back(key_light);
+    }
+    return CreateSceneLights(key_lights, light_count);
+}
+
+BufferHandle InitializeLights(const LightList &scene_lights, unsigned int light_count, LightList &lights) {
+    // Light list (shader storage) for the multi-light paths
+    lights = CreateLightList(scene_lights, light_count);
 
-    // Normal to World
-    glBufferSubData(GL_UNIFORM_BUFFER, 4 * sizeof(GlmMat4), sizeof(GlmMat4),
-                    glm::value_ptr(normal_to_world));
+    return CreateLightBuffer(lights);
 }
 
-BufferParams CreateVertexBuffer(const std::vector<Vertex> &vertices) {
-    // Allocates and populates vertex buffer
-    // copy into C array
-    VertexListPtr vertex_data = std::make_unique<Vertex[]>(vertices.size());
+SceneTransforms ComputeTransforms(const std::vector<SceneInstance> &instances, const SceneGlobals &scene_globals) {
+    // View and projection, then world and normal matrices per instance; pure CPU work, safe off the render thread
+    SceneTransforms transforms;
 
-    std::copy(vertices.begin(), vertices.end(), vertex_data.get());
+    transforms.camera.view = GetViewMatrix();
+    transforms.camera.projection = GetPerspectiveMatrix(scene_globals.fov,
+                                                        (float) scene_globals.width / (float) scene_globals.height,
+                                                        near_plane);
 
-    // create the vertex array object to hold vertex positions
-    GLuint vao;
-    glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    transforms.instances.resize(instances.size());
 
-    // create a vertex buffer that contains all vertex attributes
-    GLuint vbo;
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertex_data.get(),
-                 GL_STATIC_DRAW);
+    for (std::size_t i = 0; i < instances.size(); ++i) {
+        auto &block = transforms.instances[i];
 
-    // specify formats of data in buffer
+        block.world = GetWorldSpaceMatrix(instances[i].transform, scene_globals);
+
+        // Normal updates (model -> view, model -> world)
+        block.normal_to_view = GetNormalUpdateMatrix(transforms.camera.view * block.world);
+        block.normal_to_world = GetNormalUpdateMatrix(block.world);
+
+        block.material = glm::uvec4(instances[i].material, 0, 0, 0);
+    }
+
+    return transforms;
+}
+
+void UploadTransformUniforms(const BufferHandle &ubo_matrices, const BufferHandle &instance_buffer,
+                             const SceneTransforms &transforms) {
+    // View (or Camera), Perspective; World Space, Normal to View, Normal to World of all instances at once
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo_matrices);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(TransformBlock), &transforms.camera);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, instance_buffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, transforms.instances.size() * sizeof(InstanceBlock),
+                    transforms.instances.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void UpdateTransformUniforms(const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Sets uniform buffers corresponding to transformations (eg. view)
+    // These can be updated via user input
+    UploadTransformUniforms(scene_params.transforms_handle, scene_params.instances_handle,
+                            ComputeTransforms(scene_params.instances, scene_globals));
+}
+
+void SetVertexLayout() {
+    // Attribute formats of Vertex, read from the bound array buffer into the bound vertex array
     // vertex position (model space)
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                           (void *) (offsetof(struct Vertex, pos)));
@@ -390,25 +491,104 @@ BufferParams CreateVertexBuffer(const std::vector<Vertex> &vertices) {
     glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                           (void *) (offsetof(struct Vertex, uv_coord)));
     glEnableVertexAttribArray(3);
+}
+
+GLuint EmptyVertexArray() {
+    // Core profile requires a bound vertex array, even if it has no attributes. Passes that fetch no vertices
+    // (fullscreen triangles, impostor quads) share this one; it is created on first use and lives with the context
+    static GLuint empty_vao = 0;
+
+    if (empty_vao == 0) {
+        glGenVertexArrays(1, &empty_vao);
+    }
+    return empty_vao;
+}
+
+BufferParams CreateVertexBuffer(const std::vector<Vertex> &vertices) {
+    // Allocates and populates vertex buffer
+    // copy into C array
+    VertexListPtr vertex_data = std::make_unique<Vertex[]>(vertices.size());
+    TrackMemory(MemoryCategory::cpu_vertex_copy, vertices.size() * sizeof(Vertex));
+
+    std::copy(vertices.begin(), vertices.end(), vertex_data.get());
+
+    // create the vertex array object to hold vertex positions
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    // create a vertex buffer that contains all vertex attributes
+    GLuint vbo;
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertex_data.get(),
+                 GL_STATIC_DRAW);
+    TrackGlObject(GL_BUFFER, vbo, MemoryCategory::gpu_vertices, vertices.size() * sizeof(Vertex));
+
+    // specify formats of data in buffer
+    SetVertexLayout();
 
     BufferParams params;
 
     params.vao = vao;
+    params.vbo = vbo;
     params.vertex_list = std::move(vertex_data);
 
     return params;
 }
 
-GLuint CompileShader(const std::string &path, GLenum shader_type) {
+/* Shader sources read along with the scene's assets, by normalized path; filled by CreateScene and only used on
+ * the thread that owns the GL context */
+static std::map<std::string, std::string> shader_sources;
+
+std::vector<std::string> ShaderFiles() {
+    // Every glsl file of the shader directories; a few kB each, so all are read whatever the options
+    std::vector<std::string> files;
+
+    for (const auto &dir: {per_vertex_dir, normal_mapping_dir, flat_dir, deferred_dir, present_dir, clustered_dir,
+                           depth_dir, overdraw_dir, antialiasing_dir, impostor_dir, deform_dir, points_dir}) {
+        if (!std::filesystem::is_directory(dir)) {
+            continue;
+        }
+        for (const auto &entry: std::filesystem::directory_iterator(dir)) {
+            if (entry.path().extension() == ".glsl") {
+                files.push_back(entry.path().string());
+            }
+        }
+    }
+    return files;
+}
+
+void CacheShaderSources(const std::map<std::string, ByteList> &files) {
+    // Keeps the prefetched sources for CompileShader
+    for (const auto &[path, bytes]: files) {
+        shader_sources[std::filesystem::path(path).lexically_normal().string()] = std::string(bytes.begin(),
+                                                                                               bytes.end());
+    }
+}
+
+GLuint CompileShader(const std::string &path, GLenum shader_type, const std::string &defines) {
     // Reads shaders on the local filesystem and compiles them on the device
     // https://www.khronos.org/opengl/wiki/Shader_Compilation#Shader_object_compilation
     int success;
     char info_log[shader_log_buffer_size];
 
-    // read glsl files
-    std::ifstream filestream(path);
-    std::string shader_source((std::istreambuf_iterator<char>(filestream)),
-                              std::istreambuf_iterator<char>());
+    // read glsl files, unless prefetched
+    std::string shader_source;
+    auto prefetched = shader_sources.find(std::filesystem::path(path).lexically_normal().string());
+
+    if (prefetched != shader_sources.end()) {
+        shader_source = prefetched->second;
+    } else {
+        std::ifstream filestream(path);
+
+        shader_source.assign(std::istreambuf_iterator<char>(filestream), std::istreambuf_iterator<char>());
+    }
+
+    // defines (and #extension lines) must follow the #version line
+    if (!defines.empty()) {
+        shader_source.insert(shader_source.find('\n') + 1, defines);
+    }
 
     // create and compile the shader
     GLuint shader_handle = glCreateShader(shader_type);
@@ -433,55 +613,27 @@ GLuint CompileShader(const std::string &path, GLenum shader_type) {
     return shader_handle;
 }
 
-std::pair<unsigned int, unsigned int> CreateTextures() {
-    // Binds a texture to uniform memory; textures are stored uniquely
-    // https://docs.gl/gl4/glBindTexture
-    auto color_map_texture = LoadTexture(texture_diffuse_filename);
-    auto normal_texture = LoadTexture(texture_normal_map_filename);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, color_map_texture);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, normal_texture);
-
-    return {color_map_texture, normal_texture};
-}
-
 ShaderParams CreateShaderProgram(const std::string &vertex_shader_path,
-                                 const std::string &fragment_shader_path) {
-    // Create and link shaders, and load textures
+                                 const std::string &fragment_shader_path, const std::string &defines) {
+    // Create and link shaders
     // https://docs.gl/gl4/glLinkProgram
-    int success;
-    char info_log[512];
-
     // Verify shader glsl files exist
     ExistsOk(vertex_shader_path);
     ExistsOk(fragment_shader_path);
 
     // create and compile shaders
-    GLenum vertex_shader = CompileShader(vertex_shader_path, GL_VERTEX_SHADER);
-    GLenum fragment_shader = CompileShader(fragment_shader_path, GL_FRAGMENT_SHADER);
+    GLenum vertex_shader = CompileShader(vertex_shader_path, GL_VERTEX_SHADER, defines);
+    GLenum fragment_shader = CompileShader(fragment_shader_path, GL_FRAGMENT_SHADER, defines);
 
     // link shaders
     GLuint shader_program = glCreateProgram();
 
-    // create textures
-    CreateTextures();
-
     glAttachShader(shader_program, vertex_shader);
     glAttachShader(shader_program, fragment_shader);
     glLinkProgram(shader_program);
 
     // check for errors while linking the shaders together
-    glGetShaderiv(shader_program, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        glGetShaderInfoLog(shader_program, 512, nullptr, info_log);
-
-        std::cout << "Error linking shaders: " << info_log << std::endl;
-
-        exit(EXIT_FAILURE);
-    }
+    CheckProgramLinked(shader_program);
 
     // shader is now installed and active, clean up
     glDeleteShader(vertex_shader);
@@ -495,35 +647,180 @@ ShaderParams CreateShaderProgram(const std::string &vertex_shader_path,
     return shader_data;
 }
 
-SceneParams CreateScene(ModelChoice model, ShadingOption opt, SceneGlobals &scene_globals) {
-    /* Loads a given mode, allocates and sets uniforms, and creates vertex buffer */
-    VertexList loaded_vertices;
+ShaderParams CreateComputeProgram(const std::string &compute_shader_path, const std::string &defines) {
+    // Create and link a program with a single compute stage
+    // https://www.khronos.org/opengl/wiki/Compute_Shader
+    ExistsOk(compute_shader_path);
+
+    GLenum compute_shader = CompileShader(compute_shader_path, GL_COMPUTE_SHADER, defines);
+
+    GLuint shader_program = glCreateProgram();
+
+    glAttachShader(shader_program, compute_shader);
+    glLinkProgram(shader_program);
+
+    CheckProgramLinked(shader_program);
+
+    glDeleteShader(compute_shader);
+
+    ShaderParams shader_data{};
+
+    shader_data.program = shader_program;
+
+    return shader_data;
+}
+
+void CheckProgramLinked(GLuint shader_program) {
+    // Exit with the info log if linking failed
+    // https://docs.gl/gl4/glGetProgram
+    int success;
+    char info_log[shader_log_buffer_size];
+
+    glGetProgramiv(shader_program, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        glGetProgramInfoLog(shader_program, shader_log_buffer_size, nullptr, info_log);
+
+        std::cout << "Error linking shaders: " << info_log << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+}
+
+SceneDescription BuiltinScene(ModelChoice model) {
+    // One of the bundled models as a single-instance scene; only the obj dragon is textured
+    SceneDescription scene;
+    MeshDesc mesh;
 
-    // Selected model is loaded into vector of structs
     if (model == ModelChoice::dragon_off) {
-        loaded_vertices = LoadDragonOff(mesh_off_filename, opt);
+        mesh.name = dragon_model_off_str;
+        mesh.path = mesh_off_filename;
     } else if (model == ModelChoice::dragon_obj) {
-        loaded_vertices = LoadDragonObj(mesh_obj_filename, opt);
+        mesh.name = dragon_model_str;
+        mesh.path = mesh_obj_filename;
+        mesh.diffuse_path = texture_diffuse_filename;
+        mesh.normal_path = texture_normal_map_filename;
     } else if (model == ModelChoice::bunny_off) {
-        loaded_vertices = LoadDragonOff(mesh_off_bunny_filename, opt);
+        mesh.name = bunny_model_str;
+        mesh.path = mesh_off_bunny_filename;
     }
+    scene.meshes.push_back(mesh);
+
+    InstanceDesc instance{};
+
+    instance.mesh = 0;
+    instance.transform = GetModelTransform(model);
+
+    scene.instances.push_back(instance);
+
+    PointLight key_light{};
+
+    key_light.position = GlmVec4(GlmVec3(GetLightPosition(model)), key_light_radius);
+    key_light.color = GlmVec4(light_color, 1.0f);
+
+    scene.lights.push_back(key_light);
+
+    return scene;
+}
+
+VertexList ConcatenateMeshes(SceneAssets &assets, std::vector<std::pair<GLuint, GLuint>> &mesh_ranges) {
+    // All unique meshes back to back; mesh_ranges gets the (first vertex, vertex count) of each. The
+    // per-mesh lists are freed as they are copied
+    VertexList vertices;
+
+    for (auto &mesh: assets.meshes) {
+        mesh_ranges.emplace_back((GLuint) vertices.size(), (GLuint) mesh.size());
+        vertices.insert(vertices.end(), mesh.begin(), mesh.end());
+
+        ReleaseMemory(MemoryCategory::cpu_vertex_list, mesh.capacity() * sizeof(Vertex));
+        VertexList().swap(mesh);
+    }
+    return vertices;
+}
+
+SceneParams CreateScene(const SceneDescription &scene, ShadingOption opt, unsigned int light_count,
+                        bool allow_bindless, SceneGlobals &scene_globals) {
+    /* Loads all meshes and textures, allocates and sets uniforms, and creates the shared vertex buffer. The
+     * shader sources are read in the same batch as the assets */
+    SceneAssets assets;
+    {
+        JobSystem jobs;
+
+        assets = LoadSceneAssets(scene, opt, jobs, ShaderFiles());
+    }
+    CacheShaderSources(assets.prefetched);
+    assets.prefetched.clear();
+
+    // Every unique mesh is suballocated from one vertex buffer, so the whole scene shares a single VAO
+    std::vector<std::pair<GLuint, GLuint>> mesh_ranges;
+    VertexList loaded_vertices = ConcatenateMeshes(assets, mesh_ranges);
+    MemoryTag loaded_memory(MemoryCategory::cpu_vertex_list, loaded_vertices.capacity() * sizeof(Vertex));
+
+    std::vector<unsigned int> material_of;
+
+    SceneParams params;
+
+    params.materials = CreateMaterials(assets, allow_bindless, light_color, material_of);
+
+    // One indirect command per instance; the base instance tells the shaders which instance it is
+    for (unsigned int i = 0; i < scene.instances.size(); ++i) {
+        auto mesh = scene.instances[i].mesh;
+        auto [first, count] = mesh_ranges[assets.mesh_of[mesh]];
+
+        params.draws.push_back({count, 1, first, i});
+        params.instances.push_back({scene.instances[i].transform, material_of[mesh]});
+    }
+    params.indirect_handle = CreateIndirectBuffer(params.draws);
 
     // Uniforms initialized and set
-    auto transforms_handle = InitializeUniforms(model, scene_globals);
+    auto [transforms_handle, instances_handle, lighting_handle] = InitializeUniforms(params.instances,
+                                                                                     scene_globals);
 
     // Vertices initialized and set
     BufferParams buffer_tris = CreateVertexBuffer(loaded_vertices);
 
-    SceneParams params;
+    // Light list for the multi-light paths
+    params.lights_handle = InitializeLights(scene.lights, light_count, params.lights);
 
     // Used in main.cpp
     params.transforms_handle = transforms_handle;
+    params.instances_handle = instances_handle;
+    params.lighting_handle = lighting_handle;
     params.buffer_tris = std::move(buffer_tris);
     params.vertices_count_tris = loaded_vertices.size();
 
     return params;
 }
 
+GLuint CreateIndirectBuffer(const std::vector<DrawCommand> &draws) {
+    // Draw commands read by glMultiDrawArraysIndirect
+    // https://www.khronos.org/opengl/wiki/Vertex_Rendering#Indirect_rendering
+    GLuint indirect_buffer;
+
+    glGenBuffers(1, &indirect_buffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, draws.size() * sizeof(DrawCommand), draws.data(), GL_STATIC_DRAW);
+    TrackGlObject(GL_BUFFER, indirect_buffer, MemoryCategory::gpu_storage, draws.size() * sizeof(DrawCommand));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    return indirect_buffer;
+}
+
+void DrawScene(const SceneParams &scene_params, GLuint vao) {
+    // The scene as the camera sees it
+    DrawScene(scene_params, vao, scene_params.indirect_handle);
+}
+
+void DrawScene(const SceneParams &scene_params, GLuint vao, GLuint indirect_handle) {
+    // The whole scene in one call: per-instance matrices and materials are looked up in shader storage
+    glBindVertexArray(vao);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_handle);
+
+    glMultiDrawArraysIndirect(GL_TRIANGLES, nullptr, (GLsizei) scene_params.draws.size(), 0);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
 void SaveToFile(const WindowPtr &window) {
     // https://lencerf.github.io/post/2019-09-21-save-the-opengl-rendering-to-image-file/
     int width, height;
@@ -552,51 +849,184 @@ void SaveToFile(const WindowPtr &window) {
 
     ImageLoader::WriteImageFile(output_filename, width, height, nr_channels,
                                 stride, std::move(buffer));
+
+    // struggled to clean exit via glfw in the main loop; this isn't great but works
+    exit(EXIT_SUCCESS);
 }
 
 InputOptions ParseArgs(const int &argc, char *argv[]) {
-    // Reads command line arguments
+    // Reads command line arguments; the model comes first, followed by any number of extras
     InputOptions input_opts;
 
     ModelChoice model_choice = ModelChoice::dragon_obj;  // the default model
-    std::optional<ShadingOption> shade_opt = std::nullopt;
-    bool save_image_bool = false;
 
-    if (argc == 1) {
-        model_choice = ModelChoice::dragon_obj;
-    } else if (argc >= 2) {
+    if (argc >= 2) {
         auto model_choice_str = std::string(argv[1]);
 
-        if (model_choice_str == dragon_model_str) {
+        if (model_choice_str.starts_with(scene_str)) {
+            input_opts.scene_file = model_choice_str.substr(scene_str.size());
+        } else if (model_choice_str.starts_with(stream_str)) {
+            input_opts.stream_file = model_choice_str.substr(stream_str.size());
+        } else if (model_choice_str == dragon_model_str) {
             model_choice = ModelChoice::dragon_obj;
         } else if (model_choice_str == dragon_model_off_str) {
             model_choice = ModelChoice::dragon_off;
         } else if (model_choice_str == bunny_model_str) {
             model_choice = ModelChoice::bunny_off;
         } else {
-            std::cout << "Invalid model choice, try 'dragon' 'dragon_off' 'bunny'";
+            std::cout << "Invalid model choice, try 'dragon' 'dragon_off' 'bunny' 'scene=path' 'stream=path'";
 
             exit(1);
         }
     }
-    if (argc == 3) {
-        auto extras = std::string(argv[2]);
+    for (int i = 2; i < argc; ++i) {
+        auto extras = std::string(argv[i]);
 
         if (extras == save_to_image_str) {
-            save_image_bool = true;
+            input_opts.save_image = true;
         } else if (extras == flat_str) {
-            shade_opt = ShadingOption::flat;
+            input_opts.opt = ShadingOption::flat;
         } else if (extras == wireframe_str) {
-            shade_opt = ShadingOption::wireframe;
+            input_opts.opt = ShadingOption::wireframe;
+        } else if (extras == points_str) {
+            input_opts.opt = ShadingOption::point_splats;
+        } else if (extras == deferred_str) {
+            input_opts.render_path = RenderPath::deferred_shading;
+        } else if (extras.starts_with(lights_str)) {
+            input_opts.light_count = ParseCount(extras.substr(lights_str.size()), extras);
+        } else if (extras.starts_with(stress_str)) {
+            input_opts.light_count = ParseCount(extras.substr(stress_str.size()), extras);
+            input_opts.stress = true;
+        } else if (extras == prepass_str) {
+            input_opts.depth_prepass = true;
+        } else if (extras == overdraw_str) {
+            input_opts.overdraw = true;
+        } else if (extras == on_demand_str) {
+            input_opts.on_demand = true;
+        } else if (extras == threaded_str) {
+            input_opts.threaded = true;
+        } else if (extras.starts_with(scene_str)) {
+            input_opts.scene_file = extras.substr(scene_str.size());
+        } else if (extras == no_bindless_str) {
+            input_opts.bindless = false;
+        } else if (extras == shadows_str) {
+            input_opts.shadows = true;
+        } else if (extras.starts_with(antialiasing_str)) {
+            input_opts.antialiasing = ParseAntialiasingMode(extras.substr(antialiasing_str.size()), extras);
+        } else if (extras == antialiasing_benchmark_str) {
+            input_opts.antialiasing_benchmark = true;
+        } else if (extras.starts_with(dynamic_resolution_str)) {
+            input_opts.dynamic_resolution_ms = ParseCount(extras.substr(dynamic_resolution_str.size()), extras);
+        } else if (extras == upscale_bilinear_str) {
+            input_opts.edge_aware_upscale = false;
+        } else if (extras == upscale_edge_str) {
+            input_opts.edge_aware_upscale = true;
+        } else if (extras.starts_with(stream_str)) {
+            input_opts.stream_file = extras.substr(stream_str.size());
+        } else if (extras.starts_with(stream_budget_str)) {
+            input_opts.stream_budget_mb = ParseCount(extras.substr(stream_budget_str.size()), extras);
+        } else if (extras == vertex_pulling_str) {
+            input_opts.vertex_pulling = true;
+        } else if (extras == pulling_benchmark_str) {
+            input_opts.pulling_benchmark = true;
+        } else if (extras.starts_with(impostors_str)) {
+            input_opts.impostor_pixels = ParseCount(extras.substr(impostors_str.size()), extras);
+        } else if (extras.starts_with(deform_str)) {
+            input_opts.deformation = ParseDeformationMode(extras.substr(deform_str.size()), extras);
+        } else if (extras.starts_with(ambient_occlusion_str)) {
+            input_opts.ao_rays = ParseCount(extras.substr(ambient_occlusion_str.size()), extras);
+        } else if (extras == camera_benchmark_str) {
+            input_opts.camera_benchmark = true;
+        } else if (extras.starts_with(camera_path_str)) {
+            input_opts.camera_benchmark = true;
+            input_opts.camera_path_file = extras.substr(camera_path_str.size());
+        } else if (extras.starts_with(record_path_str)) {
+            input_opts.record_file = extras.substr(record_path_str.size());
+        } else if (extras.starts_with(benchmark_report_str)) {
+            input_opts.report_file = extras.substr(benchmark_report_str.size());
+        } else if (extras == memory_report_str) {
+            input_opts.memory_report = true;
+        } else if (extras.starts_with(cpu_budget_str)) {
+            input_opts.cpu_budget_mb = ParseCount(extras.substr(cpu_budget_str.size()), extras);
+        } else if (extras.starts_with(gpu_budget_str)) {
+            input_opts.gpu_budget_mb = ParseCount(extras.substr(gpu_budget_str.size()), extras);
         } else {
-            std::cout << "Invalid option, try 'image' 'flat' 'wireframe'";
+            std::cout << "Invalid option, try 'image' 'flat' 'wireframe' 'points' 'deferred' 'lights=N' 'stress=N' "
+                         "'prepass' 'overdraw' 'ondemand' 'threaded' 'scene=path' 'nobindless' 'shadows'"
+                         " 'aa=off|msaa2|msaa4|msaa8|fxaa|taa' 'aabench' 'dynres=MS' 'upscale=bilinear|edge'"
+                         " 'stream=path' 'budget=MB' 'pulling' 'pullbench'"
+                         " 'impostors=PX' 'deform=off|morph|wave|twist' 'ao=N'"
+                         " 'campath' 'campath=path' 'record=path' 'report=path'"
+                         " 'memory' 'cpubudget=MB' 'gpubudget=MB'";
 
             exit(1);
         }
     }
     input_opts.model = model_choice;
-    input_opts.opt = shade_opt;
-    input_opts.save_image = save_image_bool;
 
     return input_opts;
 }
+
+AntialiasingMode ParseAntialiasingMode(const std::string &value, const std::string &option) {
+    // Parses the mode of 'aa=name'
+    for (std::size_t i = 0; i < std::size(antialiasing_names); ++i) {
+        if (value == antialiasing_names[i]) {
+            return (AntialiasingMode) i;
+        }
+    }
+    std::cout << "Invalid value in '" << option << "', expected one of 'off' 'msaa2' 'msaa4' 'msaa8' 'fxaa' 'taa'";
+
+    exit(1);
+}
+
+DeformationMode ParseDeformationMode(const std::string &value, const std::string &option) {
+    // Parses the mode of 'deform=name'
+    for (std::size_t i = 0; i < std::size(deformation_names); ++i) {
+        if (value == deformation_names[i]) {
+            return (DeformationMode) i;
+        }
+    }
+    std::cout << "Invalid value in '" << option << "', expected one of 'off' 'morph' 'wave' 'twist'";
+
+    exit(1);
+}
+
+std::string ModelName(ModelChoice model) {
+    // Name of a built-in model, as given on the command line
+    if (model == ModelChoice::dragon_off) {
+        return dragon_model_off_str;
+    } else if (model == ModelChoice::bunny_off) {
+        return bunny_model_str;
+    }
+    return dragon_model_str;
+}
+
+std::string ShadingName(ShadingOption opt) {
+    // Name of a shading option in reports
+    if (opt == ShadingOption::normal_mapping) {
+        return "normal_mapping";
+    } else if (opt == ShadingOption::flat) {
+        return flat_str;
+    } else if (opt == ShadingOption::wireframe) {
+        return wireframe_str;
+    } else if (opt == ShadingOption::point_splats) {
+        return points_str;
+    }
+    return "gouraud";
+}
+
+unsigned int ParseCount(const std::string &value, const std::string &option) {
+    // Parses the positive integer of a 'name=N' option
+    try {
+        auto count = std::stoi(value);
+
+        if (count > 0) {
+            return count;
+        }
+    } catch (const std::logic_error &) {
+        // handled below
+    }
+    std::cout << "Invalid value in '" << option << "', expected a positive integer";
+
+    exit(1);
+}
@@ -8,7 +8,9 @@
 #include <iostream>
 #include <filesystem>
 #include <vector>
+#include <map>
 #include <memory>
+#include <tuple>
 
 /* OpenGL headers */
 #include <glad/glad.h>
@@ -22,18 +24,53 @@
 #include "attributes.h"
 #include "../load-utils/load_utils.h"
 #include "../load-utils/image.h"
+#include "../load-utils/scene_file.h"
+#include "../load-utils/asset_manager.h"
+#include "lights.h"
+#include "materials.h"
+#include "job_system.h"
+#include "memory_tracker.h"
 
 using VertexListPtr = std::unique_ptr<Vertex[]>;
 using BufferHandle = GLuint;
 
 struct InputOptions {
     ModelChoice model = ModelChoice::dragon_obj;
+    std::string scene_file;  // replaces the model if set
+    std::string stream_file;  // paged mesh (.dmo), streamed instead of loaded; replaces the model if set
+    unsigned int stream_budget_mb = 256;  // GPU vertex buffer of the streamed mesh
     std::optional<ShadingOption> opt;
     bool save_image = false;
+    RenderPath render_path = RenderPath::forward_shading;
+    unsigned int light_count = 1;
+    bool stress = false;
+    bool depth_prepass = false;
+    bool overdraw = false;
+    bool on_demand = false;
+    bool threaded = false;
+    bool shadows = false;
+    AntialiasingMode antialiasing = AntialiasingMode::msaa_8x;
+    bool antialiasing_benchmark = false;  // cycles through every mode, then exits
+    unsigned int dynamic_resolution_ms = 0;  // GPU budget of the main pass; 0 renders at the window size
+    bool edge_aware_upscale = false;
+    bool bindless = true;  // use bindless textures if the driver has them
+    bool vertex_pulling = false;  // vertex shaders read storage buffers instead of attributes
+    bool pulling_benchmark = false;  // alternates attributes and vertex pulling, then exits
+    unsigned int impostor_pixels = 0;  // instances smaller on screen are drawn as impostors; 0 never
+    DeformationMode deformation = DeformationMode::no_deform;  // animated by compute passes every frame
+    unsigned int ao_rays = 0;  // rays per vertex of the baked ambient occlusion; 0 none
+    bool camera_benchmark = false;  // replays a camera path, then exits
+    std::string camera_path_file;   // the built-in path if empty
+    std::string record_file;        // the views of the session are saved there as a camera path
+    std::string report_file;        // benchmark report, appended to
+    bool memory_report = false;     // prints live and peak memory per category at exit
+    unsigned int cpu_budget_mb = 0;  // warns above; 0 none
+    unsigned int gpu_budget_mb = 0;
 };
 
 struct BufferParams {
     GLuint vao;
+    GLuint vbo;  // interleaved vertices; rewritten by the deformation passes
     VertexListPtr vertex_list;
 };
 
@@ -41,10 +78,38 @@ struct ShaderParams {
     GLuint program;
 };
 
+// A placed mesh and its material
+struct SceneInstance {
+    GlmMat4 transform;  // model space -> world space, before user rotation
+    unsigned int material;
+};
+
+// Layout defined by glMultiDrawArraysIndirect (DrawArraysIndirectCommand)
+struct DrawCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first;
+    GLuint base_instance;  // the scene instance; read by shaders as gl_BaseInstance
+};
+
+// Contents of the Matrices uniform block and the instance buffer
+struct SceneTransforms {
+    TransformBlock camera;
+    std::vector<InstanceBlock> instances;
+};
+
 struct SceneParams {
-    BufferParams buffer_tris;
+    BufferParams buffer_tris;  // all meshes of the scene, back to back
     BufferHandle transforms_handle;
+    BufferHandle instances_handle;
+    BufferHandle lighting_handle;
+    BufferHandle lights_handle;
+    BufferHandle indirect_handle;
+    LightList lights;
     unsigned int vertices_count_tris;
+    std::vector<SceneInstance> instances;
+    std::vector<DrawCommand> draws;  // one per instance
+    MaterialParams materials;
 };
 
 struct DestroyGLFWindow{
@@ -63,6 +128,47 @@ const std::string bunny_model_str = "bunny";
 const std::string save_to_image_str = "image";
 const std::string flat_str = "flat";
 const std::string wireframe_str = "wireframe";
+const std::string points_str = "points";
+const std::string deferred_str = "deferred";
+const std::string lights_str = "lights=";
+const std::string stress_str = "stress=";
+const std::string prepass_str = "prepass";
+const std::string overdraw_str = "overdraw";
+const std::string on_demand_str = "ondemand";
+const std::string threaded_str = "threaded";
+const std::string scene_str = "scene=";
+const std::string no_bindless_str = "nobindless";
+const std::string shadows_str = "shadows";
+const std::string antialiasing_str = "aa=";
+const std::string antialiasing_benchmark_str = "aabench";
+const std::string dynamic_resolution_str = "dynres=";
+const std::string upscale_bilinear_str = "upscale=bilinear";
+const std::string upscale_edge_str = "upscale=edge";
+const std::string stream_str = "stream=";
+const std::string stream_budget_str = "budget=";
+const std::string vertex_pulling_str = "pulling";
+const std::string pulling_benchmark_str = "pullbench";
+const std::string impostors_str = "impostors=";
+const std::string deform_str = "deform=";
+const std::string ambient_occlusion_str = "ao=";
+const std::string camera_benchmark_str = "campath";
+const std::string camera_path_str = "campath=";
+const std::string record_path_str = "record=";
+const std::string benchmark_report_str = "report=";
+const std::string memory_report_str = "memory";
+const std::string cpu_budget_str = "cpubudget=";
+const std::string gpu_budget_str = "gpubudget=";
+
+// Every built-in model and shading option, eg. for the regression and benchmark runs
+const ModelChoice builtin_models[] = {ModelChoice::dragon_obj, ModelChoice::dragon_off, ModelChoice::bunny_off};
+const ShadingOption shading_options[] = {ShadingOption::per_vertex, ShadingOption::normal_mapping,
+                                         ShadingOption::flat, ShadingOption::wireframe};
+
+// Values of 'aa=', in AntialiasingMode order
+const std::string antialiasing_names[] = {"off", "msaa2", "msaa4", "msaa8", "fxaa", "taa"};
+
+// Values of 'deform=', in DeformationMode order
+const std::string deformation_names[] = {"off", "morph", "wave", "twist"};
 
 // Camera
 const VecPosition eye_pos(0,0,3);
@@ -71,11 +177,15 @@ const VecDirection gaze_dir(0,0,-1);
 
 // Lighting
 const VecColor light_color(.3f, .45f, .3f);
+const VecColor clear_color(.2f, .2f, .2f);
 
-// Perspective
+// Perspective; reverse-Z with an infinite far plane: window depth is near / distance, 1 at the near plane
+// and 0 at infinity, in a 32-bit float buffer
 const float fov_initial = 45.0;
 const float near_plane = 0.1;
-const float far_plane = 10.0f;
+const float far_plane = 10.0f;  // the projection has no far plane; this bounds the light clusters only
+const GLenum depth_func = GL_GREATER;  // nearer is greater
+const double depth_clear = 0.0;
 
 // Initial Window size
 const unsigned int width_init = 1000;
@@ -85,18 +195,12 @@ const unsigned int height_init = 1000;
 const double zoom_tick = .09;
 const float rotation_tick = 1.35f;
 
-// Texture names
-const std::string color_texture_name = "diffuseMap";
-const std::string normal_texture_name = "normalMap";
-
 // Shader error log size
 const short shader_log_buffer_size = 512;
 
-// Antialiasing
-const short antialiasing_subsamples = 8;
-
 // these fields can be changed through user input
-// in a game, this would probably be behind a semaphore
+// only the thread running the GLFW callbacks touches them; with 'threaded' the render thread
+// receives copies through a triple buffer (see threading.h)
 struct SceneGlobals {
     unsigned int width = width_init;
     unsigned int height = height_init;
@@ -104,38 +208,72 @@ struct SceneGlobals {
     float rotate_y = 0.0;  // degrees
     float fov = fov_initial;
 
+    double pick_x = 0.0;  // framebuffer pixels, y down
+    double pick_y = 0.0;
+
     volatile bool dirty_ = false;
+    volatile bool redraw_ = true;  // set when the window must be redrawn, eg. after being exposed
+    volatile bool pick_ = false;   // set on left click; the main loop picks the face under the cursor
 };
 
 static void ErrorCallback([[maybe_unused]] int error, const char* description);
 static void ScrollCallback([[maybe_unused]] GLFWwindow* window, [[maybe_unused]] double xoffset, double yoffset);
 static void FrameBufferSizeCallback([[maybe_unused]] GLFWwindow* window, int width, int height);
+static void RefreshCallback(GLFWwindow* window);
 static void InputCallback(GLFWwindow* window, int key, [[maybe_unused]] int scancode,
                           [[maybe_unused]] int action, [[maybe_unused]] int mods);
+static void MouseButtonCallback(GLFWwindow* window, int button, int action, [[maybe_unused]] int mods);
 
 void SetResizeCallback(const WindowPtr &window_ptr);
 
 GlmVec4 GetLightPosition(ModelChoice model);
-GlmMat4 GetWorldSpaceMatrix(ModelChoice model, const SceneGlobals &scene_globals);
+GlmMat4 GetModelTransform(ModelChoice model);
+GlmMat4 GetWorldSpaceMatrix(const GlmMat4 &instance_transform, const SceneGlobals &scene_globals);
 GlmMat4 GetViewMatrix();
-GlmMat4 GetPerspectiveMatrix(double fov, double aspect_ratio, double near, double far);
+GlmMat4 GetPerspectiveMatrix(double fov, double aspect_ratio, double near);
 GlmMat4 GetNormalUpdateMatrix(const GlmMat4 &model_view);
 
+unsigned int CreateTexture(const unsigned char *data, int width, int height, int components);
 unsigned int LoadTexture(const std::string &filename);
 
 WindowPtr InitializeWindow(int width, int height, const std::string& title, SceneGlobals &scene_globals);
-GLuint InitTransformUniforms(ModelChoice model, const SceneGlobals &scene_globals);
-void InitLightingUniforms(ModelChoice model);
-BufferHandle InitializeUniforms(ModelChoice model, SceneGlobals &scene_globals);
-void UpdateTransformUniforms(const BufferHandle &ubo_matrices, ModelChoice model, const SceneGlobals &scene_globals);
+GLuint InitTransformUniforms();
+GLuint InitInstanceBuffer(std::size_t instance_count);
+GLuint InitLightingUniforms(const SceneGlobals &scene_globals);
+void UpdateLightingUniforms(const BufferHandle &ubo_lighting, const SceneGlobals &scene_globals);
+std::tuple<BufferHandle, BufferHandle, BufferHandle> InitializeUniforms(const std::vector<SceneInstance> &instances,
+                                                                        SceneGlobals &scene_globals);
+LightList CreateLightList(const LightList &scene_lights, unsigned int light_count);
+BufferHandle InitializeLights(const LightList &scene_lights, unsigned int light_count, LightList &lights);
+SceneTransforms ComputeTransforms(const std::vector<SceneInstance> &instances, const SceneGlobals &scene_globals);
+void UploadTransformUniforms(const BufferHandle &ubo_matrices, const BufferHandle &instance_buffer,
+                             const SceneTransforms &transforms);
+void UpdateTransformUniforms(const SceneParams &scene_params, const SceneGlobals &scene_globals);
 
+void SetVertexLayout();
+GLuint EmptyVertexArray();
 BufferParams CreateVertexBuffer(const std::vector<Vertex>& vertices);
-GLuint CompileShader(const std::string& path, GLenum shader_type);
-std::pair<unsigned int, unsigned int> CreateTextures();
-ShaderParams CreateShaderProgram(const std::string& vertex_shader_path, const std::string& fragment_shader_path);
-SceneParams CreateScene(ModelChoice model, ShadingOption opt, SceneGlobals &scene_globals);
+std::vector<std::string> ShaderFiles();
+void CacheShaderSources(const std::map<std::string, ByteList> &files);
+GLuint CompileShader(const std::string& path, GLenum shader_type, const std::string& defines = "");
+ShaderParams CreateShaderProgram(const std::string& vertex_shader_path, const std::string& fragment_shader_path,
+                                 const std::string& defines = "");
+ShaderParams CreateComputeProgram(const std::string& compute_shader_path, const std::string& defines = "");
+void CheckProgramLinked(GLuint shader_program);
+SceneDescription BuiltinScene(ModelChoice model);
+VertexList ConcatenateMeshes(SceneAssets &assets, std::vector<std::pair<GLuint, GLuint>> &mesh_ranges);
+SceneParams CreateScene(const SceneDescription &scene, ShadingOption opt, unsigned int light_count,
+                        bool allow_bindless, SceneGlobals &scene_globals);
+GLuint CreateIndirectBuffer(const std::vector<DrawCommand> &draws);
+void DrawScene(const SceneParams &scene_params, GLuint vao);
+void DrawScene(const SceneParams &scene_params, GLuint vao, GLuint indirect_handle);
 
 void SaveToFile(const WindowPtr &window);
 InputOptions ParseArgs(const int &argc, char* argv[]);
+AntialiasingMode ParseAntialiasingMode(const std::string &value, const std::string &option);
+DeformationMode ParseDeformationMode(const std::string &value, const std::string &option);
+std::string ModelName(ModelChoice model);
+std::string ShadingName(ShadingOption opt);
+unsigned int ParseCount(const std::string &value, const std::string &option);
 
 #endif
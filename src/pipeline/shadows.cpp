@@ -0,0 +1,205 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "shadows.h"
+
+ShadowParams CreateShadows(const Vertex *vertices, unsigned int count, const std::vector<DrawCommand> &draws) {
+    // Depth texture and framebuffer, the light's uniform blocks, and draw bounds (the vertex list is freed later)
+    ShadowParams shadows;
+
+    shadows.positions = CreatePositionBuffer(vertices, count);
+    shadows.depth_program = CreateShaderProgram(depth_dir + "/vertex.glsl", depth_dir + "/fragment.glsl");
+
+    for (const auto &draw: draws) {
+        GlmVec3 lo(std::numeric_limits<float>::max());
+        GlmVec3 hi(std::numeric_limits<float>::lowest());
+
+        for (GLuint i = draw.first; i < draw.first + draw.count; ++i) {
+            lo = glm::min(lo, vertices[i].pos);
+            hi = glm::max(hi, vertices[i].pos);
+        }
+
+        auto center = draw.count ? 0.5f * (lo + hi) : GlmVec3(0.0f);
+        auto radius = 0.0f;
+
+        for (GLuint i = draw.first; i < draw.first + draw.count; ++i) {
+            radius = std::max(radius, glm::length(vertices[i].pos - center));
+        }
+        shadows.bounds.emplace_back(center, radius);
+    }
+    shadows.indirect_handle = CreateIndirectBuffer(draws);
+
+    // Comparison sampling gives bilinear filtered visibility per tap
+    glGenTextures(1, &shadows.depth_texture);
+    glBindTexture(GL_TEXTURE_2D, shadows.depth_texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, shadow_map_size, shadow_map_size);
+    TrackGlObject(GL_TEXTURE, shadows.depth_texture, MemoryCategory::gpu_targets,
+                  TextureBytes(shadow_map_size, shadow_map_size, 1, 1, sizeof(float)));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_GEQUAL);  // reverse-Z: lit if not farther
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &shadows.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, shadows.fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, shadows.depth_texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Shadow map framebuffer is incomplete" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &shadows.camera_handle);
+    glBindBuffer(GL_UNIFORM_BUFFER, shadows.camera_handle);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(TransformBlock), nullptr, GL_DYNAMIC_DRAW);
+    TrackGlObject(GL_BUFFER, shadows.camera_handle, MemoryCategory::gpu_uniforms, sizeof(TransformBlock));
+
+    glGenBuffers(1, &shadows.shadow_handle);
+    glBindBuffer(GL_UNIFORM_BUFFER, shadows.shadow_handle);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowBlock), nullptr, GL_DYNAMIC_DRAW);
+    TrackGlObject(GL_BUFFER, shadows.shadow_handle, MemoryCategory::gpu_uniforms, sizeof(ShadowBlock));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    return shadows;
+}
+
+GlmVec4 GetSceneBounds(const ShadowParams &shadows, const SceneParams &scene_params,
+                       const SceneTransforms &transforms) {
+    // Sphere around the draw bounds moved into world space (xyz: center, w: radius)
+    GlmVec3 lo(std::numeric_limits<float>::max());
+    GlmVec3 hi(std::numeric_limits<float>::lowest());
+    std::vector<GlmVec4> spheres;
+
+    for (std::size_t i = 0; i < scene_params.draws.size(); ++i) {
+        const auto &world = transforms.instances[scene_params.draws[i].base_instance].world;
+        auto scale = std::max({glm::length(GlmVec3(world[0])), glm::length(GlmVec3(world[1])),
+                               glm::length(GlmVec3(world[2]))});
+        auto center = GlmVec3(world * GlmVec4(GlmVec3(shadows.bounds[i]), 1.0f));
+        auto radius = scale * shadows.bounds[i].w;
+
+        lo = glm::min(lo, center - radius);
+        hi = glm::max(hi, center + radius);
+        spheres.emplace_back(center, radius);
+    }
+
+    if (spheres.empty()) {
+        return GlmVec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+
+    auto center = 0.5f * (lo + hi);
+    auto radius = 0.0f;
+
+    for (const auto &sphere: spheres) {
+        radius = std::max(radius, glm::length(GlmVec3(sphere) - center) + sphere.w);
+    }
+
+    return {center, radius};
+}
+
+ShadowBlock ComputeShadowCamera(const GlmVec3 &light_pos, const GlmVec4 &bounds, TransformBlock &camera) {
+    // Perspective from the light, just wide enough for the bounding sphere; the near plane sits at its front
+    auto to_center = GlmVec3(bounds) - light_pos;
+    auto distance = std::max(glm::length(to_center), shadow_near_min);
+    auto direction = to_center / distance;
+    auto up = std::abs(direction.y) > 0.99f ? GlmVec3(1.0f, 0.0f, 0.0f) : GlmVec3(0.0f, 1.0f, 0.0f);
+
+    // A light inside the sphere gets the widest field of view the map can take
+    auto fov = distance > bounds.w ? 2.0f * std::asin(bounds.w / distance) : shadow_fov_max;
+    fov = std::min(fov, shadow_fov_max);
+
+    camera.view = glm::lookAt(light_pos, light_pos + direction, up);
+    camera.projection = GetPerspectiveMatrix(fov, 1.0, std::max(distance - bounds.w, shadow_near_min));
+
+    // Clip xy [-1, 1] -> texture coordinates [0, 1]; depth is already in [0, 1]
+    GlmMat4 to_texture(1.0f);
+
+    to_texture[0][0] = 0.5f;
+    to_texture[1][1] = 0.5f;
+    to_texture[3][0] = 0.5f;
+    to_texture[3][1] = 0.5f;
+
+    ShadowBlock block;
+
+    block.shadow_from_world = to_texture * camera.projection * camera.view;
+    block.params = GlmVec4(shadow_normal_offset_texels * 2.0f * std::tan(fov / 2.0f) / (float) shadow_map_size,
+                           shadow_depth_bias, 1.0f / (float) shadow_map_size, 0.0f);
+
+    return block;
+}
+
+bool ShadowsOutdated(const ShadowParams &shadows, const SceneParams &scene_params,
+                     const SceneGlobals &scene_globals) {
+    // True if the model rotated or the key light moved since the map was drawn; a few compares per frame
+    return !shadows.valid || shadows.rotate_x != scene_globals.rotate_x || shadows.rotate_y != scene_globals.rotate_y ||
+           shadows.light_pos != GlmVec3(scene_params.lights[0].position);
+}
+
+void RenderShadows(ShadowParams &shadows, const SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Fits the light camera to the rotated scene and draws the depth map
+    auto light_pos = GlmVec3(scene_params.lights[0].position);
+
+    shadows.valid = true;
+    shadows.rotate_x = scene_globals.rotate_x;
+    shadows.rotate_y = scene_globals.rotate_y;
+    shadows.light_pos = light_pos;
+    shadows.renders++;
+
+    auto transforms = ComputeTransforms(scene_params.instances, scene_globals);
+    auto bounds = GetSceneBounds(shadows, scene_params, transforms);
+
+    TransformBlock camera{};
+    auto block = ComputeShadowCamera(light_pos, bounds, camera);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, shadows.camera_handle);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(TransformBlock), &camera);
+    glBindBuffer(GL_UNIFORM_BUFFER, shadows.shadow_handle);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShadowBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Depth only, from the light; the instance buffer already holds the same world matrices
+    GLint current_program;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, shadows.fbo);
+    glViewport(0, 0, shadow_map_size, shadow_map_size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(shadow_offset_factor, shadow_offset_units);
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, shadows.camera_handle, 0, sizeof(TransformBlock));
+    glUseProgram(shadows.depth_program.program);
+    DrawScene(scene_params, shadows.positions.vao, shadows.indirect_handle);
+
+    // Back to the camera
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, scene_params.transforms_handle, 0, sizeof(TransformBlock));
+    glUseProgram(current_program);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, (GLsizei) scene_globals.width, (GLsizei) scene_globals.height);
+}
+
+void BindShadows(const ShadowParams &shadows) {
+    // The map and its transform stay bound; only their contents change
+    glActiveTexture(GL_TEXTURE0 + shadow_map_unit);
+    glBindTexture(GL_TEXTURE_2D, shadows.depth_texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, shadow_block_binding, shadows.shadow_handle);
+}
+
+void SetShadowSampler(GLuint program) {
+    // Points the shadowMap sampler at its unit
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, shadow_map_name.c_str()), (GLint) shadow_map_unit);
+}
@@ -0,0 +1,76 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_SHADOWS_H
+#define DRAGON_GL_SHADOWS_H
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+#include "prepass.h"
+
+// Uniform binding of the Shadow block and the unit of the shadow map (materials use 6 to 13)
+const GLuint shadow_block_binding = 7;
+const GLuint shadow_map_unit = 14;
+const std::string shadow_map_name = "shadowMap";
+
+// Prepended (after #version) to the gouraud and normal mapping shaders if shadows are on
+const std::string shadow_shader_defines = "#define SHADOWS\n";
+
+// Depth map of the key light; a single perspective map, fitted to the bounding sphere of the scene
+const unsigned int shadow_map_size = 2048;
+const float shadow_fov_max = glm::radians(150.0f);
+const float shadow_near_min = 0.01f;
+
+// Receivers are pushed out along their normal by this many shadow map texels (world size at their distance),
+// and compare against the map with a relative depth bias
+const float shadow_normal_offset_texels = 1.5f;
+const float shadow_depth_bias = 0.002f;
+
+// Slope scaled offset of the shadow pass; negative pushes occluders away from the light with reverse-Z
+const float shadow_offset_factor = -1.5f;
+const float shadow_offset_units = -2.0f;
+
+// Shadow uniform block (std140)
+struct ShadowBlock {
+    GlmMat4 shadow_from_world;  // world space -> shadow map texture coordinates and depth (before the divide)
+    GlmVec4 params;             // x: normal offset per unit of light distance, y: depth bias, z: 1 / map size
+};
+
+struct ShadowParams {
+    PositionBufferParams positions;
+    GLuint indirect_handle = 0;  // every draw; the camera's commands may leave out instances drawn as impostors
+    ShaderParams depth_program{};
+    GLuint fbo = 0;
+    GLuint depth_texture = 0;    // DEPTH_COMPONENT32F with depth comparison
+    GLuint camera_handle = 0;    // Matrices block of the light, bound in place of the camera while drawing
+    GLuint shadow_handle = 0;    // ShadowBlock
+    std::vector<GlmVec4> bounds;  // bounding sphere of each draw in model space (xyz: center, w: radius)
+
+    // What the map was rendered for; nothing is drawn while these stay the same
+    bool valid = false;
+    float rotate_x = 0.0f;
+    float rotate_y = 0.0f;
+    GlmVec3 light_pos{0.0f};
+    unsigned int renders = 0;
+};
+
+ShadowParams CreateShadows(const Vertex *vertices, unsigned int count, const std::vector<DrawCommand> &draws);
+GlmVec4 GetSceneBounds(const ShadowParams &shadows, const SceneParams &scene_params,
+                       const SceneTransforms &transforms);
+ShadowBlock ComputeShadowCamera(const GlmVec3 &light_pos, const GlmVec4 &bounds, TransformBlock &camera);
+bool ShadowsOutdated(const ShadowParams &shadows, const SceneParams &scene_params,
+                     const SceneGlobals &scene_globals);
+void RenderShadows(ShadowParams &shadows, const SceneParams &scene_params, const SceneGlobals &scene_globals);
+void BindShadows(const ShadowParams &shadows);
+void SetShadowSampler(GLuint program);
+
+#endif // DRAGON_GL_SHADOWS_H
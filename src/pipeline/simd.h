@@ -0,0 +1,106 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_SIMD_H
+#define DRAGON_GL_SIMD_H
+
+#include <algorithm>
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#define DRAGON_GL_SSE
+#endif
+
+/* 4 lanes of floats for the CPU-side geometry code (BVH, software rasterizer); SSE when available,
+ * plain arrays otherwise. Masks are lane bitfields (bit i set if lane i passed) */
+#ifdef DRAGON_GL_SSE
+struct Float4 {
+    __m128 v;
+
+    static Float4 Load(const float *p) { return {_mm_load_ps(p)}; }
+    // Lane 3 cleared; structs often keep integers there, which would otherwise be slow denormals
+    static Float4 LoadXYZ(const float *p) {
+        return {_mm_and_ps(_mm_load_ps(p), _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0)))};
+    }
+    static Float4 Set(float s) { return {_mm_set1_ps(s)}; }
+    static Float4 Set(float x, float y, float z, float w) { return {_mm_setr_ps(x, y, z, w)}; }
+
+    Float4 operator+(Float4 o) const { return {_mm_add_ps(v, o.v)}; }
+    Float4 operator-(Float4 o) const { return {_mm_sub_ps(v, o.v)}; }
+    Float4 operator*(Float4 o) const { return {_mm_mul_ps(v, o.v)}; }
+    Float4 operator/(Float4 o) const { return {_mm_div_ps(v, o.v)}; }
+
+    void Store(float *p) const { _mm_storeu_ps(p, v); }
+};
+
+inline Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+
+// NaN lanes compare false
+inline int GreaterEqual(Float4 a, Float4 b) { return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v)); }
+inline int Greater(Float4 a, Float4 b) { return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v)); }
+inline int Equal(Float4 a, Float4 b) { return _mm_movemask_ps(_mm_cmpeq_ps(a.v, b.v)); }
+inline int NotEqual(Float4 a, Float4 b) { return _mm_movemask_ps(_mm_cmpneq_ps(a.v, b.v)) &
+                                                 _mm_movemask_ps(_mm_cmpord_ps(a.v, b.v)); }
+
+inline float MaxXYZ(Float4 a) {
+    auto m = _mm_max_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1)));
+
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 1, 0, 2))));
+}
+
+inline float MinXYZ(Float4 a) {
+    auto m = _mm_min_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1)));
+
+    return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 1, 0, 2))));
+}
+#else
+struct Float4 {
+    std::array<float, 4> v;
+
+    static Float4 Load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+    static Float4 LoadXYZ(const float *p) { return {{p[0], p[1], p[2], 0.0f}}; }
+    static Float4 Set(float s) { return {{s, s, s, s}}; }
+    static Float4 Set(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+
+    template<typename Op>
+    Float4 Apply(Float4 o, Op op) const {
+        return {{op(v[0], o.v[0]), op(v[1], o.v[1]), op(v[2], o.v[2]), op(v[3], o.v[3])}};
+    }
+
+    Float4 operator+(Float4 o) const { return Apply(o, [](float a, float b) { return a + b; }); }
+    Float4 operator-(Float4 o) const { return Apply(o, [](float a, float b) { return a - b; }); }
+    Float4 operator*(Float4 o) const { return Apply(o, [](float a, float b) { return a * b; }); }
+    Float4 operator/(Float4 o) const { return Apply(o, [](float a, float b) { return a / b; }); }
+
+    void Store(float *p) const { std::copy(v.begin(), v.end(), p); }
+};
+
+// Same NaN behaviour as minps / maxps: the second operand wins
+inline Float4 Min(Float4 a, Float4 b) { return a.Apply(b, [](float x, float y) { return x < y ? x : y; }); }
+inline Float4 Max(Float4 a, Float4 b) { return a.Apply(b, [](float x, float y) { return x > y ? x : y; }); }
+
+template<typename Compare>
+inline int CompareMask(Float4 a, Float4 b, Compare compare) {
+    int mask = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        mask |= compare(a.v[i], b.v[i]) ? 1 << i : 0;
+    }
+    return mask;
+}
+
+inline int GreaterEqual(Float4 a, Float4 b) { return CompareMask(a, b, [](float x, float y) { return x >= y; }); }
+inline int Greater(Float4 a, Float4 b) { return CompareMask(a, b, [](float x, float y) { return x > y; }); }
+inline int Equal(Float4 a, Float4 b) { return CompareMask(a, b, [](float x, float y) { return x == y; }); }
+inline int NotEqual(Float4 a, Float4 b) {
+    return CompareMask(a, b, [](float x, float y) { return x == x && y == y && x != y; });
+}
+
+inline float MaxXYZ(Float4 a) { return std::max({a.v[0], a.v[1], a.v[2]}); }
+inline float MinXYZ(Float4 a) { return std::min({a.v[0], a.v[1], a.v[2]}); }
+#endif
+
+#endif // DRAGON_GL_SIMD_H
@@ -0,0 +1,330 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "streaming.h"
+
+namespace {
+    std::uint32_t FindSlot(const StreamingParams &streaming) {
+        // A free slot, else the one whose chunk was visible longest ago; never a slot visible this frame or
+        // still waiting for its chunk
+        auto found = stream_no_chunk;
+
+        for (std::uint32_t slot = 0; slot < streaming.slot_count; ++slot) {
+            auto chunk = streaming.slot_chunk[slot];
+
+            if (chunk == stream_no_chunk) {
+                return slot;
+            }
+            if (streaming.slot_visible[slot] == streaming.frame || streaming.residency[chunk] != chunk_resident) {
+                continue;
+            }
+            if (found == stream_no_chunk || streaming.slot_visible[slot] < streaming.slot_visible[found]) {
+                found = slot;
+            }
+        }
+        return found;
+    }
+
+    double Megabytes(std::uint64_t bytes) {
+        return (double) bytes / (1 << 20);
+    }
+}
+
+SceneDescription StreamedScene(const std::string &fname) {
+    // The paged mesh as a single-instance scene, centered and scaled to a fixed size; only the tables are read
+    auto mesh = ReadOctreeMesh(fname);
+    const auto &header = mesh.header;
+
+    GlmVec3 lo(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+    GlmVec3 hi(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+    auto extent = std::max({hi.x - lo.x, hi.y - lo.y, hi.z - lo.z});
+    auto scale = extent > 0.0f ? stream_model_extent / extent : 1.0f;
+
+    SceneDescription scene;
+    MeshDesc mesh_desc;
+
+    mesh_desc.name = std::filesystem::path(fname).stem().string();
+    mesh_desc.path = fname;
+
+    scene.meshes.push_back(mesh_desc);
+
+    InstanceDesc instance{};
+
+    instance.mesh = 0;
+    instance.transform = glm::translate(glm::scale(GlmMat4(1.0f), GlmVec3(scale)), -0.5f * (lo + hi));
+
+    scene.instances.push_back(instance);
+
+    PointLight key_light{};
+
+    key_light.position = GlmVec4(0.0f, 0.0f, stream_light_z, key_light_radius);
+    key_light.color = GlmVec4(light_color, 1.0f);
+
+    scene.lights.push_back(key_light);
+
+    return scene;
+}
+
+StreamingParams CreateStreaming(const std::string &fname, unsigned int budget_mb) {
+    // Reads the tables and allocates the fixed vertex buffer; no chunk is loaded until it is seen
+    StreamingParams streaming;
+
+    streaming.fname = fname;
+    streaming.mesh = ReadOctreeMesh(fname);
+
+    const auto &header = streaming.mesh.header;
+
+    streaming.slot_vertices = (std::size_t) header.chunk_triangles * 3;
+
+    auto slot_bytes = streaming.slot_vertices * sizeof(Vertex);
+    auto slots = ((std::size_t) budget_mb << 20) / slot_bytes;
+
+    if (slots == 0) {
+        std::cout << "A budget of " << budget_mb << " MB holds no chunk of " << fname << ", chunks take up to "
+                  << Megabytes(slot_bytes) << " MB" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+    // more slots than chunks would never be used
+    streaming.slot_count = (std::uint32_t) std::clamp<std::size_t>(slots, 1, header.chunk_count);
+
+    streaming.slot_chunk.assign(streaming.slot_count, stream_no_chunk);
+    streaming.slot_visible.assign(streaming.slot_count, 0);
+    streaming.residency.assign(header.chunk_count, chunk_absent);
+    streaming.chunk_slot.assign(header.chunk_count, stream_no_chunk);
+
+    // Immutable storage: the budget is allocated once and chunks are copied into their slots
+    glGenVertexArrays(1, &streaming.vao);
+    glBindVertexArray(streaming.vao);
+
+    glGenBuffers(1, &streaming.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, streaming.vbo);
+    glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr) (streaming.slot_count * slot_bytes), nullptr,
+                    GL_DYNAMIC_STORAGE_BIT);
+    TrackGlObject(GL_BUFFER, streaming.vbo, MemoryCategory::gpu_vertices, streaming.slot_count * slot_bytes);
+
+    SetVertexLayout();
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    streaming.loader = std::make_unique<JobSystem>(stream_loader_threads);
+
+    std::cout << "Streaming " << header.triangle_count << " triangles in " << header.chunk_count << " chunks from "
+              << fname << " through " << streaming.slot_count << " slots of " << Megabytes(slot_bytes) << " MB ("
+              << Megabytes(streaming.slot_count * slot_bytes) << " MB)" << std::endl;
+
+    return streaming;
+}
+
+void UploadFinishedChunks(StreamingParams &streaming) {
+    // Copies the chunks read since the last frame into their slots, up to a byte limit per frame
+    std::size_t uploaded = 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, streaming.vbo);
+
+    for (auto it = streaming.pending.begin(); it != streaming.pending.end();) {
+        if (uploaded >= stream_upload_bytes_max ||
+            it->vertices.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        auto vertices = it->vertices.get();
+        auto bytes = vertices.size() * sizeof(Vertex);
+
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) ((std::size_t) it->slot * streaming.slot_vertices * sizeof(Vertex)),
+                        (GLsizeiptr) bytes, vertices.data());
+
+        streaming.residency[it->chunk] = chunk_resident;
+        streaming.bytes_read += bytes;
+        uploaded += bytes;
+
+        it = streaming.pending.erase(it);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+std::vector<VisibleChunk> CullChunks(const StreamingParams &streaming, const SceneParams &scene_params,
+                                     const SceneGlobals &scene_globals) {
+    /* Walks the octree from the root, skipping nodes outside the frustum, and returns the chunks of the visible
+     * leaves ranked by projected size. Everything happens in model space: the planes come from the rows of the
+     * model -> clip matrix, and distances and radii scale alike, so their ratio needs no world matrix
+     * https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf */
+    auto transforms = ComputeTransforms(scene_params.instances, scene_globals);
+    auto model_view = transforms.camera.view * transforms.instances[0].world;
+    auto clip = transforms.camera.projection * model_view;
+
+    auto row = [&clip](int i) {
+        return GlmVec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+    };
+
+    // Left, right, bottom, top and near (reverse-Z: z_clip <= w_clip); the projection has no far plane
+    const GlmVec4 planes[] = {row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) - row(2)};
+
+    auto outside = [&planes](const float *bounds_min, const float *bounds_max) {
+        for (const auto &plane: planes) {
+            // the corner farthest along the plane normal
+            GlmVec3 corner(plane.x >= 0.0f ? bounds_max[0] : bounds_min[0],
+                           plane.y >= 0.0f ? bounds_max[1] : bounds_min[1],
+                           plane.z >= 0.0f ? bounds_max[2] : bounds_min[2]);
+
+            if (glm::dot(GlmVec3(plane), corner) + plane.w < 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    auto eye = GlmVec3(glm::inverse(model_view) * GlmVec4(0.0f, 0.0f, 0.0f, 1.0f));
+    auto pixels_per_unit = 0.5f * (float) scene_globals.height * transforms.camera.projection[1][1];
+
+    const auto &mesh = streaming.mesh;
+    std::vector<VisibleChunk> visible;
+    std::vector<std::uint32_t> stack = {0};
+
+    while (!stack.empty()) {
+        const auto &node = mesh.nodes[stack.back()];
+
+        stack.pop_back();
+
+        if (outside(node.bounds_min, node.bounds_max)) {
+            continue;
+        }
+        for (std::uint32_t i = 0; i < node.child_count; ++i) {
+            stack.push_back(node.first_child + i);
+        }
+        for (auto c = node.first_chunk; c < node.first_chunk + node.chunk_count; ++c) {
+            const auto &chunk = mesh.chunks[c];
+
+            // a leaf at the depth limit has several chunks, each with its own bounds
+            if (node.chunk_count > 1 && outside(chunk.bounds_min, chunk.bounds_max)) {
+                continue;
+            }
+            GlmVec3 lo(chunk.bounds_min[0], chunk.bounds_min[1], chunk.bounds_min[2]);
+            GlmVec3 hi(chunk.bounds_max[0], chunk.bounds_max[1], chunk.bounds_max[2]);
+
+            auto radius = 0.5f * glm::length(hi - lo);
+            auto distance = glm::length(0.5f * (lo + hi) - eye);
+            auto pixels = distance > radius ? pixels_per_unit * radius / distance : std::numeric_limits<float>::max();
+
+            visible.push_back({c, pixels});
+        }
+    }
+
+    std::sort(visible.begin(), visible.end(), [](const VisibleChunk &a, const VisibleChunk &b) {
+        return a.pixels > b.pixels;
+    });
+
+    return visible;
+}
+
+void RequestChunks(StreamingParams &streaming, const std::vector<VisibleChunk> &visible) {
+    // Visible chunks keep their slots; the largest missing ones are read into free or least recently visible
+    // slots, as long as few enough reads are in flight
+    streaming.budget_full = false;
+
+    for (const auto &entry: visible) {
+        if (streaming.residency[entry.chunk] != chunk_absent) {
+            streaming.slot_visible[streaming.chunk_slot[entry.chunk]] = streaming.frame;
+        }
+    }
+
+    for (const auto &entry: visible) {
+        if (streaming.residency[entry.chunk] != chunk_absent) {
+            continue;
+        }
+        if (streaming.pending.size() >= stream_loads_in_flight) {
+            break;
+        }
+        auto slot = FindSlot(streaming);
+
+        // every slot holds a visible chunk: the smaller remaining ones wait until the view changes
+        if (slot == stream_no_chunk) {
+            streaming.budget_full = true;
+            streaming.budget_full_frames++;
+            break;
+        }
+
+        auto evicted = streaming.slot_chunk[slot];
+
+        if (evicted != stream_no_chunk) {
+            streaming.residency[evicted] = chunk_absent;
+            streaming.chunk_slot[evicted] = stream_no_chunk;
+            streaming.evictions++;
+        }
+
+        streaming.slot_chunk[slot] = entry.chunk;
+        streaming.slot_visible[slot] = streaming.frame;
+        streaming.chunk_slot[entry.chunk] = slot;
+        streaming.residency[entry.chunk] = chunk_loading;
+        streaming.loads++;
+
+        auto read = streaming.loader->Submit([fname = streaming.fname, chunk = streaming.mesh.chunks[entry.chunk]]() {
+            return ReadOctreeChunk(fname, chunk);
+        });
+
+        streaming.pending.push_back({entry.chunk, slot, std::move(read)});
+    }
+}
+
+void UpdateStreaming(StreamingParams &streaming, SceneParams &scene_params, const SceneGlobals &scene_globals) {
+    // Once per frame, before drawing: uploads, culling, new reads, then the draw commands of the resident
+    // visible chunks replace the scene's
+    streaming.frame++;
+
+    UploadFinishedChunks(streaming);
+
+    auto visible = CullChunks(streaming, scene_params, scene_globals);
+
+    RequestChunks(streaming, visible);
+
+    scene_params.draws.clear();
+
+    for (const auto &entry: visible) {
+        if (streaming.residency[entry.chunk] != chunk_resident) {
+            continue;
+        }
+        auto count = streaming.mesh.chunks[entry.chunk].triangle_count * 3;
+        auto first = (GLuint) (streaming.chunk_slot[entry.chunk] * streaming.slot_vertices);
+
+        scene_params.draws.push_back({count, 1, first, 0});
+    }
+
+    streaming.visible = visible.size();
+    streaming.drawn = scene_params.draws.size();
+    streaming.missing = streaming.visible - streaming.drawn;
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, scene_params.indirect_handle);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr) (scene_params.draws.size() * sizeof(DrawCommand)),
+                 scene_params.draws.data(), GL_STREAM_DRAW);
+    TrackGlObject(GL_BUFFER, scene_params.indirect_handle, MemoryCategory::gpu_storage,
+                  scene_params.draws.size() * sizeof(DrawCommand));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+bool StreamingBusy(const StreamingParams &streaming) {
+    // True while reads are in flight or missing visible chunks can still get a slot; on-demand pacing keeps
+    // drawing until then. Chunks left out by a full budget only change with the view, so they do not count
+    return !streaming.pending.empty() || (streaming.missing > 0 && !streaming.budget_full);
+}
+
+std::string StreamingStats(const StreamingParams &streaming) {
+    // eg. "streaming 60 visible chunks, 52 drawn, 118 of 118 slots (256 MB), 130 loads, 12 evictions, 270 MB read"
+    std::ostringstream stats;
+
+    auto used = std::count_if(streaming.slot_chunk.begin(), streaming.slot_chunk.end(), [](std::uint32_t chunk) {
+        return chunk != stream_no_chunk;
+    });
+    auto budget_bytes = (std::uint64_t) streaming.slot_count * streaming.slot_vertices * sizeof(Vertex);
+
+    stats << "streaming " << streaming.visible << " visible chunks, " << streaming.drawn << " drawn, " << used
+          << " of " << streaming.slot_count << " slots (" << Megabytes(budget_bytes) << " MB), " << streaming.loads
+          << " loads, " << streaming.evictions << " evictions, " << Megabytes(streaming.bytes_read) << " MB read";
+
+    if (streaming.budget_full_frames > 0) {
+        stats << ", budget full in " << streaming.budget_full_frames << " frames";
+    }
+    return stats.str();
+}
@@ -0,0 +1,97 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_STREAMING_H
+#define DRAGON_GL_STREAMING_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "attributes.h"
+#include "scene.h"
+#include "job_system.h"
+#include "../load-utils/mesh_octree.h"
+
+/* Out-of-core rendering of a paged mesh ('stream=path', see mesh_octree.h). The GPU holds one vertex buffer of a
+ * fixed budget ('budget=MB'), cut into slots of one chunk each. Every frame the octree is culled against the view
+ * frustum and the visible chunks are ranked by projected size. The largest missing ones are read by background
+ * jobs into a free slot, or into the slot least recently visible. Resident visible chunks are drawn as commands of
+ * the scene's multi-draw, largest (nearest) first. GPU memory is the budget and CPU memory a few chunks in flight,
+ * whatever the size of the mesh */
+const unsigned int stream_budget_default_mb = 256;
+const unsigned int stream_loader_threads = 2;
+const unsigned int stream_loads_in_flight = 8;            // chunk reads queued or running
+const std::size_t stream_upload_bytes_max = 64u << 20;    // per frame, so a burst of finished reads cannot stall
+const float stream_model_extent = 2.0f;                   // the mesh is centered and scaled to this size
+const float stream_light_z = 2.0f;
+
+const std::uint32_t stream_no_chunk = 0xffffffff;
+
+enum ChunkResidency { chunk_absent, chunk_loading, chunk_resident };
+
+// A chunk read by a job, waiting to be uploaded into its reserved slot
+struct PendingChunk {
+    std::uint32_t chunk;
+    std::uint32_t slot;
+    std::future<VertexList> vertices;
+};
+
+// A chunk that passed culling, and its projected radius in pixels
+struct VisibleChunk {
+    std::uint32_t chunk;
+    float pixels;
+};
+
+struct StreamingParams {
+    std::string fname;
+    OctreeMesh mesh;
+
+    // Fixed vertex buffer; slot i starts at vertex i * slot_vertices
+    GLuint vbo = 0;
+    GLuint vao = 0;
+    std::uint32_t slot_count = 0;
+    std::size_t slot_vertices = 0;
+    std::vector<std::uint32_t> slot_chunk;     // stream_no_chunk if free
+    std::vector<std::uint64_t> slot_visible;   // last frame its chunk was visible
+
+    std::vector<ChunkResidency> residency;     // per chunk
+    std::vector<std::uint32_t> chunk_slot;
+
+    std::unique_ptr<JobSystem> loader;
+    std::vector<PendingChunk> pending;
+
+    std::uint64_t frame = 0;
+    bool budget_full = false;  // last frame: a visible chunk found no slot, so it waits for the view to change
+
+    // Stats; visible, drawn and missing are for the last frame
+    std::size_t visible = 0;
+    std::size_t drawn = 0;
+    std::size_t missing = 0;
+    std::uint64_t loads = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t bytes_read = 0;
+    std::uint64_t budget_full_frames = 0;  // frames where a visible chunk found no slot to evict
+};
+
+SceneDescription StreamedScene(const std::string &fname);
+StreamingParams CreateStreaming(const std::string &fname, unsigned int budget_mb);
+void UploadFinishedChunks(StreamingParams &streaming);
+std::vector<VisibleChunk> CullChunks(const StreamingParams &streaming, const SceneParams &scene_params,
+                                     const SceneGlobals &scene_globals);
+void RequestChunks(StreamingParams &streaming, const std::vector<VisibleChunk> &visible);
+void UpdateStreaming(StreamingParams &streaming, SceneParams &scene_params, const SceneGlobals &scene_globals);
+bool StreamingBusy(const StreamingParams &streaming);
+std::string StreamingStats(const StreamingParams &streaming);
+
+#endif // DRAGON_GL_STREAMING_H
@@ -0,0 +1,73 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "threading.h"
+
+void PublishSnapshot(SnapshotChannel &channel, const std::vector<SceneInstance> &instances,
+                     const SceneGlobals &scene_globals) {
+    // Computes all matrices (including the normal matrix inverses) and hands them to the render thread
+    auto &snapshot = channel.snapshots.WriteBuffer();
+
+    snapshot.transforms = ComputeTransforms(instances, scene_globals);
+    snapshot.width = scene_globals.width;
+    snapshot.height = scene_globals.height;
+    snapshot.fov = scene_globals.fov;
+    snapshot.version = channel.version.load(std::memory_order_relaxed) + 1;
+
+    channel.snapshots.Publish();
+
+    // Wake the render thread if it is idling (on-demand mode)
+    channel.version.store(snapshot.version, std::memory_order_release);
+    channel.version.notify_all();
+}
+
+void RunInputLoop(const WindowPtr &window, const std::vector<SceneInstance> &instances,
+                  SceneGlobals &scene_globals, SnapshotChannel &channel, const std::function<void()> &on_events) {
+    // Main thread: GLFW requires event processing here. Blocks until events arrive, lets the caller
+    // handle them (eg. picking), then publishes a new snapshot if the callbacks changed anything
+    PublishSnapshot(channel, instances, scene_globals);
+
+    while (!glfwWindowShouldClose(window.get())) {
+        glfwWaitEvents();
+
+        on_events();
+
+        if (scene_globals.dirty_ || scene_globals.redraw_) {
+            scene_globals.dirty_ = false;
+            scene_globals.redraw_ = false;
+
+            PublishSnapshot(channel, instances, scene_globals);
+        }
+    }
+
+    // Let the render thread finish
+    channel.running = false;
+    channel.version.fetch_add(1, std::memory_order_release);
+    channel.version.notify_all();
+}
+
+bool AcquireSnapshot(SnapshotChannel &channel, SceneGlobals &frame_globals, const SceneParams &scene_params) {
+    // Render thread: applies the newest snapshot, if any; never blocks
+    if (!channel.snapshots.Acquire()) {
+        return false;
+    }
+
+    const auto &snapshot = channel.snapshots.ReadBuffer();
+
+    frame_globals.width = snapshot.width;
+    frame_globals.height = snapshot.height;
+    frame_globals.fov = snapshot.fov;
+
+    glViewport(0, 0, (GLsizei) snapshot.width, (GLsizei) snapshot.height);
+
+    UploadTransformUniforms(scene_params.transforms_handle, scene_params.instances_handle, snapshot.transforms);
+    UpdateLightingUniforms(scene_params.lighting_handle, frame_globals);
+
+    return true;
+}
+
+void WaitForSnapshot(const SnapshotChannel &channel, std::uint64_t seen_version) {
+    // Render thread: sleep until a snapshot newer than seen_version is published (or shutdown)
+    channel.version.wait(seen_version, std::memory_order_acquire);
+}
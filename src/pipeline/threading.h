@@ -0,0 +1,40 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_THREADING_H
+#define DRAGON_GL_THREADING_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "attributes.h"
+#include "scene.h"
+#include "triple_buffer.h"
+
+// Everything the render thread needs for a frame, computed on the input thread
+struct UniformSnapshot {
+    SceneTransforms transforms;
+    unsigned int width = width_init;
+    unsigned int height = height_init;
+    float fov = fov_initial;
+    std::uint64_t version = 0;
+};
+
+// Input thread -> render thread channel
+struct SnapshotChannel {
+    TripleBuffer<UniformSnapshot> snapshots;
+    std::atomic<std::uint64_t> version{0};  // bumped after every publish; the render thread can wait on it
+    std::atomic<bool> running{true};
+};
+
+void PublishSnapshot(SnapshotChannel &channel, const std::vector<SceneInstance> &instances,
+                     const SceneGlobals &scene_globals);
+void RunInputLoop(const WindowPtr &window, const std::vector<SceneInstance> &instances,
+                  SceneGlobals &scene_globals, SnapshotChannel &channel, const std::function<void()> &on_events);
+bool AcquireSnapshot(SnapshotChannel &channel, SceneGlobals &frame_globals, const SceneParams &scene_params);
+void WaitForSnapshot(const SnapshotChannel &channel, std::uint64_t seen_version);
+
+#endif // DRAGON_GL_THREADING_H
@@ -0,0 +1,53 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_TRIPLE_BUFFER_H
+#define DRAGON_GL_TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Single producer, single consumer handoff of complete values without locks or blocking.
+// The writer fills its private slot and swaps it with the shared middle slot; the reader swaps
+// the middle slot with its private slot only if a newer value was published since its last swap.
+template<typename T>
+class TripleBuffer {
+private:
+    static constexpr std::uint8_t index_mask = 0x3;
+    static constexpr std::uint8_t fresh_bit = 0x4;
+
+    std::array<T, 3> buffers;
+    std::atomic<std::uint8_t> middle{1};
+    std::uint8_t back = 0;   // owned by the writer
+    std::uint8_t front = 2;  // owned by the reader
+
+public:
+    T &WriteBuffer() {
+        // Writer: slot to fill before calling Publish
+        return buffers[back];
+    }
+
+    void Publish() {
+        // Writer: make the filled slot the newest value (release: contents are visible to the reader)
+        back = middle.exchange(back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+    }
+
+    bool Acquire() {
+        // Reader: take the newest value if there is one; ReadBuffer stays valid until the next Acquire
+        if (!(middle.load(std::memory_order_relaxed) & fresh_bit)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+
+        return true;
+    }
+
+    const T &ReadBuffer() const {
+        // Reader: last acquired value
+        return buffers[front];
+    }
+};
+
+#endif // DRAGON_GL_TRIPLE_BUFFER_H
@@ -0,0 +1,174 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#include "vertex_pulling.h"
+
+namespace {
+    template<std::size_t N, typename Field>
+    GLuint CreateStream(const Vertex *vertices, std::size_t count, Field field) {
+        // Storage buffer holding N floats per vertex, taken from one member of Vertex
+        std::vector<float> stream(count * N);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto &value = vertices[i].*field;
+
+            for (std::size_t c = 0; c < N; ++c) {
+                stream[i * N + c] = value[(int) c];
+            }
+        }
+
+        GLuint buffer;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr) (stream.size() * sizeof(float)), stream.data(),
+                     GL_STATIC_DRAW);
+        TrackGlObject(GL_BUFFER, buffer, MemoryCategory::gpu_vertices, stream.size() * sizeof(float));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        return buffer;
+    }
+
+    double Megabytes(std::size_t bytes) {
+        return (double) bytes / (1024.0 * 1024.0);
+    }
+}
+
+VertexStreams CreateVertexStreams(const Vertex *vertices, std::size_t count) {
+    // Splits the interleaved vertices into one buffer per attribute
+    VertexStreams streams;
+
+    streams.positions = CreateStream<3>(vertices, count, &Vertex::pos);
+    streams.normals = CreateStream<3>(vertices, count, &Vertex::normal);
+    streams.tangents = CreateStream<3>(vertices, count, &Vertex::tangent);
+    streams.uvs = CreateStream<2>(vertices, count, &Vertex::uv_coord);
+    streams.vertex_count = count;
+
+    glGenVertexArrays(1, &streams.empty_vao);
+
+    return streams;
+}
+
+void BindVertexStreams(const VertexStreams &streams) {
+    // Shaders without a stream simply do not declare its block
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, pulling_positions_binding, streams.positions);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, pulling_normals_binding, streams.normals);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, pulling_tangents_binding, streams.tangents);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, pulling_uvs_binding, streams.uvs);
+}
+
+void DeleteVertexStreams(VertexStreams &streams) {
+    GLuint buffers[] = {streams.positions, streams.normals, streams.tangents, streams.uvs};
+
+    ReleaseGlObjects(GL_BUFFER, 4, buffers);
+    glDeleteBuffers(4, buffers);
+    glDeleteVertexArrays(1, &streams.empty_vao);
+
+    streams = VertexStreams{};
+}
+
+std::size_t PulledBytesPerVertex(ShadingOption opt, RenderPath path) {
+    // Streams read by the vertex shader of a mode; the attribute path always fetches the whole Vertex
+    if (path == RenderPath::deferred_shading || opt == ShadingOption::normal_mapping) {
+        return 11 * sizeof(float);
+    }
+    return 6 * sizeof(float);
+}
+
+std::size_t DrawnVertices(const std::vector<DrawCommand> &draws) {
+    // Vertex shader invocations of one multi-draw, ignoring the post-transform cache (draws are not indexed)
+    std::size_t vertices = 0;
+
+    for (const auto &draw: draws) {
+        vertices += (std::size_t) draw.count * draw.instance_count;
+    }
+    return vertices;
+}
+
+std::string VertexPullingStats(const VertexStreams &streams, ShadingOption opt, RenderPath path) {
+    // eg. "vertex pulling: 24 of 44 bytes per vertex, 40.1 MB of streams"
+    auto stream_bytes = streams.vertex_count * 11 * sizeof(float);
+
+    std::ostringstream stats;
+
+    stats << "vertex pulling: " << PulledBytesPerVertex(opt, path) << " of " << sizeof(Vertex)
+          << " bytes per vertex, " << std::fixed << std::setprecision(1) << Megabytes(stream_bytes)
+          << " MB of streams";
+
+    return stats.str();
+}
+
+bool AdvanceVertexPullingBenchmark(VertexPullingBenchmark &benchmark, GpuTimer &timer, double now,
+                                   std::size_t vertices, std::size_t pulled_bytes) {
+    // Called after every frame; switches between the attribute path and vertex pulling once a run is measured.
+    // Returns true after the last run, with the results printed
+    benchmark.frames++;
+
+    if (benchmark.frames == pulling_benchmark_warmup_frames) {
+        // Drop what was timed so far, it may include the previous mode
+        CollectGpuTimer(timer);
+
+        timer.samples = 0;
+        timer.sum_ms = 0.0;
+        benchmark.start = now;
+
+        return false;
+    }
+
+    if (benchmark.frames < pulling_benchmark_warmup_frames || now - benchmark.start < pulling_benchmark_seconds) {
+        return false;
+    }
+
+    CollectGpuTimer(timer);
+
+    VertexPullingResult result;
+
+    result.pulling = benchmark.pulling;
+    result.frames = benchmark.frames - pulling_benchmark_warmup_frames;
+    result.gpu_ms = timer.samples ? timer.sum_ms / timer.samples : 0.0;
+    result.vertices = vertices;
+    result.vertex_bytes = benchmark.pulling ? pulled_bytes : sizeof(Vertex);
+
+    benchmark.results.push_back(result);
+
+    auto name = [](bool pulling) {
+        return pulling ? "pulling" : "attributes";
+    };
+
+    std::cout << name(result.pulling) << ": " << std::fixed << std::setprecision(3) << result.gpu_ms
+              << " ms GPU over " << result.frames << " frames" << std::endl;
+
+    benchmark.frames = 0;
+    benchmark.pulling = !benchmark.pulling;
+
+    // a round is the attribute path, then pulling
+    if (benchmark.pulling || ++benchmark.run < pulling_benchmark_rounds) {
+        return false;
+    }
+
+    // Summary: the best run of each mode; bandwidth is what the vertex stage needed, over the whole main pass
+    std::cout << std::left << std::setw(12) << "mode" << std::right << std::setw(10) << "GPU ms"
+              << std::setw(14) << "bytes/vertex" << std::setw(14) << "MB fetched" << std::setw(10) << "GB/s"
+              << std::endl;
+
+    for (auto pulling: {false, true}) {
+        const VertexPullingResult *best = nullptr;
+
+        for (const auto &entry: benchmark.results) {
+            if (entry.pulling == pulling && entry.gpu_ms > 0.0 && (!best || entry.gpu_ms < best->gpu_ms)) {
+                best = &entry;
+            }
+        }
+        if (!best) {
+            continue;
+        }
+        auto bytes = best->vertices * best->vertex_bytes;
+
+        std::cout << std::left << std::setw(12) << name(pulling) << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(10) << best->gpu_ms << std::setw(14) << best->vertex_bytes
+                  << std::setprecision(1) << std::setw(14) << Megabytes(bytes) << std::setprecision(2)
+                  << std::setw(10) << (double) bytes / (best->gpu_ms * 1.0e6) << std::endl;
+    }
+    return true;
+}
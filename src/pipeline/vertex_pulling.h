@@ -0,0 +1,77 @@
+//
+// Created by francisk on 10/18/26.
+//
+
+#ifndef DRAGON_GL_VERTEX_PULLING_H
+#define DRAGON_GL_VERTEX_PULLING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "attributes.h"
+#include "scene.h"
+#include "frame_stats.h"
+
+/* Vertex pulling ('pulling'): instead of attributes described by the vertex array, the vertex shaders read their
+ * inputs from storage buffers at gl_VertexID. Positions, normals, tangents and texture coordinates are separate,
+ * tightly packed streams, and each shader declares only the streams it reads: gouraud, flat and wireframe fetch
+ * 24 bytes per vertex instead of the 44 of the interleaved Vertex. All draws of the multi-draw share the one set
+ * of bound streams; the vertex array bound while drawing has no attributes */
+
+// Storage buffer bindings of the streams (the scene uses 2 to 6)
+const GLuint pulling_positions_binding = 8;
+const GLuint pulling_normals_binding = 9;
+const GLuint pulling_tangents_binding = 10;
+const GLuint pulling_uvs_binding = 11;
+
+// Prepended (after #version) to the forward and deferred geometry vertex shaders
+const std::string vertex_pulling_defines = "#define VERTEX_PULLING\n";
+
+// Benchmark ('pullbench'): the attribute path and vertex pulling each run for a while after some warm-up frames
+const unsigned int pulling_benchmark_warmup_frames = 30;
+const double pulling_benchmark_seconds = 3.0;
+const unsigned int pulling_benchmark_rounds = 2;  // attributes, pulling, attributes, pulling
+
+struct VertexStreams {
+    GLuint positions = 0;  // vec3 per vertex
+    GLuint normals = 0;    // vec3
+    GLuint tangents = 0;   // vec3
+    GLuint uvs = 0;        // vec2
+    GLuint empty_vao = 0;  // bound while drawing; core profile needs one
+    std::size_t vertex_count = 0;
+};
+
+// One run of the benchmark
+struct VertexPullingResult {
+    bool pulling = false;
+    unsigned int frames = 0;
+    double gpu_ms = 0.0;
+    std::size_t vertices = 0;        // per frame
+    std::size_t vertex_bytes = 0;    // fetched per vertex
+};
+
+struct VertexPullingBenchmark {
+    bool pulling = false;     // mode of the current run
+    unsigned int run = 0;
+    unsigned int frames = 0;  // in the current run, including warm-up
+    double start = 0.0;       // end of the warm-up
+    std::vector<VertexPullingResult> results;
+};
+
+VertexStreams CreateVertexStreams(const Vertex *vertices, std::size_t count);
+void BindVertexStreams(const VertexStreams &streams);
+void DeleteVertexStreams(VertexStreams &streams);
+std::size_t PulledBytesPerVertex(ShadingOption opt, RenderPath path);
+std::size_t DrawnVertices(const std::vector<DrawCommand> &draws);
+std::string VertexPullingStats(const VertexStreams &streams, ShadingOption opt, RenderPath path);
+bool AdvanceVertexPullingBenchmark(VertexPullingBenchmark &benchmark, GpuTimer &timer, double now,
+                                   std::size_t vertices, std::size_t pulled_bytes);
+
+#endif // DRAGON_GL_VERTEX_PULLING_H
@@ -0,0 +1,130 @@
+#include "pipeline/render_protocol.h"
+
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+/* Test client of the render daemon: every argument that is not one of its own options is a word of the request
+ * line, eg. dragon-render-client model=bunny shading=flat size=256x256. 'repeat=N' sends the request N times on
+ * one connection before reading any reply, like a busy thumbnail service would, and reports the throughput.
+ * The PNG of the last reply is written to 'save=path' (default render.png) */
+const std::string save_str = "save=";
+const std::string repeat_str = "repeat=";
+const std::string client_output_default = "render.png";
+
+int main(int argc, char* argv[]) {
+    auto socket_path = DefaultSocketPath();
+    std::string save_path = client_output_default;
+    std::string request;
+    unsigned long repeat = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        auto extras = std::string(argv[i]);
+
+        if(extras.starts_with(socket_str)) {
+            socket_path = extras.substr(socket_str.size());
+        } else if(extras.starts_with(save_str)) {
+            save_path = extras.substr(save_str.size());
+        } else if(extras.starts_with(repeat_str)) {
+            repeat = std::max(1ul, std::strtoul(extras.substr(repeat_str.size()).c_str(), nullptr, 10));
+        } else {
+            request += (request.empty() ? "" : " ") + extras;
+        }
+    }
+
+    // Replies are read after everything is sent; a daemon that stopped early must not kill the client
+    std::signal(SIGPIPE, SIG_IGN);
+
+    auto fd = ConnectLocalSocket(socket_path);
+
+    if(fd < 0) {
+        std::cout << "No render daemon on " << socket_path << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // 'shutdown' has no reply
+    auto stop_daemon = request == shutdown_request;
+    auto count = stop_daemon ? 1 : repeat;
+    std::string lines;
+
+    for (unsigned long i = 0; i < count; ++i) {
+        lines += request + "\n";
+    }
+    if(stop_daemon) {
+        auto sent = SendAll(fd, lines.data(), lines.size());
+
+        CloseLocalSocket(fd);
+        return sent ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Sent from a second thread: the daemon answers while requests are still coming, and both sides blocking on
+    // full socket buffers would deadlock
+    std::thread sender([&]() {
+        if(SendAll(fd, lines.data(), lines.size())) {
+            shutdown(fd, SHUT_WR);
+        }
+    });
+
+    std::string buffer;
+    std::string png;
+    unsigned long failed = 0;
+
+    for (unsigned long i = 0; i < count; ++i) {
+        std::string header;
+
+        if(!ReceiveLine(fd, buffer, header)) {
+            std::cout << "The render daemon closed the connection after " << i << " replies" << std::endl;
+
+            sender.join();
+            exit(EXIT_FAILURE);
+        }
+
+        if(header.starts_with(reply_ok + " ")) {
+            auto size = std::strtoull(header.substr(reply_ok.size() + 1).c_str(), nullptr, 10);
+
+            if(!ReceiveBytes(fd, buffer, size)) {
+                std::cout << "The render daemon closed the connection in the middle of an image" << std::endl;
+
+                sender.join();
+                exit(EXIT_FAILURE);
+            }
+            png = buffer.substr(0, size);
+            buffer.erase(0, size);
+        } else if(!header.starts_with(reply_saved + " ")) {
+            ++failed;
+        }
+
+        // the first and last replies, and every one that is not an image
+        if(i == 0 || i + 1 == count || !header.starts_with(reply_ok + " ")) {
+            std::cout << header << std::endl;
+        }
+    }
+    sender.join();
+    CloseLocalSocket(fd);
+
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if(count > 1) {
+        std::cout << count << " requests in " << seconds * 1000.0 << " ms: " << count / seconds << " images/s, "
+                  << failed << " failed" << std::endl;
+    }
+
+    if(!png.empty()) {
+        std::ofstream file(save_path, std::ios::binary);
+
+        file.write(png.data(), (std::streamsize) png.size());
+
+        if(!file) {
+            std::cout << "Could not write " << save_path << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+        std::cout << "Image written to " << save_path << std::endl;
+    }
+
+    return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
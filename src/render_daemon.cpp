@@ -0,0 +1,327 @@
+#include "pipeline/render_service.h"
+#include "pipeline/render_protocol.h"
+
+/* Render daemon: keeps scenes resident and answers render requests over a Unix domain socket, so a thumbnail
+ * service pays for loading a model once instead of once per image. Requests that arrive together (up to
+ * 'batch=N', or within 'wait=MS' of the first one) form a batch; see render_service.h and render_protocol.h.
+ * Requests may only write files with 'outdir=dir', and only inside it */
+const std::string batch_str = "batch=";
+const std::string scenes_str = "scenes=";
+const std::string wait_str = "wait=";
+const std::string outdir_str = "outdir=";
+const unsigned int daemon_batch_default = 16;
+const std::size_t daemon_max_queued = 64 * 1024 * 1024;  // reply bytes of a client before its requests wait
+const unsigned int daemon_drain_ms = 5000;                // to send the last replies once stopped
+
+namespace {
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    void RequestStop([[maybe_unused]] int signal) {
+        stop_requested = 1;
+    }
+
+    struct DaemonClient {
+        int fd = -1;
+        std::string input;    // received, not yet a complete line
+        std::deque<RenderReply> output;  // answered, not sent yet
+        std::size_t output_sent = 0;     // bytes of the first reply already sent
+        std::size_t output_bytes = 0;    // queued in total
+        bool hung_up = false;  // sent everything; closed once its requests are answered and sent
+    };
+
+    void QueueReply(DaemonClient &client, const RenderReply &reply) {
+        client.output.push_back(reply);
+        client.output_bytes += reply.header.size() + (reply.png ? reply.png->size() : 0);
+    }
+
+    bool SendReplies(DaemonClient &client) {
+        // Sends queued replies until the socket buffer is full, so a client that does not read never holds up the
+        // others; false once the client is gone
+        while (!client.output.empty()) {
+            const auto &reply = client.output.front();
+            auto header_size = reply.header.size();
+            auto total = header_size + (reply.png ? reply.png->size() : 0);
+            auto in_header = client.output_sent < header_size;
+            auto data = in_header ? reply.header.data() + client.output_sent :
+                        reply.png->data() + (client.output_sent - header_size);
+            auto size = (in_header ? header_size : total) - client.output_sent;
+            auto sent = SendSome(client.fd, data, size);
+
+            if (sent < 0) {
+                return false;
+            }
+            if (sent == 0) {
+                break;
+            }
+            client.output_sent += (std::size_t) sent;
+            client.output_bytes -= (std::size_t) sent;
+
+            if (client.output_sent == total) {
+                client.output.pop_front();
+                client.output_sent = 0;
+            }
+        }
+        return true;
+    }
+
+    struct PendingRequest {
+        unsigned int client = 0;
+        RenderRequest request;
+    };
+}
+
+int main(int argc, char* argv[]) {
+    auto socket_path = DefaultSocketPath();
+    unsigned int batch_size = daemon_batch_default;
+    unsigned int wait_ms = 0;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    RenderServiceParams service;
+
+    for (int i = 1; i < argc; ++i) {
+        auto extras = std::string(argv[i]);
+
+        if(extras.starts_with(socket_str)) {
+            socket_path = extras.substr(socket_str.size());
+        } else if(extras.starts_with(batch_str)) {
+            batch_size = ParseCount(extras.substr(batch_str.size()), extras);
+        } else if(extras.starts_with(scenes_str)) {
+            service.max_scenes = ParseCount(extras.substr(scenes_str.size()), extras);
+        } else if(extras.starts_with(wait_str)) {
+            wait_ms = ParseCount(extras.substr(wait_str.size()), extras);
+        } else if(extras.starts_with(threads_str)) {
+            threads = ParseCount(extras.substr(threads_str.size()), extras);
+        } else if(extras.starts_with(outdir_str)) {
+            service.output_dir = extras.substr(outdir_str.size());
+
+            if(!std::filesystem::is_directory(service.output_dir)) {
+                std::cout << service.output_dir.string() << " is not a directory" << std::endl;
+
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            std::cout << "Invalid option, try 'socket=path' 'batch=N' 'scenes=N' 'wait=MS' 'threads=N' 'outdir=dir'"
+                      << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // A client that hangs up early must not kill the daemon; SIGINT and SIGTERM stop it cleanly
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+
+    auto jobs = JobSystem::ForCores(threads);
+
+    auto listener = ListenLocalSocket(socket_path);
+
+    std::cout << "Render daemon on " << socket_path << ": batches of up to " << batch_size << " requests, "
+              << service.max_scenes << " resident scenes, " << threads << " threads, "
+              << (service.output_dir.empty() ? "no output files" : "output files in " + service.output_dir.string())
+              << std::endl;
+
+    std::map<unsigned int, DaemonClient> clients;
+    unsigned int next_client = 0;
+    std::vector<PendingRequest> pending;
+    auto first_pending = std::chrono::steady_clock::now();
+    auto running = true;
+
+    auto close_client = [&](unsigned int id) {
+        CloseLocalSocket(clients[id].fd);
+        clients.erase(id);
+    };
+
+    // Renders the pending requests and queues the replies in arrival order, so each connection gets its replies in
+    // the order of its requests; what the sockets take right away is sent
+    auto run_batch = [&]() {
+        std::vector<RenderRequest> requests;
+
+        for (const auto &entry: pending) {
+            requests.push_back(entry.request);
+        }
+
+        auto replies = RenderBatch(service, requests, jobs);
+
+        for (std::size_t i = 0; i < pending.size(); ++i) {
+            if (clients.contains(pending[i].client)) {
+                QueueReply(clients[pending[i].client], replies[i]);
+            }
+        }
+        for (const auto &entry: pending) {
+            if (clients.contains(entry.client) && !SendReplies(clients[entry.client])) {
+                close_client(entry.client);
+            }
+        }
+        pending.clear();
+    };
+
+    // Clients that hung up are closed once every request they sent is answered and sent
+    auto close_hung_up = [&]() {
+        std::erase_if(clients, [&](const auto &entry) {
+            auto waiting = std::any_of(pending.begin(), pending.end(), [&](const PendingRequest &request) {
+                return request.client == entry.first;
+            });
+            auto done = entry.second.hung_up && !waiting && entry.second.output.empty();
+
+            if (done) {
+                CloseLocalSocket(entry.second.fd);
+            }
+            return done;
+        });
+    };
+
+    while (running && !stop_requested) {
+        /* The listener first, then every client: for requests unless it hung up or has too many replies it does
+         * not read, and for room to send the replies it has */
+        std::vector<pollfd> fds{{listener, POLLIN, 0}};
+        std::vector<unsigned int> ids;
+
+        for (const auto &[id, client]: clients) {
+            short events = 0;
+
+            if (!client.hung_up && client.output_bytes < daemon_max_queued) {
+                events |= POLLIN;
+            }
+            if (!client.output.empty()) {
+                events |= POLLOUT;
+            }
+            if (events != 0) {
+                fds.push_back({client.fd, events, 0});
+                ids.push_back(id);
+            }
+        }
+
+        // Without pending requests wait for input; with some, only until the batch is due
+        auto timeout = -1;
+
+        if (!pending.empty()) {
+            auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                               first_pending).count();
+            timeout = (int) std::max<long long>(0, (long long) wait_ms - waited);
+        }
+
+        auto ready = poll(fds.data(), fds.size(), timeout);
+
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            std::cout << "poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            auto fd = accept(listener, nullptr, nullptr);
+
+            if (fd >= 0 && SetNonBlocking(fd)) {
+                clients[next_client++].fd = fd;
+            } else {
+                CloseLocalSocket(fd);
+            }
+        }
+
+        for (std::size_t i = 1; i < fds.size() && running; ++i) {
+            // a full batch may have dropped the client since the poll
+            auto id = ids[i - 1];
+            auto found = clients.find(id);
+
+            if (found == clients.end()) {
+                continue;
+            }
+
+            auto &client = found->second;
+
+            if ((fds[i].revents & (POLLOUT | POLLHUP | POLLERR)) && !client.output.empty() && !SendReplies(client)) {
+                close_client(id);
+                continue;
+            }
+            if (!(fds[i].events & POLLIN) || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+
+            auto received = ReceiveSome(client.fd, client.input);
+
+            // the last lines may come with the end of the stream (eg. a client that shuts down its sending side)
+            client.hung_up = !received;
+
+            std::string line;
+
+            while (TakeLine(client.input, line)) {
+                if (line == shutdown_request) {
+                    running = false;
+                    break;
+                }
+                if (line.find_first_not_of(" \t") == std::string::npos) {
+                    continue;
+                }
+                if (pending.empty()) {
+                    first_pending = std::chrono::steady_clock::now();
+                }
+                pending.push_back({id, ParseRenderRequest(line)});
+
+                // a full batch is answered right away; a client whose replies cannot be sent is dropped
+                if (pending.size() >= batch_size) {
+                    run_batch();
+
+                    if (!clients.contains(id)) {
+                        break;
+                    }
+                }
+            }
+
+            // what is left is an incomplete line
+            if (clients.contains(id) && client.input.size() > max_request_line) {
+                close_client(id);
+            }
+        }
+
+        // Checked after every wake-up, so connections that keep the poll busy cannot hold back a batch that is due
+        if (!pending.empty() &&
+            std::chrono::steady_clock::now() - first_pending >= std::chrono::milliseconds(wait_ms)) {
+            run_batch();
+        }
+        close_hung_up();
+    }
+
+    // Requests accepted before stopping are still answered, if their clients read them in time
+    if (!pending.empty()) {
+        run_batch();
+    }
+
+    auto drain_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(daemon_drain_ms);
+
+    while (true) {
+        std::vector<pollfd> fds;
+        std::vector<unsigned int> ids;
+
+        for (const auto &[id, client]: clients) {
+            if (!client.output.empty()) {
+                fds.push_back({client.fd, POLLOUT, 0});
+                ids.push_back(id);
+            }
+        }
+
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(drain_end -
+                                                                          std::chrono::steady_clock::now()).count();
+
+        if (fds.empty() || left <= 0) {
+            break;
+        }
+        if (poll(fds.data(), fds.size(), (int) left) < 0 && errno != EINTR) {
+            break;
+        }
+        for (std::size_t i = 0; i < fds.size(); ++i) {
+            if (fds[i].revents != 0 && !SendReplies(clients[ids[i]])) {
+                close_client(ids[i]);
+            }
+        }
+    }
+
+    for (const auto &[id, client]: clients) {
+        CloseLocalSocket(client.fd);
+    }
+    CloseLocalSocket(listener);
+    unlink(socket_path.c_str());
+
+    std::cout << "Render daemon: " << RenderServiceStats(service) << std::endl;
+}
@@ -0,0 +1,52 @@
+#version 420 core
+/* FXAA: blurs along the local edge direction where the luma contrast is high, in one pass over the
+   single sampled frame. After Timothy Lottes' FXAA (console variant) */
+
+// Inputs
+in vec2 oTextureCoords;
+
+// Uniform textures
+uniform sampler2D currentColor;
+
+// Outputs
+out vec3 outColor;
+
+// Tuning
+const float reduce_min = 1.0 / 128.0;
+const float reduce_mul = 1.0 / 8.0;
+const float span_max = 8.0;
+
+float luma(in vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main() {
+    vec2 texel = 1.0 / vec2(textureSize(currentColor, 0));
+    vec2 uv = oTextureCoords;
+
+    vec3 color_m = texture(currentColor, uv).rgb;
+    float luma_nw = luma(texture(currentColor, uv + vec2(-1.0, -1.0) * texel).rgb);
+    float luma_ne = luma(texture(currentColor, uv + vec2(1.0, -1.0) * texel).rgb);
+    float luma_sw = luma(texture(currentColor, uv + vec2(-1.0, 1.0) * texel).rgb);
+    float luma_se = luma(texture(currentColor, uv + vec2(1.0, 1.0) * texel).rgb);
+    float luma_m = luma(color_m);
+
+    float luma_min = min(luma_m, min(min(luma_nw, luma_ne), min(luma_sw, luma_se)));
+    float luma_max = max(luma_m, max(max(luma_nw, luma_ne), max(luma_sw, luma_se)));
+
+    // Edge direction from the luma gradient, normalized by its smaller component (long edges blur further)
+    vec2 direction = vec2(-((luma_nw + luma_ne) - (luma_sw + luma_se)), (luma_nw + luma_sw) - (luma_ne + luma_se));
+    float reduce = max((luma_nw + luma_ne + luma_sw + luma_se) * 0.25 * reduce_mul, reduce_min);
+    float scale = 1.0 / (min(abs(direction.x), abs(direction.y)) + reduce);
+
+    direction = clamp(direction * scale, vec2(-span_max), vec2(span_max)) * texel;
+
+    // Two taps close to the pixel, and two more further out; the wider blur is kept unless it crossed the edge
+    vec3 color_a = 0.5 * (texture(currentColor, uv + direction * (1.0 / 3.0 - 0.5)).rgb +
+                          texture(currentColor, uv + direction * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 color_b = 0.5 * color_a + 0.25 * (texture(currentColor, uv - 0.5 * direction).rgb +
+                                           texture(currentColor, uv + 0.5 * direction).rgb);
+    float luma_b = luma(color_b);
+
+    outColor = (luma_b < luma_min || luma_b > luma_max) ? color_a : color_b;
+}
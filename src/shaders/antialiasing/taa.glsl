@@ -0,0 +1,57 @@
+#version 420 core
+/* TAA resolve: blends the jittered frame into the reprojected history. The history is clamped to the
+   color range of the current 3x3 neighbourhood, which rejects what the reprojection got wrong
+   (disocclusions, lighting changes) instead of ghosting it */
+
+// Inputs
+in vec2 oTextureCoords;
+
+// Uniform textures
+uniform sampler2D currentColor;
+uniform sampler2D currentDepth;
+uniform sampler2D historyColor;
+
+// Current clip space -> clip space of the previous frame; weight of the history, 0 if there is none
+uniform mat4 previousFromCurrent;
+uniform float historyWeight;
+
+// Outputs
+out vec4 outColor;
+
+void main() {
+    vec2 texel = 1.0 / vec2(textureSize(currentColor, 0));
+    vec2 uv = oTextureCoords;
+    vec3 current = texture(currentColor, uv).rgb;
+
+    vec3 color_min = current;
+    vec3 color_max = current;
+
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            vec3 color = texture(currentColor, uv + vec2(x, y) * texel).rgb;
+
+            color_min = min(color_min, color);
+            color_max = max(color_max, color);
+        }
+    }
+
+    // Reverse-Z: 0 is the cleared background, which does not move with the camera fixed
+    float depth = texture(currentDepth, uv).r;
+    vec2 previous_uv = uv;
+
+    if (depth > 0.0) {
+        vec4 previous = previousFromCurrent * vec4(uv * 2.0 - 1.0, depth, 1.0);
+
+        previous_uv = previous.xy / previous.w * 0.5 + 0.5;
+    }
+
+    float weight = historyWeight;
+
+    if (any(lessThan(previous_uv, vec2(0.0))) || any(greaterThan(previous_uv, vec2(1.0)))) {
+        weight = 0.0;
+    }
+
+    vec3 history = clamp(texture(historyColor, previous_uv).rgb, color_min, color_max);
+
+    outColor = vec4(mix(current, history, weight), 1.0);
+}
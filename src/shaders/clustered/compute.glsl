@@ -0,0 +1,119 @@
+#version 430 core
+/* Clustered light culling pre-pass. One invocation per froxel: its view space bounding box is
+   tested against every light, which the work group streams through shared memory in batches. */
+
+#define GROUP_SIZE 64
+
+layout (local_size_x = GROUP_SIZE) in;
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+layout (std140, binding=1) uniform Lighting
+{
+    vec4 eyePos;
+    uvec4 clusterGrid; // x, y, z froxel counts; w: light capacity per cluster
+    vec4 clusterDepth; // near, far, z slices / log(far / near)
+    vec4 viewport;
+};
+
+struct PointLight {
+    vec4 position; // xyz: world space, w: radius of influence
+    vec4 color;
+};
+
+layout (std430, binding=2) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+layout (std430, binding=3) writeonly buffer ClusterLights
+{
+    uint clusterLights[];
+};
+
+layout (std430, binding=4) writeonly buffer ClusterCounts
+{
+    uint clusterCounts[];
+};
+
+uniform mat4 inverseProjection;
+
+// View space light spheres of the current batch
+shared vec4 batch[GROUP_SIZE];
+
+// Forward declarations
+vec3 view_ray(in vec2 ndc_xy);
+
+void main() {
+    uint cluster = gl_GlobalInvocationID.x;
+    uint cluster_total = clusterGrid.x * clusterGrid.y * clusterGrid.z;
+    bool valid = cluster < cluster_total;
+
+    uvec3 cell = uvec3(cluster % clusterGrid.x, (cluster / clusterGrid.x) % clusterGrid.y,
+                       cluster / (clusterGrid.x * clusterGrid.y));
+
+    // Exponential depth slices between the near and far planes
+    float near_z = clusterDepth.x;
+    float depth_ratio = clusterDepth.y / clusterDepth.x;
+    float slice_near = near_z * pow(depth_ratio, float(cell.z) / float(clusterGrid.z));
+    float slice_far = near_z * pow(depth_ratio, float(cell.z + 1) / float(clusterGrid.z));
+
+    vec2 ndc_min = vec2(cell.xy) / vec2(clusterGrid.xy) * 2.0 - 1.0;
+    vec2 ndc_max = vec2(cell.xy + 1) / vec2(clusterGrid.xy) * 2.0 - 1.0;
+
+    // View space bounding box of the froxel
+    vec3 aabb_min = vec3(1e30);
+    vec3 aabb_max = vec3(-1e30);
+
+    vec2 corners[4] = vec2[4](ndc_min, vec2(ndc_max.x, ndc_min.y), ndc_max, vec2(ndc_min.x, ndc_max.y));
+
+    for (int i = 0; i < 4; ++i) {
+        vec3 ray = view_ray(corners[i]);
+
+        aabb_min = min(aabb_min, min(ray * slice_near, ray * slice_far));
+        aabb_max = max(aabb_max, max(ray * slice_near, ray * slice_far));
+    }
+
+    uint light_count = lights.length();
+    uint count = 0;
+
+    for (uint base = 0; base < light_count; base += GROUP_SIZE) {
+        uint i = base + gl_LocalInvocationIndex;
+
+        if (i < light_count) {
+            batch[gl_LocalInvocationIndex] = vec4((view * vec4(lights[i].position.xyz, 1.0)).xyz,
+                                                  lights[i].position.w);
+        }
+        barrier();
+
+        uint batch_size = min(uint(GROUP_SIZE), light_count - base);
+
+        for (uint j = 0; j < batch_size && valid; ++j) {
+            // Sphere / box overlap via the closest point of the box
+            vec3 closest = clamp(batch[j].xyz, aabb_min, aabb_max);
+            vec3 delta = closest - batch[j].xyz;
+
+            if (dot(delta, delta) <= batch[j].w * batch[j].w && count < clusterGrid.w) {
+                clusterLights[cluster * clusterGrid.w + count] = base + j;
+                count++;
+            }
+        }
+        barrier();
+    }
+
+    if (valid) {
+        clusterCounts[cluster] = count;
+    }
+}
+
+vec3 view_ray(in vec2 ndc_xy) {
+    // View space direction through an NDC position, scaled to unit depth (z = -1)
+    vec4 pos = inverseProjection * vec4(ndc_xy, 1.0, 1.0);
+
+    return pos.xyz / pos.w / (-pos.z / pos.w);
+}
@@ -0,0 +1,197 @@
+#version 430 core
+/* Lighting pass of the deferred path. Each work group covers one screen tile: it culls the light
+   list against the tile frustum once, then every invocation shades its pixel with only the
+   lights that survived. */
+
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 256
+
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+struct PointLight {
+    vec4 position; // xyz: world space, w: radius of influence
+    vec4 color;
+};
+
+layout (std430, binding=2) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+uniform mat4 inverseProjection;
+uniform vec3 clearColor;
+
+// G-buffer
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+// Output
+layout (rgba16f, binding=0) uniform writeonly image2D litImage;
+
+// Tile shared state
+shared uint tile_min_depth;
+shared uint tile_max_depth;
+shared uint tile_light_count;
+shared uint tile_lights[MAX_LIGHTS_PER_TILE];
+
+// Forward declarations
+vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
+    in vec3 color_mat, in vec3 color_light);
+vec3 unproject(in vec2 ndc_xy, in float depth);
+float falloff_window(in float light_dist, in float radius);
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(litImage);
+    bool in_bounds = pixel.x < size.x && pixel.y < size.y;
+
+    if (gl_LocalInvocationIndex == 0) {
+        tile_min_depth = 0xFFFFFFFFu;
+        tile_max_depth = 0u;
+        tile_light_count = 0u;
+    }
+    barrier();
+
+    // Depth bounds of the tile (positive view space distances compare correctly as uint bits)
+    float depth = in_bounds ? texelFetch(gDepth, pixel, 0).x : 0.0;
+    vec2 ndc_xy = (vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0;
+    vec3 pos_vs = unproject(ndc_xy, depth);
+    bool covered = depth > 0.0;  // reverse-Z: cleared to 0, at infinity
+
+    if (covered) {
+        atomicMin(tile_min_depth, floatBitsToUint(-pos_vs.z));
+        atomicMax(tile_max_depth, floatBitsToUint(-pos_vs.z));
+    }
+    barrier();
+
+    // Side planes of the tile frustum; the eye is at the origin in view space
+    vec2 tile_min = vec2(gl_WorkGroupID.xy * TILE_SIZE) / vec2(size) * 2.0 - 1.0;
+    vec2 tile_max = vec2((gl_WorkGroupID.xy + 1) * TILE_SIZE) / vec2(size) * 2.0 - 1.0;
+
+    // (on the near plane, depth 1; any depth but infinity spans the same planes)
+    vec3 corners[4] = vec3[4](unproject(tile_min, 1.0),
+                              unproject(vec2(tile_max.x, tile_min.y), 1.0),
+                              unproject(tile_max, 1.0),
+                              unproject(vec2(tile_min.x, tile_max.y), 1.0));
+    vec3 center = unproject(0.5 * (tile_min + tile_max), 1.0);
+    vec4 planes[4];
+
+    for (int i = 0; i < 4; ++i) {
+        vec3 n = normalize(cross(corners[i], corners[(i + 1) % 4]));
+        planes[i] = vec4(dot(n, center) < 0.0 ? -n : n, 0.0);
+    }
+
+    float min_dist = uintBitsToFloat(tile_min_depth);
+    float max_dist = uintBitsToFloat(tile_max_depth);
+
+    // Cull lights; invocations of the group stride over the light list
+    uint light_count = lights.length();
+
+    for (uint i = gl_LocalInvocationIndex; i < light_count && tile_max_depth != 0u;
+         i += TILE_SIZE * TILE_SIZE) {
+        vec3 light_vs = (view * vec4(lights[i].position.xyz, 1.0)).xyz;
+        float radius = lights[i].position.w;
+
+        bool visible = -light_vs.z + radius >= min_dist && -light_vs.z - radius <= max_dist;
+
+        for (int p = 0; p < 4 && visible; ++p) {
+            visible = dot(planes[p].xyz, light_vs) > -radius;
+        }
+        if (visible) {
+            uint slot = atomicAdd(tile_light_count, 1u);
+
+            if (slot < MAX_LIGHTS_PER_TILE) {
+                tile_lights[slot] = i;
+            }
+        }
+    }
+    barrier();
+
+    if (!in_bounds) {
+        return;
+    }
+    if (!covered) {
+        imageStore(litImage, pixel, vec4(clearColor, 1.0));
+        return;
+    }
+
+    vec3 albedo = texelFetch(gAlbedo, pixel, 0).xyz;
+    vec3 normal_vs = normalize(texelFetch(gNormal, pixel, 0).xyz);
+    vec3 eyepos_vs = vec3(0, 0, 0);
+    vec3 color = vec3(0.0);
+
+    uint tile_count = min(tile_light_count, uint(MAX_LIGHTS_PER_TILE));
+
+    // Accumulate all lights of the tile, in view space
+    for (uint i = 0; i < tile_count; ++i) {
+        PointLight light = lights[tile_lights[i]];
+        vec3 lightpos_vs = (view * vec4(light.position.xyz, 1.0)).xyz;
+        float window = falloff_window(length(lightpos_vs - pos_vs), light.position.w);
+
+        color += window * lighting(pos_vs, lightpos_vs, eyepos_vs, normal_vs, albedo, light.color.xyz);
+    }
+
+#ifdef AMBIENT_OCCLUSION
+    // Ambient light, occluded by the mesh itself; the visibility is in the albedo's alpha
+    color += AO_AMBIENT * texelFetch(gAlbedo, pixel, 0).w * albedo;
+#endif
+
+    imageStore(litImage, pixel, vec4(color, 1.0));
+}
+
+vec3 unproject(in vec2 ndc_xy, in float depth) {
+    // Window depth [0,1] -> NDC (the same, with GL_ZERO_TO_ONE) -> View space
+    vec4 pos = inverseProjection * vec4(ndc_xy, depth, 1.0);
+
+    return pos.xyz / pos.w;
+}
+
+float falloff_window(in float light_dist, in float radius) {
+    // Smoothly forces the contribution to zero at the culling radius
+    float ratio = clamp(light_dist / radius, 0.0, 1.0);
+    float window = 1.0 - ratio * ratio * ratio * ratio;
+
+    return window * window;
+}
+
+vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
+    in vec3 color_mat, in vec3 color_light)
+{
+    // Computes ambient, diffuse, and specular contributions and the overall color
+    vec3 light_vec = light_pos - vertex_pos.xyz;
+    vec3 light_dir = normalize(light_vec);
+    float light_dist = length(light_vec);
+    vec3 view_dir = normalize(eye_pos - vertex_pos);
+
+    // Ambient contribution (very weak)
+    vec3 ambient = .005 * color_light;
+
+    // Diffuse contribution
+    float diffuse = max(dot(normal, light_dir), 0.0);
+
+    // Specular contribution
+    vec3 h_vector = normalize(view_dir + light_dir);
+    float specular = pow(max(dot(normal, h_vector), 0.0), 256.0);
+
+    // Constant, linear and quadratic falloff
+    float attenuation = 1.0 / (1.0f + 0.07f * light_dist + .017f * (light_dist * light_dist));
+
+    vec3 diffuse_color = diffuse * mix(color_light, color_mat, .75);
+    vec3 specular_color = specular * mix(color_light, color_mat, .75);
+
+    diffuse *= attenuation;
+    specular *= attenuation;
+
+    // Combine lighting contributions
+    vec3 color = ambient + diffuse_color + specular_color;
+
+    return color;
+}
@@ -0,0 +1,105 @@
+#version 460 core
+/* Geometry pass of the deferred path; the normal map is resolved to view space here so the
+   lighting pass only needs a single normal per pixel */
+
+// Inputs
+in VS_OUTPUT {
+    vec3 oNormalViewSpace; // computed
+    vec3 oTangentViewSpace; // computed
+    vec2 oTextureCoords; // forwarded
+    flat uint oMaterial; // forwarded; index into the material table
+#ifdef AMBIENT_OCCLUSION
+    float oVisibility; // forwarded; baked ambient visibility
+#endif
+} vs_inputs;
+
+// Material table; textures are found through it
+struct Material {
+    uvec4 textures; // bindless: diffuse and normal handles; otherwise (array, layer) of each
+    vec4 color; // rgb: albedo of untextured meshes; w: 1 if textured
+};
+
+layout (std430, binding=6) readonly buffer Materials
+{
+    Material materials[];
+};
+
+// Without bindless handles, textures live in one array per texture size
+#ifndef BINDLESS_TEXTURES
+#define MAX_MATERIAL_ARRAYS 8
+uniform sampler2DArray materialArrays[MAX_MATERIAL_ARRAYS];
+#endif
+
+// Untextured materials (.off) and shading modes other than normal mapping use the material color and
+// the interpolated vertex normal
+uniform bool useTextures;
+
+// Outputs (G-buffer); depth is written to the depth attachment
+layout(location = 0) out vec4 outAlbedo;
+layout(location = 1) out vec4 outNormal;
+
+// Forward declarations
+vec3 resolve_normal(in Material material, in bool textured, in vec2 uv_dx, in vec2 uv_dy);
+vec4 sample_material(in uvec2 texture_ref, in vec2 uv, in vec2 uv_dx, in vec2 uv_dy);
+
+void main() {
+    Material material = materials[vs_inputs.oMaterial];
+    bool textured = useTextures && material.color.w > 0.0;
+
+    // Gradients in uniform control flow; untextured materials have no valid texture to sample
+    vec2 uv_dx = dFdx(vs_inputs.oTextureCoords);
+    vec2 uv_dy = dFdy(vs_inputs.oTextureCoords);
+
+    if (textured) {
+        outAlbedo = vec4(sample_material(material.textures.xy, vs_inputs.oTextureCoords, uv_dx, uv_dy).xyz, 1.0);
+    } else {
+        outAlbedo = vec4(material.color.xyz, 1.0);
+    }
+    outNormal = vec4(resolve_normal(material, textured, uv_dx, uv_dy), 0.0);
+
+#ifdef AMBIENT_OCCLUSION
+    // The albedo's alpha carries the baked ambient visibility to the lighting pass
+    outAlbedo.w = vs_inputs.oVisibility;
+#endif
+}
+
+vec3 resolve_normal(in Material material, in bool textured, in vec2 uv_dx, in vec2 uv_dy) {
+    vec3 normal_vs = normalize(vs_inputs.oNormalViewSpace);  // "N"
+
+    if (!textured) {
+        return normal_vs;
+    }
+
+    // Orthonormalize via Gram–Schmidt process
+    vec3 tangent_vs = normalize(vs_inputs.oTangentViewSpace);
+    tangent_vs = normalize(tangent_vs - dot(tangent_vs, normal_vs) * normal_vs);  // "T"
+
+    // Compute bitangent
+    vec3 bitangent_vs = cross(normal_vs, tangent_vs);  // "B"
+
+    // Sample from normal map and transform to range [-1,1]
+    vec3 normal_ts = sample_material(material.textures.zw, vs_inputs.oTextureCoords, uv_dx, uv_dy).xyz;
+    normal_ts = normalize(2.0 * normal_ts - vec3(1.0, 1.0, 1.0));
+
+    // Tangent space -> View space
+    return normalize(mat3(tangent_vs, bitangent_vs, normal_vs) * normal_ts);
+}
+
+
+vec4 sample_material(in uvec2 texture_ref, in vec2 uv, in vec2 uv_dx, in vec2 uv_dy) {
+    // Looks up one texture of a material. Neighbouring fragments may belong to different draws, so
+    // this can run in non-uniform control flow: explicit gradients, taken by the caller beforehand
+#ifdef BINDLESS_TEXTURES
+    return textureGrad(sampler2D(texture_ref), uv, uv_dx, uv_dy);
+#else
+    // Sampler arrays may only be indexed uniformly; test every array with a constant index instead
+    vec4 color = vec4(0.0);
+
+    for (int i = 0; i < MAX_MATERIAL_ARRAYS; ++i) {
+        if (uint(i) == texture_ref.x) {
+            color = textureGrad(materialArrays[i], vec3(uv, float(texture_ref.y)), uv_dx, uv_dy);
+        }
+    }
+    return color;
+#endif
+}
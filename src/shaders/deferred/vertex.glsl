@@ -0,0 +1,115 @@
+#version 460 core
+/* Geometry pass of the deferred path; writes surface attributes instead of a color */
+
+#ifdef VERTEX_PULLING
+// Vertex pulling (see vertex_pulling.h): every stream is read, at gl_VertexID
+layout (std430, binding=8) readonly buffer Positions
+{
+    float positions[];
+};
+
+layout (std430, binding=9) readonly buffer Normals
+{
+    float normals[];
+};
+
+layout (std430, binding=10) readonly buffer Tangents
+{
+    float tangents[];
+};
+
+layout (std430, binding=11) readonly buffer TextureCoords
+{
+    float uvs[];
+};
+
+vec3 pull_position(in int index);
+vec3 pull_normal(in int index);
+vec3 pull_tangent(in int index);
+vec2 pull_uv(in int index);
+
+#define aPos pull_position(gl_VertexID)
+#define aNormal pull_normal(gl_VertexID)
+#define aTangent pull_tangent(gl_VertexID)
+#define aTextureCoords pull_uv(gl_VertexID)
+#else
+// Vertex attributes
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aTangent;
+layout (location = 3) in vec2 aTextureCoords;
+#endif
+
+#ifdef AMBIENT_OCCLUSION
+// Baked visibility of the hemisphere above the vertex (see ambient_occlusion.h); 0 when fully occluded
+layout (location = 4) in float aVisibility;
+#endif
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+struct Instance {
+    mat4 world;
+    mat4 normalToView;
+    mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+// Per-instance data; every command of the multi-draw carries its instance as the base instance
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+// Outputs
+out VS_OUTPUT {
+    vec3 oNormalViewSpace; // computed
+    vec3 oTangentViewSpace; // computed
+    vec2 oTextureCoords; // forwarded
+    flat uint oMaterial; // forwarded; index into the material table
+#ifdef AMBIENT_OCCLUSION
+    float oVisibility; // forwarded; baked ambient visibility
+#endif
+} outputs;
+
+void main() {
+    Instance instance = instances[gl_BaseInstance];
+
+    // Model space -> Perspective
+    gl_Position = projection * view * instance.world * vec4(aPos, 1.0);
+
+    // Model space -> View space; the fragment shader builds the TBN basis from these
+    outputs.oNormalViewSpace = mat3(instance.normalToView) * aNormal;
+    outputs.oTangentViewSpace = mat3(instance.normalToView) * aTangent;
+
+    // Forward texture coords and material
+    outputs.oTextureCoords = aTextureCoords;
+    outputs.oMaterial = instance.material.x;
+
+#ifdef AMBIENT_OCCLUSION
+    outputs.oVisibility = aVisibility;
+#endif
+}
+
+#ifdef VERTEX_PULLING
+// The streams are float arrays: std430 would pad a vec3 array to 16 bytes per element
+vec3 pull_position(in int index) {
+    return vec3(positions[3 * index], positions[3 * index + 1], positions[3 * index + 2]);
+}
+
+vec3 pull_normal(in int index) {
+    return vec3(normals[3 * index], normals[3 * index + 1], normals[3 * index + 2]);
+}
+
+vec3 pull_tangent(in int index) {
+    return vec3(tangents[3 * index], tangents[3 * index + 1], tangents[3 * index + 2]);
+}
+
+vec2 pull_uv(in int index) {
+    return vec2(uvs[2 * index], uvs[2 * index + 1]);
+}
+#endif
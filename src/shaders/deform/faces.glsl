@@ -0,0 +1,87 @@
+#version 430 core
+/* Deformation, second pass. One invocation per triangle: its face normal and tangent (as on load, see
+   ComputeTangent) are added to the sums of its three vertices. Float atomics are not core, so the unit vectors are
+   added in fixed point with integer atomics; 2^16 per unit leaves room for 2^15 faces around a vertex. */
+
+#define GROUP_SIZE 64
+#define FIXED_ONE 65536.0
+
+layout (local_size_x = GROUP_SIZE) in;
+
+layout (std430, binding=17) readonly buffer DeformPositions
+{
+    vec4 positions[];
+};
+
+layout (std430, binding=18) buffer DeformSums
+{
+    int sums[]; // normal xyz, tangent xyz
+};
+
+layout (std430, binding=19) readonly buffer DeformCorners
+{
+    uint corners[]; // unique vertex of each corner
+};
+
+layout (std430, binding=20) readonly buffer Vertices
+{
+    float vertices[]; // 11 per corner: position, normal, tangent, uv
+};
+
+uniform uint triangleCount;
+
+// Forward declarations
+vec2 corner_uv(in uint corner);
+void add_sum(in uint vertex, in uint offset, in vec3 value);
+
+void main() {
+    uint triangle = gl_GlobalInvocationID.x;
+
+    if (triangle >= triangleCount) {
+        return;
+    }
+
+    uint first = triangle * 3;
+    uint v0 = corners[first];
+    uint v1 = corners[first + 1];
+    uint v2 = corners[first + 2];
+
+    vec3 edge1 = positions[v1].xyz - positions[v0].xyz;
+    vec3 edge2 = positions[v2].xyz - positions[v0].xyz;
+    vec3 normal = cross(edge1, edge2);
+
+    if (dot(normal, normal) == 0.0) {
+        return;
+    }
+    normal = normalize(normal);
+
+    // Tangent along u; untextured meshes have no uvs and no tangent
+    vec2 delta_uv1 = corner_uv(first + 1) - corner_uv(first);
+    vec2 delta_uv2 = corner_uv(first + 2) - corner_uv(first);
+    float determinant = delta_uv1.x * delta_uv2.y - delta_uv2.x * delta_uv1.y;
+    vec3 tangent = vec3(0.0);
+
+    if (determinant != 0.0) {
+        tangent = (delta_uv2.y * edge1 - delta_uv1.y * edge2) / determinant;
+        tangent = dot(tangent, tangent) > 0.0 ? normalize(tangent) : vec3(0.0);
+    }
+
+    add_sum(v0, 0u, normal);
+    add_sum(v1, 0u, normal);
+    add_sum(v2, 0u, normal);
+    add_sum(v0, 3u, tangent);
+    add_sum(v1, 3u, tangent);
+    add_sum(v2, 3u, tangent);
+}
+
+vec2 corner_uv(in uint corner) {
+    return vec2(vertices[corner * 11 + 9], vertices[corner * 11 + 10]);
+}
+
+void add_sum(in uint vertex, in uint offset, in vec3 value) {
+    ivec3 fixed_value = ivec3(round(value * FIXED_ONE));
+
+    atomicAdd(sums[vertex * 6 + offset], fixed_value.x);
+    atomicAdd(sums[vertex * 6 + offset + 1], fixed_value.y);
+    atomicAdd(sums[vertex * 6 + offset + 2], fixed_value.z);
+}
@@ -0,0 +1,88 @@
+#version 430 core
+/* Deformation, first pass. One invocation per unique vertex: its rest position is blended with the morph targets,
+   or waved, or twisted about the vertical axis of its mesh, and the normal and tangent sums of the next pass are
+   cleared. */
+
+#define GROUP_SIZE 64
+#define TARGETS 2
+
+// Modes, in DeformationMode order
+#define MORPH 1u
+#define WAVE 2u
+#define TWIST 3u
+
+#define WAVE_AMPLITUDE 0.06  // of the mesh radius
+#define WAVE_LENGTH 0.8      // of the mesh radius
+#define WAVE_SPEED 3.0       // radians per second
+#define TWIST_ANGLE 1.2      // radians between the center and the top of the bounding sphere, at the peak
+#define MORPH_SPEED 1.5      // radians per second
+
+layout (local_size_x = GROUP_SIZE) in;
+
+layout (std430, binding=14) readonly buffer DeformRest
+{
+    vec4 rest[]; // xyz: model space position, w: mesh
+};
+
+layout (std430, binding=15) readonly buffer DeformTargets
+{
+    vec4 targets[]; // offsets, target by target
+};
+
+layout (std430, binding=16) readonly buffer DeformMeshes
+{
+    vec4 meshes[]; // xyz: center, w: radius
+};
+
+layout (std430, binding=17) writeonly buffer DeformPositions
+{
+    vec4 positions[];
+};
+
+layout (std430, binding=18) writeonly buffer DeformSums
+{
+    int sums[]; // normal xyz, tangent xyz
+};
+
+uniform float time;
+uniform uint mode;
+uniform uint uniqueCount;
+
+void main() {
+    uint vertex = gl_GlobalInvocationID.x;
+
+    if (vertex >= uniqueCount) {
+        return;
+    }
+
+    vec3 position = rest[vertex].xyz;
+    vec4 mesh = meshes[uint(rest[vertex].w)];
+    vec3 local = (position - mesh.xyz) / mesh.w;
+
+    if (mode == MORPH) {
+        // Each target fades in and out at its own pace
+        for (uint i = 0; i < uint(TARGETS); ++i) {
+            float weight = 0.5 - 0.5 * cos(MORPH_SPEED * time * (1.0 + 0.37 * float(i)) + float(i));
+
+            position += weight * targets[i * uniqueCount + vertex].xyz;
+        }
+    } else if (mode == WAVE) {
+        // Travelling along x, displacing y
+        float phase = local.x / WAVE_LENGTH * 6.2831853 - WAVE_SPEED * time;
+
+        position.y += WAVE_AMPLITUDE * mesh.w * sin(phase);
+    } else if (mode == TWIST) {
+        float angle = TWIST_ANGLE * local.y * sin(time);
+        float c = cos(angle);
+        float s = sin(angle);
+        vec3 offset = position - mesh.xyz;
+
+        position = mesh.xyz + vec3(c * offset.x + s * offset.z, offset.y, -s * offset.x + c * offset.z);
+    }
+
+    positions[vertex] = vec4(position, 0.0);
+
+    for (uint i = 0; i < 6u; ++i) {
+        sums[vertex * 6 + i] = 0;
+    }
+}
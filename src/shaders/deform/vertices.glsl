@@ -0,0 +1,75 @@
+#version 430 core
+/* Deformation, last pass. One invocation per corner of the vertex buffer: its position, normal and tangent are
+   rewritten in place from its unique vertex; the uv is left as loaded. Flat and wireframe shading take the face
+   normal, as on load. */
+
+#define GROUP_SIZE 64
+
+layout (local_size_x = GROUP_SIZE) in;
+
+layout (std430, binding=17) readonly buffer DeformPositions
+{
+    vec4 positions[];
+};
+
+layout (std430, binding=18) readonly buffer DeformSums
+{
+    int sums[]; // normal xyz, tangent xyz
+};
+
+layout (std430, binding=19) readonly buffer DeformCorners
+{
+    uint corners[]; // unique vertex of each corner
+};
+
+layout (std430, binding=20) buffer Vertices
+{
+    float vertices[]; // 11 per corner: position, normal, tangent, uv
+};
+
+uniform uint vertexCount;
+uniform bool faceNormals;
+
+// Forward declarations
+vec3 sum(in uint vertex, in uint offset);
+vec3 safe_normalize(in vec3 v);
+void write_vec3(in uint corner, in uint offset, in vec3 value);
+
+void main() {
+    uint corner = gl_GlobalInvocationID.x;
+
+    if (corner >= vertexCount) {
+        return;
+    }
+
+    uint vertex = corners[corner];
+    vec3 position = positions[vertex].xyz;
+    vec3 normal = safe_normalize(sum(vertex, 0u));
+
+    if (faceNormals) {
+        uint first = corner - corner % 3u;
+        vec3 a = positions[corners[first]].xyz;
+        vec3 b = positions[corners[first + 1]].xyz;
+        vec3 c = positions[corners[first + 2]].xyz;
+
+        normal = safe_normalize(cross(b - a, c - a));
+    }
+
+    write_vec3(corner, 0u, position);
+    write_vec3(corner, 3u, normal);
+    write_vec3(corner, 6u, safe_normalize(sum(vertex, 3u)));
+}
+
+vec3 sum(in uint vertex, in uint offset) {
+    return vec3(sums[vertex * 6 + offset], sums[vertex * 6 + offset + 1], sums[vertex * 6 + offset + 2]);
+}
+
+vec3 safe_normalize(in vec3 v) {
+    return dot(v, v) > 0.0 ? normalize(v) : vec3(0.0);
+}
+
+void write_vec3(in uint corner, in uint offset, in vec3 value) {
+    vertices[corner * 11 + offset] = value.x;
+    vertices[corner * 11 + offset + 1] = value.y;
+    vertices[corner * 11 + offset + 2] = value.z;
+}
@@ -0,0 +1,5 @@
+#version 430 core
+/* Depth pre-pass; color writes are masked off, only the depth test and write happen */
+
+void main() {
+}
@@ -0,0 +1,35 @@
+#version 460 core
+/* Depth pre-pass; only the position stream is read. The transform must be written exactly like in
+   the shading passes so both produce bit-identical depth (see 'invariant') */
+
+// Vertex attributes
+layout (location = 0) in vec3 aPos;
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+struct Instance {
+    mat4 world;
+    mat4 normalToView;
+    mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+// Per-instance data; every command of the multi-draw carries its instance as the base instance
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+invariant gl_Position;
+
+void main() {
+    mat4 world = instances[gl_BaseInstance].world;
+
+    // Model space -> Perspective
+    gl_Position = projection * (view * (world * vec4(aPos, 1.0)));
+}
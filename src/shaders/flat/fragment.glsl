@@ -1,4 +1,4 @@
-#version 420 core
+#version 430 core
 /* The only difference between this and the Gouraud shader is the 'flat' keyword below */
 
 // Inputs
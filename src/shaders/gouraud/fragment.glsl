@@ -1,11 +1,54 @@
-#version 420 core
+#version 430 core
 
 // Inputs
 in vec3 oColor;
 
+#ifdef SHADOWS
+in vec3 oKeyColor;
+in vec4 oShadowCoord;
+
+// Key light shadow map (see shadows.h)
+layout (std140, binding=7) uniform Shadow
+{
+    mat4 shadowFromWorld; // world space -> shadow map coordinates, before the divide
+    vec4 shadowParams; // x: normal offset per unit of light distance, y: depth bias, z: 1 / map size
+};
+
+uniform sampler2DShadow shadowMap;
+
+// Forward declarations
+float shadow_factor(in vec4 shadow_coord);
+#endif
+
 // Outputs
 out vec3 outColor;
 
 void main() {
     outColor = oColor;
+
+#ifdef SHADOWS
+    outColor += shadow_factor(oShadowCoord) * oKeyColor;
+#endif
+}
+
+#ifdef SHADOWS
+float shadow_factor(in vec4 shadow_coord) {
+    // Visibility of the key light, 3x3 comparison taps (each bilinear filtered); 1 outside the map
+    vec3 coord = shadow_coord.xyz / shadow_coord.w;
+
+    if (shadow_coord.w <= 0.0 || any(lessThan(coord.xy, vec2(0.0))) || any(greaterThan(coord.xy, vec2(1.0)))) {
+        return 1.0;
+    }
+
+    // Reverse-Z: a slightly larger reference is slightly nearer the light
+    float reference = coord.z * (1.0 + shadowParams.y);
+    float visible = 0.0;
+
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            visible += texture(shadowMap, vec3(coord.xy + vec2(x, y) * shadowParams.z, reference));
+        }
+    }
+    return visible / 9.0;
 }
+#endif
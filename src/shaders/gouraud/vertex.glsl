@@ -1,51 +1,162 @@
-#version 420 core
+#version 460 core
 
+#ifdef VERTEX_PULLING
+// Vertex pulling (see vertex_pulling.h): only the position and normal streams, read at gl_VertexID
+layout (std430, binding=8) readonly buffer Positions
+{
+    float positions[];
+};
+
+layout (std430, binding=9) readonly buffer Normals
+{
+    float normals[];
+};
+
+vec3 pull_position(in int index);
+vec3 pull_normal(in int index);
+
+#define aPos pull_position(gl_VertexID)
+#define aNormal pull_normal(gl_VertexID)
+#else
 // Vertex attributes
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+#endif
+
+#ifdef AMBIENT_OCCLUSION
+// Baked visibility of the hemisphere above the vertex (see ambient_occlusion.h); 0 when fully occluded
+layout (location = 4) in float aVisibility;
+#endif
 
 // Uniform variables
 layout (std140, binding=0) uniform Matrices
 {
-    mat4 world;
     mat4 view;
     mat4 projection;
-    mat4 normal_to_view;
-    mat4 normal_to_world;
+};
+
+struct Instance {
+    mat4 world;
+    mat4 normalToView;
+    mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+// Per-instance data; every command of the multi-draw carries its instance as the base instance
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
 };
 
 layout (std140, binding=1) uniform Lighting
 {
     vec4 eyePos;
-    vec4 lightPos;
-    vec4 lightColor;
+    uvec4 clusterGrid; // x, y, z froxel counts; w: light capacity per cluster
+    vec4 clusterDepth; // near, far, z slices / log(far / near)
+    vec4 viewport;
+};
+
+struct PointLight {
+    vec4 position; // xyz: world space, w: radius of influence
+    vec4 color;
+};
+
+// Light list and the per-cluster light indices built by the clustered culling pre-pass
+layout (std430, binding=2) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+layout (std430, binding=3) readonly buffer ClusterLights
+{
+    uint clusterLights[];
 };
 
+layout (std430, binding=4) readonly buffer ClusterCounts
+{
+    uint clusterCounts[];
+};
+
+#ifdef SHADOWS
+// Key light shadow map (see shadows.h)
+layout (std140, binding=7) uniform Shadow
+{
+    mat4 shadowFromWorld; // world space -> shadow map coordinates, before the divide
+    vec4 shadowParams; // x: normal offset per unit of light distance, y: depth bias, z: 1 / map size
+};
+#endif
+
 // Outputs
 out vec3 oColor;
 
+#ifdef SHADOWS
+// The key light is added per fragment, scaled by its visibility
+out vec3 oKeyColor;
+out vec4 oShadowCoord;
+#endif
+
+// Depth must match the depth pre-pass exactly
+invariant gl_Position;
+
 // Forward declarations
 vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
     in vec3 color_mat, in vec3 color_light);
+uint cluster_index(in vec2 ndc_xy, in float view_depth);
+float falloff_window(in float light_dist, in float radius);
 
 void main() {
-    vec3 lightpos_vs;
     vec3 eyepos_vs = vec3(0,0,0);
+    mat4 world = instances[gl_BaseInstance].world;
 
     // Model space -> View
-    gl_Position = view * world * vec4(aPos, 1.0);
+    vec4 pos_vs4 = view * (world * vec4(aPos, 1.0));
+    vec3 pos_vs = pos_vs4.xyz;
 
-    // World space -> View
-    lightpos_vs = (view * lightPos).xyz;
+    // Camera -> Perspective; same expression as the depth pre-pass
+    gl_Position = projection * pos_vs4;
 
     // Update vertex normal from model space to view space, and normalize
-    vec3 normal_vs = normalize(mat3(normal_to_view) * aNormal);
+    vec3 normal_vs = normalize(mat3(instances[gl_BaseInstance].normalToView) * aNormal);
 
-    // Compute lighting, in view space
-    oColor = lighting(gl_Position.xyz, lightpos_vs, eyepos_vs, normal_vs, lightColor.xyz, lightColor.xyz);
+    // Only the lights binned into this vertex's cluster; the key light (0) sets the material color
+    uint cluster = cluster_index(gl_Position.xy / gl_Position.w, -pos_vs.z);
+    uint count = clusterCounts[cluster];
+    vec3 color_mat = lights[0].color.xyz;
+
+    oColor = vec3(0.0);
+
+#ifdef SHADOWS
+    oKeyColor = vec3(0.0);
+
+    // Offset along the normal by a few shadow texels, so the surface does not shadow itself
+    vec3 pos_ws = (world * vec4(aPos, 1.0)).xyz;
+    vec3 normal_ws = normalize(mat3(instances[gl_BaseInstance].normalToWorld) * aNormal);
+    float offset = shadowParams.x * length(lights[0].position.xyz - pos_ws);
+
+    oShadowCoord = shadowFromWorld * vec4(pos_ws + offset * normal_ws, 1.0);
+#endif
 
-    // Camera -> Perspective
-    gl_Position = projection * gl_Position;
+    // Compute lighting, in view space
+    for (uint i = 0; i < count; ++i) {
+        uint index = clusterLights[cluster * clusterGrid.w + i];
+        PointLight light = lights[index];
+        vec3 lightpos_vs = (view * vec4(light.position.xyz, 1.0)).xyz;
+        float window = falloff_window(length(lightpos_vs - pos_vs), light.position.w);
+        vec3 color = window * lighting(pos_vs, lightpos_vs, eyepos_vs, normal_vs, color_mat, light.color.xyz);
+
+#ifdef SHADOWS
+        if (index == 0u) {
+            oKeyColor += color;
+            continue;
+        }
+#endif
+        oColor += color;
+    }
+
+#ifdef AMBIENT_OCCLUSION
+    // Ambient light, occluded by the mesh itself
+    oColor += AO_AMBIENT * aVisibility * color_mat;
+#endif
 }
 
 vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
@@ -81,3 +192,31 @@ vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 no
 
     return color;
 }
+
+uint cluster_index(in vec2 ndc_xy, in float view_depth) {
+    // Froxel containing a position given in NDC (x, y) and view space distance
+    vec2 cell_xy = clamp((ndc_xy * 0.5 + 0.5) * vec2(clusterGrid.xy), vec2(0.0), vec2(clusterGrid.xy) - 1.0);
+    float slice = log(max(view_depth, clusterDepth.x) / clusterDepth.x) * clusterDepth.z;
+    uint cell_z = uint(clamp(slice, 0.0, float(clusterGrid.z) - 1.0));
+
+    return (cell_z * clusterGrid.y + uint(cell_xy.y)) * clusterGrid.x + uint(cell_xy.x);
+}
+
+float falloff_window(in float light_dist, in float radius) {
+    // Smoothly forces the contribution to zero at the culling radius
+    float ratio = clamp(light_dist / radius, 0.0, 1.0);
+    float window = 1.0 - ratio * ratio * ratio * ratio;
+
+    return window * window;
+}
+
+#ifdef VERTEX_PULLING
+// The streams are float arrays: std430 would pad a vec3 array to 16 bytes per element
+vec3 pull_position(in int index) {
+    return vec3(positions[3 * index], positions[3 * index + 1], positions[3 * index + 2]);
+}
+
+vec3 pull_normal(in int index) {
+    return vec3(normals[3 * index], normals[3 * index + 1], normals[3 * index + 2]);
+}
+#endif
@@ -0,0 +1,273 @@
+#version 460 core
+/* Octahedral impostor: the view ray is intersected with the planes of the four baked views nearest to its
+   direction; each sample is moved along the ray to the baked depth, and the four are blended */
+
+#define GRID 8 // views per side of the grid; impostor_grid in impostors.h
+#define PARALLAX_STEPS 3
+
+// Inputs
+in IMPOSTOR_OUTPUT {
+    flat vec3 oRayOrigin; // computed; the eye
+    vec3 oQuadPos; // computed; point of the quad
+    flat uint oInstance; // forwarded
+    flat uint oLayer; // forwarded
+} vs_inputs;
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+layout (std140, binding=1) uniform Lighting
+{
+    vec4 eyePos;
+    uvec4 clusterGrid; // x, y, z froxel counts; w: light capacity per cluster
+    vec4 clusterDepth; // near, far, z slices / log(far / near)
+    vec4 viewport;
+};
+
+struct Instance {
+    mat4 world;
+    mat4 normalToView;
+    mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+struct PointLight {
+    vec4 position; // xyz: world space, w: radius of influence
+    vec4 color;
+};
+
+// Light list and the per-cluster light indices built by the clustered culling pre-pass
+layout (std430, binding=2) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+layout (std430, binding=3) readonly buffer ClusterLights
+{
+    uint clusterLights[];
+};
+
+layout (std430, binding=4) readonly buffer ClusterCounts
+{
+    uint clusterCounts[];
+};
+
+layout (std430, binding=13) readonly buffer ImpostorSpheres
+{
+    vec4 impostorSpheres[]; // model space; xyz: center, w: radius
+};
+
+// Atlases; one layer per mesh, GRID x GRID views per layer
+uniform sampler2DArray impostorAlbedo; // alpha: coverage
+uniform sampler2DArray impostorNormal; // model space
+uniform sampler2DArray impostorDepth; // 1 at the front of the bounding sphere, 0 at its back
+
+// Outputs
+layout(location = 0) out vec3 outColor;
+
+// One baked view as seen along the ray
+struct ViewSample {
+    vec4 albedo; // premultiplied by coverage
+    vec3 normal; // model space, weighted by coverage
+    vec3 position; // model space
+};
+
+// Forward declarations
+vec3 hemi_octahedron_direction(in vec2 grid_uv);
+vec2 hemi_octahedron_grid(in vec3 direction);
+ViewSample sample_view(in vec2 frame, in vec3 origin, in vec3 ray, in vec4 sphere, in float layer, in float lod);
+vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
+    in vec3 color_mat, in vec3 color_light);
+uint cluster_index(in vec2 ndc_xy, in float view_depth);
+float falloff_window(in float light_dist, in float radius);
+
+void main() {
+    vec4 sphere = impostorSpheres[vs_inputs.oLayer];
+    vec3 origin = vs_inputs.oRayOrigin;
+    vec3 ray = normalize(vs_inputs.oQuadPos - origin);
+    float layer = float(vs_inputs.oLayer);
+
+    // Mip level from the footprint of the pixel on the quad; taken here, in uniform control flow
+    vec3 pos_dx = dFdx(vs_inputs.oQuadPos);
+    vec3 pos_dy = dFdy(vs_inputs.oQuadPos);
+    float texels_per_unit = float(textureSize(impostorAlbedo, 0).x) / (2.0 * sphere.w * float(GRID));
+    float lod = log2(max(max(length(pos_dx), length(pos_dy)) * texels_per_unit, 1.0));
+
+    // Views are baked above the horizon only; from below, the horizon views are used
+    vec3 to_eye = normalize(origin - sphere.xyz);
+    vec2 grid = hemi_octahedron_grid(normalize(vec3(to_eye.x, max(to_eye.y, 0.0), to_eye.z))) * float(GRID - 1);
+    vec2 frame = min(floor(grid), vec2(GRID - 2));
+    vec2 blend = grid - frame;
+
+    // Bilinear weights of the four nearest views
+    ViewSample samples[4];
+    float weights[4] = float[4]((1.0 - blend.x) * (1.0 - blend.y), blend.x * (1.0 - blend.y),
+                                (1.0 - blend.x) * blend.y, blend.x * blend.y);
+
+    samples[0] = sample_view(frame, origin, ray, sphere, layer, lod);
+    samples[1] = sample_view(frame + vec2(1.0, 0.0), origin, ray, sphere, layer, lod);
+    samples[2] = sample_view(frame + vec2(0.0, 1.0), origin, ray, sphere, layer, lod);
+    samples[3] = sample_view(frame + vec2(1.0, 1.0), origin, ray, sphere, layer, lod);
+
+    vec4 albedo = vec4(0.0);
+    vec3 normal_ms = vec3(0.0);
+    vec3 pos_ms = vec3(0.0);
+
+    for (int i = 0; i < 4; ++i) {
+        albedo += weights[i] * samples[i].albedo;
+        normal_ms += weights[i] * samples[i].normal;
+        pos_ms += weights[i] * samples[i].albedo.a * samples[i].position;
+    }
+
+    if (albedo.a < 0.5) {
+        discard;
+    }
+    pos_ms /= albedo.a;
+
+    // Depth of the surface found, not of the quad, so impostors and meshes intersect correctly
+    Instance instance = instances[vs_inputs.oInstance];
+    vec4 pos_ws = instance.world * vec4(pos_ms, 1.0);
+    vec4 pos_vs = view * pos_ws;
+    vec4 clip = projection * pos_vs;
+
+    gl_FragDepth = clip.z / clip.w;
+
+    // Lit in world space, with the lights of the fragment's cluster
+    vec3 normal_ws = normalize(mat3(instance.normalToWorld) * normal_ms);
+    vec3 color_mat = albedo.rgb / albedo.a;
+    uint cluster = cluster_index(gl_FragCoord.xy / viewport.xy * 2.0 - 1.0, -pos_vs.z);
+    uint count = clusterCounts[cluster];
+
+    outColor = vec3(0.0);
+
+    for (uint i = 0; i < count; ++i) {
+        PointLight light = lights[clusterLights[cluster * clusterGrid.w + i]];
+        float window = falloff_window(length(light.position.xyz - pos_ws.xyz), light.position.w);
+
+        outColor += window * lighting(pos_ws.xyz, light.position.xyz, eyePos.xyz, normal_ws, color_mat,
+                                      light.color.xyz);
+    }
+}
+
+vec3 hemi_octahedron_direction(in vec2 grid_uv) {
+    // [0, 1]^2 -> direction with y >= 0; the corners and edges of the square are on the horizon
+    vec2 o = grid_uv * 2.0 - 1.0;
+    vec3 direction = vec3(0.5 * (o.x + o.y), 0.0, 0.5 * (o.x - o.y));
+
+    direction.y = 1.0 - abs(direction.x) - abs(direction.z);
+
+    return normalize(direction);
+}
+
+vec2 hemi_octahedron_grid(in vec3 direction) {
+    // Inverse of hemi_octahedron_direction
+    direction /= abs(direction.x) + abs(direction.y) + abs(direction.z);
+
+    return vec2(direction.x + direction.z, direction.x - direction.z) * 0.5 + 0.5;
+}
+
+ViewSample sample_view(in vec2 frame, in vec3 origin, in vec3 ray, in vec4 sphere, in float layer, in float lod) {
+    // Intersects the ray with the plane of a view, at the baked depth (a few fixed point steps)
+    ViewSample result = ViewSample(vec4(0.0), vec3(0.0), vec3(0.0));
+    vec3 direction = hemi_octahedron_direction(frame / float(GRID - 1));
+    float facing = dot(ray, direction);
+
+    // The view looks along -direction; rays from behind it see nothing
+    if (facing > -1e-3) {
+        return result;
+    }
+
+    // Same basis as the bake camera (ImpostorFrameBasis)
+    vec3 up_ref = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up_ref, direction));
+    vec3 up = cross(direction, right);
+
+    // Half a texel inside the view, so filtering never reads its neighbours
+    vec2 frame_min = (frame * float(textureSize(impostorAlbedo, 0).x) / float(GRID) + 0.5) /
+                     vec2(textureSize(impostorAlbedo, 0).xy);
+    vec2 frame_max = frame_min + (1.0 / float(GRID)) - 1.0 / vec2(textureSize(impostorAlbedo, 0).xy);
+    float height = 0.0;  // above the plane through the center, along direction
+    vec3 position = vec3(0.0);
+    vec2 uv = vec2(0.0);
+
+    for (int i = 0; i < PARALLAX_STEPS; ++i) {
+        float t = (height - dot(origin - sphere.xyz, direction)) / facing;
+
+        position = origin + t * ray;
+
+        vec2 local = vec2(dot(position - sphere.xyz, right), dot(position - sphere.xyz, up)) / sphere.w;
+
+        if (any(greaterThan(abs(local), vec2(1.0)))) {
+            return result;
+        }
+        uv = clamp((frame + local * 0.5 + 0.5) / float(GRID), frame_min, frame_max);
+        height = sphere.w * (2.0 * textureLod(impostorDepth, vec3(uv, layer), 0.0).x - 1.0);
+    }
+
+    // Explicit level: some neighbouring fragments may have returned early
+    result.albedo = textureLod(impostorAlbedo, vec3(uv, layer), lod);
+    result.normal = result.albedo.a * textureLod(impostorNormal, vec3(uv, layer), lod).xyz;
+    result.position = position;
+
+    return result;
+}
+
+vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
+    in vec3 color_mat, in vec3 color_light)
+{
+    // Computes ambient, diffuse, and specular contributions and the overall color
+    vec3 light_vec = light_pos - vertex_pos.xyz;
+    vec3 light_dir = normalize(light_vec);
+    float light_dist = length(light_vec);
+    vec3 view_dir = normalize(eye_pos - vertex_pos);
+
+    // Ambient contribution (very weak)
+    vec3 ambient = .005 * color_light;
+
+    // Diffuse contribution
+    float diffuse = max(dot(normal, light_dir), 0.0);
+
+    // Specular contribution
+    vec3 h_vector = normalize(view_dir + light_dir);
+    float specular = pow(max(dot(normal, h_vector), 0.0), 256.0);
+
+    // Constant, linear and quadratic falloff
+    float attenuation = 1.0 / (1.0f + 0.07f * light_dist + .017f * (light_dist * light_dist));
+
+    vec3 diffuse_color = diffuse * mix(color_light, color_mat, .75);
+    vec3 specular_color = specular * mix(color_light, color_mat, .75);
+
+    diffuse *= attenuation;
+    specular *= attenuation;
+
+    // Combine lighting contributions
+    vec3 color = ambient + diffuse_color + specular_color;
+
+    return color;
+}
+
+uint cluster_index(in vec2 ndc_xy, in float view_depth) {
+    // Froxel containing a position given in NDC (x, y) and view space distance
+    vec2 cell_xy = clamp((ndc_xy * 0.5 + 0.5) * vec2(clusterGrid.xy), vec2(0.0), vec2(clusterGrid.xy) - 1.0);
+    float slice = log(max(view_depth, clusterDepth.x) / clusterDepth.x) * clusterDepth.z;
+    uint cell_z = uint(clamp(slice, 0.0, float(clusterGrid.z) - 1.0));
+
+    return (cell_z * clusterGrid.y + uint(cell_xy.y)) * clusterGrid.x + uint(cell_xy.x);
+}
+
+float falloff_window(in float light_dist, in float radius) {
+    // Smoothly forces the contribution to zero at the culling radius
+    float ratio = clamp(light_dist / radius, 0.0, 1.0);
+    float window = 1.0 - ratio * ratio * ratio * ratio;
+
+    return window * window;
+}
@@ -0,0 +1,77 @@
+#version 460 core
+/* Octahedral impostor (see impostors.h): one camera facing quad per instance, covering its bounding sphere.
+   The fragment shader finds the surface in the baked views */
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+layout (std140, binding=1) uniform Lighting
+{
+    vec4 eyePos;
+    uvec4 clusterGrid; // x, y, z froxel counts; w: light capacity per cluster
+    vec4 clusterDepth; // near, far, z slices / log(far / near)
+    vec4 viewport;
+};
+
+struct Instance {
+    mat4 world;
+    mat4 normalToView;
+    mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+// Impostors drawn this frame (x: instance, y: layer of the atlases) and the bounds of every layer
+layout (std430, binding=12) readonly buffer ImpostorDraws
+{
+    uvec4 impostorDraws[];
+};
+
+layout (std430, binding=13) readonly buffer ImpostorSpheres
+{
+    vec4 impostorSpheres[]; // model space; xyz: center, w: radius
+};
+
+// Outputs; the ray is in model space, where the views were baked
+out IMPOSTOR_OUTPUT {
+    flat vec3 oRayOrigin; // computed; the eye
+    vec3 oQuadPos; // computed; point of the quad
+    flat uint oInstance; // forwarded
+    flat uint oLayer; // forwarded
+} outputs;
+
+void main() {
+    uvec4 draw = impostorDraws[gl_InstanceID];
+    vec4 sphere = impostorSpheres[draw.y];
+    mat4 world = instances[draw.x].world;
+
+    // The eye in model space, and a quad through the center facing it
+    vec3 eye_ms = (inverse(world) * vec4(eyePos.xyz, 1.0)).xyz;
+    vec3 to_eye = normalize(eye_ms - sphere.xyz);
+    vec3 up_ref = abs(to_eye.y) > 0.999 ? vec3(0.0, 0.0, -1.0) : vec3(0.0, 1.0, 0.0);
+    vec3 right = normalize(cross(up_ref, to_eye));
+    vec3 up = cross(to_eye, right);
+
+    // Under perspective the silhouette of the sphere is a little wider than its radius
+    float distance = max(length(eye_ms - sphere.xyz), 1.001 * sphere.w);
+    float half_size = sphere.w * distance / sqrt(distance * distance - sphere.w * sphere.w);
+
+    // Triangle strip: (-1, -1), (1, -1), (-1, 1), (1, 1)
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    vec3 pos_ms = sphere.xyz + half_size * (corner.x * right + corner.y * up);
+
+    gl_Position = projection * (view * (world * vec4(pos_ms, 1.0)));
+
+    outputs.oRayOrigin = eye_ms;
+    outputs.oQuadPos = pos_ms;
+    outputs.oInstance = draw.x;
+    outputs.oLayer = draw.y;
+}
@@ -1,33 +1,84 @@
-#version 420 core
+#version 460 core
 
 // Inputs
 in VS_OUTPUT {
     vec3 oPosTangentSpace; // computed
-    vec3 oLightPosTangentSpace; // computed
     vec3 oEyePosTangentSpace; // computed
+    float oViewDepth; // computed; selects the light cluster
+    mat3 oTangentFromWorld; // computed; lights are transformed per fragment
     vec2 oTextureCoords; // forwarded
+    flat uint oMaterial; // forwarded; index into the material table
+#ifdef AMBIENT_OCCLUSION
+    float oVisibility; // forwarded; baked ambient visibility
+#endif
+#ifdef SHADOWS
+    vec4 oShadowCoord; // computed; key light shadow map coordinates
+#endif
 } vs_inputs;
 
 // Uniform variables
 layout (std140, binding=0) uniform Matrices
 {
-    mat4 world;
     mat4 view;
     mat4 projection;
-    mat4 normalToView;
-    mat4 normalToWorld;
 };
 
 layout (std140, binding=1) uniform Lighting
 {
     vec4 eyePos;
-    vec4 lightPos;
-    vec4 lightColor;
+    uvec4 clusterGrid; // x, y, z froxel counts; w: light capacity per cluster
+    vec4 clusterDepth; // near, far, z slices / log(far / near)
+    vec4 viewport;
 };
 
-// Uniform textures
-uniform sampler2D diffuseMap;
-uniform sampler2D normalMap;
+struct PointLight {
+    vec4 position; // xyz: world space, w: radius of influence
+    vec4 color;
+};
+
+// Light list and the per-cluster light indices built by the clustered culling pre-pass
+layout (std430, binding=2) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+layout (std430, binding=3) readonly buffer ClusterLights
+{
+    uint clusterLights[];
+};
+
+layout (std430, binding=4) readonly buffer ClusterCounts
+{
+    uint clusterCounts[];
+};
+
+#ifdef SHADOWS
+// Key light shadow map (see shadows.h)
+layout (std140, binding=7) uniform Shadow
+{
+    mat4 shadowFromWorld; // world space -> shadow map coordinates, before the divide
+    vec4 shadowParams; // x: normal offset per unit of light distance, y: depth bias, z: 1 / map size
+};
+
+uniform sampler2DShadow shadowMap;
+#endif
+
+// Material table; textures are found through it
+struct Material {
+    uvec4 textures; // bindless: diffuse and normal handles; otherwise (array, layer) of each
+    vec4 color; // rgb: albedo of untextured meshes; w: 1 if textured
+};
+
+layout (std430, binding=6) readonly buffer Materials
+{
+    Material materials[];
+};
+
+// Without bindless handles, textures live in one array per texture size
+#ifndef BINDLESS_TEXTURES
+#define MAX_MATERIAL_ARRAYS 8
+uniform sampler2DArray materialArrays[MAX_MATERIAL_ARRAYS];
+#endif
 
 // Outputs
 layout(location = 0) out vec3 outColor;
@@ -35,20 +86,54 @@ layout(location = 0) out vec3 outColor;
 // Forward declarations
 vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
     in vec3 color_mat, in vec3 color_light);
+uint cluster_index(in vec2 ndc_xy, in float view_depth);
+float falloff_window(in float light_dist, in float radius);
+vec4 sample_material(in uvec2 texture_ref, in vec2 uv, in vec2 uv_dx, in vec2 uv_dy);
+#ifdef SHADOWS
+float shadow_factor(in vec4 shadow_coord);
+#endif
 
 void main() {
+    Material material = materials[vs_inputs.oMaterial];
+    vec2 uv_dx = dFdx(vs_inputs.oTextureCoords);
+    vec2 uv_dy = dFdy(vs_inputs.oTextureCoords);
+
     // Sample from diffuse map
-    vec3 color_texture = texture(diffuseMap, vs_inputs.oTextureCoords).xyz;
+    vec3 color_texture = sample_material(material.textures.xy, vs_inputs.oTextureCoords, uv_dx, uv_dy).xyz;
 
     // Sample from normal map
-    vec3 normal_ts = texture(normalMap, vs_inputs.oTextureCoords).xyz;
+    vec3 normal_ts = sample_material(material.textures.zw, vs_inputs.oTextureCoords, uv_dx, uv_dy).xyz;
 
     // Transform sampled normal to range [-1,1]
     normal_ts = normalize(2.0 * normal_ts - vec3(1.0, 1.0, 1.0));
 
+    // Only the lights binned into this fragment's cluster
+    uint cluster = cluster_index(gl_FragCoord.xy / viewport.xy * 2.0 - 1.0, vs_inputs.oViewDepth);
+    uint count = clusterCounts[cluster];
+
+    outColor = vec3(0.0);
+
     // Compute lighting in tangent space; normal is in tangent space
-    outColor = lighting(vs_inputs.oPosTangentSpace, vs_inputs.oLightPosTangentSpace,
-                        vs_inputs.oEyePosTangentSpace, normal_ts, color_texture, lightColor.xyz);
+    for (uint i = 0; i < count; ++i) {
+        uint index = clusterLights[cluster * clusterGrid.w + i];
+        PointLight light = lights[index];
+        vec3 lightpos_ts = vs_inputs.oTangentFromWorld * light.position.xyz;
+        float window = falloff_window(length(lightpos_ts - vs_inputs.oPosTangentSpace), light.position.w);
+
+#ifdef SHADOWS
+        // Only the key light casts shadows
+        if (index == 0u) {
+            window *= shadow_factor(vs_inputs.oShadowCoord);
+        }
+#endif
+        outColor += window * lighting(vs_inputs.oPosTangentSpace, lightpos_ts,
+                                      vs_inputs.oEyePosTangentSpace, normal_ts, color_texture, light.color.xyz);
+    }
+
+#ifdef AMBIENT_OCCLUSION
+    // Ambient light, occluded by the mesh itself
+    outColor += AO_AMBIENT * vs_inputs.oVisibility * color_texture;
+#endif
 }
 
 vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 normal,
@@ -84,3 +169,61 @@ vec3 lighting(in vec3 vertex_pos, in vec3 light_pos, in vec3 eye_pos, in vec3 no
 
     return color;
 }
+
+uint cluster_index(in vec2 ndc_xy, in float view_depth) {
+    // Froxel containing a position given in NDC (x, y) and view space distance
+    vec2 cell_xy = clamp((ndc_xy * 0.5 + 0.5) * vec2(clusterGrid.xy), vec2(0.0), vec2(clusterGrid.xy) - 1.0);
+    float slice = log(max(view_depth, clusterDepth.x) / clusterDepth.x) * clusterDepth.z;
+    uint cell_z = uint(clamp(slice, 0.0, float(clusterGrid.z) - 1.0));
+
+    return (cell_z * clusterGrid.y + uint(cell_xy.y)) * clusterGrid.x + uint(cell_xy.x);
+}
+
+float falloff_window(in float light_dist, in float radius) {
+    // Smoothly forces the contribution to zero at the culling radius
+    float ratio = clamp(light_dist / radius, 0.0, 1.0);
+    float window = 1.0 - ratio * ratio * ratio * ratio;
+
+    return window * window;
+}
+
+
+vec4 sample_material(in uvec2 texture_ref, in vec2 uv, in vec2 uv_dx, in vec2 uv_dy) {
+    // Looks up one texture of a material. Neighbouring fragments may belong to different draws, so
+    // this can run in non-uniform control flow: explicit gradients, taken by the caller beforehand
+#ifdef BINDLESS_TEXTURES
+    return textureGrad(sampler2D(texture_ref), uv, uv_dx, uv_dy);
+#else
+    // Sampler arrays may only be indexed uniformly; test every array with a constant index instead
+    vec4 color = vec4(0.0);
+
+    for (int i = 0; i < MAX_MATERIAL_ARRAYS; ++i) {
+        if (uint(i) == texture_ref.x) {
+            color = textureGrad(materialArrays[i], vec3(uv, float(texture_ref.y)), uv_dx, uv_dy);
+        }
+    }
+    return color;
+#endif
+}
+
+#ifdef SHADOWS
+float shadow_factor(in vec4 shadow_coord) {
+    // Visibility of the key light, 3x3 comparison taps (each bilinear filtered); 1 outside the map
+    vec3 coord = shadow_coord.xyz / shadow_coord.w;
+
+    if (shadow_coord.w <= 0.0 || any(lessThan(coord.xy, vec2(0.0))) || any(greaterThan(coord.xy, vec2(1.0)))) {
+        return 1.0;
+    }
+
+    // Reverse-Z: a slightly larger reference is slightly nearer the light
+    float reference = coord.z * (1.0 + shadowParams.y);
+    float visible = 0.0;
+
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            visible += texture(shadowMap, vec3(coord.xy + vec2(x, y) * shadowParams.z, reference));
+        }
+    }
+    return visible / 9.0;
+}
+#endif
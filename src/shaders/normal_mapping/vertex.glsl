@@ -1,60 +1,156 @@
-#version 420 core
+#version 460 core
 
+#ifdef VERTEX_PULLING
+// Vertex pulling (see vertex_pulling.h): every stream is read, at gl_VertexID
+layout (std430, binding=8) readonly buffer Positions
+{
+    float positions[];
+};
+
+layout (std430, binding=9) readonly buffer Normals
+{
+    float normals[];
+};
+
+layout (std430, binding=10) readonly buffer Tangents
+{
+    float tangents[];
+};
+
+layout (std430, binding=11) readonly buffer TextureCoords
+{
+    float uvs[];
+};
+
+vec3 pull_position(in int index);
+vec3 pull_normal(in int index);
+vec3 pull_tangent(in int index);
+vec2 pull_uv(in int index);
+
+#define aPos pull_position(gl_VertexID)
+#define aNormal pull_normal(gl_VertexID)
+#define aTangent pull_tangent(gl_VertexID)
+#define aTextureCoords pull_uv(gl_VertexID)
+#else
 // Vertex attributes
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec3 aTangent;
 layout (location = 3) in vec2 aTextureCoords;
+#endif
+
+#ifdef AMBIENT_OCCLUSION
+// Baked visibility of the hemisphere above the vertex (see ambient_occlusion.h); 0 when fully occluded
+layout (location = 4) in float aVisibility;
+#endif
 
 // Uniform attributes
 layout (std140, binding=0) uniform Matrices
 {
-    mat4 world;
     mat4 view;
     mat4 projection;
+};
+
+struct Instance {
+    mat4 world;
     mat4 normalToView;
     mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+// Per-instance data; every command of the multi-draw carries its instance as the base instance
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
 };
 
 layout (std140, binding=1) uniform Lighting
 {
     vec4 eyePos;
-    vec4 lightPos;
-    vec4 lightColor;
+    uvec4 clusterGrid; // x, y, z froxel counts; w: light capacity per cluster
+    vec4 clusterDepth; // near, far, z slices / log(far / near)
+    vec4 viewport;
 };
 
+#ifdef SHADOWS
+struct PointLight {
+    vec4 position; // xyz: world space, w: radius of influence
+    vec4 color;
+};
+
+layout (std430, binding=2) readonly buffer Lights
+{
+    PointLight lights[];
+};
+
+// Key light shadow map (see shadows.h)
+layout (std140, binding=7) uniform Shadow
+{
+    mat4 shadowFromWorld; // world space -> shadow map coordinates, before the divide
+    vec4 shadowParams; // x: normal offset per unit of light distance, y: depth bias, z: 1 / map size
+};
+#endif
+
 // Outputs
 out VS_OUTPUT {
     vec3 oPosTangentSpace; // computed
-    vec3 oLightPosTangentSpace; // computed
     vec3 oEyePosTangentSpace; // computed
+    float oViewDepth; // computed; selects the light cluster
+    mat3 oTangentFromWorld; // computed; lights are transformed per fragment
     vec2 oTextureCoords; // forwarded
+    flat uint oMaterial; // forwarded; index into the material table
+#ifdef AMBIENT_OCCLUSION
+    float oVisibility; // forwarded; baked ambient visibility
+#endif
+#ifdef SHADOWS
+    vec4 oShadowCoord; // computed; key light shadow map coordinates
+#endif
 } outputs;
 
+// Depth must match the depth pre-pass exactly
+invariant gl_Position;
+
 // Forward declarations
-mat3 tbn_matrix();
+mat3 tbn_matrix(in mat4 normal_to_world);
 
 void main() {
     mat3 tbn;
+    mat4 world = instances[gl_BaseInstance].world;
 
-    // Model space -> Perspective
-    gl_Position = projection * view * world * vec4(aPos, 1.0);
+    // Model space -> Perspective; same expression as the depth pre-pass
+    gl_Position = projection * (view * (world * vec4(aPos, 1.0)));
 
     // World space -> Tangent space
-    tbn = tbn_matrix();
+    tbn = tbn_matrix(instances[gl_BaseInstance].normalToWorld);
 
-    // World space -> Tangent space transforms to vertex, light and eye positions
-    outputs.oPosTangentSpace = tbn * vec3(world * vec4(aPos, 1.0));
-    outputs.oLightPosTangentSpace = tbn * lightPos.xyz;
+    // World space -> Tangent space transforms to vertex and eye positions
+    vec4 pos_ws = world * vec4(aPos, 1.0);
+
+    outputs.oPosTangentSpace = tbn * pos_ws.xyz;
     outputs.oEyePosTangentSpace = tbn * eyePos.xyz;
+    outputs.oViewDepth = -(view * pos_ws).z;
+    outputs.oTangentFromWorld = tbn;
 
-    // Forward texture coords
+    // Forward texture coords and material
     outputs.oTextureCoords = aTextureCoords;
+    outputs.oMaterial = instances[gl_BaseInstance].material.x;
+
+#ifdef AMBIENT_OCCLUSION
+    outputs.oVisibility = aVisibility;
+#endif
+
+#ifdef SHADOWS
+    // Offset along the normal by a few shadow texels, so the surface does not shadow itself
+    vec3 normal_ws = normalize(mat3(instances[gl_BaseInstance].normalToWorld) * aNormal);
+    float offset = shadowParams.x * length(lights[0].position.xyz - pos_ws.xyz);
+
+    outputs.oShadowCoord = shadowFromWorld * vec4(pos_ws.xyz + offset * normal_ws, 1.0);
+#endif
 }
 
-mat3 tbn_matrix() {
-    vec3 tangent_ws = normalize(mat3(normalToWorld) * aTangent);
-    vec3 normal_ws = normalize(mat3(normalToWorld) * aNormal);  // "N"
+mat3 tbn_matrix(in mat4 normal_to_world) {
+    vec3 tangent_ws = normalize(mat3(normal_to_world) * aTangent);
+    vec3 normal_ws = normalize(mat3(normal_to_world) * aNormal);  // "N"
 
     // Orthonormalize via Gram–Schmidt process
     tangent_ws = normalize(tangent_ws - dot(tangent_ws, normal_ws) * normal_ws);  // "T"
@@ -65,3 +161,22 @@ mat3 tbn_matrix() {
     // "TBN" matrix
     return transpose(mat3(tangent_ws, bitangent_ws, normal_ws));
 }
+
+#ifdef VERTEX_PULLING
+// The streams are float arrays: std430 would pad a vec3 array to 16 bytes per element
+vec3 pull_position(in int index) {
+    return vec3(positions[3 * index], positions[3 * index + 1], positions[3 * index + 2]);
+}
+
+vec3 pull_normal(in int index) {
+    return vec3(normals[3 * index], normals[3 * index + 1], normals[3 * index + 2]);
+}
+
+vec3 pull_tangent(in int index) {
+    return vec3(tangents[3 * index], tangents[3 * index + 1], tangents[3 * index + 2]);
+}
+
+vec2 pull_uv(in int index) {
+    return vec2(uvs[2 * index], uvs[2 * index + 1]);
+}
+#endif
@@ -0,0 +1,12 @@
+#version 430 core
+/* Overdraw counter; paired with the depth pre-pass vertex shader. Early depth testing guarantees
+   that only fragments which would also be shaded are counted */
+
+layout (early_fragment_tests) in;
+
+// Fragments per pixel
+layout (r32ui, binding=1) uniform coherent uimage2D overdrawCounts;
+
+void main() {
+    imageAtomicAdd(overdrawCounts, ivec2(gl_FragCoord.xy), 1u);
+}
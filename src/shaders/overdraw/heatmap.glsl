@@ -0,0 +1,31 @@
+#version 430 core
+/* Overdraw visualization; paired with the fullscreen present vertex shader */
+
+// Inputs
+in vec2 oTextureCoords;
+
+// Fragments per pixel
+layout (r32ui, binding=1) uniform readonly uimage2D overdrawCounts;
+
+// Count that maps to the hottest color
+uniform float maxOverdraw;
+
+// Outputs
+out vec3 outColor;
+
+void main() {
+    uint count = imageLoad(overdrawCounts, ivec2(gl_FragCoord.xy)).x;
+
+    if (count == 0u) {
+        outColor = vec3(0.0);
+        return;
+    }
+
+    // blue (1 fragment) -> green -> yellow -> red (maxOverdraw or more)
+    float heat = clamp(float(count - 1u) / max(maxOverdraw - 1.0, 1.0), 0.0, 1.0);
+
+    vec3 cold = mix(vec3(0.0, 0.2, 1.0), vec3(0.0, 1.0, 0.2), clamp(heat * 3.0, 0.0, 1.0));
+    vec3 warm = mix(vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), clamp(heat * 3.0 - 2.0, 0.0, 1.0));
+
+    outColor = mix(cold, warm, clamp(heat * 3.0 - 1.0, 0.0, 1.0));
+}
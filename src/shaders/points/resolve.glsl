@@ -0,0 +1,99 @@
+#version 460 core
+/* Point splats, resolve pass (see point_splats.h). One invocation per pixel writes the color of its nearest point,
+   or fills a hole: when points clearly nearer than the pixel's own lie around it on two opposite sides (left and
+   right, or above and below), the pixel sees through a gap of that nearer surface and takes the nearest of them.
+   Silhouettes have nearer points on one side only and stay as they are. */
+
+#define TILE_SIZE 16
+#define EMPTY 0xFFFFFFFFu
+
+layout (local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+#ifdef ATOMIC_INT64
+layout (std430, binding=22) readonly buffer Pixels
+{
+    uint64_t pixels[]; // high: view distance bits, low: RGBA8; all ones when empty
+};
+#else
+layout (std430, binding=22) readonly buffer Pixels
+{
+    uint pixels[]; // RGBA8
+};
+
+layout (std430, binding=23) readonly buffer Depths
+{
+    uint depths[]; // view distance bits; all ones when empty
+};
+#endif
+
+layout (rgba8, binding=0) uniform writeonly image2D splatImage;
+
+uniform uvec2 viewportSize;
+uniform int fillRadius;
+uniform float depthTolerance; // relative
+uniform vec3 clearColor;
+
+// Forward declarations
+uvec2 fetch(in ivec2 pixel);
+
+void main() {
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+
+    if (any(greaterThanEqual(uvec2(pixel), viewportSize))) {
+        return;
+    }
+
+    uvec2 own = fetch(pixel);
+    float own_depth = own.y == EMPTY ? 3.0e38 : uintBitsToFloat(own.y);
+
+    // The nearest point clearly in front, and the sides (left, right, below, above) with such points
+    uvec2 nearest = own;
+    float nearest_depth = own_depth;
+    uint sides = 0u;
+
+    for (int dy = -fillRadius; dy <= fillRadius; ++dy) {
+        for (int dx = -fillRadius; dx <= fillRadius; ++dx) {
+            ivec2 neighbor = pixel + ivec2(dx, dy);
+
+            if ((dx == 0 && dy == 0) || any(lessThan(neighbor, ivec2(0))) ||
+                any(greaterThanEqual(uvec2(neighbor), viewportSize))) {
+                continue;
+            }
+
+            uvec2 other = fetch(neighbor);
+
+            if (other.y == EMPTY) {
+                continue;
+            }
+
+            float depth = uintBitsToFloat(other.y);
+
+            if (depth * (1.0 + depthTolerance) >= own_depth) {
+                continue;
+            }
+            sides |= (dx < 0 ? 1u : 0u) | (dx > 0 ? 2u : 0u) | (dy < 0 ? 4u : 0u) | (dy > 0 ? 8u : 0u);
+
+            if (depth < nearest_depth) {
+                nearest = other;
+                nearest_depth = depth;
+            }
+        }
+    }
+
+    bool enclosed = (sides & 3u) == 3u || (sides & 12u) == 12u;
+    uvec2 result = enclosed ? nearest : own;
+    vec4 color = result.y == EMPTY ? vec4(clearColor, 1.0) : unpackUnorm4x8(result.x);
+
+    imageStore(splatImage, pixel, color);
+}
+
+uvec2 fetch(in ivec2 pixel) {
+    // x: RGBA8, y: view distance bits
+    uint index = uint(pixel.y) * viewportSize.x + uint(pixel.x);
+
+#ifdef ATOMIC_INT64
+    return unpackUint2x32(pixels[index]);
+#else
+    return uvec2(pixels[index], depths[index]);
+#endif
+}
@@ -0,0 +1,132 @@
+#version 460 core
+/* Point splats, splat pass (see point_splats.h). One invocation per point of one draw: the point is projected to
+   its pixel, shaded with a headlight, and kept if it is the nearest so far. With 64-bit atomics a single atomicMin
+   on (view distance << 32 | RGBA8 color) keeps both at once; positive floats order like their bits, so the
+   distance compares as an integer. Without them, the DEPTH_PASS build keeps the distance alone and the color build
+   then writes where its point matches it. The groups loop over points when a draw has more than fit a dispatch. */
+
+#define GROUP_SIZE 256
+#define FLOATS_PER_POINT 11
+#define AMBIENT 0.15
+
+layout (local_size_x = GROUP_SIZE) in;
+
+// Uniform variables
+layout (std140, binding=0) uniform Matrices
+{
+    mat4 view;
+    mat4 projection;
+};
+
+struct Instance {
+    mat4 world;
+    mat4 normalToView;
+    mat4 normalToWorld;
+    uvec4 material; // x: index into the material table
+};
+
+layout (std430, binding=5) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+struct Material {
+    uvec4 textures; // bindless: diffuse and normal handles; otherwise (array, layer) of each
+    vec4 color; // rgb: albedo of untextured meshes; w: 1 if textured
+};
+
+layout (std430, binding=6) readonly buffer Materials
+{
+    Material materials[];
+};
+
+// The scene's vertex buffer: 11 floats per point (position, normal, tangent, uv)
+layout (std430, binding=21) readonly buffer Points
+{
+    float points[];
+};
+
+#ifdef ATOMIC_INT64
+layout (std430, binding=22) buffer Pixels
+{
+    uint64_t pixels[]; // high: view distance bits, low: RGBA8; all ones when empty
+};
+#else
+layout (std430, binding=22) buffer Pixels
+{
+    uint pixels[]; // RGBA8
+};
+
+layout (std430, binding=23) buffer Depths
+{
+    uint depths[]; // view distance bits; all ones when empty
+};
+#endif
+
+uniform uint firstPoint;
+uniform uint pointCount;
+uniform uint instanceIndex;
+uniform uvec2 viewportSize;
+
+// Forward declarations
+vec3 point_position(in uint point);
+vec3 point_normal(in uint point);
+uint shade(in uint point, in vec3 pos_vs);
+
+void main() {
+    mat4 world_view = view * instances[instanceIndex].world;
+    uint stride = gl_NumWorkGroups.x * GROUP_SIZE;
+
+    for (uint i = gl_GlobalInvocationID.x; i < pointCount; i += stride) {
+        uint point = firstPoint + i;
+        vec4 pos_vs = world_view * vec4(point_position(point), 1.0);
+        vec4 clip = projection * pos_vs;
+
+        // Behind the camera or outside the frustum
+        if (clip.w <= 0.0 || any(greaterThan(abs(clip.xyz), vec3(clip.w)))) {
+            continue;
+        }
+
+        uvec2 pixel = min(uvec2((clip.xy / clip.w * 0.5 + 0.5) * vec2(viewportSize)), viewportSize - 1u);
+        uint index = pixel.y * viewportSize.x + pixel.x;
+        uint depth = floatBitsToUint(-pos_vs.z);
+
+#if defined(ATOMIC_INT64)
+        atomicMin(pixels[index], packUint2x32(uvec2(shade(point, pos_vs.xyz), depth)));
+#elif defined(DEPTH_PASS)
+        atomicMin(depths[index], depth);
+#else
+        // Points at the same distance race; any of them is right
+        if (depths[index] == depth) {
+            pixels[index] = shade(point, pos_vs.xyz);
+        }
+#endif
+    }
+}
+
+vec3 point_position(in uint point) {
+    uint first = point * FLOATS_PER_POINT;
+
+    return vec3(points[first], points[first + 1], points[first + 2]);
+}
+
+vec3 point_normal(in uint point) {
+    uint first = point * FLOATS_PER_POINT + 3;
+
+    return vec3(points[first], points[first + 1], points[first + 2]);
+}
+
+uint shade(in uint point, in vec3 pos_vs) {
+    // Two-sided headlight on the material color; bare scans have no normals and are shown unlit
+    Material material = materials[instances[instanceIndex].material.x];
+    vec3 albedo = material.color.w > 0.5 ? vec3(0.8) : material.color.rgb;
+    vec3 normal = point_normal(point);
+    float diffuse = 1.0;
+
+    if (dot(normal, normal) > 0.0) {
+        vec3 normal_vs = normalize(mat3(instances[instanceIndex].normalToView) * normal);
+
+        diffuse = abs(dot(normal_vs, normalize(-pos_vs)));
+    }
+    return packUnorm4x8(vec4((AMBIENT + (1.0 - AMBIENT) * diffuse) * albedo, 1.0));
+}
@@ -0,0 +1,15 @@
+#version 420 core
+/* Copies an offscreen color target to the window framebuffer */
+
+// Inputs
+in vec2 oTextureCoords;
+
+// Uniform textures
+uniform sampler2D sceneColor;
+
+// Outputs
+out vec3 outColor;
+
+void main() {
+    outColor = texture(sceneColor, oTextureCoords).xyz;
+}
@@ -0,0 +1,44 @@
+#version 420 core
+/* Upscales the scene, rendered at a reduced resolution, to the window. Bilinear, or edge-aware: a contrast
+   adaptive sharpen that restores detail in flat areas, backs off across strong edges and never leaves the
+   range of its neighbours, so it does not ring */
+
+// Inputs
+in vec2 oTextureCoords;
+
+// Uniform textures
+uniform sampler2D sceneColor;
+
+uniform bool edgeAware;
+uniform float sharpness;
+
+// Outputs
+out vec3 outColor;
+
+void main() {
+    vec2 uv = oTextureCoords;
+    vec3 center = texture(sceneColor, uv).rgb;
+
+    if (!edgeAware) {
+        outColor = center;
+        return;
+    }
+
+    // Neighbours one source texel away, bilinear filtered like the center
+    vec2 texel = 1.0 / vec2(textureSize(sceneColor, 0));
+    vec3 north = texture(sceneColor, uv + vec2(0.0, texel.y)).rgb;
+    vec3 south = texture(sceneColor, uv - vec2(0.0, texel.y)).rgb;
+    vec3 east = texture(sceneColor, uv + vec2(texel.x, 0.0)).rgb;
+    vec3 west = texture(sceneColor, uv - vec2(texel.x, 0.0)).rgb;
+
+    vec3 color_min = min(center, min(min(north, south), min(east, west)));
+    vec3 color_max = max(center, max(max(north, south), max(east, west)));
+
+    // Full strength where the neighbourhood is flat, none where it already spans the whole range
+    vec3 amount = sqrt(clamp(min(color_min, 1.0 - color_max) / max(color_max, vec3(1.0e-4)), 0.0, 1.0));
+    vec3 weight = -amount * sharpness;
+
+    vec3 sharpened = (center + weight * (north + south + east + west)) / (1.0 + 4.0 * weight);
+
+    outColor = clamp(sharpened, color_min, color_max);
+}
@@ -0,0 +1,12 @@
+#version 420 core
+/* Fullscreen triangle generated from gl_VertexID; no vertex buffer is bound */
+
+// Outputs
+out vec2 oTextureCoords;
+
+void main() {
+    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+    oTextureCoords = position;
+    gl_Position = vec4(2.0 * position - 1.0, 0.0, 1.0);
+}
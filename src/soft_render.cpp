@@ -0,0 +1,90 @@
+#include "pipeline/rasterizer.h"
+
+// Renders a scene on the CPU (no GL context) and writes output.png; reports images per second per core
+const unsigned int soft_frames_default = 10;
+
+int main(int argc, char* argv[]) {
+    // The model or scene comes first, as for dragon-opengl
+    auto input_options = ParseArgs(std::min(argc, 2), argv);
+
+    if(!input_options.stream_file.empty()) {
+        std::cout << "Paged meshes are only streamed by dragon-opengl" << std::endl;
+
+        exit(EXIT_FAILURE);
+    }
+
+    auto scene_description = input_options.scene_file.empty() ? BuiltinScene(input_options.model) :
+                             LoadSceneFile(input_options.scene_file);
+
+    std::optional<ShadingOption> shading;
+    unsigned int width = width_init;
+    unsigned int height = height_init;
+    unsigned int frames = soft_frames_default;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int light_count = 1;
+
+    for (int i = 2; i < argc; ++i) {
+        auto extras = std::string(argv[i]);
+
+        if(extras == flat_str) {
+            shading = ShadingOption::flat;
+        } else if(extras == wireframe_str) {
+            shading = ShadingOption::wireframe;
+        } else if(extras.starts_with(lights_str)) {
+            light_count = ParseCount(extras.substr(lights_str.size()), extras);
+        } else if(extras.starts_with(frames_str)) {
+            frames = ParseCount(extras.substr(frames_str.size()), extras);
+        } else if(extras.starts_with(threads_str)) {
+            threads = ParseCount(extras.substr(threads_str.size()), extras);
+        } else if(extras.starts_with(size_str) && extras.find('x') != std::string::npos) {
+            auto dims = extras.substr(size_str.size());
+
+            width = ParseCount(dims.substr(0, dims.find('x')), extras);
+            height = ParseCount(dims.substr(dims.find('x') + 1), extras);
+        } else {
+            std::cout << "Invalid option, try 'flat' 'wireframe' 'lights=N' 'size=WxH' 'frames=N' 'threads=N'" << std::endl;
+
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Same default as dragon-opengl: normal mapping if every mesh is textured
+    auto render_mode = shading.value_or(SceneHasTextures(scene_description) ? ShadingOption::normal_mapping :
+                                        ShadingOption::per_vertex);
+
+    auto jobs = JobSystem::ForCores(threads);
+
+    auto scene = CreateSoftScene(scene_description, render_mode, light_count, jobs);
+
+    SceneGlobals scene_globals;
+
+    scene_globals.width = width;
+    scene_globals.height = height;
+
+    Framebuffer framebuffer;
+
+    // The first frame touches the framebuffer and texture pages; it is not timed
+    auto stats = RenderSoftFrame(scene, scene_globals, framebuffer, jobs);
+
+    double total_ms = 0;
+    double best_ms = std::numeric_limits<double>::max();
+
+    for (unsigned int i = 0; i < frames; ++i) {
+        stats = RenderSoftFrame(scene, scene_globals, framebuffer, jobs);
+
+        total_ms += stats.milliseconds;
+        best_ms = std::min(best_ms, stats.milliseconds);
+    }
+
+    auto images_per_second = 1000.0 * frames / total_ms;
+
+    std::cout << "Software rasterizer: " << width << "x" << height << ", " << stats.triangles << " triangles ("
+              << stats.setup << " after clipping and culling), " << stats.pixels << " pixels shaded" << std::endl;
+    std::cout << frames << " frames, " << total_ms / frames << " ms average, " << best_ms << " ms best: "
+              << images_per_second << " images/s on " << threads << " cores, "
+              << images_per_second / threads << " images/s per core" << std::endl;
+
+    if(!WriteFramebuffer(framebuffer, output_filename)) {
+        exit(EXIT_FAILURE);
+    }
+}